@@ -0,0 +1,117 @@
+#include "BindlessDescriptors.h"
+
+BindlessDescriptors::BindlessDescriptors()
+{
+
+}
+
+uint32_t BindlessDescriptors::getBinding(Table table){
+    switch (table)
+    {
+        case TableVertices: return 3;
+        case TableIndices:  return 4;
+        case TableTextures: return 5;
+        case TableSpheres:  return 6;
+        case TableSphereMaterials: return 12;
+        default:            break;
+    }
+    throw std::runtime_error("unknown bindless table!");
+}
+
+VkDescriptorType BindlessDescriptors::getType(Table table){
+    return table == TableTextures ? VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+}
+
+uint32_t BindlessDescriptors::getCapacity(Table table){
+    return table == TableTextures ? MaxTextures : MaxGeometries;
+}
+
+VkShaderStageFlags BindlessDescriptors::getStages(Table table){
+    if (table == TableSpheres) {
+        return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+    }
+    return VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+}
+
+// Alle Descriptoren eines Sets mit UPDATE_AFTER_BIND_POOL zählen gegen die Update After Bind Limits
+void BindlessDescriptors::checkSupport(Device* device, uint32_t additionalStorageBuffers){
+    VkPhysicalDeviceDescriptorIndexingFeatures indexingFeatures{};
+    indexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    VkPhysicalDeviceFeatures2 features2{};
+    features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    features2.pNext = &indexingFeatures;
+    vkGetPhysicalDeviceFeatures2(device->getPhysicalDevice(), &features2);
+    if (!indexingFeatures.descriptorBindingPartiallyBound || !indexingFeatures.descriptorBindingStorageBufferUpdateAfterBind || !indexingFeatures.descriptorBindingSampledImageUpdateAfterBind || !indexingFeatures.descriptorBindingUpdateUnusedWhilePending) {
+        throw std::runtime_error("device does not support partially bound update after bind descriptors!");
+    }
+
+    VkPhysicalDeviceDescriptorIndexingProperties indexingProperties{};
+    indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2{};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &indexingProperties;
+    vkGetPhysicalDeviceProperties2(device->getPhysicalDevice(), &properties2);
+    uint32_t storageBuffers = additionalStorageBuffers;
+    for (uint32_t table = 0; table < TableCount; table++) {
+        if (getType(static_cast<Table>(table)) == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            storageBuffers += getCapacity(static_cast<Table>(table));
+        }
+    }
+    if (storageBuffers > indexingProperties.maxPerStageDescriptorUpdateAfterBindStorageBuffers || storageBuffers > indexingProperties.maxDescriptorSetUpdateAfterBindStorageBuffers) {
+        throw std::runtime_error("bindless storage buffer capacity exceeds device limits!");
+    }
+    if (MaxTextures > indexingProperties.maxPerStageDescriptorUpdateAfterBindSamplers || MaxTextures > indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages) {
+        throw std::runtime_error("bindless texture capacity exceeds device limits!");
+    }
+}
+
+void BindlessDescriptors::appendLayoutBindings(std::vector<VkDescriptorSetLayoutBinding>& bindings, std::vector<VkDescriptorBindingFlags>& bindingFlags){
+    for (uint32_t table = 0; table < TableCount; table++) {
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding         = getBinding(static_cast<Table>(table));
+        binding.descriptorType  = getType(static_cast<Table>(table));
+        binding.descriptorCount = getCapacity(static_cast<Table>(table));
+        binding.stageFlags      = getStages(static_cast<Table>(table));
+        bindings.push_back(binding);
+        // Laufende Command Buffer lesen nie einen Slot, der gerade neu beschrieben wird
+        bindingFlags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT);
+    }
+}
+
+void BindlessDescriptors::appendPoolSizes(std::vector<VkDescriptorPoolSize>& poolSizes){
+    for (uint32_t table = 0; table < TableCount; table++) {
+        poolSizes.push_back({getType(static_cast<Table>(table)), getCapacity(static_cast<Table>(table))});
+    }
+}
+
+void BindlessDescriptors::setDescriptorSet(Device* device, VkDescriptorSet descriptorSet){
+    m_device = device;
+    m_descriptorSet = descriptorSet;
+}
+
+void BindlessDescriptors::writeBuffer(Table table, uint32_t slot, const VkDescriptorBufferInfo& bufferInfo){
+    write(table, slot, &bufferInfo, nullptr);
+}
+
+void BindlessDescriptors::writeImage(Table table, uint32_t slot, const VkDescriptorImageInfo& imageInfo){
+    write(table, slot, nullptr, &imageInfo);
+}
+
+void BindlessDescriptors::write(Table table, uint32_t slot, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo){
+    if (m_descriptorSet == VK_NULL_HANDLE) {
+        throw std::runtime_error("bindless descriptors written before the descriptor set exists!");
+    }
+    if (slot >= getCapacity(table)) {
+        throw std::runtime_error("bindless descriptor slot out of range!");
+    }
+    VkWriteDescriptorSet descriptorWrite{};
+    descriptorWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    descriptorWrite.dstSet          = m_descriptorSet;
+    descriptorWrite.dstBinding      = getBinding(table);
+    descriptorWrite.dstArrayElement = slot;
+    descriptorWrite.descriptorType  = getType(table);
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.pBufferInfo     = bufferInfo;
+    descriptorWrite.pImageInfo      = imageInfo;
+    vkUpdateDescriptorSets(m_device->getHandle(), 1, &descriptorWrite, 0, nullptr);
+}
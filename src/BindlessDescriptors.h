@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Device.h"
+#include "GlobalDefs.h"
+
+// Große PARTIALLY_BOUND | UPDATE_AFTER_BIND Arrays für Geometrie und Texturen. Layout und Pool hängen nur
+// von den Kapazitäten ab, neue BLAS oder Texturen schreiben ihren Descriptor in einen freien Slot,
+// ohne dass Layout, Pipeline oder Pool neu gebaut werden müssen
+class BindlessDescriptors
+{
+public:
+    enum Table{
+        TableVertices = 0,
+        TableIndices,
+        TableTextures,
+        TableSpheres,
+        TableSphereMaterials,
+        TableCount
+    };
+    static const uint32_t MaxGeometries = 1024;
+    static const uint32_t MaxTextures = 4096;
+    BindlessDescriptors();
+    static uint32_t getBinding(Table table);
+    static VkDescriptorType getType(Table table);
+    static uint32_t getCapacity(Table table);
+    static VkShaderStageFlags getStages(Table table);
+    static void checkSupport(Device* device, uint32_t additionalStorageBuffers);
+    static void appendLayoutBindings(std::vector<VkDescriptorSetLayoutBinding>& bindings, std::vector<VkDescriptorBindingFlags>& bindingFlags);
+    static void appendPoolSizes(std::vector<VkDescriptorPoolSize>& poolSizes);
+    void setDescriptorSet(Device* device, VkDescriptorSet descriptorSet);
+    void writeBuffer(Table table, uint32_t slot, const VkDescriptorBufferInfo& bufferInfo);
+    void writeImage(Table table, uint32_t slot, const VkDescriptorImageInfo& imageInfo);
+private:
+    Device* m_device = nullptr;
+    VkDescriptorSet m_descriptorSet = VK_NULL_HANDLE;
+    void write(Table table, uint32_t slot, const VkDescriptorBufferInfo* bufferInfo, const VkDescriptorImageInfo* imageInfo);
+};
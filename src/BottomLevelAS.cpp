@@ -1,26 +1,67 @@
 #include "BottomLevelAS.h"
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
+#include "JobSystem.h"
 
 std::vector<Material> BottomLevelAS::m_materials = std::vector<Material>(0);
 std::vector<Texture> BottomLevelAS::m_textures = std::vector<Texture>(0);
+std::vector<uint32_t> BottomLevelAS::m_textureSlotIds = std::vector<uint32_t>(0);
+SlotAllocator BottomLevelAS::m_textureSlots = SlotAllocator(BindlessDescriptors::MaxTextures);
 Buffer BottomLevelAS::m_materialBuffer;
-std::vector<VkDescriptorImageInfo> BottomLevelAS::m_textureDescriptors(0);
 VkDescriptorBufferInfo BottomLevelAS::m_materialBufferDescriptor;
-
-BottomLevelAS::BottomLevelAS(Device* device, std::string name, uint32_t id) : m_device(device), m_name(name), m_id(id) {
+Profiler* BottomLevelAS::m_profiler = nullptr;
+uint64_t BottomLevelAS::m_profiledBuild = 0;
+std::vector<std::string> BottomLevelAS::m_requestedTextures = std::vector<std::string>(0);
+std::vector<uint32_t> BottomLevelAS::m_requestedTextureSlots = std::vector<uint32_t>(0);
+
+BottomLevelAS::BottomLevelAS(Device* device, std::string name, uint32_t id) : m_instanceTransforms(1, glm::mat4(1.0f)), m_device(device), m_name(name), m_id(id) {
+    // Ohne Device (CPU Ray Tracer) werden nur die Szenendaten geladen
+    if (m_device == nullptr) {
+        return;
+    }
     vkCmdBuildAccelerationStructuresKHR = reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCmdBuildAccelerationStructuresKHR"));
-    vkBuildAccelerationStructuresKHR = reinterpret_cast<PFN_vkBuildAccelerationStructuresKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkBuildAccelerationStructuresKHR"));
     vkCreateAccelerationStructureKHR = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCreateAccelerationStructureKHR"));
     vkGetAccelerationStructureBuildSizesKHR = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetAccelerationStructureBuildSizesKHR"));
     vkGetAccelerationStructureDeviceAddressKHR = reinterpret_cast<PFN_vkGetAccelerationStructureDeviceAddressKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetAccelerationStructureDeviceAddressKHR"));
     vkDestroyAccelerationStructureKHR = reinterpret_cast<PFN_vkDestroyAccelerationStructureKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkDestroyAccelerationStructureKHR"));
 }
 
+int32_t BottomLevelAS::requestTexture(const std::string& filepath){
+    uint32_t slot = m_textureSlots.allocate();
+    m_requestedTextures.push_back(filepath);
+    m_requestedTextureSlots.push_back(slot);
+    return static_cast<int32_t>(slot);
+}
+
+void BottomLevelAS::loadRequestedTextures(Device* device){
+    std::vector<Texture::Image> images(m_requestedTextures.size());
+    if (device != nullptr) {
+        JobSystem::getDefault().parallelFor(0, static_cast<uint32_t>(images.size()), 1, [&](uint32_t begin, uint32_t end){
+            for (uint32_t i = begin; i < end; i++) {
+                images[i] = Texture::decode(m_requestedTextures[i]);
+            }
+        });
+    }
+    for (size_t i = 0; i < m_requestedTextures.size(); i++) {
+        m_textures.push_back(Texture(device, m_requestedTextures[i], VK_FORMAT_R8G8B8A8_SRGB, images[i]));
+        m_textureSlotIds.push_back(m_requestedTextureSlots[i]);
+    }
+    m_requestedTextures.clear();
+    m_requestedTextureSlots.clear();
+}
+
 uint32_t BottomLevelAS::getId() const{
     return m_id;
 }
 
+void BottomLevelAS::setInstanceTransforms(std::vector<glm::mat4> transforms){
+    m_instanceTransforms = std::move(transforms);
+}
+
+const std::vector<glm::mat4>& BottomLevelAS::getInstanceTransforms() const{
+    return m_instanceTransforms;
+}
+
 VkDeviceAddress BottomLevelAS::getDeviceAdress() const{
     return m_deviceAddress;
 }
@@ -35,39 +76,156 @@ void BottomLevelAS::createMaterialBuffer(Device* device){
     m_materialBuffer.unmap();
 }
 
+void BottomLevelAS::setProfiler(Profiler* profiler){
+    m_profiler = profiler;
+}
+
 VkDescriptorBufferInfo* BottomLevelAS::getMaterialBufferDescriptor(){
     m_materialBufferDescriptor = m_materialBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0);
     return &m_materialBufferDescriptor; 
 }
 
-VkDescriptorImageInfo* BottomLevelAS::getTextureDescriptors(){
-    std::vector<VkDescriptorImageInfo>	descriptorImageInfos(m_textures.size());
+// Die Textur ID in den Materialien ist der beim Anfordern vergebene Slot im Texture Array
+void BottomLevelAS::writeTextureDescriptors(BindlessDescriptors& descriptors){
     for (size_t i = 0; i < m_textures.size(); i++)
     {
-        descriptorImageInfos[i] = m_textures[i].getDescriptorInfo();
+        descriptors.writeImage(BindlessDescriptors::TableTextures, m_textureSlotIds[i], m_textures[i].getDescriptorInfo());
     }
-    m_textureDescriptors = descriptorImageInfos;
-    return m_textureDescriptors.data();
 }
 
+// Obergrenze der Textur IDs, freie Slots darunter sind möglich
 uint32_t BottomLevelAS::getTextureCount(){
-    return static_cast<uint32_t>(m_textures.size());
+    return m_textureSlots.getHighWater();
+}
+
+const std::vector<Material>& BottomLevelAS::getMaterials(){
+    return m_materials;
+}
+
+// Index entspricht der Textur ID in den Materialien, freie Slots bleiben leer
+std::vector<std::string> BottomLevelAS::getTexturePaths(){
+    std::vector<std::string> paths(m_textureSlots.getHighWater());
+    for (size_t i = 0; i < m_textures.size(); i++) {
+        paths[m_textureSlotIds[i]] = m_textures[i].getFilepath();
+    }
+    return paths;
 }
 
 void BottomLevelAS::destroyTextures(){
-    for(Texture texture : m_textures){
-        texture.destroy();
+    for (size_t i = 0; i < m_textures.size(); i++) {
+        m_textures[i].destroy();
+        m_textureSlots.free(m_textureSlotIds[i]);
     }
+    m_textures.clear();
+    m_textureSlotIds.clear();
 }
 
 void BottomLevelAS::destroyMaterials(){
     m_materialBuffer.destroy();
 }
 
-VkCommandBuffer BottomLevelAS::createCommandBuffer(VkCommandBufferLevel level, bool begin){
+void BottomLevelAS::bufferBarrier(VkCommandBuffer command_buffer, std::vector<VkBuffer> buffers, uint32_t srcQueueFamily, uint32_t dstQueueFamily, VkPipelineStageFlags srcMask, VkAccessFlags srcAccess, VkPipelineStageFlags dstMask, VkAccessFlags dstAccess){
+    std::vector<VkBufferMemoryBarrier> barriers(buffers.size());
+    for (size_t i = 0; i < buffers.size(); i++)
+    {
+        barriers[i].sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barriers[i].srcAccessMask       = srcAccess;
+        barriers[i].dstAccessMask       = dstAccess;
+        barriers[i].srcQueueFamilyIndex = srcQueueFamily;
+        barriers[i].dstQueueFamilyIndex = dstQueueFamily;
+        barriers[i].buffer              = buffers[i];
+        barriers[i].offset              = 0;
+        barriers[i].size                = VK_WHOLE_SIZE;
+    }
+    vkCmdPipelineBarrier(command_buffer, srcMask, dstMask, 0, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data(), 0, nullptr);
+}
+
+Buffer BottomLevelAS::uploadBuffer(void* data, VkDeviceSize size, VkBufferUsageFlags usage){
+    Buffer stagingBuffer = Buffer(m_device, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    stagingBuffer.map(size, 0);
+    stagingBuffer.copyTo(data, size);
+    stagingBuffer.unmap();
+
+    Buffer buffer = Buffer(m_device, size, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    VkCommandBuffer command_buffer = createCommandBuffer(m_device->getTransferCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+    VkBufferCopy region{};
+    region.size = size;
+    vkCmdCopyBuffer(command_buffer, stagingBuffer.getHandle(), buffer.getHandle(), 1, &region);
+    // Release an die Compute Queue, das Acquire passiert vor dem Bau
+    if (m_device->getTransferQueueFamily() != m_device->getComputeQueueFamily())
+    {
+        bufferBarrier(command_buffer, {buffer.getHandle()}, m_device->getTransferQueueFamily(), m_device->getComputeQueueFamily(), VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    }
+    m_uploadValue = m_device->submitAsync(Device::QueueTransfer, command_buffer);
+    m_device->deferRelease(Device::QueueTransfer, m_uploadValue, [stagingBuffer]() mutable {
+        stagingBuffer.destroy();
+    });
+    return buffer;
+}
+
+void BottomLevelAS::buildOnComputeQueue(VkAccelerationStructureBuildGeometryInfoKHR &buildGeometryInfo, const VkAccelerationStructureBuildRangeInfoKHR* const* buildRangeInfos, std::vector<VkBuffer> inputBuffers, std::vector<Buffer> transientBuffers){
+    uint32_t transferFamily = m_device->getTransferQueueFamily();
+    uint32_t computeFamily = m_device->getComputeQueueFamily();
+    uint32_t graphicsFamily = m_device->getGraphicsQueueFamily();
+
+    // Alle asynchronen Builds teilen sich einen Slot, zurückgesetzt wird er erst nach dem Auslesen
+    Profiler* profiler = (m_profiler && m_profiler->supports(computeFamily)) ? m_profiler : nullptr;
+    uint32_t profilerSlot = profiler ? profiler->getAsyncSlot() : 0;
+
+    VkCommandBuffer command_buffer = createCommandBuffer(m_device->getComputeCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+    if (profiler && !profiler->isPending(profilerSlot))
+    {
+        profiler->reset(command_buffer, profilerSlot, computeFamily);
+    }
+    bufferBarrier(command_buffer, inputBuffers, transferFamily, computeFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_SHADER_READ_BIT);
+    {
+        ProfilerScope scope(profiler, command_buffer, profilerSlot, "blas build");
+        vkCmdBuildAccelerationStructuresKHR(command_buffer, 1, &buildGeometryInfo, buildRangeInfos);
+    }
+
+    // Geometrie und BLAS werden danach vom TLAS Bau und den Shadern auf der Graphics Queue gelesen
+    std::vector<VkBuffer> sharedBuffers = inputBuffers;
+    sharedBuffers.push_back(m_accelerationStructureBuffer.getHandle());
+    const VkPipelineStageFlags consumerStages = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR | VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+    const VkAccessFlags consumerAccess = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+    if (computeFamily != graphicsFamily)
+    {
+        bufferBarrier(command_buffer, sharedBuffers, computeFamily, graphicsFamily, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+    }else{
+        bufferBarrier(command_buffer, sharedBuffers, computeFamily, graphicsFamily, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, consumerStages, consumerAccess);
+    }
+    uint64_t buildValue = m_device->submitAsync(Device::QueueCompute, command_buffer, {{Device::QueueTransfer, m_uploadValue, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR}});
+    m_device->deferRelease(Device::QueueCompute, buildValue, [transientBuffers]() mutable {
+        for (Buffer& buffer : transientBuffers) {
+            buffer.destroy();
+        }
+    });
+    if (profiler)
+    {
+        profiler->markSubmitted(profilerSlot);
+        m_profiledBuild = buildValue;
+        // Erst der letzte Build liest den Slot aus, vorher sind seine Marker noch nicht geschrieben
+        m_device->deferRelease(Device::QueueCompute, buildValue, [profiler, profilerSlot, buildValue](){
+            if (buildValue == m_profiledBuild) {
+                profiler->collect(profilerSlot);
+            }
+        });
+    }
+
+    // Acquire auf der Graphics Queue, die per Timeline auf den Build wartet. Spätere Graphics Submits sind dahinter eingereiht
+    if (computeFamily != graphicsFamily)
+    {
+        command_buffer = createCommandBuffer(m_device->getCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+        bufferBarrier(command_buffer, sharedBuffers, computeFamily, graphicsFamily, consumerStages, 0, consumerStages, consumerAccess);
+        m_device->submitAsync(Device::QueueGraphics, command_buffer, {{Device::QueueCompute, buildValue, consumerStages}});
+    }
+}
+
+VkCommandBuffer BottomLevelAS::createCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level, bool begin){
     VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
     cmdBufAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    cmdBufAllocateInfo.commandPool        = m_device->getCommandPool();
+    cmdBufAllocateInfo.commandPool        = commandPool;
     cmdBufAllocateInfo.level              = level;
     cmdBufAllocateInfo.commandBufferCount = 1;
 
@@ -84,39 +242,3 @@ VkCommandBuffer BottomLevelAS::createCommandBuffer(VkCommandBufferLevel level, b
 
     return command_buffer;
 }
-
-void BottomLevelAS::flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue, bool free, VkSemaphore signalSemaphore){
-    if (command_buffer == VK_NULL_HANDLE)
-    {
-        return;
-    }
-
-    if(vkEndCommandBuffer(command_buffer) != VK_SUCCESS)
-        throw std::runtime_error("failed to flush command buffer!");
-
-    VkSubmitInfo submit_info{};
-    submit_info.sType              = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submit_info.commandBufferCount = 1;
-    submit_info.pCommandBuffers    = &command_buffer;
-    if (signalSemaphore)
-    {
-        submit_info.pSignalSemaphores    = &signalSemaphore;
-        submit_info.signalSemaphoreCount = 1;
-    }
-
-    VkFenceCreateInfo fence_info{};
-    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fence_info.flags = VK_FLAGS_NONE;
-
-    VkFence fence;
-    if(vkCreateFence(m_device->getHandle(), &fence_info, nullptr, &fence) != VK_SUCCESS)
-        throw std::runtime_error("failed to create Fence while flushing command buffer!");
-
-    VkResult result = vkQueueSubmit(queue, 1, &submit_info, fence);
-    if(vkWaitForFences(m_device->getHandle(), 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT) != VK_SUCCESS)
-        throw std::runtime_error("failed to wait for the fence to signal that command buffer has finished executing!");
-
-    vkDestroyFence(m_device->getHandle(), fence, nullptr);
-
-    vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), 1, &command_buffer);
-}
\ No newline at end of file
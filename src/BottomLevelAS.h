@@ -3,16 +3,22 @@
 #include <tiny_obj_loader.h>
 #include "Device.h"
 #include "Texture.h"
+#include "Profiler.h"
+#include "BindlessDescriptors.h"
+#include "SlotAllocator.h"
 #include "GlobalDefs.h"
 
 class BottomLevelAS
 {
 protected:
-    VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin);
-    void flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue, bool free = true, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+    VkCommandBuffer createCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level, bool begin);
+    void bufferBarrier(VkCommandBuffer command_buffer, std::vector<VkBuffer> buffers, uint32_t srcQueueFamily, uint32_t dstQueueFamily, VkPipelineStageFlags srcMask, VkAccessFlags srcAccess, VkPipelineStageFlags dstMask, VkAccessFlags dstAccess);
+    // Kehrt ohne Host Wait zurück, der Bau wartet über die Transfer Timeline auf den letzten Upload
+    Buffer uploadBuffer(void* data, VkDeviceSize size, VkBufferUsageFlags usage);
+    // transientBuffers (z.B. Scratch) werden freigegeben, sobald der Bau auf der GPU abgeschlossen ist
+    void buildOnComputeQueue(VkAccelerationStructureBuildGeometryInfoKHR &buildGeometryInfo, const VkAccelerationStructureBuildRangeInfoKHR* const* buildRangeInfos, std::vector<VkBuffer> inputBuffers, std::vector<Buffer> transientBuffers);
     BottomLevelAS(Device* device, std::string name, uint32_t id);
     PFN_vkCmdBuildAccelerationStructuresKHR  vkCmdBuildAccelerationStructuresKHR;            
-    PFN_vkBuildAccelerationStructuresKHR vkBuildAccelerationStructuresKHR;                     
     PFN_vkCreateAccelerationStructureKHR vkCreateAccelerationStructureKHR;                     
     PFN_vkGetAccelerationStructureBuildSizesKHR vkGetAccelerationStructureBuildSizesKHR;       
     PFN_vkGetAccelerationStructureDeviceAddressKHR vkGetAccelerationStructureDeviceAddressKHR;
@@ -20,8 +26,20 @@ protected:
     static std::vector<Material> m_materials;
     static Buffer m_materialBuffer;
     static std::vector<Texture> m_textures;
-    static std::vector<VkDescriptorImageInfo> m_textureDescriptors;
+    // Slot im Texture Array pro Eintrag in m_textures, entspricht der Textur ID in den Materialien
+    static std::vector<uint32_t> m_textureSlotIds;
+    static SlotAllocator m_textureSlots;
     static VkDescriptorBufferInfo m_materialBufferDescriptor;
+    static Profiler* m_profiler;
+    static uint64_t m_profiledBuild;
+    uint64_t m_uploadValue = 0;
+    std::vector<glm::mat4> m_instanceTransforms;
+    static std::vector<std::string> m_requestedTextures;
+    static std::vector<uint32_t> m_requestedTextureSlots;
+    // Merkt die Textur vor und liefert ihre spätere ID, geladen wird gesammelt über loadRequestedTextures
+    static int32_t requestTexture(const std::string& filepath);
+    // Dekodiert alle vorgemerkten Texturen parallel, hochgeladen wird danach der Reihe nach auf diesem Thread
+    static void loadRequestedTextures(Device* device);
 public:
     Device* m_device;
     std::string m_name;
@@ -30,13 +48,21 @@ public:
     VkDeviceAddress m_deviceAddress;
     VkAccelerationStructureKHR  m_handle = VK_NULL_HANDLE;
     uint32_t getId() const;
+    // Eine TLAS Instanz pro Eintrag, jeweils vor der Szenen Transformation angewendet. Standard ist eine Instanz ohne Transformation
+    void setInstanceTransforms(std::vector<glm::mat4> transforms);
+    const std::vector<glm::mat4>& getInstanceTransforms() const;
     VkDeviceAddress getDeviceAdress() const;
     static void createMaterialBuffer(Device* device);
+    static void setProfiler(Profiler* profiler);
     static VkDescriptorBufferInfo* getMaterialBufferDescriptor(); 
-    static VkDescriptorImageInfo* getTextureDescriptors(); 
+    static void writeTextureDescriptors(BindlessDescriptors& descriptors);
     static uint32_t getTextureCount();
+    static const std::vector<Material>& getMaterials();
+    static std::vector<std::string> getTexturePaths();
     static void destroyTextures();
     static void destroyMaterials();
+    virtual uint32_t getHitGroup() const = 0;
+    virtual void writeDescriptors(BindlessDescriptors& descriptors) = 0;
     virtual void create() = 0;
     virtual void destroy() = 0;
 };
\ No newline at end of file
@@ -1,17 +1,14 @@
 #include "BottomLevelSphereAS.h"
+#include "MaterialClassifier.h"
+#include "JobSystem.h"
 
-uint32_t BottomLevelSphereAS::m_count = 0;
-std::vector<VkDescriptorBufferInfo> BottomLevelSphereAS::m_sphereBufferDescriptors;
+SlotAllocator BottomLevelSphereAS::m_slots = SlotAllocator(BindlessDescriptors::MaxGeometries);
 
-BottomLevelSphereAS::BottomLevelSphereAS(Device* device, std::string name) : BottomLevelAS(device, name, m_count){
-    m_count++;
-}
+BottomLevelSphereAS::BottomLevelSphereAS(Device* device, std::string name) : BottomLevelAS(device, name, m_slots.allocate()){
 
-VkDescriptorBufferInfo* BottomLevelSphereAS::getSphereBufferDescriptors(){
-    return m_sphereBufferDescriptors.data();
 }
 
-void BottomLevelSphereAS::createSphere(Sphere &sphere, tinyobj::material_t &material_in){
+uint32_t BottomLevelSphereAS::createMaterial(tinyobj::material_t &material_in){
     uint32_t materialOffset = static_cast<uint32_t>(m_materials.size());
 
     Material material{};
@@ -25,130 +22,113 @@ void BottomLevelSphereAS::createSphere(Sphere &sphere, tinyobj::material_t &mate
     material.dissolve = material_in.dissolve;                // 1 == opaque; 0 == fully transparent
     material.illum = material_in.illum;                   // Beleuchtungsmodell
     if(material_in.ambient_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.ambient_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.ambientTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ka
+        material.ambientTexId = requestTexture(material_in.ambient_texname);            // map_Ka
     }else{
         material.ambientTexId = -1;
     }
     if(material_in.diffuse_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.diffuse_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.diffuseTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Kd
+        material.diffuseTexId = requestTexture(material_in.diffuse_texname);            // map_Kd
     }else{
         material.diffuseTexId = -1;
     }
     if(material_in.specular_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.specular_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.specularTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ks
+        material.specularTexId = requestTexture(material_in.specular_texname);            // map_Ks
     }else{
         material.specularTexId = -1;
     }
     if(material_in.specular_highlight_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.specular_highlight_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.specularHighlightTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ns
+        material.specularHighlightTexId = requestTexture(material_in.specular_highlight_texname);            // map_Ns
     }else{
         material.specularHighlightTexId = -1;
     }
     if(material_in.bump_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.bump_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.bumpTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_bump, map_Bump, bump
+        material.bumpTexId = requestTexture(material_in.bump_texname);            // map_bump, map_Bump, bump
     }else{
         material.bumpTexId = -1;
     }
     if(material_in.displacement_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.displacement_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.displacementTexId = static_cast<uint32_t>(m_textures.size() - 1);            // disp
+        material.displacementTexId = requestTexture(material_in.displacement_texname);            // disp
     }else{
         material.displacementTexId = -1;
     }
     if(material_in.alpha_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.alpha_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.alphaTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_d
+        material.alphaTexId = requestTexture(material_in.alpha_texname);            // map_d
     }else{
         material.alphaTexId = -1;
     }
     if(material_in.reflection_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.reflection_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.reflectionTexId = static_cast<uint32_t>(m_textures.size() - 1);            // refl
+        material.reflectionTexId = requestTexture(material_in.reflection_texname);            // refl
     }else{
         material.reflectionTexId = -1;
     }
     m_materials.push_back(material);
+    loadRequestedTextures(m_device);
+    return materialOffset;
+}
 
-    sphere.matID = materialOffset;
-    m_spheres.push_back(sphere);
+void BottomLevelSphereAS::createSphere(Sphere &sphere, tinyobj::material_t &material_in){
+    sphere.matID = createMaterial(material_in);
+    m_centerRadius.push_back(glm::vec4(sphere.center[0], sphere.center[1], sphere.center[2], sphere.radius));
+    m_materialIndices.push_back(sphere.matID);
 }
 
 void BottomLevelSphereAS::createSpheres(std::vector<Sphere> &spheres, tinyobj::material_t &material_in){
-    uint32_t materialOffset = static_cast<uint32_t>(m_materials.size());
-
-    Material material{};
-    material.ambient[0] = material_in.ambient[0];               material.ambient[1] = material_in.ambient[1];               material.ambient[2] = material_in.ambient[2];
-    material.diffuse[0] = material_in.diffuse[0];               material.diffuse[1] = material_in.diffuse[1];               material.diffuse[2] = material_in.diffuse[2];
-    material.specular[0] = material_in.specular[0];             material.specular[1] = material_in.specular[1];             material.specular[2] = material_in.specular[2];
-    material.transmittance[0] = material_in.transmittance[0];   material.transmittance[1] = material_in.transmittance[1];   material.transmittance[2] = material_in.transmittance[2];
-    material.emission[0] = material_in.emission[0];             material.emission[1] = material_in.emission[1];             material.emission[2] = material_in.emission[2];
-    material.shininess = material_in.shininess;
-    material.ior = material_in.ior;                     // index of refraction
-    material.dissolve = material_in.dissolve;                // 1 == opaque; 0 == fully transparent
-    material.illum = material_in.illum;                   // Beleuchtungsmodell
-    if(material_in.ambient_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.ambient_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.ambientTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ka
-    }else{
-        material.ambientTexId = -1;
-    }
-    if(material_in.diffuse_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.diffuse_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.diffuseTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Kd
-    }else{
-        material.diffuseTexId = -1;
-    }
-    if(material_in.specular_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.specular_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.specularTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ks
-    }else{
-        material.specularTexId = -1;
-    }
-    if(material_in.specular_highlight_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.specular_highlight_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.specularHighlightTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ns
-    }else{
-        material.specularHighlightTexId = -1;
-    }
-    if(material_in.bump_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.bump_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.bumpTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_bump, map_Bump, bump
-    }else{
-        material.bumpTexId = -1;
-    }
-    if(material_in.displacement_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.displacement_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.displacementTexId = static_cast<uint32_t>(m_textures.size() - 1);            // disp
-    }else{
-        material.displacementTexId = -1;
-    }
-    if(material_in.alpha_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.alpha_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.alphaTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_d
-    }else{
-        material.alphaTexId = -1;
-    }
-    if(material_in.reflection_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.reflection_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.reflectionTexId = static_cast<uint32_t>(m_textures.size() - 1);            // refl
-    }else{
-        material.reflectionTexId = -1;
-    }
-    m_materials.push_back(material);
+    uint32_t materialOffset = createMaterial(material_in);
+    getStreams(spheres, static_cast<int32_t>(materialOffset), m_centerRadius, m_materialIndices);
+}
 
-    for(Sphere sphere : spheres){
-        sphere.matID = materialOffset;
-        m_spheres.push_back(sphere);
-    }
+// Die Kugeln werden in die Ströme aufgeteilt und der Puffer des Aufrufers sofort freigegeben, z.B. aus SphereFlake::takeSpheres
+void BottomLevelSphereAS::createSpheres(std::vector<Sphere> &&spheres, tinyobj::material_t &material_in){
+    createSpheres(spheres, material_in);
+    std::vector<Sphere>().swap(spheres);
 }
 
 uint32_t BottomLevelSphereAS::getCount(){
-    return m_count;
+    return m_slots.getHighWater();
+}
+
+std::vector<Sphere> BottomLevelSphereAS::getSpheres() const{
+    std::vector<Sphere> spheres(m_centerRadius.size());
+    for(size_t i = 0; i < spheres.size(); i++){
+        Sphere& sphere = spheres[i];
+        const glm::vec4& centerRadius = m_centerRadius[i];
+        for(int axis = 0; axis < 3; axis++){
+            sphere.center[axis] = centerRadius[axis];
+            sphere.aabbmin[axis] = centerRadius[axis] - centerRadius.w;
+            sphere.aabbmax[axis] = centerRadius[axis] + centerRadius.w;
+        }
+        sphere.radius = centerRadius.w;
+        sphere.matID = m_materialIndices[i];
+    }
+    return spheres;
+}
+
+void BottomLevelSphereAS::getStreams(const std::vector<Sphere>& spheres, int32_t materialIndex, std::vector<glm::vec4>& centerRadius, std::vector<int32_t>& materialIndices){
+    size_t first = centerRadius.size();
+    centerRadius.resize(first + spheres.size());
+    materialIndices.resize(first + spheres.size(), materialIndex);
+    JobSystem::getDefault().parallelFor(0, static_cast<uint32_t>(spheres.size()), 1 << 16, [&](uint32_t begin, uint32_t end){
+        for(uint32_t i = begin; i < end; i++){
+            const Sphere& sphere = spheres[i];
+            centerRadius[first + i] = glm::vec4(sphere.center[0], sphere.center[1], sphere.center[2], sphere.radius);
+        }
+    });
+}
+
+std::vector<VkAabbPositionsKHR> BottomLevelSphereAS::getAabbs(const std::vector<glm::vec4>& centerRadius){
+    std::vector<VkAabbPositionsKHR> aabbs(centerRadius.size());
+    JobSystem::getDefault().parallelFor(0, static_cast<uint32_t>(centerRadius.size()), 1 << 16, [&](uint32_t begin, uint32_t end){
+        for(uint32_t i = begin; i < end; i++){
+            const glm::vec4& sphere = centerRadius[i];
+            aabbs[i] = {sphere.x - sphere.w, sphere.y - sphere.w, sphere.z - sphere.w, sphere.x + sphere.w, sphere.y + sphere.w, sphere.z + sphere.w};
+        }
+    });
+    return aabbs;
+}
+
+// Kugeln haben eine eigene Hit Group direkt nach den Dreieck Varianten
+uint32_t BottomLevelSphereAS::getHitGroup() const{
+    return MaterialVariantCount;
 }
 
 void BottomLevelSphereAS::create(){
@@ -158,17 +138,17 @@ void BottomLevelSphereAS::create(){
         0.0f, 1.0f, 0.0f, 0.0f,
         0.0f, 0.0f, 1.0f, 0.0f
     };
-    uint32_t numSpheres = static_cast<uint32_t>(m_spheres.size());
-    auto sphereBufferSize = numSpheres * sizeof(Sphere);
+    uint32_t numSpheres = static_cast<uint32_t>(m_centerRadius.size());
     auto transformBufferSize = sizeof(transformMatrix);
 
     const VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     const VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    m_sphereBuffer = Buffer(m_device, sphereBufferSize, bufferUsageFlags, memoryPropertyFlags);
-    m_sphereBuffer.map(sphereBufferSize, 0);
-    m_sphereBuffer.copyTo(m_spheres.data(), sphereBufferSize);
-    m_sphereBuffer.unmap();
+    // Der AABB Strom wird nur für den Build gebraucht und danach freigegeben, die anderen Ströme gehen ohne Umweg hoch
+    std::vector<VkAabbPositionsKHR> aabbs = getAabbs(m_centerRadius);
+    Buffer aabbBuffer = uploadBuffer(aabbs.data(), aabbs.size() * sizeof(VkAabbPositionsKHR), VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT);
+    m_sphereBuffer = uploadBuffer(m_centerRadius.data(), m_centerRadius.size() * sizeof(glm::vec4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+    m_materialIndexBuffer = uploadBuffer(m_materialIndices.data(), m_materialIndices.size() * sizeof(int32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
 
     m_transformBuffer = Buffer(m_device, transformBufferSize, bufferUsageFlags, memoryPropertyFlags);
     m_transformBuffer.map(transformBufferSize, 0);
@@ -178,7 +158,7 @@ void BottomLevelSphereAS::create(){
     VkDeviceOrHostAddressConstKHR sphereDataDeviceAddress{};
     VkDeviceOrHostAddressConstKHR transformMatrixDeviceAddress{};
 
-    sphereDataDeviceAddress.deviceAddress      = m_sphereBuffer.getDeviceAddress();
+    sphereDataDeviceAddress.deviceAddress      = aabbBuffer.getDeviceAddress();
     transformMatrixDeviceAddress.deviceAddress = m_transformBuffer.getDeviceAddress();
 
     VkAccelerationStructureGeometryKHR accelerationStructureGeometry{};
@@ -187,7 +167,7 @@ void BottomLevelSphereAS::create(){
     accelerationStructureGeometry.flags                            = VK_GEOMETRY_OPAQUE_BIT_KHR;
     accelerationStructureGeometry.geometry.aabbs.sType             = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_AABBS_DATA_KHR;
     accelerationStructureGeometry.geometry.aabbs.data              = sphereDataDeviceAddress;
-    accelerationStructureGeometry.geometry.aabbs.stride            = sizeof(Sphere);
+    accelerationStructureGeometry.geometry.aabbs.stride            = sizeof(VkAabbPositionsKHR);
 
     VkAccelerationStructureBuildGeometryInfoKHR accelerationStructureBuildGeometryInfo{};
     accelerationStructureBuildGeometryInfo.sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
@@ -231,30 +211,28 @@ void BottomLevelSphereAS::create(){
     accelerationStructureBuildRangeInfo.transformOffset                                          = 0;
     std::vector<VkAccelerationStructureBuildRangeInfoKHR *> accelerationBuildStructureRangeInfos = {&accelerationStructureBuildRangeInfo};
 
-    if (m_device->supportsAccelerationStructureHostCommands())
-    {
-        vkBuildAccelerationStructuresKHR(m_device->getHandle(), VK_NULL_HANDLE, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
-    }else{
-        VkCommandBuffer command_buffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-        vkCmdBuildAccelerationStructuresKHR(command_buffer, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
-        flushCommandBuffer(command_buffer, m_device->getGraphicsQueue());
-        scratchBuffer.destroy();
-    }
+    // Immer auf der GPU: die Eingaben liegen device local und werden asynchron hochgeladen
+    buildOnComputeQueue(accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data(), {aabbBuffer.getHandle(), m_sphereBuffer.getHandle(), m_materialIndexBuffer.getHandle()}, {scratchBuffer, aabbBuffer});
 
     VkAccelerationStructureDeviceAddressInfoKHR accelerationDeviceAddressInfo{};
     accelerationDeviceAddressInfo.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
     accelerationDeviceAddressInfo.accelerationStructure = m_handle;
 
     m_deviceAddress = vkGetAccelerationStructureDeviceAddressKHR(m_device->getHandle(), &accelerationDeviceAddressInfo);
+}
 
-    m_sphereBufferDescriptors.push_back(m_sphereBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
+void BottomLevelSphereAS::writeDescriptors(BindlessDescriptors& descriptors){
+    descriptors.writeBuffer(BindlessDescriptors::TableSpheres, m_id, m_sphereBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
+    descriptors.writeBuffer(BindlessDescriptors::TableSphereMaterials, m_id, m_materialIndexBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
 }
 
 void BottomLevelSphereAS::destroy(){
     m_sphereBuffer.destroy();
+    m_materialIndexBuffer.destroy();
     m_transformBuffer.destroy();
     m_accelerationStructureBuffer.destroy();
     vkDestroyAccelerationStructureKHR(m_device->getHandle(), m_handle, nullptr);
+    m_slots.free(m_id);
 }
 
 BottomLevelSphereAS::~BottomLevelSphereAS(){
@@ -1,16 +1,17 @@
-#include "BottomLevelAS.h" 
+#include "BottomLevelAS.h"
+#include "SlotAllocator.h" 
 
 class BottomLevelSphereAS : public BottomLevelAS
 {
 private:
-    static uint32_t m_count;
-    std::vector<Sphere> m_spheres;
-    Buffer m_sphereBuffer;
+    static SlotAllocator m_slots;
+    std::vector<glm::vec4> m_centerRadius;     // CPU Kopie der beiden GPU Ströme, die AABBs entstehen erst beim Build
+    std::vector<int32_t> m_materialIndices;
+    Buffer m_sphereBuffer;              // vec4 Mittelpunkt und Radius pro Kugel
+    Buffer m_materialIndexBuffer;       // int32 Material pro Kugel
     Buffer m_transformBuffer;
-    static std::vector<VkDescriptorBufferInfo> m_sphereBufferDescriptors;
+    uint32_t createMaterial(tinyobj::material_t &material_in);
 public:
-    static VkDescriptorBufferInfo* getSphereBufferDescriptors();
-
     static uint32_t getCount();
 
     BottomLevelSphereAS(Device* device, std::string name);
@@ -19,6 +20,21 @@ public:
 
     void createSpheres(std::vector<Sphere> &spheres, tinyobj::material_t &material_in);
 
+    void createSpheres(std::vector<Sphere> &&spheres, tinyobj::material_t &material_in);
+
+    // Setzt die Kugeln aus den Strömen zusammen, nur für die CPU Pfade
+    std::vector<Sphere> getSpheres() const;
+
+    // Hängt spheres an die GPU Ströme an: Mittelpunkt und Radius für intersection.rint, Material für closesthitsphere.rchit.
+    // 20 statt 64 Byte pro Kugel, die übrigen Felder von Sphere werden nicht gespeichert
+    static void getStreams(const std::vector<Sphere>& spheres, int32_t materialIndex, std::vector<glm::vec4>& centerRadius, std::vector<int32_t>& materialIndices);
+    // AABB Strom nur für den Build, aus Mittelpunkt und Radius
+    static std::vector<VkAabbPositionsKHR> getAabbs(const std::vector<glm::vec4>& centerRadius);
+
+    uint32_t getHitGroup() const override;
+
+    void writeDescriptors(BindlessDescriptors& descriptors) override;
+
     void create() override;
 
     void destroy() override;
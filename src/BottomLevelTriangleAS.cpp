@@ -1,11 +1,14 @@
 #include "BottomLevelTriangleAS.h"
+#include <cmath>
+#include <numeric>
+#include "JobSystem.h"
+#include <glm/gtc/type_ptr.hpp>
 
-uint32_t BottomLevelTriangleAS::m_count = 0;
-std::vector<VkDescriptorBufferInfo> BottomLevelTriangleAS::m_vertexBufferDescriptors;
-std::vector<VkDescriptorBufferInfo> BottomLevelTriangleAS::m_indexBufferDescriptors;
+SlotAllocator BottomLevelTriangleAS::m_slots = SlotAllocator(BindlessDescriptors::MaxGeometries);
+
+// Die ID ist der Slot in den Vertex und Index Arrays und wird als instanceCustomIndex verwendet
+BottomLevelTriangleAS::BottomLevelTriangleAS(Device* device, std::string name) : BottomLevelAS(device, name, m_slots.allocate()){
 
-BottomLevelTriangleAS::BottomLevelTriangleAS(Device* device, std::string name) : BottomLevelAS(device, name, m_count){
-    m_count++;
 }
 
 void BottomLevelTriangleAS::uploadData(std::string path){
@@ -50,112 +53,57 @@ void BottomLevelTriangleAS::uploadData(std::string path){
         if(objMaterial.ambient_texname.length() != 0 ){
             std::string base_filename = objMaterial.ambient_texname.substr(objMaterial.ambient_texname.find_last_of("/\\") + 1);
             std::string texturepath = "/"+modelname+"/"+base_filename;
-            m_textures.push_back(Texture(m_device, texturepath, VK_FORMAT_R8G8B8A8_SRGB));
-            material.ambientTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ka
+            material.ambientTexId = requestTexture(texturepath);            // map_Ka
         }else{
             material.ambientTexId = -1;
         }
         if(objMaterial.diffuse_texname.length() != 0 ){
             std::string base_filename = objMaterial.diffuse_texname.substr(objMaterial.diffuse_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.diffuseTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Kd
+            material.diffuseTexId = requestTexture("/"+modelname+"/"+base_filename);            // map_Kd
         }else{
             material.diffuseTexId = -1;
         }
         if(objMaterial.specular_texname.length() != 0 ){
             std::string base_filename = objMaterial.specular_texname.substr(objMaterial.specular_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.specularTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ks
+            material.specularTexId = requestTexture("/"+modelname+"/"+base_filename);            // map_Ks
         }else{
             material.specularTexId = -1;
         }
         if(objMaterial.specular_highlight_texname.length() != 0 ){
             std::string base_filename = objMaterial.specular_highlight_texname.substr(objMaterial.specular_highlight_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.specularHighlightTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ns
+            material.specularHighlightTexId = requestTexture("/"+modelname+"/"+base_filename);            // map_Ns
         }else{
             material.specularHighlightTexId = -1;
         }
         if(objMaterial.bump_texname.length() != 0 ){
             std::string base_filename = objMaterial.bump_texname.substr(objMaterial.bump_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.bumpTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_bump, map_Bump, bump
+            material.bumpTexId = requestTexture("/"+modelname+"/"+base_filename);            // map_bump, map_Bump, bump
         }else{
             material.bumpTexId = -1;
         }
         if(objMaterial.displacement_texname.length() != 0 ){
             std::string base_filename = objMaterial.displacement_texname.substr(objMaterial.displacement_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.displacementTexId = static_cast<uint32_t>(m_textures.size() - 1);            // disp
+            material.displacementTexId = requestTexture("/"+modelname+"/"+base_filename);            // disp
         }else{
             material.displacementTexId = -1;
         }
         if(objMaterial.alpha_texname.length() != 0 ){
             std::string base_filename = objMaterial.alpha_texname.substr(objMaterial.alpha_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.alphaTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_d
+            material.alphaTexId = requestTexture("/"+modelname+"/"+base_filename);            // map_d
         }else{
             material.alphaTexId = -1;
         }
         if(objMaterial.reflection_texname.length() != 0 ){
             std::string base_filename = objMaterial.reflection_texname.substr(objMaterial.reflection_texname.find_last_of("/\\") + 1);
-            m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-            material.reflectionTexId = static_cast<uint32_t>(m_textures.size() - 1);            // refl
+            material.reflectionTexId = requestTexture("/"+modelname+"/"+base_filename);            // refl
         }else{
             material.reflectionTexId = -1;
         }
         m_materials.push_back(material);
     }
+    loadRequestedTextures(m_device);
 
-    uint32_t current_index = 0; 
-    bool hasNormals = attrib.normals.size() > 0;
-    bool hasUVs = attrib.texcoords.size() > 0;
-    glm::vec3 tempNormal;
-
-    for (size_t s = 0; s < shapes.size(); s++) {
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-            int fv = shapes[s].mesh.num_face_vertices[f];
-            int matID = shapes[s].mesh.material_ids[f];
-            if(!hasNormals){
-                tinyobj::index_t index = shapes[s].mesh.indices[index_offset];
-                glm::vec3 v0 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
-                index = shapes[s].mesh.indices[index_offset + 1];
-                glm::vec3 v1 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
-                index = shapes[s].mesh.indices[index_offset + 2];
-                glm::vec3 v2 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
-                tempNormal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-            }
-            for (size_t v = 0; v < fv; v++) {
-                tinyobj::index_t index = shapes[s].mesh.indices[index_offset + v];
-                Vertex vertex{};
-                vertex.matID = materialOffset + matID;
-                vertex.position[0] = attrib.vertices[3 * index.vertex_index + 0];
-                vertex.position[1] = attrib.vertices[3 * index.vertex_index + 1];
-                vertex.position[2] = attrib.vertices[3 * index.vertex_index + 2];
-                if(hasNormals){
-                    vertex.normal[0] = attrib.normals[3 * index.normal_index + 0];
-                    vertex.normal[1] = attrib.normals[3 * index.normal_index + 1];
-                    vertex.normal[2] = attrib.normals[3 * index.normal_index + 2];
-                }else{
-                    vertex.normal[0] = tempNormal.x;
-                    vertex.normal[1] = tempNormal.y;
-                    vertex.normal[2] = tempNormal.z;
-                }
-                if(hasUVs){
-                    vertex.texture[0] = attrib.texcoords[2 * index.texcoord_index + 0];
-                    vertex.texture[1] = 1.0f - attrib.texcoords[2 * index.texcoord_index + 1];
-                }else{
-                    vertex.texture[0] = 0;
-                    vertex.texture[1] = 0;
-                }
-                m_vertices.push_back(vertex);
-                m_indices.push_back(current_index);
-                current_index++;
-            }
-            index_offset += fv;
-        }
-    }
+    appendShapes(attrib, shapes, materialOffset, true);
 }
 
 void BottomLevelTriangleAS::uploadData(std::string path, tinyobj::material_t &material_in){
@@ -193,108 +141,184 @@ void BottomLevelTriangleAS::uploadData(std::string path, tinyobj::material_t &ma
     material.dissolve = material_in.dissolve;                // 1 == opaque; 0 == fully transparent
     material.illum = material_in.illum;                   // Beleuchtungsmodell
     if(material_in.ambient_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.ambient_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.ambientTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ka
+        material.ambientTexId = requestTexture(material_in.ambient_texname);            // map_Ka
     }else{
         material.ambientTexId = -1;
     }
     if(material_in.diffuse_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.diffuse_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.diffuseTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Kd
+        material.diffuseTexId = requestTexture(material_in.diffuse_texname);            // map_Kd
     }else{
         material.diffuseTexId = -1;
     }
     if(material_in.specular_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.specular_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.specularTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ks
+        material.specularTexId = requestTexture(material_in.specular_texname);            // map_Ks
     }else{
         material.specularTexId = -1;
     }
     if(material_in.specular_highlight_texname.length() != 0 ){
         std::string base_filename = material_in.specular_highlight_texname.substr(material_in.specular_highlight_texname.find_last_of("/\\") + 1);
-        m_textures.push_back(Texture(m_device, "/"+modelname+"/"+base_filename, VK_FORMAT_R8G8B8A8_SRGB));
-        material.specularHighlightTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_Ns
+        material.specularHighlightTexId = requestTexture("/"+modelname+"/"+base_filename);            // map_Ns
     }else{
         material.specularHighlightTexId = -1;
     }
     if(material_in.bump_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.bump_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.bumpTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_bump, map_Bump, bump
+        material.bumpTexId = requestTexture(material_in.bump_texname);            // map_bump, map_Bump, bump
     }else{
         material.bumpTexId = -1;
     }
     if(material_in.displacement_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.displacement_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.displacementTexId = static_cast<uint32_t>(m_textures.size() - 1);            // disp
+        material.displacementTexId = requestTexture(material_in.displacement_texname);            // disp
     }else{
         material.displacementTexId = -1;
     }
     if(material_in.alpha_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.alpha_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.alphaTexId = static_cast<uint32_t>(m_textures.size() - 1);            // map_d
+        material.alphaTexId = requestTexture(material_in.alpha_texname);            // map_d
     }else{
         material.alphaTexId = -1;
     }
     if(material_in.reflection_texname.length() != 0 ){
-        m_textures.push_back(Texture(m_device, material_in.reflection_texname, VK_FORMAT_R8G8B8A8_SRGB));
-        material.reflectionTexId = static_cast<uint32_t>(m_textures.size() - 1);            // refl
+        material.reflectionTexId = requestTexture(material_in.reflection_texname);            // refl
     }else{
         material.reflectionTexId = -1;
     }
     m_materials.push_back(material);
+    loadRequestedTextures(m_device);
+
+    appendShapes(attrib, shapes, materialOffset, false);
+}
 
-    uint32_t current_index = 0; 
+// Jede Ecke wird ein eigener Vertex mit fortlaufendem Index. Die Startposition jeder Shape steht über die Anzahl
+// ihrer Ecken vorher fest, deshalb werden die Shapes als Jobs parallel umgewandelt. objMaterials: matID aus der OBJ
+void BottomLevelTriangleAS::appendShapes(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, uint32_t materialOffset, bool objMaterials){
     bool hasNormals = attrib.normals.size() > 0;
     bool hasUVs = attrib.texcoords.size() > 0;
-    glm::vec3 tempNormal;
-
+    size_t base = m_vertices.size();
+    std::vector<size_t> shapeOffsets(shapes.size() + 1, base);
     for (size_t s = 0; s < shapes.size(); s++) {
-        size_t index_offset = 0;
-        for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
-            int fv = shapes[s].mesh.num_face_vertices[f];
-            int matID = shapes[s].mesh.material_ids[f];
-            if(!hasNormals){
-                tinyobj::index_t index = shapes[s].mesh.indices[index_offset];
-                glm::vec3 v0 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
-                index = shapes[s].mesh.indices[index_offset + 1];
-                glm::vec3 v1 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
-                index = shapes[s].mesh.indices[index_offset + 2];
-                glm::vec3 v2 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
-                tempNormal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
-            }
-            for (size_t v = 0; v < fv; v++) {
-                tinyobj::index_t index = shapes[s].mesh.indices[index_offset + v];
-                Vertex vertex{};
-                vertex.matID = materialOffset;
-                vertex.position[0] = attrib.vertices[3 * index.vertex_index + 0];
-                vertex.position[1] = attrib.vertices[3 * index.vertex_index + 1];
-                vertex.position[2] = attrib.vertices[3 * index.vertex_index + 2];
-                if(hasNormals){
-                    vertex.normal[0] = attrib.normals[3 * index.normal_index + 0];
-                    vertex.normal[1] = attrib.normals[3 * index.normal_index + 1];
-                    vertex.normal[2] = attrib.normals[3 * index.normal_index + 2];
-                }else{
-                    vertex.normal[0] = tempNormal.x;
-                    vertex.normal[1] = tempNormal.y;
-                    vertex.normal[2] = tempNormal.z;
+        shapeOffsets[s + 1] = shapeOffsets[s] + shapes[s].mesh.indices.size();
+    }
+    m_vertices.resize(shapeOffsets.back());
+    m_indices.resize(shapeOffsets.back());
+
+    JobSystem::getDefault().parallelFor(0, static_cast<uint32_t>(shapes.size()), 1, [&](uint32_t begin, uint32_t end){
+        for (uint32_t s = begin; s < end; s++) {
+            size_t index_offset = 0;
+            glm::vec3 tempNormal;
+            for (size_t f = 0; f < shapes[s].mesh.num_face_vertices.size(); f++) {
+                int fv = shapes[s].mesh.num_face_vertices[f];
+                int matID = shapes[s].mesh.material_ids[f];
+                if(!hasNormals){
+                    tinyobj::index_t index = shapes[s].mesh.indices[index_offset];
+                    glm::vec3 v0 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
+                    index = shapes[s].mesh.indices[index_offset + 1];
+                    glm::vec3 v1 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
+                    index = shapes[s].mesh.indices[index_offset + 2];
+                    glm::vec3 v2 = glm::vec3(attrib.vertices[3 * index.vertex_index + 0], attrib.vertices[3 * index.vertex_index + 1],  attrib.vertices[3 * index.vertex_index + 2]);
+                    tempNormal = glm::normalize(glm::cross(v1 - v0, v2 - v0));
                 }
-                if(hasUVs){
-                    vertex.texture[0] = attrib.texcoords[2 * index.texcoord_index + 0];
-                    vertex.texture[1] = 1.0f - attrib.texcoords[2 * index.texcoord_index + 1];
-                }else{
-                    vertex.texture[0] = 0;
-                    vertex.texture[1] = 0;
+                for (size_t v = 0; v < fv; v++) {
+                    tinyobj::index_t index = shapes[s].mesh.indices[index_offset + v];
+                    Vertex vertex{};
+                    vertex.matID = objMaterials ? materialOffset + matID : materialOffset;
+                    vertex.position[0] = attrib.vertices[3 * index.vertex_index + 0];
+                    vertex.position[1] = attrib.vertices[3 * index.vertex_index + 1];
+                    vertex.position[2] = attrib.vertices[3 * index.vertex_index + 2];
+                    if(hasNormals){
+                        vertex.normal[0] = attrib.normals[3 * index.normal_index + 0];
+                        vertex.normal[1] = attrib.normals[3 * index.normal_index + 1];
+                        vertex.normal[2] = attrib.normals[3 * index.normal_index + 2];
+                    }else{
+                        vertex.normal[0] = tempNormal.x;
+                        vertex.normal[1] = tempNormal.y;
+                        vertex.normal[2] = tempNormal.z;
+                    }
+                    if(hasUVs){
+                        vertex.texture[0] = attrib.texcoords[2 * index.texcoord_index + 0];
+                        vertex.texture[1] = 1.0f - attrib.texcoords[2 * index.texcoord_index + 1];
+                    }else{
+                        vertex.texture[0] = 0;
+                        vertex.texture[1] = 0;
+                    }
+                    size_t current_index = shapeOffsets[s] + index_offset + v;
+                    m_vertices[current_index] = vertex;
+                    m_indices[current_index] = static_cast<uint32_t>(current_index);
                 }
-                m_vertices.push_back(vertex);
-                m_indices.push_back(current_index);
-                current_index++;
+                index_offset += fv;
             }
-            index_offset += fv;
         }
+    });
+}
+
+// Teilt die Dreiecke nach Materialvariante auf, damit jede Instanz über ihren SBT Offset einen Hit Shader ohne
+// Materialverzweigungen bekommt. Dieses Objekt behält die erste vorkommende Variante, für die weiteren entstehen neue BLAS
+std::vector<BottomLevelTriangleAS*> BottomLevelTriangleAS::splitByVariant(){
+    std::vector<std::vector<Vertex>> buckets(MaterialVariantCount);
+    for (size_t i = 0; i + 2 < m_vertices.size(); i += 3) {
+        int matID = m_vertices[i].matID;
+        MaterialVariant variant = (matID >= 0 && matID < static_cast<int>(m_materials.size())) ? MaterialClassifier::classify(m_materials[matID]) : MaterialVariantDiffuse;
+        buckets[variant].insert(buckets[variant].end(), m_vertices.begin() + i, m_vertices.begin() + i + 3);
+    }
+
+    std::vector<BottomLevelTriangleAS*> parts;
+    for (uint32_t variant = 0; variant < MaterialVariantCount; variant++) {
+        if (buckets[variant].empty()) {
+            continue;
+        }
+        BottomLevelTriangleAS* part = parts.empty() ? this : new BottomLevelTriangleAS(m_device, m_name + "_" + MaterialClassifier::getName(static_cast<MaterialVariant>(variant)));
+        part->m_variant = static_cast<MaterialVariant>(variant);
+        part->m_instanceTransforms = m_instanceTransforms;
+        part->m_vertices = std::move(buckets[variant]);
+        part->m_indices = std::vector<uint32_t>(part->m_vertices.size());
+        std::iota(part->m_indices.begin(), part->m_indices.end(), 0);
+        parts.push_back(part);
+    }
+    return parts;
+}
+
+MaterialVariant BottomLevelTriangleAS::getVariant() const{
+    return m_variant;
+}
+
+const std::vector<Vertex>& BottomLevelTriangleAS::getVertices() const{
+    return m_vertices;
+}
+
+const std::vector<uint32_t>& BottomLevelTriangleAS::getIndices() const{
+    return m_indices;
+}
+
+uint32_t BottomLevelTriangleAS::getHitGroup() const{
+    return m_variant;
+}
+
+// Texturunabhängiger Teil des Ray Cone LOD, degenerierte Dreiecke bekommen 0
+float BottomLevelTriangleAS::getTriangleLod(const Vertex& v0, const Vertex& v1, const Vertex& v2){
+    glm::vec3 p0 = glm::make_vec3(v0.position);
+    glm::vec2 t0 = glm::make_vec2(v0.texture);
+    float worldArea = glm::length(glm::cross(glm::make_vec3(v1.position) - p0, glm::make_vec3(v2.position) - p0));
+    glm::vec2 e1 = glm::make_vec2(v1.texture) - t0;
+    glm::vec2 e2 = glm::make_vec2(v2.texture) - t0;
+    float uvArea = std::abs(e1.x * e2.y - e2.x * e1.y);
+    if (worldArea <= 0.0f || uvArea <= 0.0f) {
+        return 0.0f;
+    }
+    return 0.5f * std::log2(uvArea / worldArea);
+}
+
+// Die Ecken eines Dreiecks werden nicht mit anderen Dreiecken geteilt (siehe uploadData),
+// deshalb kann der Wert pro Dreieck in jeder seiner Ecken liegen
+void BottomLevelTriangleAS::computeTriangleLods(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices){
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        float lod = getTriangleLod(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
+        vertices[indices[i]].triangleLod = lod;
+        vertices[indices[i + 1]].triangleLod = lod;
+        vertices[indices[i + 2]].triangleLod = lod;
     }
 }
 
 void BottomLevelTriangleAS::create(){
+    computeTriangleLods(m_vertices, m_indices);
+
     uint32_t numTriangles = static_cast<uint32_t>(m_vertices.size()) / 3;
     uint32_t maxVertex = static_cast<uint32_t>(m_vertices.size());
 
@@ -311,15 +335,8 @@ void BottomLevelTriangleAS::create(){
     const VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
     const VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
 
-    m_vertexBuffer = Buffer(m_device, vertexBufferSize, bufferUsageFlags, memoryPropertyFlags);
-    m_vertexBuffer.map(vertexBufferSize, 0);
-    m_vertexBuffer.copyTo(m_vertices.data(), vertexBufferSize);
-    m_vertexBuffer.unmap();
-
-    m_indexBuffer = Buffer(m_device, indexBufferSize, bufferUsageFlags, memoryPropertyFlags);
-    m_indexBuffer.map(indexBufferSize, 0);
-    m_indexBuffer.copyTo(m_indices.data(), indexBufferSize);
-    m_indexBuffer.unmap();
+    m_vertexBuffer = uploadBuffer(m_vertices.data(), vertexBufferSize, bufferUsageFlags);
+    m_indexBuffer = uploadBuffer(m_indices.data(), indexBufferSize, bufferUsageFlags);
 
     m_transformBuffer = Buffer(m_device, transformBufferSize, bufferUsageFlags, memoryPropertyFlags);
     m_transformBuffer.map(transformBufferSize, 0);
@@ -334,10 +351,19 @@ void BottomLevelTriangleAS::create(){
     indexDataDeviceAddress.deviceAddress       = m_indexBuffer.getDeviceAddress();
     transformMatrixDeviceAddress.deviceAddress = m_transformBuffer.getDeviceAddress();
 
+    // Ohne Alpha Texturen ist die Geometrie opak und der Any Hit Shader wird nie aufgerufen
+    bool alphaTested = false;
+    for (const Vertex& vertex : m_vertices) {
+        if (vertex.matID >= 0 && m_materials[vertex.matID].alphaTexId >= 0) {
+            alphaTested = true;
+            break;
+        }
+    }
+
     VkAccelerationStructureGeometryKHR accelerationStructureGeometry{};
     accelerationStructureGeometry.sType                            = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
     accelerationStructureGeometry.geometryType                     = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
-    accelerationStructureGeometry.flags                            = VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+    accelerationStructureGeometry.flags                            = alphaTested ? VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR : VK_GEOMETRY_OPAQUE_BIT_KHR;
     accelerationStructureGeometry.geometry.triangles.sType         = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
     accelerationStructureGeometry.geometry.triangles.vertexFormat  = VK_FORMAT_R32G32B32_SFLOAT;
     accelerationStructureGeometry.geometry.triangles.vertexData    = vertexDataDeviceAddress;
@@ -389,24 +415,19 @@ void BottomLevelTriangleAS::create(){
     accelerationStructureBuildRangeInfo.transformOffset                                          = 0;
     std::vector<VkAccelerationStructureBuildRangeInfoKHR *> accelerationBuildStructureRangeInfos = {&accelerationStructureBuildRangeInfo};
 
-    if (m_device->supportsAccelerationStructureHostCommands())
-    {
-        vkBuildAccelerationStructuresKHR(m_device->getHandle(), VK_NULL_HANDLE, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
-    }else{
-        VkCommandBuffer command_buffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-        vkCmdBuildAccelerationStructuresKHR(command_buffer, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
-        flushCommandBuffer(command_buffer, m_device->getGraphicsQueue());
-        scratchBuffer.destroy();
-    }
+    // Immer auf der GPU: die Eingaben liegen device local und werden asynchron hochgeladen
+    buildOnComputeQueue(accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data(), {m_vertexBuffer.getHandle(), m_indexBuffer.getHandle()}, {scratchBuffer});
 
     VkAccelerationStructureDeviceAddressInfoKHR accelerationDeviceAddressInfo{};
     accelerationDeviceAddressInfo.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
     accelerationDeviceAddressInfo.accelerationStructure = m_handle;
 
     m_deviceAddress     = vkGetAccelerationStructureDeviceAddressKHR(m_device->getHandle(), &accelerationDeviceAddressInfo);
+}
 
-    m_vertexBufferDescriptors.push_back(m_vertexBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
-    m_indexBufferDescriptors.push_back(m_indexBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
+void BottomLevelTriangleAS::writeDescriptors(BindlessDescriptors& descriptors){
+    descriptors.writeBuffer(BindlessDescriptors::TableVertices, m_id, m_vertexBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
+    descriptors.writeBuffer(BindlessDescriptors::TableIndices, m_id, m_indexBuffer.getDescriptorInfo(VK_WHOLE_SIZE, 0));
 }
 
 void BottomLevelTriangleAS::destroy(){
@@ -415,18 +436,12 @@ void BottomLevelTriangleAS::destroy(){
     m_transformBuffer.destroy();
     m_accelerationStructureBuffer.destroy();
     vkDestroyAccelerationStructureKHR(m_device->getHandle(), m_handle, nullptr);
+    m_slots.free(m_id);
 }
 
-VkDescriptorBufferInfo* BottomLevelTriangleAS::getVertexBufferDescriptors(){
-    return m_vertexBufferDescriptors.data();
-}
-
-VkDescriptorBufferInfo* BottomLevelTriangleAS::getIndexBufferDescriptors(){
-    return m_indexBufferDescriptors.data();
-}
-
+// Obergrenze der belegten Slots, freie Slots darunter sind erlaubt
 uint32_t BottomLevelTriangleAS::getCount(){
-    return m_count;
+    return m_slots.getHighWater();
 }
 
 BottomLevelTriangleAS::~BottomLevelTriangleAS(){
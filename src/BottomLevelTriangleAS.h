@@ -1,25 +1,33 @@
 #include "BottomLevelAS.h" 
+#include "MaterialClassifier.h"
+#include "SlotAllocator.h"
 
 class BottomLevelTriangleAS : public BottomLevelAS
 {
 private:
-    static uint32_t m_count;
+    static SlotAllocator m_slots;
     Buffer m_vertexBuffer;
     Buffer m_indexBuffer;
     Buffer m_transformBuffer;
     std::vector<Vertex> m_vertices;
     std::vector<uint32_t> m_indices;
-    static std::vector<VkDescriptorBufferInfo> m_vertexBufferDescriptors;
-    static std::vector<VkDescriptorBufferInfo> m_indexBufferDescriptors;
+    MaterialVariant m_variant = MaterialVariantDiffuse;
+    void appendShapes(const tinyobj::attrib_t& attrib, const std::vector<tinyobj::shape_t>& shapes, uint32_t materialOffset, bool objMaterials);
 public:
-    static VkDescriptorBufferInfo* getVertexBufferDescriptors();
-    static VkDescriptorBufferInfo* getIndexBufferDescriptors();
     static uint32_t getCount();
+    static float getTriangleLod(const Vertex& v0, const Vertex& v1, const Vertex& v2);
+    static void computeTriangleLods(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
 
     BottomLevelTriangleAS(Device* device, std::string name);
 
     void uploadData(std::string path);
     void uploadData(std::string path, tinyobj::material_t &material_in);
+    std::vector<BottomLevelTriangleAS*> splitByVariant();
+    MaterialVariant getVariant() const;
+    const std::vector<Vertex>& getVertices() const;
+    const std::vector<uint32_t>& getIndices() const;
+    uint32_t getHitGroup() const override;
+    void writeDescriptors(BindlessDescriptors& descriptors) override;
 
     void create() override;
 
@@ -39,6 +39,7 @@ Buffer::Buffer(Device* device, VkDeviceSize size, VkBufferUsageFlags usageFlags,
     if (vkAllocateMemory(m_device->getHandle(), &allocInfo, nullptr, &m_memory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate buffer memory!");
     }
+    m_device->trackAllocation(m_memory, allocInfo.allocationSize);
     bind(0);
     if (m_usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
         PFN_vkGetBufferDeviceAddressKHR vkGetBufferDeviceAddressKHR = reinterpret_cast<PFN_vkGetBufferDeviceAddressKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetBufferDeviceAddressKHR"));
@@ -71,7 +72,7 @@ void Buffer::unmap(){
     }
 }
 
-void Buffer::copyTo(void* data, VkDeviceSize size){
+void Buffer::copyTo(const void* data, VkDeviceSize size){
     memcpy(m_mapped, data, size);
 }
 
@@ -107,6 +108,7 @@ void Buffer::destroy()
         vkDestroyBuffer(m_device->getHandle(), m_handle, nullptr);
     }
     if (m_memory){
+        m_device->trackFree(m_memory);
         vkFreeMemory(m_device->getHandle(), m_memory, nullptr);
     }
 }
\ No newline at end of file
@@ -21,7 +21,7 @@ public:
     void map(VkDeviceSize size, VkDeviceSize offset);
     void bind(VkDeviceSize offset);
     void unmap();
-    void copyTo(void* data, VkDeviceSize size);
+    void copyTo(const void* data, VkDeviceSize size);
     void destroy();
     VkBuffer getHandle();
     VkDeviceAddress getDeviceAddress();
@@ -0,0 +1,266 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+void Aabb::grow(glm::vec3 point){
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+}
+
+void Aabb::grow(const Aabb& other){
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+}
+
+glm::vec3 Aabb::getCenter() const{
+    return 0.5f * (min + max);
+}
+
+float Aabb::getSurfaceArea() const{
+    glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+Bvh::Bvh()
+{
+
+}
+
+namespace {
+
+// Hängt einen separat gebauten Teilbaum an, die Kind Indizes der inneren Knoten werden verschoben
+void appendSubtree(std::vector<Bvh::Node>& nodes, const std::vector<Bvh::Node>& subtree){
+    uint32_t offset = static_cast<uint32_t>(nodes.size());
+    for (Bvh::Node node : subtree) {
+        if (node.count == 0) {
+            node.rightOrFirst += offset;
+        }
+        nodes.push_back(node);
+    }
+}
+
+}
+
+void Bvh::build(const std::vector<Aabb>& bounds){
+    build(bounds, BuildSettings());
+}
+
+void Bvh::build(const std::vector<Aabb>& bounds, const BuildSettings& settings){
+    m_nodes.clear();
+    m_depth = 0;
+    m_indices.resize(bounds.size());
+    std::iota(m_indices.begin(), m_indices.end(), 0);
+    if (bounds.empty()) {
+        return;
+    }
+    std::vector<glm::vec3> centers(bounds.size());
+    for (size_t i = 0; i < bounds.size(); i++) {
+        centers[i] = bounds[i].getCenter();
+    }
+    BuildSettings clamped = settings;
+    clamped.maxLeafSize = std::max(settings.maxLeafSize, 1u);
+    clamped.binCount = std::min(std::max(settings.binCount, 2u), 256u);
+    JobSystem& jobs = settings.jobs ? *settings.jobs : JobSystem::getDefault();
+    uint32_t threadCount = jobs.getThreadCount();
+    // Eine Ebene mehr als nötig, damit ungleich große Teilbäume die Threads trotzdem auslasten
+    uint32_t parallelDepth = threadCount > 1 ? static_cast<uint32_t>(std::ceil(std::log2(threadCount))) + 1 : 0;
+    BuildContext context{bounds, centers, clamped, jobs, parallelDepth};
+
+    m_nodes.reserve(2 * bounds.size() / clamped.maxLeafSize + 1);
+    buildRecursive(context, m_nodes, 0, static_cast<uint32_t>(bounds.size()), 0);
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 1}};
+    while (!stack.empty()) {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+        m_depth = std::max(m_depth, depth);
+        if (m_nodes[nodeIndex].count == 0) {
+            stack.push_back({nodeIndex + 1, depth + 1});
+            stack.push_back({m_nodes[nodeIndex].rightOrFirst, depth + 1});
+        }
+    }
+}
+
+// Sortiert [begin, end) um und gibt die Grenze zwischen linkem und rechtem Kind zurück.
+// Bewertet pro Achse binCount Bins der Mittelpunkte nach SAH, ohne brauchbare Teilung wird am Median geteilt.
+// splitCost sind die erwarteten Kosten der Teilung in Primitiv Tests, unendlich bei der Median Teilung
+uint32_t Bvh::findSplit(const BuildContext& context, uint32_t begin, uint32_t end, const Aabb& nodeBounds, const Aabb& centerBounds, uint32_t depth, float& splitCost){
+    const uint32_t binCount = context.settings.binCount;
+    glm::vec3 extent = centerBounds.max - centerBounds.min;
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    uint32_t bestBin = 0;
+    if (depth < MedianSplitDepth) {
+        std::vector<Aabb> binBounds(binCount);
+        std::vector<uint32_t> binCounts(binCount);
+        std::vector<float> leftCost(binCount);
+        for (int axis = 0; axis < 3; axis++) {
+            if (extent[axis] <= 0.0f) {
+                continue;
+            }
+            std::fill(binBounds.begin(), binBounds.end(), Aabb());
+            std::fill(binCounts.begin(), binCounts.end(), 0);
+            float scale = binCount / extent[axis];
+            for (uint32_t i = begin; i < end; i++) {
+                uint32_t bin = std::min(binCount - 1, static_cast<uint32_t>((context.centers[m_indices[i]][axis] - centerBounds.min[axis]) * scale));
+                binBounds[bin].grow(context.bounds[m_indices[i]]);
+                binCounts[bin]++;
+            }
+            // Von links die Kosten aller Teilungen hinter Bin k sammeln, von rechts ergänzen
+            Aabb left;
+            uint32_t leftCount = 0;
+            for (uint32_t k = 0; k + 1 < binCount; k++) {
+                left.grow(binBounds[k]);
+                leftCount += binCounts[k];
+                leftCost[k] = leftCount > 0 ? left.getSurfaceArea() * leftCount : 0.0f;
+            }
+            Aabb right;
+            uint32_t rightCount = 0;
+            for (uint32_t k = binCount - 1; k > 0; k--) {
+                right.grow(binBounds[k]);
+                rightCount += binCounts[k];
+                uint32_t leftCountAtSplit = (end - begin) - rightCount;
+                if (rightCount == 0 || leftCountAtSplit == 0) {
+                    continue;
+                }
+                float cost = leftCost[k - 1] + right.getSurfaceArea() * rightCount;
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestBin = k - 1;
+                }
+            }
+        }
+    }
+    float nodeArea = nodeBounds.getSurfaceArea();
+    splitCost = std::numeric_limits<float>::infinity();
+    if (bestAxis >= 0) {
+        if (nodeArea > 0.0f) {
+            splitCost = context.settings.traversalCost + bestCost / nodeArea;
+        }
+        float scale = binCount / extent[bestAxis];
+        float minimum = centerBounds.min[bestAxis];
+        auto middle = std::partition(m_indices.begin() + begin, m_indices.begin() + end, [&](uint32_t index){
+            return std::min(binCount - 1, static_cast<uint32_t>((context.centers[index][bestAxis] - minimum) * scale)) <= bestBin;
+        });
+        return static_cast<uint32_t>(middle - m_indices.begin());
+    }
+
+    int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+    uint32_t middle = begin + (end - begin) / 2;
+    std::nth_element(m_indices.begin() + begin, m_indices.begin() + middle, m_indices.begin() + end, [&](uint32_t a, uint32_t b){
+        return context.centers[a][axis] < context.centers[b][axis];
+    });
+    return middle;
+}
+
+// Hängt den Teilbaum über [begin, end) an nodes an. Oberhalb von parallelDepth wird das linke Kind
+// als Job in einen eigenen Vektor gebaut und danach angehängt
+uint32_t Bvh::buildRecursive(const BuildContext& context, std::vector<Node>& nodes, uint32_t begin, uint32_t end, uint32_t depth){
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes.size());
+    nodes.push_back({});
+    Aabb nodeBounds;
+    Aabb centerBounds;
+    for (uint32_t i = begin; i < end; i++) {
+        nodeBounds.grow(context.bounds[m_indices[i]]);
+        centerBounds.grow(context.centers[m_indices[i]]);
+    }
+    nodes[nodeIndex].boundsMin = nodeBounds.min;
+    nodes[nodeIndex].boundsMax = nodeBounds.max;
+    uint32_t count = end - begin;
+    float splitCost = 0.0f;
+    uint32_t middle = count > 1 ? findSplit(context, begin, end, nodeBounds, centerBounds, depth, splitCost) : begin;
+    // Kleine Knoten bleiben Blätter, solange eine Teilung nicht billiger ist als count Primitiv Tests
+    if (count <= 1 || (count <= context.settings.maxLeafSize && splitCost >= static_cast<float>(count))) {
+        nodes[nodeIndex].rightOrFirst = begin;
+        nodes[nodeIndex].count = count;
+        return nodeIndex;
+    }
+    uint32_t right;
+    if (depth < context.parallelDepth && end - begin > context.settings.parallelThreshold) {
+        std::vector<Node> leftNodes;
+        std::vector<Node> rightNodes;
+        JobSystem::JobHandle leftJob = context.jobs.run([&](){
+            buildRecursive(context, leftNodes, begin, middle, depth + 1);
+        });
+        buildRecursive(context, rightNodes, middle, end, depth + 1);
+        context.jobs.wait(leftJob);
+        appendSubtree(nodes, leftNodes);
+        right = static_cast<uint32_t>(nodes.size());
+        appendSubtree(nodes, rightNodes);
+    } else {
+        buildRecursive(context, nodes, begin, middle, depth + 1);
+        right = buildRecursive(context, nodes, middle, end, depth + 1);
+    }
+    nodes[nodeIndex].rightOrFirst = right;
+    nodes[nodeIndex].count = 0;
+    return nodeIndex;
+}
+
+const std::vector<Bvh::Node>& Bvh::getNodes() const{
+    return m_nodes;
+}
+
+const std::vector<uint32_t>& Bvh::getIndices() const{
+    return m_indices;
+}
+
+bool Bvh::empty() const{
+    return m_nodes.empty();
+}
+
+uint32_t Bvh::getDepth() const{
+    return m_depth;
+}
+
+// Erwartete Kosten eines Strahls relativ zur Wurzel: Flächenverhältnis mal Knoten- bzw. Primitivkosten
+float Bvh::getSahCost(float traversalCost) const{
+    if (m_nodes.empty()) {
+        return 0.0f;
+    }
+    Aabb root{m_nodes[0].boundsMin, m_nodes[0].boundsMax};
+    float rootArea = root.getSurfaceArea();
+    if (rootArea <= 0.0f) {
+        return m_nodes[0].count > 0 ? static_cast<float>(m_nodes[0].count) : traversalCost;
+    }
+    double cost = 0.0;
+    for (const Node& node : m_nodes) {
+        Aabb bounds{node.boundsMin, node.boundsMax};
+        float relativeArea = bounds.getSurfaceArea() / rootArea;
+        cost += relativeArea * (node.count > 0 ? static_cast<float>(node.count) : traversalCost);
+    }
+    return static_cast<float>(cost);
+}
+
+std::vector<Aabb> Bvh::getTriangleBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices){
+    std::vector<Aabb> bounds(indices.size() / 3);
+    for (size_t i = 0; i < bounds.size(); i++) {
+        for (size_t corner = 0; corner < 3; corner++) {
+            const Vertex& vertex = vertices[indices[3 * i + corner]];
+            bounds[i].grow(glm::vec3(vertex.position[0], vertex.position[1], vertex.position[2]));
+        }
+    }
+    return bounds;
+}
+
+std::vector<Aabb> Bvh::getSphereBounds(const std::vector<Sphere>& spheres){
+    std::vector<Aabb> bounds(spheres.size());
+    for (size_t i = 0; i < spheres.size(); i++) {
+        glm::vec3 center = glm::vec3(spheres[i].center[0], spheres[i].center[1], spheres[i].center[2]);
+        bounds[i].grow(center - glm::vec3(spheres[i].radius));
+        bounds[i].grow(center + glm::vec3(spheres[i].radius));
+    }
+    return bounds;
+}
+
+// Slab Test, inverseDirection darf unendlich sein
+bool Bvh::intersectBounds(const Node& node, glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax){
+    glm::vec3 t0 = (node.boundsMin - origin) * inverseDirection;
+    glm::vec3 t1 = (node.boundsMax - origin) * inverseDirection;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tmin));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tmax));
+    return enter <= exit;
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "JobSystem.h"
+#include "GlobalDefs.h"
+
+struct Aabb
+{
+    glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+    void grow(glm::vec3 point);
+    void grow(const Aabb& other);
+    glm::vec3 getCenter() const;
+    float getSurfaceArea() const;
+};
+
+// Binäre Bounding Volume Hierarchy über beliebige Primitive, die nur über ihre Bounding Box eingehen.
+// Gebaut mit gebinnter SAH, große Teilbäume parallel. Die Knoten liegen flach in einem Array,
+// das linke Kind direkt hinter dem Elternknoten
+class Bvh
+{
+public:
+    struct Node{
+        glm::vec3 boundsMin;
+        uint32_t rightOrFirst;  // innerer Knoten: Index des rechten Kindes, Blatt: erster Eintrag in getIndices()
+        glm::vec3 boundsMax;
+        uint32_t count;         // 0 bei inneren Knoten
+    };
+    struct BuildSettings{
+        uint32_t maxLeafSize = 4;           // Knoten mit mehr Primitiven werden immer geteilt, kleinere nur wenn die SAH es lohnt
+        uint32_t binCount = 16;
+        float traversalCost = 1.0f;         // relativ zu einem Primitiv Test, Abbruchkriterium der SAH
+        JobSystem* jobs = nullptr;          // nullptr = JobSystem::getDefault()
+        uint32_t parallelThreshold = 4096;  // kleinere Teilbäume baut der aufrufende Thread
+    };
+    // Ab dieser Tiefe wird am Median geteilt, so bleibt die Tiefe und damit der Traversierungsstack unter MaxDepth
+    static const uint32_t MedianSplitDepth = 32;
+    static const uint32_t MaxDepth = 64;
+
+    Bvh();
+    void build(const std::vector<Aabb>& bounds);
+    void build(const std::vector<Aabb>& bounds, const BuildSettings& settings);
+    const std::vector<Node>& getNodes() const;
+    const std::vector<uint32_t>& getIndices() const;
+    bool empty() const;
+    uint32_t getDepth() const;
+    float getSahCost(float traversalCost = 1.0f) const;
+    static std::vector<Aabb> getTriangleBounds(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+    static std::vector<Aabb> getSphereBounds(const std::vector<Sphere>& spheres);
+    static bool intersectBounds(const Node& node, glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax);
+
+    // Ruft intersect(primitive, tmax) für jedes Primitiv in getroffenen Blättern auf. intersect gibt true zurück,
+    // wenn es tmax verkürzt hat, mit anyHit endet die Suche beim ersten Treffer
+    template<typename Intersect>
+    bool traverse(glm::vec3 origin, glm::vec3 direction, float tmin, float& tmax, bool anyHit, Intersect intersect) const{
+        if (m_nodes.empty()) {
+            return false;
+        }
+        glm::vec3 inverseDirection = 1.0f / direction;
+        uint32_t stack[MaxDepth];
+        uint32_t stackSize = 0;
+        uint32_t nodeIndex = 0;
+        bool hit = false;
+        while (true) {
+            const Node& node = m_nodes[nodeIndex];
+            if (intersectBounds(node, origin, inverseDirection, tmin, tmax)) {
+                if (node.count > 0) {
+                    for (uint32_t i = 0; i < node.count; i++) {
+                        if (intersect(m_indices[node.rightOrFirst + i], tmax)) {
+                            hit = true;
+                            if (anyHit) {
+                                return true;
+                            }
+                        }
+                    }
+                } else {
+                    stack[stackSize++] = node.rightOrFirst;
+                    nodeIndex = nodeIndex + 1;
+                    continue;
+                }
+            }
+            if (stackSize == 0) {
+                break;
+            }
+            nodeIndex = stack[--stackSize];
+        }
+        return hit;
+    }
+private:
+    struct BuildContext{
+        const std::vector<Aabb>& bounds;
+        const std::vector<glm::vec3>& centers;
+        const BuildSettings& settings;
+        JobSystem& jobs;
+        uint32_t parallelDepth;             // bis zu dieser Tiefe werden Teilbäume als Jobs verteilt
+    };
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_indices;
+    uint32_t m_depth = 0;
+    uint32_t findSplit(const BuildContext& context, uint32_t begin, uint32_t end, const Aabb& nodeBounds, const Aabb& centerBounds, uint32_t depth, float& splitCost);
+    uint32_t buildRecursive(const BuildContext& context, std::vector<Node>& nodes, uint32_t begin, uint32_t end, uint32_t depth);
+};
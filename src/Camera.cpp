@@ -111,4 +111,23 @@ void Camera::update(){
 
 glm::mat4 Camera::getView(){
     return glm::inverse(m_viewMatrix);
-}
\ No newline at end of file
+}
+
+glm::vec3 Camera::getPosition(){
+    return m_eye;
+}
+
+glm::vec3 Camera::getTarget(){
+    if(m_type == TypeTrackBall)
+        return glm::vec3(0.0f);
+    return m_eye + m_forward;
+}
+
+// Strahl durch die Mausposition wie in raygen.rgen, inverseProj mit gespiegelter y Achse wie im Uniform Buffer
+void Camera::getCursorRay(const glm::mat4& inverseProj, glm::vec3& origin, glm::vec3& direction){
+    glm::mat4 inverseView = getView();
+    glm::vec2 d = glm::vec2(Camera::m_xpos / m_width, Camera::m_ypos / m_height) * 2.0f - 1.0f;
+    glm::vec4 target = inverseProj * glm::vec4(d.x, d.y, 1.0f, 1.0f);
+    origin = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    direction = glm::vec3(inverseView * glm::vec4(glm::normalize(glm::vec3(target)), 0.0f));
+}
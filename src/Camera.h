@@ -13,6 +13,9 @@ public:
 	Camera(Type type, GLFWwindow* window, uint32_t width, uint32_t height, glm::vec3 eye, glm::vec3 center);
     void update();
     glm::mat4 getView();
+    glm::vec3 getPosition();
+    glm::vec3 getTarget();
+    void getCursorRay(const glm::mat4& inverseProj, glm::vec3& origin, glm::vec3& direction);
 private:
 	glm::mat4 m_viewMatrix;
     glm::vec3 m_eye;
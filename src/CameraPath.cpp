@@ -0,0 +1,116 @@
+#include "CameraPath.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+CameraPath::CameraPath()
+{
+
+}
+
+CameraPath CameraPath::orbit(glm::vec3 center, float radius, float height, float duration, uint32_t keyframeCount){
+    CameraPath path;
+    for (uint32_t i = 0; i <= keyframeCount; i++) {
+        float t = static_cast<float>(i) / keyframeCount;
+        float angle = t * 2.0f * 3.141592f;
+        glm::vec3 eye = center + glm::vec3(radius * cos(angle), height, radius * sin(angle));
+        path.addKeyframe(t * duration, eye, center);
+    }
+    return path;
+}
+
+// Eine Zeile pro Keyframe: time eye.x eye.y eye.z target.x target.y target.z
+void CameraPath::load(std::string filepath){
+    std::ifstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open camera path " + filepath + "!");
+    }
+    m_keyframes.clear();
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream stream(line);
+        Keyframe keyframe{};
+        if (!(stream >> keyframe.time >> keyframe.eye.x >> keyframe.eye.y >> keyframe.eye.z >> keyframe.target.x >> keyframe.target.y >> keyframe.target.z)) {
+            throw std::runtime_error("invalid keyframe in camera path " + filepath + "!");
+        }
+        addKeyframe(keyframe.time, keyframe.eye, keyframe.target);
+    }
+    if (m_keyframes.empty()) {
+        throw std::runtime_error("camera path " + filepath + " has no keyframes!");
+    }
+}
+
+void CameraPath::save(std::string filepath){
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to write camera path " + filepath + "!");
+    }
+    file << "# time eye.x eye.y eye.z target.x target.y target.z\n";
+    for (const Keyframe& keyframe : m_keyframes) {
+        file << keyframe.time << " "
+             << keyframe.eye.x << " " << keyframe.eye.y << " " << keyframe.eye.z << " "
+             << keyframe.target.x << " " << keyframe.target.y << " " << keyframe.target.z << "\n";
+    }
+}
+
+void CameraPath::addKeyframe(float time, glm::vec3 eye, glm::vec3 target){
+    if (!m_keyframes.empty() && time <= m_keyframes.back().time) {
+        throw std::runtime_error("camera path keyframes must have increasing time!");
+    }
+    m_keyframes.push_back({time, eye, target});
+}
+
+bool CameraPath::empty() const{
+    return m_keyframes.empty();
+}
+
+float CameraPath::getDuration() const{
+    if (m_keyframes.empty()) {
+        return 0.0f;
+    }
+    return m_keyframes.back().time - m_keyframes.front().time;
+}
+
+glm::vec3 CameraPath::catmullRom(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t){
+    float t2 = t * t;
+    float t3 = t2 * t;
+    return 0.5f * ((2.0f * p1) + (-p0 + p2) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 + (-p0 + 3.0f * p1 - 3.0f * p2 + p3) * t3);
+}
+
+// Zeiten über die Länge hinaus laufen in einer Schleife
+CameraPath::Keyframe CameraPath::evaluate(float time) const{
+    if (m_keyframes.empty()) {
+        throw std::runtime_error("camera path is empty!");
+    }
+    if (m_keyframes.size() == 1) {
+        return m_keyframes[0];
+    }
+    float duration = getDuration();
+    float t = m_keyframes.front().time + fmod(std::max(time, 0.0f), duration);
+
+    size_t i = 0;
+    while (i + 2 < m_keyframes.size() && m_keyframes[i + 1].time <= t) {
+        i++;
+    }
+    const Keyframe& k0 = m_keyframes[i > 0 ? i - 1 : i];
+    const Keyframe& k1 = m_keyframes[i];
+    const Keyframe& k2 = m_keyframes[i + 1];
+    const Keyframe& k3 = m_keyframes[std::min(i + 2, m_keyframes.size() - 1)];
+    float u = glm::clamp((t - k1.time) / (k2.time - k1.time), 0.0f, 1.0f);
+
+    Keyframe keyframe{};
+    keyframe.time = time;
+    keyframe.eye = catmullRom(k0.eye, k1.eye, k2.eye, k3.eye, u);
+    keyframe.target = catmullRom(k0.target, k1.target, k2.target, k3.target, u);
+    return keyframe;
+}
+
+// Gibt wie Camera::getView die inverse View Matrix zurück
+glm::mat4 CameraPath::getView(float time) const{
+    Keyframe keyframe = evaluate(time);
+    return glm::inverse(glm::lookAt(keyframe.eye, keyframe.target, glm::vec3(0.0f, 1.0f, 0.0f)));
+}
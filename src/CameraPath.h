@@ -0,0 +1,26 @@
+#pragma once
+
+#include "GlobalDefs.h"
+
+// Kamerafahrt aus Keyframes, zwischen denen mit Catmull-Rom interpoliert wird
+class CameraPath
+{
+public:
+    struct Keyframe{
+        float time;
+        glm::vec3 eye;
+        glm::vec3 target;
+    };
+    CameraPath();
+    static CameraPath orbit(glm::vec3 center, float radius, float height, float duration, uint32_t keyframeCount);
+    void load(std::string filepath);
+    void save(std::string filepath);
+    void addKeyframe(float time, glm::vec3 eye, glm::vec3 target);
+    bool empty() const;
+    float getDuration() const;
+    Keyframe evaluate(float time) const;
+    glm::mat4 getView(float time) const;
+private:
+    std::vector<Keyframe> m_keyframes;
+    static glm::vec3 catmullRom(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2, glm::vec3 p3, float t);
+};
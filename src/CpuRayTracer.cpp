@@ -0,0 +1,440 @@
+#include "CpuRayTracer.h"
+#include <cmath>
+#include "JobSystem.h"
+#include <glm/gtc/matrix_inverse.hpp>
+#include <glm/gtc/type_ptr.hpp>
+#include <stb_image.h>
+
+namespace {
+
+const float PI = 3.14159f;
+const glm::vec3 SKY_COLOR = glm::vec3(0.5255f, 0.8745f, 1.0f);
+
+float srgbToLinear(uint8_t value){
+    float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+glm::vec3 toVec3(const float* values){
+    return glm::vec3(values[0], values[1], values[2]);
+}
+
+}
+
+CpuRayTracer::CpuRayTracer()
+{
+    m_defaultMaterial.diffuse[0] = m_defaultMaterial.diffuse[1] = m_defaultMaterial.diffuse[2] = 0.8f;
+    m_defaultMaterial.dissolve = 1.0f;
+    m_defaultMaterial.shininess = 1.0f;
+    m_defaultMaterial.ambientTexId = m_defaultMaterial.diffuseTexId = m_defaultMaterial.specularTexId = -1;
+    m_defaultMaterial.specularHighlightTexId = m_defaultMaterial.bumpTexId = m_defaultMaterial.displacementTexId = -1;
+    m_defaultMaterial.alphaTexId = m_defaultMaterial.reflectionTexId = -1;
+}
+
+// Die Instanz Transformation wird wie in der TLAS auf die Geometrie angewendet
+uint32_t CpuRayTracer::addTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::mat4& transform){
+    Instance instance;
+    instance.vertices = vertices;
+    instance.indices = indices;
+    glm::mat3 normalMatrix = glm::inverseTranspose(glm::mat3(transform));
+    for (Vertex& vertex : instance.vertices) {
+        glm::vec3 position = glm::vec3(transform * glm::vec4(toVec3(vertex.position), 1.0f));
+        glm::vec3 normal = normalMatrix * toVec3(vertex.normal);
+        vertex.position[0] = position.x; vertex.position[1] = position.y; vertex.position[2] = position.z;
+        vertex.normal[0] = normal.x;     vertex.normal[1] = normal.y;     vertex.normal[2] = normal.z;
+    }
+    uint32_t instanceIndex = static_cast<uint32_t>(m_instances.size());
+    for (uint32_t i = 0; i < indices.size() / 3; i++) {
+        m_primitives.push_back({instanceIndex, i, false});
+    }
+    m_instances.push_back(std::move(instance));
+    return instanceIndex;
+}
+
+// Wie intersection.rint: Mittelpunkt transformiert, Radius mit der Länge der ersten Spalte skaliert (gleichmäßige Skalierung)
+uint32_t CpuRayTracer::addSpheres(const std::vector<Sphere>& spheres, const glm::mat4& transform){
+    Instance instance;
+    instance.spheres = spheres;
+    float scale = glm::length(glm::vec3(transform[0]));
+    for (Sphere& sphere : instance.spheres) {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(toVec3(sphere.center), 1.0f));
+        sphere.center[0] = center.x; sphere.center[1] = center.y; sphere.center[2] = center.z;
+        sphere.radius *= scale;
+    }
+    uint32_t instanceIndex = static_cast<uint32_t>(m_instances.size());
+    for (uint32_t i = 0; i < spheres.size(); i++) {
+        m_primitives.push_back({instanceIndex, i, true});
+    }
+    m_instances.push_back(std::move(instance));
+    return instanceIndex;
+}
+
+void CpuRayTracer::setMaterials(const std::vector<Material>& materials){
+    m_materials = materials;
+}
+
+// Richtungslichter haben w == 0, die Reihenfolge im Buffer spielt hier keine Rolle
+void CpuRayTracer::setLights(const std::vector<Light>& lights){
+    m_lights = lights;
+}
+
+// Pfade relativ zu TEXTURE_PATH wie beim Texture Konstruktor, Indizes entsprechen den Textur IDs der Materialien
+void CpuRayTracer::loadTextures(const std::vector<std::string>& paths){
+    m_textures.clear();
+    for (const std::string& path : paths) {
+        if (path.empty()) {
+            m_textures.push_back(TextureData{});
+            continue;
+        }
+        std::string texturePath = std::string(TEXTURE_PATH) + path;
+        int width, height, channels;
+        stbi_uc* pixels = stbi_load(texturePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+        if (!pixels) {
+            throw std::runtime_error("failed to load texture image " + texturePath + "!");
+        }
+        TextureData texture{};
+        texture.width = static_cast<uint32_t>(width);
+        texture.height = static_cast<uint32_t>(height);
+        texture.texels.resize(static_cast<size_t>(width) * height);
+        for (size_t i = 0; i < texture.texels.size(); i++) {
+            texture.texels[i] = glm::vec4(srgbToLinear(pixels[4 * i]), srgbToLinear(pixels[4 * i + 1]), srgbToLinear(pixels[4 * i + 2]), pixels[4 * i + 3] / 255.0f);
+        }
+        stbi_image_free(pixels);
+        m_textures.push_back(std::move(texture));
+    }
+}
+
+void CpuRayTracer::setMaxRecursion(uint32_t maxRecursion){
+    m_maxRecursion = maxRecursion;
+}
+
+Aabb CpuRayTracer::getBounds(const Primitive& primitive) const{
+    const Instance& instance = m_instances[primitive.instance];
+    Aabb bounds;
+    if (primitive.sphere) {
+        const Sphere& sphere = instance.spheres[primitive.index];
+        bounds.grow(toVec3(sphere.center) - glm::vec3(sphere.radius));
+        bounds.grow(toVec3(sphere.center) + glm::vec3(sphere.radius));
+    } else {
+        for (uint32_t i = 0; i < 3; i++) {
+            bounds.grow(toVec3(instance.vertices[instance.indices[3 * primitive.index + i]].position));
+        }
+    }
+    return bounds;
+}
+
+void CpuRayTracer::build(){
+    std::vector<Aabb> bounds(m_primitives.size());
+    for (size_t i = 0; i < m_primitives.size(); i++) {
+        bounds[i] = getBounds(m_primitives[i]);
+    }
+    m_bvh.build(bounds);
+}
+
+const CpuRayTracer::Primitive& CpuRayTracer::getPrimitive(uint32_t primitive) const{
+    return m_primitives[primitive];
+}
+
+const Bvh& CpuRayTracer::getBvh() const{
+    return m_bvh;
+}
+
+const Material& CpuRayTracer::getMaterial(int matID) const{
+    if (matID < 0 || matID >= static_cast<int>(m_materials.size())) {
+        return m_defaultMaterial;
+    }
+    return m_materials[matID];
+}
+
+// Bilinear mit REPEAT wie der Sampler der Texturen, immer aus Level 0
+glm::vec4 CpuRayTracer::sampleTexture(int texId, glm::vec2 uv) const{
+    if (texId < 0 || texId >= static_cast<int>(m_textures.size()) || m_textures[texId].texels.empty()) {
+        return glm::vec4(1.0f);
+    }
+    const TextureData& texture = m_textures[texId];
+    float x = uv.x * texture.width - 0.5f;
+    float y = uv.y * texture.height - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    auto texel = [&](float tx, float ty){
+        int ix = static_cast<int>(tx) % static_cast<int>(texture.width);
+        int iy = static_cast<int>(ty) % static_cast<int>(texture.height);
+        ix = ix < 0 ? ix + texture.width : ix;
+        iy = iy < 0 ? iy + texture.height : iy;
+        return texture.texels[static_cast<size_t>(iy) * texture.width + ix];
+    };
+    float wx = x - fx;
+    float wy = y - fy;
+    glm::vec4 top = glm::mix(texel(fx, fy), texel(fx + 1.0f, fy), wx);
+    glm::vec4 bottom = glm::mix(texel(fx, fy + 1.0f), texel(fx + 1.0f, fy + 1.0f), wx);
+    return glm::mix(top, bottom, wy);
+}
+
+// anyhit.rahit: Treffer auf Alpha Texturen mit Wert ~0 werden ignoriert
+bool CpuRayTracer::passesAlphaTest(const Primitive& primitive, float u, float v) const{
+    const Instance& instance = m_instances[primitive.instance];
+    const Vertex& v0 = instance.vertices[instance.indices[3 * primitive.index]];
+    const Material& material = getMaterial(v0.matID);
+    if (material.alphaTexId == -1) {
+        return true;
+    }
+    const Vertex& v1 = instance.vertices[instance.indices[3 * primitive.index + 1]];
+    const Vertex& v2 = instance.vertices[instance.indices[3 * primitive.index + 2]];
+    glm::vec2 uv = (1.0f - u - v) * glm::make_vec2(v0.texture) + u * glm::make_vec2(v1.texture) + v * glm::make_vec2(v2.texture);
+    return sampleTexture(material.alphaTexId, uv).x > 0.000001f;
+}
+
+bool CpuRayTracer::intersectPrimitive(uint32_t primitiveIndex, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Hit& hit) const{
+    const Primitive& primitive = m_primitives[primitiveIndex];
+    const Instance& instance = m_instances[primitive.instance];
+    if (primitive.sphere) {
+        // Gleiche Lösung wie hitSphereStable in intersection.rint, danach wie reportIntersectionEXT auf [tmin, tmax] prüfen
+        const Sphere& sphere = instance.spheres[primitive.index];
+        glm::vec3 oc = origin - toVec3(sphere.center);
+        float a = glm::dot(direction, direction);
+        float halfB = glm::dot(oc, direction);
+        float c = glm::dot(oc, oc) - sphere.radius * sphere.radius;
+        glm::vec3 l = oc - (halfB / a) * direction;
+        float discriminant = a * (sphere.radius * sphere.radius - glm::dot(l, l));
+        if (discriminant < 0) {
+            return false;
+        }
+        float root = std::sqrt(discriminant);
+        float q = halfB >= 0.0f ? -halfB - root : -halfB + root;
+        if (q == 0.0f) {
+            return false;
+        }
+        float tNear = std::min(q / a, c / q);
+        float tFar = std::max(q / a, c / q);
+        float t = tNear >= tmin ? tNear : tFar;
+        if (t < tmin || t > tmax) {
+            return false;
+        }
+        hit = {t, primitiveIndex, 0.0f, 0.0f};
+        return true;
+    }
+
+    // Möller-Trumbore ohne Backface Culling (VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR)
+    glm::vec3 p0 = toVec3(instance.vertices[instance.indices[3 * primitive.index]].position);
+    glm::vec3 e1 = toVec3(instance.vertices[instance.indices[3 * primitive.index + 1]].position) - p0;
+    glm::vec3 e2 = toVec3(instance.vertices[instance.indices[3 * primitive.index + 2]].position) - p0;
+    glm::vec3 p = glm::cross(direction, e2);
+    float determinant = glm::dot(e1, p);
+    if (std::abs(determinant) < 1e-12f) {
+        return false;
+    }
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 s = origin - p0;
+    float u = glm::dot(s, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f) {
+        return false;
+    }
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f) {
+        return false;
+    }
+    float t = glm::dot(e2, q) * inverseDeterminant;
+    if (t < tmin || t > tmax || !passesAlphaTest(primitive, u, v)) {
+        return false;
+    }
+    hit = {t, primitiveIndex, u, v};
+    return true;
+}
+
+bool CpuRayTracer::intersect(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Hit& hit) const{
+    return m_bvh.traverse(origin, direction, tmin, tmax, false, [&](uint32_t primitive, float& closest){
+        Hit candidate;
+        if (intersectPrimitive(primitive, origin, direction, tmin, closest, candidate)) {
+            hit = candidate;
+            closest = candidate.t;
+            return true;
+        }
+        return false;
+    });
+}
+
+// Schattenstrahlen: gl_RayFlagsTerminateOnFirstHitEXT, der Alpha Test läuft trotzdem
+bool CpuRayTracer::occluded(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax) const{
+    return m_bvh.traverse(origin, direction, tmin, tmax, true, [&](uint32_t primitive, float& closest){
+        Hit candidate;
+        return intersectPrimitive(primitive, origin, direction, tmin, closest, candidate);
+    });
+}
+
+glm::vec3 CpuRayTracer::refractRay(glm::vec3 I, glm::vec3 N, float ior){
+    float cosi = glm::clamp(glm::dot(I, N), -1.0f, 1.0f);
+    float etai = 1, etat = ior;
+    glm::vec3 n = N;
+    if (cosi < 0) {
+        cosi = -cosi;
+    } else {
+        std::swap(etai, etat);
+        n = -N;
+    }
+    float eta = etai / etat;
+    float k = 1 - eta * eta * (1 - cosi * cosi);
+    if (k < 0) {
+        return glm::vec3(0.0f);
+    }
+    return eta * I + (eta * cosi - std::sqrt(k)) * n;
+}
+
+// weight ist der Faktor, mit dem die Shader kr und kt multiplizieren
+void CpuRayTracer::fresnel(glm::vec3 I, glm::vec3 N, float ior, float weight, float& kr, float& kt){
+    float cosi = glm::clamp(glm::dot(I, N), -1.0f, 1.0f);
+    float etai = 1;
+    float etat = ior;
+    if (cosi > 0) {
+        std::swap(etai, etat);
+    }
+    float sint = etai / etat * std::sqrt(std::max(0.f, 1 - cosi * cosi));
+    if (sint >= 1) {
+        kr = 1;
+    } else {
+        float cost = std::sqrt(std::max(0.f, 1 - sint * sint));
+        cosi = std::abs(cosi);
+        float Rs = ((etat * cosi) - (etai * cost)) / ((etat * cosi) + (etai * cost));
+        float Rp = ((etai * cosi) - (etat * cost)) / ((etai * cosi) + (etat * cost));
+        kr = (Rs * Rs + Rp * Rp) / 2;
+    }
+    kt = 1.0f - kr;
+    kt *= weight;
+    kr *= weight;
+}
+
+// processDirLight und processPointLight aus den Hit Shadern
+glm::vec3 CpuRayTracer::processLight(const Light& light, glm::vec3 direction, glm::vec3 hitPos, glm::vec3 normal, float shininess, glm::vec3 ambi, glm::vec3 diff, glm::vec3 spec) const{
+    bool pointLight = light.m_pos[3] > 0.0001f;
+    glm::vec3 lightPos = toVec3(light.m_pos);
+    glm::vec3 color = toVec3(light.m_color);
+    glm::vec3 lightVector = pointLight ? glm::normalize(lightPos - hitPos) : glm::normalize(lightPos);
+    float cos_phi = std::max(glm::dot(lightVector, normal), 0.0f);
+    glm::vec3 reflectedDir = glm::reflect(direction, normal);
+    float cos_psi_n = std::pow(std::max(glm::dot(lightVector, reflectedDir), 0.0f), shininess);
+
+    float attenuation = 1.0f;
+    float tmax = 10000.0f;
+    if (pointLight) {
+        float distance = glm::distance(lightPos, hitPos);
+        attenuation = 1.0f / (light.m_attenuation[0] + light.m_attenuation[1] * distance + light.m_attenuation[2] * (distance * distance));
+        tmax = distance;
+    }
+    glm::vec3 ambient = light.m_ambientIntensity * color * ambi * attenuation;
+    if (cos_phi > 0 && occluded(hitPos, lightVector, 0.001f, tmax)) {
+        return ambient;
+    }
+    glm::vec3 diffuse = color * cos_phi * diff * attenuation;
+    glm::vec3 specular = color * cos_psi_n * spec * attenuation;
+    return ambient + diffuse + specular;
+}
+
+glm::vec3 CpuRayTracer::shade(glm::vec3 direction, glm::vec3 position, glm::vec3 normal, const Material& material, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular) const{
+    glm::vec3 calculatedColor = glm::vec3(0.0f);
+    for (const Light& light : m_lights) {
+        calculatedColor += processLight(light, direction, position, normal, material.shininess, ambient, diffuse, specular);
+    }
+    return calculatedColor;
+}
+
+// Entspricht einem traceRayEXT mit dem gemeinsamen Payload: Kinder addieren ihre Farbe und erhöhen die Rekursion
+void CpuRayTracer::trace(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Payload& payload) const{
+    // refractRay liefert bei Totalreflexion den Nullvektor, der trägt nichts bei
+    if (glm::dot(direction, direction) == 0.0f) {
+        return;
+    }
+    Hit hit;
+    if (!intersect(origin, direction, tmin, tmax, hit)) {
+        payload.color += payload.weight * SKY_COLOR;
+        return;
+    }
+    const Primitive& primitive = m_primitives[hit.primitive];
+    const Instance& instance = m_instances[primitive.instance];
+
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 textureCoord;
+    int matID;
+    if (primitive.sphere) {
+        const Sphere& sphere = instance.spheres[primitive.index];
+        glm::vec3 center = toVec3(sphere.center);
+        position = origin + direction * hit.t;
+        position = center + sphere.radius * glm::normalize(position - center);
+        normal = glm::normalize(position - center);
+        textureCoord = glm::vec2((1 + std::atan2(normal.z, normal.x) / PI) * 0.5f, std::acos(glm::clamp(normal.y, -1.0f, 1.0f)) / PI);
+        matID = sphere.matID;
+    } else {
+        const Vertex& v0 = instance.vertices[instance.indices[3 * primitive.index]];
+        const Vertex& v1 = instance.vertices[instance.indices[3 * primitive.index + 1]];
+        const Vertex& v2 = instance.vertices[instance.indices[3 * primitive.index + 2]];
+        glm::vec3 barycentricCoords = glm::vec3(1.0f - hit.u - hit.v, hit.u, hit.v);
+        position = toVec3(v0.position) * barycentricCoords.x + toVec3(v1.position) * barycentricCoords.y + toVec3(v2.position) * barycentricCoords.z;
+        normal = glm::normalize(toVec3(v0.normal) * barycentricCoords.x + toVec3(v1.normal) * barycentricCoords.y + toVec3(v2.normal) * barycentricCoords.z);
+        textureCoord = glm::make_vec2(v0.texture) * barycentricCoords.x + glm::make_vec2(v1.texture) * barycentricCoords.y + glm::make_vec2(v2.texture) * barycentricCoords.z;
+        matID = v0.matID;
+    }
+    const Material& material = getMaterial(matID);
+
+    glm::vec3 diffuse = material.diffuseTexId >= 0 ? glm::vec3(sampleTexture(material.diffuseTexId, textureCoord)) : toVec3(material.diffuse);
+    glm::vec3 specular = material.specularTexId >= 0 ? glm::vec3(sampleTexture(material.specularTexId, textureCoord)) * toVec3(material.specular) : toVec3(material.specular);
+    glm::vec3 ambient = material.ambientTexId >= 0 ? sampleTexture(material.ambientTexId, textureCoord).r * diffuse : diffuse;
+
+    float reflectance = 0.0f;
+    if (material.illum == 3) {
+        reflectance = 1.0f - material.dissolve;
+    }
+    float refractance = 0.0f;
+    if (material.illum == 7) {
+        fresnel(direction, normal, material.ior, payload.weight * (primitive.sphere ? 0.95f : 1.0f - material.dissolve), reflectance, refractance);
+    }
+
+    payload.recursion++;
+    glm::vec3 calculatedColor = shade(direction, position, normal, material, ambient, diffuse, specular);
+    payload.color += payload.weight * (1.0f - reflectance - refractance) * calculatedColor;
+
+    if (payload.recursion < static_cast<int>(m_maxRecursion)) {
+        float parentWeight = payload.weight;
+        if (reflectance > 0.0001f) {
+            payload.weight = parentWeight * reflectance;
+            trace(position, glm::reflect(direction, normal), primitive.sphere ? 0.001f : 0.01f, 10000.0f, payload);
+        }
+        if (refractance > 0.0001f) {
+            payload.weight = parentWeight * refractance;
+            trace(position, refractRay(direction, normal, material.ior), 0.01f, 10000.0f, payload);
+        }
+    }
+}
+
+// Ein Sample pro Pixel in der Pixelmitte wie das erste Bild der progressiven Akkumulation, Zeilen von oben nach unten
+std::vector<float> CpuRayTracer::render(const glm::mat4& inverseView, const glm::mat4& inverseProj, uint32_t width, uint32_t height, JobSystem& jobs, uint32_t tileSize) const{
+    std::vector<float> image(static_cast<size_t>(width) * height * 3, 0.0f);
+    uint32_t tilesX = (width + tileSize - 1) / tileSize;
+    uint32_t tilesY = (height + tileSize - 1) / tileSize;
+    uint32_t tileCount = tilesX * tilesY;
+
+    auto renderTiles = [&](uint32_t firstTile, uint32_t endTile){
+        for (uint32_t tile = firstTile; tile < endTile; tile++) {
+            uint32_t x0 = (tile % tilesX) * tileSize;
+            uint32_t y0 = (tile / tilesX) * tileSize;
+            for (uint32_t y = y0; y < std::min(y0 + tileSize, height); y++) {
+                for (uint32_t x = x0; x < std::min(x0 + tileSize, width); x++) {
+                    glm::vec2 inUV = (glm::vec2(x, y) + glm::vec2(0.5f)) / glm::vec2(width, height);
+                    glm::vec2 d = inUV * 2.0f - 1.0f;
+                    glm::vec4 origin = inverseView * glm::vec4(0, 0, 0, 1);
+                    glm::vec4 target = inverseProj * glm::vec4(d.x, d.y, 1, 1);
+                    glm::vec4 direction = inverseView * glm::vec4(glm::normalize(glm::vec3(target)), 0);
+
+                    Payload payload{glm::vec3(0.0f), 0, 1.0f};
+                    trace(glm::vec3(origin), glm::vec3(direction), 0.01f, 10000.0f, payload);
+                    size_t pixel = (static_cast<size_t>(y) * width + x) * 3;
+                    image[pixel] = payload.color.r;
+                    image[pixel + 1] = payload.color.g;
+                    image[pixel + 2] = payload.color.b;
+                }
+            }
+        }
+    };
+
+    jobs.parallelFor(0, tileCount, 1, renderTiles);
+    return image;
+}
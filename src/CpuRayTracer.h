@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "Bvh.h"
+#include "GlobalDefs.h"
+
+// Referenz Ray Tracer ohne GPU. Nutzt dieselben Vertex, Index, Sphere, Material und Light Daten wie die
+// Pipeline und bildet closesthit.rchit, closesthitsphere.rchit, anyhit.rahit und miss.rmiss im Modus
+// "alle Lichter" nach. Das Bild wird in Kacheln aufgeteilt, jede Kachel ist ein Job auf jobs
+class CpuRayTracer
+{
+public:
+    struct Hit{
+        float t;
+        uint32_t primitive;     // Index in die Primitive Liste, siehe getPrimitive
+        float u;                // Baryzentrische Koordinaten wie hitAttributeEXT, bei Kugeln 0
+        float v;
+    };
+    struct Primitive{
+        uint32_t instance;      // Reihenfolge der add Aufrufe, entspricht der TLAS Instanz
+        uint32_t index;         // Dreieck bzw. Kugel innerhalb der Instanz
+        bool sphere;
+    };
+    CpuRayTracer();
+    uint32_t addTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::mat4& transform);
+    uint32_t addSpheres(const std::vector<Sphere>& spheres, const glm::mat4& transform);
+    void setMaterials(const std::vector<Material>& materials);
+    void setLights(const std::vector<Light>& lights);
+    void loadTextures(const std::vector<std::string>& paths);
+    void setMaxRecursion(uint32_t maxRecursion);
+    void build();
+    bool intersect(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Hit& hit) const;
+    bool occluded(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax) const;
+    std::vector<float> render(const glm::mat4& inverseView, const glm::mat4& inverseProj, uint32_t width, uint32_t height, JobSystem& jobs = JobSystem::getDefault(), uint32_t tileSize = 16) const;
+    const Primitive& getPrimitive(uint32_t primitive) const;
+    const Bvh& getBvh() const;
+private:
+    struct Instance{
+        std::vector<Vertex> vertices;   // Positionen und Normalen bereits in Weltkoordinaten
+        std::vector<uint32_t> indices;
+        std::vector<Sphere> spheres;
+    };
+    struct TextureData{
+        uint32_t width;
+        uint32_t height;
+        std::vector<glm::vec4> texels;  // linear, sRGB ist beim Laden schon umgerechnet
+    };
+    struct Payload{
+        glm::vec3 color;
+        int recursion;
+        float weight;
+    };
+    std::vector<Instance> m_instances;
+    std::vector<Primitive> m_primitives;
+    std::vector<Material> m_materials;
+    std::vector<Light> m_lights;
+    std::vector<TextureData> m_textures;
+    Material m_defaultMaterial{};
+    uint32_t m_maxRecursion = 4;
+    Bvh m_bvh;
+    Aabb getBounds(const Primitive& primitive) const;
+    bool intersectPrimitive(uint32_t primitive, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Hit& hit) const;
+    bool passesAlphaTest(const Primitive& primitive, float u, float v) const;
+    const Material& getMaterial(int matID) const;
+    glm::vec4 sampleTexture(int texId, glm::vec2 uv) const;
+    glm::vec3 processLight(const Light& light, glm::vec3 direction, glm::vec3 hitPos, glm::vec3 normal, float shininess, glm::vec3 ambi, glm::vec3 diff, glm::vec3 spec) const;
+    glm::vec3 shade(glm::vec3 direction, glm::vec3 position, glm::vec3 normal, const Material& material, glm::vec3 ambient, glm::vec3 diffuse, glm::vec3 specular) const;
+    void trace(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Payload& payload) const;
+    static glm::vec3 refractRay(glm::vec3 I, glm::vec3 N, float ior);
+    static void fresnel(glm::vec3 I, glm::vec3 N, float ior, float weight, float& kr, float& kt);
+};
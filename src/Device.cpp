@@ -1,4 +1,5 @@
 #include "Device.h"
+#include <algorithm>
 
 Device::Device(Instance* instance){
     m_instance = instance;
@@ -54,9 +55,10 @@ void Device::pickPhysicalDevice(){
 
 void Device::createLogicalDevice() {
     QueueFamilyIndices indices = findQueueFamilies(m_physical_device);
+    m_queueFamilyIndices = indices;
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value(), indices.transferFamily.value(), indices.computeFamily.value()};
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -88,6 +90,16 @@ void Device::createLogicalDevice() {
     //Um die Länge von UniformBuffer Arrays nicht sperat in Shader übergeben zu müssen
     m_enabledDescriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
     m_enabledDescriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+    //Bindless Arrays: nicht belegte Slots erlaubt, neue Geometrie und Texturen werden nach dem Binden geschrieben
+    m_enabledDescriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+    m_enabledDescriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+    m_enabledDescriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    m_enabledDescriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    m_enabledDescriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    m_enabledDescriptorIndexingFeatures.pNext = &m_enabledTimelineSemaphoreFeatures;
+    //Uploads und BLAS Builds signalisieren Timeline Werte, auf die die Graphics Queue wartet statt der CPU
+    m_enabledTimelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    m_enabledTimelineSemaphoreFeatures.timelineSemaphore = VK_TRUE;
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -108,6 +120,25 @@ void Device::createLogicalDevice() {
     }
     vkGetDeviceQueue(m_handle, indices.graphicsFamily.value(), 0, &m_graphics_queue);
     vkGetDeviceQueue(m_handle, indices.presentFamily.value(), 0, &m_present_queue);
+    vkGetDeviceQueue(m_handle, indices.transferFamily.value(), 0, &m_transfer_queue);
+    vkGetDeviceQueue(m_handle, indices.computeFamily.value(), 0, &m_compute_queue);
+    createTimelines();
+}
+
+void Device::createTimelines(){
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+    for (uint32_t queue = 0; queue < QueueCount; queue++) {
+        if (vkCreateSemaphore(m_handle, &semaphoreInfo, nullptr, &m_timelines[queue]) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create timeline semaphore!");
+        }
+        m_timelineValues[queue] = 0;
+    }
 }
 
 VkDevice Device::getHandle(){
@@ -126,8 +157,24 @@ VkQueue Device::getPresentQueue(){
     return m_present_queue;
 }
 
-bool Device::supportsAccelerationStructureHostCommands(){
-    return m_accelerationStructureFeatures.accelerationStructureHostCommands;
+VkQueue Device::getTransferQueue(){
+    return m_transfer_queue;
+}
+
+VkQueue Device::getComputeQueue(){
+    return m_compute_queue;
+}
+
+uint32_t Device::getGraphicsQueueFamily(){
+    return m_queueFamilyIndices.graphicsFamily.value();
+}
+
+uint32_t Device::getTransferQueueFamily(){
+    return m_queueFamilyIndices.transferFamily.value();
+}
+
+uint32_t Device::getComputeQueueFamily(){
+    return m_queueFamilyIndices.computeFamily.value();
 }
 
 uint32_t Device::getShaderGroupHandleSize(){
@@ -138,6 +185,53 @@ uint32_t Device::getShaderGroupHandleAlignment(){
     return m_rayTracingPipelineProperties.shaderGroupHandleAlignment;
 }
 
+uint32_t Device::getShaderGroupBaseAlignment(){
+    return m_rayTracingPipelineProperties.shaderGroupBaseAlignment;
+}
+
+uint32_t Device::getMaxShaderGroupStride(){
+    return m_rayTracingPipelineProperties.maxShaderGroupStride;
+}
+
+uint32_t Device::getMaxRayRecursionDepth(){
+    return m_rayTracingPipelineProperties.maxRayRecursionDepth;
+}
+
+std::string Device::getName(){
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(m_physical_device, &properties);
+    return std::string(properties.deviceName);
+}
+
+uint32_t Device::getDriverVersion(){
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(m_physical_device, &properties);
+    return properties.driverVersion;
+}
+
+// Buchführung über Gerätespeicher, Speicher der mehrfach freigegeben wird zählt nur einmal
+void Device::trackAllocation(VkDeviceMemory memory, VkDeviceSize size){
+    m_allocations[memory] = size;
+    m_allocatedBytes += size;
+    m_peakAllocatedBytes = std::max(m_peakAllocatedBytes, m_allocatedBytes);
+}
+
+void Device::trackFree(VkDeviceMemory memory){
+    auto it = m_allocations.find(memory);
+    if (it != m_allocations.end()) {
+        m_allocatedBytes -= it->second;
+        m_allocations.erase(it);
+    }
+}
+
+VkDeviceSize Device::getAllocatedBytes(){
+    return m_allocatedBytes;
+}
+
+VkDeviceSize Device::getPeakAllocatedBytes(){
+    return m_peakAllocatedBytes;
+}
+
 void Device::printPropertiesAndFeatures(){
     std::cout << "Picked Device: " <<m_deviceProperties2.properties.deviceName << std::endl;
     std::cout << std::endl;
@@ -188,8 +282,11 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device) {
         swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
     }
 
+    VkPhysicalDeviceTimelineSemaphoreFeatures supportedTimelineSemaphoreFeatures{};
+    supportedTimelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
     VkPhysicalDeviceBufferDeviceAddressFeatures supportedBufferDeviceAddressFeatures{};
     supportedBufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+    supportedBufferDeviceAddressFeatures.pNext = &supportedTimelineSemaphoreFeatures;
     VkPhysicalDeviceRayTracingPipelineFeaturesKHR supportedRayTracingPipelineFeatures{};
     supportedRayTracingPipelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_TRACING_PIPELINE_FEATURES_KHR;
     supportedRayTracingPipelineFeatures.pNext = &supportedBufferDeviceAddressFeatures;
@@ -201,7 +298,7 @@ bool Device::isDeviceSuitable(VkPhysicalDevice device) {
     supportedFeatures.pNext = &supportedAccelerationStructureFeatures;
     vkGetPhysicalDeviceFeatures2(device, &supportedFeatures);
 
-    if(supportedFeatures.features.samplerAnisotropy && supportedAccelerationStructureFeatures.accelerationStructure && supportedRayTracingPipelineFeatures.rayTracingPipeline && supportedBufferDeviceAddressFeatures.bufferDeviceAddress)
+    if(supportedFeatures.features.samplerAnisotropy && supportedAccelerationStructureFeatures.accelerationStructure && supportedRayTracingPipelineFeatures.rayTracingPipeline && supportedBufferDeviceAddressFeatures.bufferDeviceAddress && supportedTimelineSemaphoreFeatures.timelineSemaphore)
         requiredFeaturesSupported = true;
 
     return indices.isComplete() && extensionsSupported && swapChainAdequate && requiredFeaturesSupported;
@@ -216,26 +313,44 @@ QueueFamilyIndices Device::findQueueFamilies(VkPhysicalDevice device) {
     std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
     vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+    bool dedicatedTransfer = false;
     int i = 0;
     for (const auto& queueFamily : queueFamilies) {
-        if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+        if ((queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !indices.graphicsFamily.has_value()) {
             indices.graphicsFamily = i;
         }
 
         VkBool32 presentSupport = false;
         vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_instance->getSurface(), &presentSupport);
 
-        if (presentSupport) {
+        if (presentSupport && !indices.presentFamily.has_value()) {
             indices.presentFamily = i;
         }
 
-        if (indices.isComplete()) {
-            break;
+        // Reine Transfer Queue (DMA), sonst eine Transfer Queue ohne Grafik
+        if ((queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            bool dedicated = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+            if (!indices.transferFamily.has_value() || (dedicated && !dedicatedTransfer)) {
+                indices.transferFamily = i;
+                dedicatedTransfer = dedicated;
+            }
+        }
+
+        // Asynchrone Compute Queue für den Bau der Beschleunigungsstrukturen
+        if ((queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && !indices.computeFamily.has_value()) {
+            indices.computeFamily = i;
         }
 
         i++;
     }
 
+    if (!indices.transferFamily.has_value()) {
+        indices.transferFamily = indices.graphicsFamily;
+    }
+    if (!indices.computeFamily.has_value()) {
+        indices.computeFamily = indices.graphicsFamily;
+    }
+
     return indices;
 }
 
@@ -288,23 +403,143 @@ SwapChainSupportDetails Device::querySwapChainSupport() {
 }
 
 void Device::createCommandPool(){
-    QueueFamilyIndices queueFamilyIndices = findQueueFamilies();
     VkCommandPoolCreateInfo poolInfo{};
     poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily.value();
+    poolInfo.queueFamilyIndex = m_queueFamilyIndices.graphicsFamily.value();
 
     if (vkCreateCommandPool(m_handle, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS) {
         throw std::runtime_error("failed to create command pool!");
     }
+
+    poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = m_queueFamilyIndices.transferFamily.value();
+    if (vkCreateCommandPool(m_handle, &poolInfo, nullptr, &m_transferCommandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create transfer command pool!");
+    }
+
+    poolInfo.queueFamilyIndex = m_queueFamilyIndices.computeFamily.value();
+    if (vkCreateCommandPool(m_handle, &poolInfo, nullptr, &m_computeCommandPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create compute command pool!");
+    }
 }
 
 VkCommandPool Device::getCommandPool(){
     return m_commandPool;
 }
 
+VkCommandPool Device::getTransferCommandPool(){
+    return m_transferCommandPool;
+}
+
+VkCommandPool Device::getComputeCommandPool(){
+    return m_computeCommandPool;
+}
+
+VkQueue Device::getQueue(Queue queue){
+    switch (queue) {
+        case QueueTransfer: return m_transfer_queue;
+        case QueueCompute: return m_compute_queue;
+        default: return m_graphics_queue;
+    }
+}
+
+VkCommandPool Device::getCommandPool(Queue queue){
+    switch (queue) {
+        case QueueTransfer: return m_transferCommandPool;
+        case QueueCompute: return m_computeCommandPool;
+        default: return m_commandPool;
+    }
+}
+
+uint64_t Device::submitAsync(Queue queue, VkCommandBuffer command_buffer, const std::vector<TimelineWait>& waits){
+    if (vkEndCommandBuffer(command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to flush command buffer!");
+    }
+
+    std::vector<VkSemaphore> waitSemaphores;
+    std::vector<uint64_t> waitValues;
+    std::vector<VkPipelineStageFlags> waitStages;
+    for (const TimelineWait& wait : waits) {
+        // Bereits signalisierte Werte kosten nichts, 0 wird nie signalisiert
+        if (wait.value == 0) {
+            continue;
+        }
+        waitSemaphores.push_back(m_timelines[wait.queue]);
+        waitValues.push_back(wait.value);
+        waitStages.push_back(wait.stages);
+    }
+    uint64_t signalValue = m_timelineValues[queue] + 1;
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &command_buffer;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &m_timelines[queue];
+    if (vkQueueSubmit(getQueue(queue), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit command buffer!");
+    }
+    m_timelineValues[queue] = signalValue;
+
+    VkDevice device = m_handle;
+    VkCommandPool commandPool = getCommandPool(queue);
+    deferRelease(queue, signalValue, [device, commandPool, command_buffer](){
+        vkFreeCommandBuffers(device, commandPool, 1, &command_buffer);
+    });
+    return signalValue;
+}
+
+void Device::deferRelease(Queue queue, uint64_t value, std::function<void()> release){
+    m_pendingReleases.push_back({queue, value, std::move(release)});
+}
+
+void Device::retire(bool wait){
+    uint64_t completed[QueueCount] = {};
+    for (uint32_t queue = 0; queue < QueueCount; queue++) {
+        if (wait && m_timelineValues[queue] > 0) {
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &m_timelines[queue];
+            waitInfo.pValues = &m_timelineValues[queue];
+            if (vkWaitSemaphores(m_handle, &waitInfo, UINT64_MAX) != VK_SUCCESS) {
+                throw std::runtime_error("failed to wait for timeline semaphore!");
+            }
+        }
+        vkGetSemaphoreCounterValue(m_handle, m_timelines[queue], &completed[queue]);
+    }
+    // Freigaben in Submit Reihenfolge, spätere dürfen sich auf frühere verlassen
+    std::vector<PendingRelease> pending;
+    for (PendingRelease& entry : m_pendingReleases) {
+        if (entry.value <= completed[entry.queue]) {
+            entry.release();
+        } else {
+            pending.push_back(std::move(entry));
+        }
+    }
+    m_pendingReleases = std::move(pending);
+}
+
 Device::~Device(){}
 
 void Device::destroy(){
+    retire(true);
+    for (uint32_t queue = 0; queue < QueueCount; queue++) {
+        vkDestroySemaphore(m_handle, m_timelines[queue], nullptr);
+    }
     vkDestroyCommandPool(m_handle, m_commandPool, nullptr);
+    vkDestroyCommandPool(m_handle, m_transferCommandPool, nullptr);
+    vkDestroyCommandPool(m_handle, m_computeCommandPool, nullptr);
     vkDestroyDevice(m_handle, nullptr);
 }
\ No newline at end of file
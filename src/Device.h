@@ -1,18 +1,49 @@
 #pragma once
 
+#include <unordered_map>
+#include <functional>
 #include "Instance.h"
 #include "GlobalDefs.h"
 
 class Device
 {
+public:
+    // Jede Queue signalisiert bei asynchronen Submits den nächsten Wert ihrer Timeline Semaphore
+    enum Queue{
+        QueueGraphics = 0,
+        QueueTransfer = 1,
+        QueueCompute = 2,
+        QueueCount = 3
+    };
+    struct TimelineWait{
+        Queue queue;
+        uint64_t value;
+        VkPipelineStageFlags stages;
+    };
 private:
+    struct PendingRelease{
+        Queue queue;
+        uint64_t value;
+        std::function<void()> release;
+    };
     VkDevice m_handle;
     Instance* m_instance;
     VkPhysicalDevice m_physical_device;
     VkQueue m_graphics_queue;
     VkQueue m_present_queue;
+    VkQueue m_transfer_queue;
+    VkQueue m_compute_queue;
+    QueueFamilyIndices m_queueFamilyIndices;
     VkCommandPool m_commandPool = VK_NULL_HANDLE;
+    VkCommandPool m_transferCommandPool = VK_NULL_HANDLE;
+    VkCommandPool m_computeCommandPool = VK_NULL_HANDLE;
+    VkSemaphore m_timelines[QueueCount] = {};
+    uint64_t m_timelineValues[QueueCount] = {};
+    std::vector<PendingRelease> m_pendingReleases;
     std::vector<const char*> m_extensions;
+    std::unordered_map<VkDeviceMemory, VkDeviceSize> m_allocations;
+    VkDeviceSize m_allocatedBytes = 0;
+    VkDeviceSize m_peakAllocatedBytes = 0;
 
     VkPhysicalDeviceProperties2 m_deviceProperties2{};
     VkPhysicalDeviceRayTracingPipelinePropertiesKHR m_rayTracingPipelineProperties{};
@@ -27,7 +58,9 @@ private:
     VkPhysicalDeviceRayTracingPipelineFeaturesKHR m_enabledRayTracingPipelineFeatures{};
     VkPhysicalDeviceAccelerationStructureFeaturesKHR m_enabledAccelerationStructureFeatures{};
     VkPhysicalDeviceDescriptorIndexingFeatures m_enabledDescriptorIndexingFeatures{};
+    VkPhysicalDeviceTimelineSemaphoreFeatures m_enabledTimelineSemaphoreFeatures{};
 
+    void createTimelines();
     bool isDeviceSuitable(VkPhysicalDevice device);
     QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
     bool checkDeviceExtensionSupport(VkPhysicalDevice device);
@@ -42,13 +75,36 @@ public:
     VkDevice getHandle();
     VkQueue getGraphicsQueue();
     VkQueue getPresentQueue();
-    bool supportsAccelerationStructureHostCommands();
+    VkQueue getTransferQueue();
+    VkQueue getComputeQueue();
+    uint32_t getGraphicsQueueFamily();
+    uint32_t getTransferQueueFamily();
+    uint32_t getComputeQueueFamily();
     uint32_t getShaderGroupHandleSize();
     uint32_t getShaderGroupHandleAlignment();
+    uint32_t getShaderGroupBaseAlignment();
+    uint32_t getMaxShaderGroupStride();
+    uint32_t getMaxRayRecursionDepth();
     SwapChainSupportDetails querySwapChainSupport();
     QueueFamilyIndices findQueueFamilies();
     void createCommandPool();
     VkCommandPool getCommandPool();
+    VkCommandPool getTransferCommandPool();
+    VkCommandPool getComputeCommandPool();
+    VkQueue getQueue(Queue queue);
+    VkCommandPool getCommandPool(Queue queue);
+    // Beendet und submittet den Command Buffer ohne Host Wait, freigegeben wird er über retire
+    uint64_t submitAsync(Queue queue, VkCommandBuffer command_buffer, const std::vector<TimelineWait>& waits = {});
+    // release läuft, sobald die Timeline der Queue value erreicht hat
+    void deferRelease(Queue queue, uint64_t value, std::function<void()> release);
+    // Gibt abgeschlossene Arbeit frei, mit wait wird vorher auf alle Submits gewartet
+    void retire(bool wait = false);
+    std::string getName();
+    uint32_t getDriverVersion();
+    void trackAllocation(VkDeviceMemory memory, VkDeviceSize size);
+    void trackFree(VkDeviceMemory memory);
+    VkDeviceSize getAllocatedBytes();
+    VkDeviceSize getPeakAllocatedBytes();
     void destroy();
     ~Device();
 };
\ No newline at end of file
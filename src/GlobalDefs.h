@@ -18,6 +18,8 @@
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    std::optional<uint32_t> transferFamily;
+    std::optional<uint32_t> computeFamily;
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
     }
@@ -39,6 +41,8 @@ struct ScratchBuffer
 struct UniformBufferObject {
     glm::mat4 view;
     glm::mat4 proj;
+    uint32_t frameIndex;
+    uint32_t sampleIndex;   // Anzahl bereits akkumulierter Samples, 0 setzt zurück
 };
 
 struct Vertex
@@ -46,11 +50,12 @@ struct Vertex
     float position[3];
     int matID;
     float normal[3];
-    float pad0;
+    float triangleLod;      // 0.5 * log2(UV Fläche / Fläche) des Dreiecks, für Ray Cone Texture LOD
     float texture[2];
     float pad1[2];
 };
 
+// Eingabeformat von SphereFlake und den CPU Pfaden, BottomLevelSphereAS hält nur getrennte Ströme, siehe getStreams
 struct Sphere
 {
     float aabbmin[3];
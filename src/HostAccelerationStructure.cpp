@@ -0,0 +1,226 @@
+#include "HostAccelerationStructure.h"
+#include <algorithm>
+#include <stdexcept>
+#include "JobSystem.h"
+
+namespace {
+
+glm::vec3 toVec3(const float* values){
+    return glm::vec3(values[0], values[1], values[2]);
+}
+
+}
+
+HostAccelerationStructure::HostAccelerationStructure()
+{
+
+}
+
+uint32_t HostAccelerationStructure::addTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::mat4& transform){
+    uint32_t instance = m_instanceCount++;
+    for (uint32_t i = 0; i < indices.size() / 3; i++) {
+        for (uint32_t k = 0; k < 3; k++) {
+            m_triangleVertices.push_back(glm::vec3(transform * glm::vec4(toVec3(vertices[indices[3 * i + k]].position), 1.0f)));
+        }
+        m_triangleReferences.push_back({instance, i});
+    }
+    return instance;
+}
+
+// Wie intersection.rint: Mittelpunkt transformiert, Radius mit der Länge der ersten Spalte skaliert (gleichmäßige Skalierung)
+uint32_t HostAccelerationStructure::addSpheres(const std::vector<Sphere>& spheres, const glm::mat4& transform){
+    uint32_t instance = m_instanceCount++;
+    float scale = glm::length(glm::vec3(transform[0]));
+    for (uint32_t i = 0; i < spheres.size(); i++) {
+        Sphere sphere = spheres[i];
+        glm::vec3 center = glm::vec3(transform * glm::vec4(toVec3(sphere.center), 1.0f));
+        sphere.center[0] = center.x; sphere.center[1] = center.y; sphere.center[2] = center.z;
+        sphere.radius *= scale;
+        m_spheres.push_back(sphere);
+        m_sphereReferences.push_back({instance, i});
+    }
+    return instance;
+}
+
+void HostAccelerationStructure::build(){
+    build(Bvh::BuildSettings());
+}
+
+// Blätter sind auf Width Primitive begrenzt, damit jedes Blatt genau ein Paket wird
+void HostAccelerationStructure::build(const Bvh::BuildSettings& settings){
+    Bvh::BuildSettings wideSettings = settings;
+    wideSettings.maxLeafSize = std::min(std::max(settings.maxLeafSize, 1u), RayKernels::Width);
+
+    std::vector<Aabb> bounds(m_triangleReferences.size());
+    for (size_t i = 0; i < bounds.size(); i++) {
+        for (uint32_t k = 0; k < 3; k++) {
+            bounds[i].grow(m_triangleVertices[3 * i + k]);
+        }
+    }
+    Bvh bvh;
+    bvh.build(bounds, wideSettings);
+    m_triangleBvh.collapse(bvh);
+    const std::vector<WideBvh::Leaf>& triangleLeaves = m_triangleBvh.getLeaves();
+    m_trianglePackets.assign(triangleLeaves.size(), TrianglePacket{});
+    m_triangleLanes.assign(triangleLeaves.size() * RayKernels::Width, Reference{});
+    for (size_t leaf = 0; leaf < triangleLeaves.size(); leaf++) {
+        TrianglePacket& packet = m_trianglePackets[leaf];
+        for (uint32_t lane = 0; lane < triangleLeaves[leaf].count; lane++) {
+            uint32_t triangle = m_triangleBvh.getIndices()[triangleLeaves[leaf].first + lane];
+            glm::vec3 v0 = m_triangleVertices[3 * triangle];
+            glm::vec3 e1 = m_triangleVertices[3 * triangle + 1] - v0;
+            glm::vec3 e2 = m_triangleVertices[3 * triangle + 2] - v0;
+            for (int axis = 0; axis < 3; axis++) {
+                packet.v0[axis][lane] = v0[axis];
+                packet.e1[axis][lane] = e1[axis];
+                packet.e2[axis][lane] = e2[axis];
+            }
+            m_triangleLanes[leaf * RayKernels::Width + lane] = m_triangleReferences[triangle];
+        }
+    }
+
+    bvh.build(Bvh::getSphereBounds(m_spheres), wideSettings);
+    m_sphereBvh.collapse(bvh);
+    const std::vector<WideBvh::Leaf>& sphereLeaves = m_sphereBvh.getLeaves();
+    m_spherePackets.assign(sphereLeaves.size(), SpherePacket{});
+    m_sphereLanes.assign(sphereLeaves.size() * RayKernels::Width, Reference{});
+    for (size_t leaf = 0; leaf < sphereLeaves.size(); leaf++) {
+        SpherePacket& packet = m_spherePackets[leaf];
+        for (uint32_t lane = 0; lane < sphereLeaves[leaf].count; lane++) {
+            uint32_t index = m_sphereBvh.getIndices()[sphereLeaves[leaf].first + lane];
+            for (int axis = 0; axis < 3; axis++) {
+                packet.center[axis][lane] = m_spheres[index].center[axis];
+            }
+            packet.radius[lane] = m_spheres[index].radius;
+            m_sphereLanes[leaf * RayKernels::Width + lane] = m_sphereReferences[index];
+        }
+    }
+}
+
+void HostAccelerationStructure::setKernel(SimdKernel kernel){
+    m_triangleBvh.setKernel(kernel);
+    m_sphereBvh.setKernel(kernel);
+}
+
+SimdKernel HostAccelerationStructure::getKernel() const{
+    return m_triangleBvh.getKernel();
+}
+
+uint32_t HostAccelerationStructure::getPrimitiveCount() const{
+    return static_cast<uint32_t>(m_triangleReferences.size() + m_sphereReferences.size());
+}
+
+Aabb HostAccelerationStructure::getBounds() const{
+    Aabb bounds;
+    for (glm::vec3 vertex : m_triangleVertices) {
+        bounds.grow(vertex);
+    }
+    for (const Sphere& sphere : m_spheres) {
+        bounds.grow(toVec3(sphere.center) - glm::vec3(sphere.radius));
+        bounds.grow(toVec3(sphere.center) + glm::vec3(sphere.radius));
+    }
+    return bounds;
+}
+
+// Nimmt den nächsten Treffer im Paket, hit darf bei Verdeckungstests null sein
+bool HostAccelerationStructure::intersectTriangleLeaf(uint32_t leaf, glm::vec3 origin, glm::vec3 direction, float tmin, float& tmax, Hit* hit) const{
+    alignas(32) float t[RayKernels::Width];
+    alignas(32) float u[RayKernels::Width];
+    alignas(32) float v[RayKernels::Width];
+    uint32_t mask = RayKernels::intersectTriangles(m_trianglePackets[leaf], m_triangleBvh.getLeaves()[leaf].count, origin, direction, tmin, tmax, t, u, v, m_triangleBvh.getKernel());
+    if (mask == 0) {
+        return false;
+    }
+    int closest = -1;
+    for (uint32_t lane = 0; lane < RayKernels::Width; lane++) {
+        if ((mask & (1u << lane)) && (closest < 0 || t[lane] < t[closest])) {
+            closest = static_cast<int>(lane);
+        }
+    }
+    tmax = t[closest];
+    if (hit != nullptr) {
+        const Reference& reference = m_triangleLanes[leaf * RayKernels::Width + closest];
+        *hit = {t[closest], reference.instance, reference.primitive, u[closest], v[closest]};
+    }
+    return true;
+}
+
+bool HostAccelerationStructure::intersectSphereLeaf(uint32_t leaf, glm::vec3 origin, glm::vec3 direction, float tmin, float& tmax, Hit* hit) const{
+    alignas(32) float t[RayKernels::Width];
+    uint32_t mask = RayKernels::intersectSpheres(m_spherePackets[leaf], m_sphereBvh.getLeaves()[leaf].count, origin, direction, tmin, tmax, t, m_sphereBvh.getKernel());
+    if (mask == 0) {
+        return false;
+    }
+    int closest = -1;
+    for (uint32_t lane = 0; lane < RayKernels::Width; lane++) {
+        if ((mask & (1u << lane)) && (closest < 0 || t[lane] < t[closest])) {
+            closest = static_cast<int>(lane);
+        }
+    }
+    tmax = t[closest];
+    if (hit != nullptr) {
+        const Reference& reference = m_sphereLanes[leaf * RayKernels::Width + closest];
+        *hit = {t[closest], reference.instance, reference.primitive, 0.0f, 0.0f};
+    }
+    return true;
+}
+
+// Die Kugeln werden mit dem schon verkürzten tmax der Dreiecke durchsucht
+bool HostAccelerationStructure::intersect(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Hit& hit) const{
+    bool found = m_triangleBvh.traverse(origin, direction, tmin, tmax, false, [&](uint32_t leaf, float& leafTmax){
+        return intersectTriangleLeaf(leaf, origin, direction, tmin, leafTmax, &hit);
+    });
+    found |= m_sphereBvh.traverse(origin, direction, tmin, tmax, false, [&](uint32_t leaf, float& leafTmax){
+        return intersectSphereLeaf(leaf, origin, direction, tmin, leafTmax, &hit);
+    });
+    return found;
+}
+
+bool HostAccelerationStructure::occluded(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax) const{
+    float triangleTmax = tmax;
+    if (m_triangleBvh.traverse(origin, direction, tmin, triangleTmax, true, [&](uint32_t leaf, float& leafTmax){
+        return intersectTriangleLeaf(leaf, origin, direction, tmin, leafTmax, nullptr);
+    })) {
+        return true;
+    }
+    return m_sphereBvh.traverse(origin, direction, tmin, tmax, true, [&](uint32_t leaf, float& leafTmax){
+        return intersectSphereLeaf(leaf, origin, direction, tmin, leafTmax, nullptr);
+    });
+}
+
+// Kleine Batches wie ein einzelner Picking Strahl laufen direkt auf dem aufrufenden Thread
+void HostAccelerationStructure::runBatches(uint32_t rayCount, JobSystem& jobs, const std::function<void(uint32_t, uint32_t)>& work){
+    if (rayCount <= BatchSize) {
+        work(0, rayCount);
+        return;
+    }
+    jobs.parallelFor(0, rayCount, BatchSize, work);
+}
+
+std::vector<HostAccelerationStructure::Hit> HostAccelerationStructure::intersect(const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, const std::vector<float>& tmax, float tmin, JobSystem& jobs) const{
+    if (origins.size() != directions.size() || origins.size() != tmax.size()) {
+        throw std::runtime_error("ray batch arrays differ in size!");
+    }
+    std::vector<Hit> hits(origins.size());
+    runBatches(static_cast<uint32_t>(origins.size()), jobs, [&](uint32_t begin, uint32_t end){
+        for (uint32_t i = begin; i < end; i++) {
+            if (!intersect(origins[i], directions[i], tmin, tmax[i], hits[i])) {
+                hits[i] = {tmax[i], Miss, Miss, 0.0f, 0.0f};
+            }
+        }
+    });
+    return hits;
+}
+
+std::vector<uint8_t> HostAccelerationStructure::occluded(const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, const std::vector<float>& tmax, float tmin, JobSystem& jobs) const{
+    if (origins.size() != directions.size() || origins.size() != tmax.size()) {
+        throw std::runtime_error("ray batch arrays differ in size!");
+    }
+    std::vector<uint8_t> result(origins.size());
+    runBatches(static_cast<uint32_t>(origins.size()), jobs, [&](uint32_t begin, uint32_t end){
+        for (uint32_t i = begin; i < end; i++) {
+            result[i] = occluded(origins[i], directions[i], tmin, tmax[i]) ? 1 : 0;
+        }
+    });
+    return result;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "Bvh.h"
+#include "WideBvh.h"
+#include "RayKernels.h"
+#include "GlobalDefs.h"
+
+// Strahl Anfragen auf der CPU über dieselbe Geometrie wie die TLAS. Dreiecke und Kugeln liegen in je einer
+// WideBvh, deren Blätter höchstens ein Paket mit RayKernels::Width Primitiven enthalten.
+// Ohne Alpha Test, alle Geometrie gilt wie bei gl_RayFlagsOpaqueEXT als undurchsichtig.
+// Die Batch Varianten verteilen Blöcke von BatchSize Strahlen als Jobs auf jobs
+class HostAccelerationStructure
+{
+public:
+    static const uint32_t Miss = 0xFFFFFFFF;
+    static const uint32_t BatchSize = 64;
+    struct Hit{
+        float t;
+        uint32_t instance;      // Rückgabewert von addTriangles bzw. addSpheres, entspricht der TLAS Instanz, ohne Treffer Miss
+        uint32_t primitive;     // Dreieck bzw. Kugel innerhalb der Instanz
+        float u;                // Baryzentrische Koordinaten wie hitAttributeEXT, bei Kugeln 0
+        float v;
+    };
+    HostAccelerationStructure();
+    uint32_t addTriangles(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, const glm::mat4& transform);
+    uint32_t addSpheres(const std::vector<Sphere>& spheres, const glm::mat4& transform);
+    void build();
+    void build(const Bvh::BuildSettings& settings);
+    void setKernel(SimdKernel kernel);
+    SimdKernel getKernel() const;
+    uint32_t getPrimitiveCount() const;
+    Aabb getBounds() const;
+    bool intersect(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, Hit& hit) const;
+    bool occluded(glm::vec3 origin, glm::vec3 direction, float tmin, float tmax) const;
+    // Ein Eintrag pro Strahl, verfehlte Strahlen haben instance == Miss und t == tmax
+    std::vector<Hit> intersect(const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, const std::vector<float>& tmax, float tmin = 0.0f, JobSystem& jobs = JobSystem::getDefault()) const;
+    std::vector<uint8_t> occluded(const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, const std::vector<float>& tmax, float tmin = 0.0f, JobSystem& jobs = JobSystem::getDefault()) const;
+private:
+    struct Reference{
+        uint32_t instance;
+        uint32_t primitive;
+    };
+    std::vector<glm::vec3> m_triangleVertices;      // drei Ecken pro Dreieck in Weltkoordinaten
+    std::vector<Reference> m_triangleReferences;
+    std::vector<Sphere> m_spheres;                  // wie in intersection.rint transformiert
+    std::vector<Reference> m_sphereReferences;
+    uint32_t m_instanceCount = 0;
+    WideBvh m_triangleBvh;
+    WideBvh m_sphereBvh;
+    // Paket i gehört zu Blatt i der jeweiligen WideBvh, die Referenzen liegen pro Paket an Stelle i * Width + Spur
+    std::vector<TrianglePacket> m_trianglePackets;
+    std::vector<Reference> m_triangleLanes;
+    std::vector<SpherePacket> m_spherePackets;
+    std::vector<Reference> m_sphereLanes;
+    static void runBatches(uint32_t rayCount, JobSystem& jobs, const std::function<void(uint32_t, uint32_t)>& work);
+    bool intersectTriangleLeaf(uint32_t leaf, glm::vec3 origin, glm::vec3 direction, float tmin, float& tmax, Hit* hit) const;
+    bool intersectSphereLeaf(uint32_t leaf, glm::vec3 origin, glm::vec3 direction, float tmin, float& tmax, Hit* hit) const;
+};
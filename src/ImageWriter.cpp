@@ -0,0 +1,186 @@
+#include "ImageWriter.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+void appendU32BE(std::vector<uint8_t>& data, uint32_t value){
+    data.push_back(static_cast<uint8_t>(value >> 24));
+    data.push_back(static_cast<uint8_t>(value >> 16));
+    data.push_back(static_cast<uint8_t>(value >> 8));
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+template<typename T>
+void appendLE(std::vector<uint8_t>& data, T value){
+    uint8_t bytes[sizeof(T)];
+    memcpy(bytes, &value, sizeof(T));
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+void appendString(std::vector<uint8_t>& data, const std::string& value){
+    data.insert(data.end(), value.begin(), value.end());
+    data.push_back(0);
+}
+
+void appendChunk(std::vector<uint8_t>& png, const char* type, const std::vector<uint8_t>& data){
+    appendU32BE(png, static_cast<uint32_t>(data.size()));
+    size_t start = png.size();
+    png.insert(png.end(), type, type + 4);
+    png.insert(png.end(), data.begin(), data.end());
+    appendU32BE(png, ImageWriter::crc32(png.data() + start, png.size() - start));
+}
+
+void writeFile(const std::string& path, const std::vector<uint8_t>& data){
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to write image " + path + "!");
+    }
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+}
+
+}
+
+void ImageWriter::write(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb){
+    std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : "";
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    if (extension == ".png") {
+        writePNG(path, width, height, rgb);
+    } else if (extension == ".exr") {
+        writeEXR(path, width, height, rgb);
+    } else {
+        throw std::runtime_error("unsupported image format " + path + "!");
+    }
+}
+
+std::vector<uint8_t> ImageWriter::toRGB8(const std::vector<float>& rgb){
+    std::vector<uint8_t> bytes(rgb.size());
+    for (size_t i = 0; i < rgb.size(); i++) {
+        bytes[i] = static_cast<uint8_t>(std::clamp(rgb[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+    return bytes;
+}
+
+uint32_t ImageWriter::crc32(const uint8_t* data, size_t size, uint32_t crc){
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t ImageWriter::adler32(const uint8_t* data, size_t size){
+    uint32_t a = 1;
+    uint32_t b = 0;
+    for (size_t i = 0; i < size; i++) {
+        a = (a + data[i]) % 65521;
+        b = (b + a) % 65521;
+    }
+    return (b << 16) | a;
+}
+
+void ImageWriter::writePNG(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb){
+    if (rgb.size() != static_cast<size_t>(width) * height * 3) {
+        throw std::runtime_error("image size does not match pixel data!");
+    }
+    std::vector<uint8_t> pixels = toRGB8(rgb);
+    // Jede Zeile beginnt mit Filtertyp 0
+    size_t rowSize = static_cast<size_t>(width) * 3;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowSize + 1) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        raw.push_back(0);
+        raw.insert(raw.end(), pixels.begin() + y * rowSize, pixels.begin() + (y + 1) * rowSize);
+    }
+
+    // zlib Stream aus Stored Blöcken mit höchstens 65535 Byte
+    std::vector<uint8_t> zlib = {0x78, 0x01};
+    size_t offset = 0;
+    do {
+        uint16_t blockSize = static_cast<uint16_t>(std::min<size_t>(raw.size() - offset, 65535));
+        bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        appendLE<uint16_t>(zlib, blockSize);
+        appendLE<uint16_t>(zlib, static_cast<uint16_t>(~blockSize));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+    appendU32BE(zlib, adler32(raw.data(), raw.size()));
+
+    std::vector<uint8_t> header;
+    appendU32BE(header, width);
+    appendU32BE(header, height);
+    header.insert(header.end(), {8, 2, 0, 0, 0});  // 8 Bit, RGB, Deflate, Standardfilter, kein Interlacing
+
+    std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    appendChunk(png, "IHDR", header);
+    appendChunk(png, "IDAT", zlib);
+    appendChunk(png, "IEND", {});
+    writeFile(path, png);
+}
+
+void ImageWriter::writeEXR(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb){
+    if (rgb.size() != static_cast<size_t>(width) * height * 3) {
+        throw std::runtime_error("image size does not match pixel data!");
+    }
+    std::vector<uint8_t> exr = {0x76, 0x2F, 0x31, 0x01, 2, 0, 0, 0};
+
+    // Kanäle alphabetisch sortiert, jeweils FLOAT ohne Subsampling
+    std::vector<uint8_t> channels;
+    for (const char* name : {"B", "G", "R"}) {
+        appendString(channels, name);
+        appendLE<int32_t>(channels, 2);
+        channels.insert(channels.end(), {0, 0, 0, 0});
+        appendLE<int32_t>(channels, 1);
+        appendLE<int32_t>(channels, 1);
+    }
+    channels.push_back(0);
+    auto appendAttribute = [&](const std::string& name, const std::string& type, const std::vector<uint8_t>& value){
+        appendString(exr, name);
+        appendString(exr, type);
+        appendLE<int32_t>(exr, static_cast<int32_t>(value.size()));
+        exr.insert(exr.end(), value.begin(), value.end());
+    };
+    std::vector<uint8_t> window;
+    appendLE<int32_t>(window, 0);
+    appendLE<int32_t>(window, 0);
+    appendLE<int32_t>(window, static_cast<int32_t>(width) - 1);
+    appendLE<int32_t>(window, static_cast<int32_t>(height) - 1);
+    std::vector<uint8_t> one;
+    appendLE<float>(one, 1.0f);
+    std::vector<uint8_t> center;
+    appendLE<float>(center, 0.0f);
+    appendLE<float>(center, 0.0f);
+
+    appendAttribute("channels", "chlist", channels);
+    appendAttribute("compression", "compression", {0});
+    appendAttribute("dataWindow", "box2i", window);
+    appendAttribute("displayWindow", "box2i", window);
+    appendAttribute("lineOrder", "lineOrder", {0});
+    appendAttribute("pixelAspectRatio", "float", one);
+    appendAttribute("screenWindowCenter", "v2f", center);
+    appendAttribute("screenWindowWidth", "float", one);
+    exr.push_back(0);
+
+    // Offset Tabelle, danach eine Scanline pro Block: y, Größe, dann B, G und R Zeile nacheinander
+    uint32_t lineSize = width * 3 * sizeof(float);
+    uint64_t lineOffset = exr.size() + static_cast<uint64_t>(height) * sizeof(uint64_t);
+    for (uint32_t y = 0; y < height; y++) {
+        appendLE<uint64_t>(exr, lineOffset + static_cast<uint64_t>(y) * (8 + lineSize));
+    }
+    for (uint32_t y = 0; y < height; y++) {
+        appendLE<int32_t>(exr, static_cast<int32_t>(y));
+        appendLE<int32_t>(exr, static_cast<int32_t>(lineSize));
+        for (int channel = 2; channel >= 0; channel--) {
+            for (uint32_t x = 0; x < width; x++) {
+                appendLE<float>(exr, rgb[(static_cast<size_t>(y) * width + x) * 3 + channel]);
+            }
+        }
+    }
+    writeFile(path, exr);
+}
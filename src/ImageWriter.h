@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Schreibt RGB Float Bilder ohne externe Bibliotheken: PNG mit unkomprimierten Deflate Blöcken
+// (Werte auf [0, 1] geklemmt, wie im UNORM Storage Image) und EXR als unkomprimierte FLOAT Scanlines
+class ImageWriter
+{
+public:
+    static void write(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb);
+    static void writePNG(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb);
+    static void writeEXR(const std::string& path, uint32_t width, uint32_t height, const std::vector<float>& rgb);
+    static std::vector<uint8_t> toRGB8(const std::vector<float>& rgb);
+    static uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+    static uint32_t adler32(const uint8_t* data, size_t size);
+};
@@ -0,0 +1,230 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+namespace {
+
+// Worker merken sich ihr System und ihre Deque, damit verschachtelte Jobs lokal bleiben
+thread_local const JobSystem* t_system = nullptr;
+thread_local uint32_t t_queue = 0;
+
+}
+
+JobSystem::JobSystem(uint32_t threadCount)
+{
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    for (uint32_t i = 0; i < threadCount; i++) {
+        m_queues.push_back(std::make_unique<Queue>());
+    }
+    for (uint32_t i = 0; i + 1 < threadCount; i++) {
+        m_workers.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+        m_running = false;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+JobSystem& JobSystem::getDefault(){
+    static JobSystem jobSystem;
+    return jobSystem;
+}
+
+uint32_t JobSystem::getThreadCount() const{
+    return static_cast<uint32_t>(m_queues.size());
+}
+
+uint32_t JobSystem::getQueueIndex() const{
+    return t_system == this ? t_queue : static_cast<uint32_t>(m_queues.size()) - 1;
+}
+
+JobSystem::JobHandle JobSystem::create(std::function<void()> work){
+    JobHandle job = std::make_shared<Job>();
+    job->work = std::move(work);
+    return job;
+}
+
+JobSystem::JobHandle JobSystem::create(std::function<void()> work, const JobHandle& parent){
+    JobHandle job = create(std::move(work));
+    job->parent = parent;
+    parent->unfinished++;
+    return job;
+}
+
+void JobSystem::addDependency(const JobHandle& job, const JobHandle& dependency){
+    std::lock_guard<std::mutex> lock(dependency->mutex);
+    if (dependency->unfinished == 0) {
+        return;
+    }
+    job->blockers++;
+    dependency->dependents.push_back(job);
+}
+
+void JobSystem::run(const JobHandle& job){
+    if (--job->blockers == 0) {
+        push(job);
+    }
+}
+
+JobSystem::JobHandle JobSystem::run(std::function<void()> work){
+    JobHandle job = create(std::move(work));
+    run(job);
+    return job;
+}
+
+// m_waiting wird vor der Prüfung erhöht, finish() und push() lesen es nach ihrer Änderung. So sieht entweder
+// der Wartende den neuen Zustand oder der andere Thread den Wartenden und weckt ihn
+void JobSystem::wait(const JobHandle& job){
+    while (!isFinished(job)) {
+        if (JobHandle next = take()) {
+            execute(next);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_waiting++;
+        m_finished.wait(lock, [this, &job](){ return job->unfinished == 0 || m_queued > 0; });
+        m_waiting--;
+    }
+    std::lock_guard<std::mutex> lock(job->mutex);
+    if (job->exception) {
+        std::rethrow_exception(job->exception);
+    }
+}
+
+bool JobSystem::isFinished(const JobHandle& job) const{
+    return job->unfinished.load(std::memory_order_acquire) == 0;
+}
+
+void JobSystem::parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& body){
+    if (end <= begin) {
+        return;
+    }
+    grainSize = std::max(grainSize, 1u);
+    if (end - begin <= grainSize || m_queues.size() == 1) {
+        body(begin, end);
+        return;
+    }
+    JobHandle root = create(nullptr);
+    for (uint32_t blockBegin = begin; blockBegin < end; blockBegin += std::min(grainSize, end - blockBegin)) {
+        uint32_t blockEnd = blockBegin + std::min(grainSize, end - blockBegin);
+        run(create([&body, blockBegin, blockEnd](){ body(blockBegin, blockEnd); }, root));
+    }
+    run(root);
+    wait(root);
+}
+
+// Das kurze Sperren von m_sleepMutex verhindert, dass ein Worker zwischen Prüfung und Einschlafen das Signal verpasst
+void JobSystem::push(const JobHandle& job){
+    Queue& queue = *m_queues[getQueueIndex()];
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    m_queued++;
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_wake.notify_one();
+    notifyWaiters();
+}
+
+// Erst die eigene Deque von hinten, dann reihum von vorne bei den anderen
+JobSystem::JobHandle JobSystem::take(){
+    uint32_t own = getQueueIndex();
+    uint32_t queueCount = static_cast<uint32_t>(m_queues.size());
+    for (uint32_t i = 0; i < queueCount; i++) {
+        Queue& queue = *m_queues[(own + i) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) {
+            continue;
+        }
+        JobHandle job;
+        if (i == 0) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        } else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+        m_queued--;
+        return job;
+    }
+    return nullptr;
+}
+
+void JobSystem::execute(const JobHandle& job){
+    if (job->work) {
+        try {
+            job->work();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(job->mutex);
+            job->exception = std::current_exception();
+        }
+        job->work = nullptr;
+    }
+    finish(job);
+}
+
+// Gibt Abhängige frei und meldet das Ende an den Elternjob, Exceptions wandern nach oben
+void JobSystem::finish(const JobHandle& job){
+    if (--job->unfinished != 0) {
+        return;
+    }
+    notifyWaiters();
+    std::vector<JobHandle> dependents;
+    std::exception_ptr exception;
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        dependents.swap(job->dependents);
+        exception = job->exception;
+    }
+    for (const JobHandle& dependent : dependents) {
+        run(dependent);
+    }
+    if (JobHandle parent = job->parent) {
+        job->parent = nullptr;
+        if (exception) {
+            std::lock_guard<std::mutex> lock(parent->mutex);
+            if (!parent->exception) {
+                parent->exception = exception;
+            }
+        }
+        finish(parent);
+    }
+}
+
+// Ohne schlafende Wartende kostet das nur eine atomare Abfrage
+void JobSystem::notifyWaiters(){
+    if (m_waiting == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_sleepMutex);
+    }
+    m_finished.notify_all();
+}
+
+void JobSystem::workerLoop(uint32_t index){
+    t_system = this;
+    t_queue = index;
+    while (true) {
+        if (JobHandle job = take()) {
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(m_sleepMutex);
+        m_wake.wait(lock, [this](){ return !m_running || m_queued > 0; });
+        if (!m_running) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work Stealing Scheduler: jeder Worker hat eine eigene Deque, nimmt neue Jobs hinten (LIFO) und stiehlt
+// bei leerer Deque vorne bei den anderen. Threads außerhalb des Systems legen Jobs in eine gemeinsame Deque.
+// wait() arbeitet selbst Jobs ab, bis der erwartete Job fertig ist, so blockieren verschachtelte Jobs keine Worker.
+// Gibt es nichts zu helfen, schläft der Wartende bis zum Ende eines Jobs oder bis neue Jobs kommen
+class JobSystem
+{
+public:
+    struct Job{
+        std::function<void()> work;
+        std::shared_ptr<Job> parent;
+        std::atomic<uint32_t> unfinished{1};    // der Job selbst und seine noch laufenden Kinder
+        std::atomic<uint32_t> blockers{1};      // offene Abhängigkeiten plus eins bis zum Aufruf von run
+        std::mutex mutex;
+        std::vector<std::shared_ptr<Job>> dependents;
+        std::exception_ptr exception;
+    };
+    using JobHandle = std::shared_ptr<Job>;
+
+    // threadCount zählt den wartenden Thread mit, 1 heißt ohne Worker, 0 alle Hardware Threads
+    explicit JobSystem(uint32_t threadCount = 0);
+    ~JobSystem();
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    static JobSystem& getDefault();
+    uint32_t getThreadCount() const;
+
+    // Ein Kind muss erzeugt werden, bevor der Elternjob fertig ist, also vor run(parent) oder aus dessen Arbeit heraus
+    JobHandle create(std::function<void()> work);
+    JobHandle create(std::function<void()> work, const JobHandle& parent);
+    // job startet erst, wenn dependency mitsamt Kindern fertig ist. Muss vor run(job) aufgerufen werden
+    void addDependency(const JobHandle& job, const JobHandle& dependency);
+    void run(const JobHandle& job);
+    JobHandle run(std::function<void()> work);
+    // Führt bis zum Ende von job andere Jobs aus und wirft die erste Exception aus job oder seinen Kindern weiter
+    void wait(const JobHandle& job);
+    bool isFinished(const JobHandle& job) const;
+    // Teilt [begin, end) in Blöcke von höchstens grainSize, body(blockBegin, blockEnd) läuft parallel
+    void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const std::function<void(uint32_t, uint32_t)>& body);
+private:
+    struct Queue{
+        std::mutex mutex;
+        std::deque<JobHandle> jobs;
+    };
+    std::vector<std::unique_ptr<Queue>> m_queues;   // eine pro Worker, die letzte für fremde Threads
+    std::vector<std::thread> m_workers;
+    std::atomic<bool> m_running{true};
+    std::atomic<uint32_t> m_queued{0};
+    std::atomic<uint32_t> m_waiting{0};             // Threads, die in wait() schlafen
+    std::mutex m_sleepMutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_finished;
+    uint32_t getQueueIndex() const;
+    void push(const JobHandle& job);
+    JobHandle take();
+    void execute(const JobHandle& job);
+    void finish(const JobHandle& job);
+    void notifyWaiters();
+    void workerLoop(uint32_t index);
+};
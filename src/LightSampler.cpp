@@ -0,0 +1,121 @@
+#include "LightSampler.h"
+#include <algorithm>
+
+LightSampler::LightSampler()
+{
+
+}
+
+LightSampler::LightSampler(Device* device) : m_device(device)
+{
+
+}
+
+// Luminanz der Lichtfarbe, Punktlichter zusätzlich mit der Abschwächung bei Abstand 1 gewichtet
+float LightSampler::getPower(const Light& light){
+    float power = 0.2126f * light.m_color[0] + 0.7152f * light.m_color[1] + 0.0722f * light.m_color[2];
+    if (light.m_pos[3] > 0.0001f) {
+        float attenuation = light.m_attenuation[0] + light.m_attenuation[1] + light.m_attenuation[2];
+        if (attenuation > 0.0f) {
+            power /= attenuation;
+        }
+    }
+    return std::max(power, 0.0f);
+}
+
+std::vector<LightSampler::AliasEntry> LightSampler::buildAliasTable(const std::vector<float>& weights){
+    size_t count = weights.size();
+    std::vector<AliasEntry> table(count);
+    if (count == 0) {
+        return table;
+    }
+    double total = 0.0;
+    for (float weight : weights) {
+        total += std::max(weight, 0.0f);
+    }
+
+    // Skalierte Wahrscheinlichkeiten, Mittelwert 1
+    std::vector<double> scaled(count);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < count; i++) {
+        double pdf = total > 0.0 ? std::max(weights[i], 0.0f) / total : 1.0 / count;
+        table[i].pdf = static_cast<float>(pdf);
+        table[i].alias = static_cast<uint32_t>(i);
+        table[i].pad = 0.0f;
+        scaled[i] = pdf * count;
+        if (scaled[i] < 1.0) {
+            small.push_back(static_cast<uint32_t>(i));
+        } else {
+            large.push_back(static_cast<uint32_t>(i));
+        }
+    }
+
+    while (!small.empty() && !large.empty()) {
+        uint32_t less = small.back();
+        small.pop_back();
+        uint32_t more = large.back();
+        large.pop_back();
+        table[less].threshold = static_cast<float>(scaled[less]);
+        table[less].alias = more;
+        scaled[more] = (scaled[more] + scaled[less]) - 1.0;
+        if (scaled[more] < 1.0) {
+            small.push_back(more);
+        } else {
+            large.push_back(more);
+        }
+    }
+    // Übrig gebliebene Einträge liegen bis auf Rundungsfehler bei 1
+    for (uint32_t i : large) {
+        table[i].threshold = 1.0f;
+    }
+    for (uint32_t i : small) {
+        table[i].threshold = 1.0f;
+    }
+    return table;
+}
+
+// Baut die Tabelle nur neu, wenn sich die Leistung eines Lichts oder die Anzahl geändert hat.
+// Gibt true zurück, wenn der Buffer neu angelegt wurde und die Deskriptoren neu geschrieben werden müssen
+bool LightSampler::update(const std::vector<Light>& lights){
+    std::vector<float> powers(lights.size());
+    for (size_t i = 0; i < lights.size(); i++) {
+        powers[i] = getPower(lights[i]);
+    }
+    if (powers == m_powers && !m_table.empty()) {
+        return false;
+    }
+    m_powers = powers;
+    m_table = buildAliasTable(m_powers);
+
+    bool recreated = false;
+    if (m_table.size() > m_capacity) {
+        if (m_capacity > 0) {
+            m_buffer.destroy();
+        }
+        m_capacity = m_table.size();
+        m_buffer = Buffer(m_device, m_capacity * sizeof(AliasEntry), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        recreated = true;
+    }
+    m_buffer.map(m_table.size() * sizeof(AliasEntry), 0);
+    m_buffer.copyTo(m_table.data(), m_table.size() * sizeof(AliasEntry));
+    m_buffer.unmap();
+    return recreated;
+}
+
+VkDescriptorBufferInfo LightSampler::getDescriptorInfo(){
+    return m_buffer.getDescriptorInfo(m_capacity * sizeof(AliasEntry), 0);
+}
+
+const std::vector<LightSampler::AliasEntry>& LightSampler::getTable() const{
+    return m_table;
+}
+
+void LightSampler::destroy(){
+    if (m_capacity > 0) {
+        m_buffer.destroy();
+        m_capacity = 0;
+    }
+    m_powers.clear();
+    m_table.clear();
+}
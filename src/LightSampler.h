@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Buffer.h"
+#include "GlobalDefs.h"
+
+// Alias Tabelle über die Lichtleistung, damit ein Hit mit konstant vielen Schattenstrahlen
+// eine Stichprobe der Lichter auswertet statt alle abzufragen (Vose's Alias Methode)
+class LightSampler
+{
+public:
+    struct AliasEntry{
+        float threshold;    // Wahrscheinlichkeit, den eigenen Index zu behalten
+        uint32_t alias;     // sonst dieser Index
+        float pdf;          // Auswahlwahrscheinlichkeit des eigenen Index
+        float pad;
+    };
+    LightSampler();
+    LightSampler(Device* device);
+    bool update(const std::vector<Light>& lights);
+    VkDescriptorBufferInfo getDescriptorInfo();
+    const std::vector<AliasEntry>& getTable() const;
+    void destroy();
+    static float getPower(const Light& light);
+    static std::vector<AliasEntry> buildAliasTable(const std::vector<float>& weights);
+private:
+    Device* m_device;
+    Buffer m_buffer;
+    size_t m_capacity = 0;
+    std::vector<float> m_powers;
+    std::vector<AliasEntry> m_table;
+};
@@ -0,0 +1,260 @@
+#include "LightTree.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+const float PI = 3.14159265f;
+const uint32_t BIN_COUNT = 12;
+
+}
+
+static_assert(sizeof(LightTree::Node) == 64, "LightTree::Node must match LightNode in the hit shaders");
+
+LightTree::LightTree()
+{
+
+}
+
+LightTree::LightTree(Device* device) : m_device(device)
+{
+
+}
+
+// Punktlichter strahlen in alle Richtungen, der Kegel ist also die ganze Kugel
+LightTree::Primitive LightTree::getPrimitive(const std::vector<Light>& lights, uint32_t index){
+    const Light& light = lights[index];
+    Primitive primitive{};
+    primitive.lightIndex = index;
+    primitive.centroid = glm::vec3(light.m_pos[0], light.m_pos[1], light.m_pos[2]);
+    primitive.boundsMin = primitive.centroid;
+    primitive.boundsMax = primitive.centroid;
+    float power = 0.2126f * light.m_color[0] + 0.7152f * light.m_color[1] + 0.0722f * light.m_color[2];
+    float attenuation = light.m_attenuation[0] + light.m_attenuation[1] + light.m_attenuation[2];
+    primitive.power = attenuation > 0.0f ? power / attenuation : power;
+    primitive.cone = {glm::vec3(0.0f, 0.0f, 1.0f), PI, PI / 2.0f};
+    return primitive;
+}
+
+LightTree::Cone LightTree::mergeCones(const Cone& a, const Cone& b){
+    if (b.thetaO > a.thetaO) {
+        return mergeCones(b, a);
+    }
+    float thetaD = std::acos(glm::clamp(glm::dot(a.axis, b.axis), -1.0f, 1.0f));
+    float thetaE = std::max(a.thetaE, b.thetaE);
+    if (std::min(thetaD + b.thetaO, PI) <= a.thetaO) {
+        return {a.axis, a.thetaO, thetaE};
+    }
+    float thetaO = (a.thetaO + thetaD + b.thetaO) / 2.0f;
+    if (thetaO >= PI) {
+        return {a.axis, PI, thetaE};
+    }
+    glm::vec3 rotationAxis = glm::cross(a.axis, b.axis);
+    if (glm::length(rotationAxis) < 1e-6f) {
+        return {a.axis, PI, thetaE};
+    }
+    float thetaR = thetaO - a.thetaO;
+    glm::vec3 axis = glm::mat3(glm::rotate(glm::mat4(1.0f), thetaR, glm::normalize(rotationAxis))) * a.axis;
+    return {glm::normalize(axis), thetaO, thetaE};
+}
+
+float LightTree::orientationMeasure(const Cone& cone){
+    float thetaW = std::min(cone.thetaO + cone.thetaE, PI);
+    return 2.0f * PI * (1.0f - std::cos(cone.thetaO)) + PI / 2.0f * (2.0f * thetaW * std::sin(cone.thetaO) - std::cos(cone.thetaO - 2.0f * thetaW) - 2.0f * cone.thetaO * std::sin(cone.thetaO) + std::cos(cone.thetaO));
+}
+
+float LightTree::surfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax){
+    glm::vec3 extent = boundsMax - boundsMin;
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+void LightTree::setNode(Node& node, glm::vec3 boundsMin, glm::vec3 boundsMax, float power, const Cone& cone){
+    for (int i = 0; i < 3; i++) {
+        node.boundsMin[i] = boundsMin[i];
+        node.boundsMax[i] = boundsMax[i];
+        node.axis[i] = cone.axis[i];
+    }
+    node.power = power;
+    node.cosThetaO = std::cos(cone.thetaO);
+    node.cosThetaE = std::cos(cone.thetaE);
+}
+
+LightTree::Cone LightTree::getCone(const Node& node) const{
+    return {glm::vec3(node.axis[0], node.axis[1], node.axis[2]), std::acos(glm::clamp(node.cosThetaO, -1.0f, 1.0f)), std::acos(glm::clamp(node.cosThetaE, -1.0f, 1.0f))};
+}
+
+// Nur Punktlichter kommen in den Baum, Richtungslichter werden in den Shadern immer ausgewertet
+void LightTree::build(const std::vector<Light>& lights){
+    std::vector<Primitive> primitives;
+    for (uint32_t i = 0; i < lights.size(); i++) {
+        if (lights[i].m_pos[3] > 0.0001f) {
+            primitives.push_back(getPrimitive(lights, i));
+        }
+    }
+    m_nodes.clear();
+    if (primitives.empty()) {
+        return;
+    }
+    m_nodes.reserve(primitives.size() * 2 - 1);
+    buildRecursive(primitives, 0, primitives.size());
+}
+
+// Eltern werden vor ihren Kindern angelegt, Kinder haben also immer einen größeren Index
+uint32_t LightTree::buildRecursive(std::vector<Primitive>& primitives, size_t begin, size_t end){
+    uint32_t nodeIndex = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back(Node{});
+
+    glm::vec3 boundsMin = primitives[begin].boundsMin;
+    glm::vec3 boundsMax = primitives[begin].boundsMax;
+    glm::vec3 centroidMin = primitives[begin].centroid;
+    glm::vec3 centroidMax = primitives[begin].centroid;
+    float power = 0.0f;
+    Cone cone = primitives[begin].cone;
+    for (size_t i = begin; i < end; i++) {
+        boundsMin = glm::min(boundsMin, primitives[i].boundsMin);
+        boundsMax = glm::max(boundsMax, primitives[i].boundsMax);
+        centroidMin = glm::min(centroidMin, primitives[i].centroid);
+        centroidMax = glm::max(centroidMax, primitives[i].centroid);
+        power += primitives[i].power;
+        if (i > begin) {
+            cone = mergeCones(cone, primitives[i].cone);
+        }
+    }
+    setNode(m_nodes[nodeIndex], boundsMin, boundsMax, power, cone);
+
+    if (end - begin == 1) {
+        m_nodes[nodeIndex].leaf = 1;
+        m_nodes[nodeIndex].lightIndex = primitives[begin].lightIndex;
+        return nodeIndex;
+    }
+
+    // Gebinnte Surface Area Orientation Heuristic, punktförmige Boxen bekommen eine Mindestgröße
+    glm::vec3 extent = boundsMax - boundsMin;
+    float padding = 0.01f * std::max(extent.x, std::max(extent.y, extent.z)) + 1e-4f;
+    float bestCost = std::numeric_limits<float>::max();
+    int bestAxis = -1;
+    uint32_t bestBin = 0;
+    for (int axis = 0; axis < 3; axis++) {
+        float axisExtent = centroidMax[axis] - centroidMin[axis];
+        if (axisExtent <= 0.0f) {
+            continue;
+        }
+        struct Bin{
+            glm::vec3 boundsMin = glm::vec3(std::numeric_limits<float>::max());
+            glm::vec3 boundsMax = glm::vec3(-std::numeric_limits<float>::max());
+            float power = 0.0f;
+            Cone cone{};
+            uint32_t count = 0;
+        };
+        Bin bins[BIN_COUNT];
+        for (size_t i = begin; i < end; i++) {
+            uint32_t b = std::min(static_cast<uint32_t>(BIN_COUNT * (primitives[i].centroid[axis] - centroidMin[axis]) / axisExtent), BIN_COUNT - 1);
+            bins[b].boundsMin = glm::min(bins[b].boundsMin, primitives[i].boundsMin);
+            bins[b].boundsMax = glm::max(bins[b].boundsMax, primitives[i].boundsMax);
+            bins[b].power += primitives[i].power;
+            bins[b].cone = bins[b].count == 0 ? primitives[i].cone : mergeCones(bins[b].cone, primitives[i].cone);
+            bins[b].count++;
+        }
+        for (uint32_t split = 1; split < BIN_COUNT; split++) {
+            Bin left;
+            Bin right;
+            for (uint32_t b = 0; b < BIN_COUNT; b++) {
+                if (bins[b].count == 0) {
+                    continue;
+                }
+                Bin& side = b < split ? left : right;
+                side.boundsMin = glm::min(side.boundsMin, bins[b].boundsMin);
+                side.boundsMax = glm::max(side.boundsMax, bins[b].boundsMax);
+                side.power += bins[b].power;
+                side.cone = side.count == 0 ? bins[b].cone : mergeCones(side.cone, bins[b].cone);
+                side.count += bins[b].count;
+            }
+            if (left.count == 0 || right.count == 0) {
+                continue;
+            }
+            float cost = left.power * surfaceArea(left.boundsMin - padding, left.boundsMax + padding) * orientationMeasure(left.cone)
+                       + right.power * surfaceArea(right.boundsMin - padding, right.boundsMax + padding) * orientationMeasure(right.cone);
+            // Lange, dünne Knoten vermeiden
+            cost *= std::max(extent.x, std::max(extent.y, extent.z)) / std::max(extent[axis], 1e-6f);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestBin = split;
+            }
+        }
+    }
+
+    size_t middle = begin + (end - begin) / 2;
+    if (bestAxis >= 0) {
+        float axisExtent = centroidMax[bestAxis] - centroidMin[bestAxis];
+        auto split = std::partition(primitives.begin() + begin, primitives.begin() + end, [&](const Primitive& primitive){
+            uint32_t b = std::min(static_cast<uint32_t>(BIN_COUNT * (primitive.centroid[bestAxis] - centroidMin[bestAxis]) / axisExtent), BIN_COUNT - 1);
+            return b < bestBin;
+        });
+        middle = split - primitives.begin();
+    } else {
+        // Alle Lichter am selben Ort, einfach halbieren
+        std::nth_element(primitives.begin() + begin, primitives.begin() + middle, primitives.begin() + end, [](const Primitive& a, const Primitive& b){
+            return a.lightIndex < b.lightIndex;
+        });
+    }
+
+    uint32_t left = buildRecursive(primitives, begin, middle);
+    uint32_t right = buildRecursive(primitives, middle, end);
+    m_nodes[nodeIndex].left = left;
+    m_nodes[nodeIndex].right = right;
+    m_nodes[nodeIndex].leaf = 0;
+    return nodeIndex;
+}
+
+// Passt Boxen, Leistung und Kegel an bewegte Lichter an, die Topologie bleibt erhalten
+void LightTree::refit(const std::vector<Light>& lights){
+    for (size_t i = m_nodes.size(); i-- > 0;) {
+        Node& node = m_nodes[i];
+        if (node.leaf) {
+            Primitive primitive = getPrimitive(lights, node.lightIndex);
+            setNode(node, primitive.boundsMin, primitive.boundsMax, primitive.power, primitive.cone);
+            continue;
+        }
+        const Node& left = m_nodes[node.left];
+        const Node& right = m_nodes[node.right];
+        glm::vec3 boundsMin = glm::min(glm::vec3(left.boundsMin[0], left.boundsMin[1], left.boundsMin[2]), glm::vec3(right.boundsMin[0], right.boundsMin[1], right.boundsMin[2]));
+        glm::vec3 boundsMax = glm::max(glm::vec3(left.boundsMax[0], left.boundsMax[1], left.boundsMax[2]), glm::vec3(right.boundsMax[0], right.boundsMax[1], right.boundsMax[2]));
+        setNode(node, boundsMin, boundsMax, left.power + right.power, mergeCones(getCone(left), getCone(right)));
+    }
+}
+
+void LightTree::upload(){
+    // Leerer Baum bekommt einen Platzhalter, damit der Deskriptor gültig bleibt
+    size_t count = std::max<size_t>(m_nodes.size(), 1);
+    if (count > m_capacity) {
+        if (m_capacity > 0) {
+            m_buffer.destroy();
+        }
+        m_capacity = count;
+        m_buffer = Buffer(m_device, m_capacity * sizeof(Node), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    }
+    if (m_nodes.empty()) {
+        return;
+    }
+    m_buffer.map(m_nodes.size() * sizeof(Node), 0);
+    m_buffer.copyTo(m_nodes.data(), m_nodes.size() * sizeof(Node));
+    m_buffer.unmap();
+}
+
+VkDescriptorBufferInfo LightTree::getDescriptorInfo(){
+    return m_buffer.getDescriptorInfo(m_capacity * sizeof(Node), 0);
+}
+
+const std::vector<LightTree::Node>& LightTree::getNodes() const{
+    return m_nodes;
+}
+
+void LightTree::destroy(){
+    if (m_capacity > 0) {
+        m_buffer.destroy();
+        m_capacity = 0;
+    }
+    m_nodes.clear();
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Buffer.h"
+#include "GlobalDefs.h"
+
+// Hierarchie über die Punktlichter für Importance Sampling nach geschätztem Beitrag
+// (nach Conty und Kulla, "Importance Sampling of Many Lights with Adaptive Tree Splitting").
+// Jeder Knoten speichert Bounding Box, Leistung und einen Orientierungskegel, Blätter genau ein Licht
+class LightTree
+{
+public:
+    // Layout entspricht dem LightNode in den Hit Shadern (std430, 64 Byte)
+    struct Node{
+        float boundsMin[3];
+        float power;
+        float boundsMax[3];
+        float cosThetaO;        // Öffnung des Kegels um die Achse, in dem Licht austritt
+        float axis[3];
+        float cosThetaE;        // zusätzlicher Abstrahlwinkel über thetaO hinaus
+        uint32_t left;          // bei inneren Knoten die Kinder, rechts folgt nicht zwingend links
+        uint32_t right;
+        uint32_t lightIndex;    // Index in den Light Buffer, nur bei Blättern gültig
+        uint32_t leaf;
+    };
+    LightTree();
+    LightTree(Device* device);
+    void build(const std::vector<Light>& lights);
+    void refit(const std::vector<Light>& lights);
+    void upload();
+    VkDescriptorBufferInfo getDescriptorInfo();
+    const std::vector<Node>& getNodes() const;
+    void destroy();
+private:
+    struct Cone{
+        glm::vec3 axis;
+        float thetaO;
+        float thetaE;
+    };
+    struct Primitive{
+        uint32_t lightIndex;
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+        glm::vec3 centroid;
+        float power;
+        Cone cone;
+    };
+    Device* m_device;
+    Buffer m_buffer;
+    size_t m_capacity = 0;
+    std::vector<Node> m_nodes;
+    uint32_t buildRecursive(std::vector<Primitive>& primitives, size_t begin, size_t end);
+    void setNode(Node& node, glm::vec3 boundsMin, glm::vec3 boundsMax, float power, const Cone& cone);
+    Cone getCone(const Node& node) const;
+    static Primitive getPrimitive(const std::vector<Light>& lights, uint32_t index);
+    static Cone mergeCones(const Cone& a, const Cone& b);
+    static float orientationMeasure(const Cone& cone);
+    static float surfaceArea(glm::vec3 boundsMin, glm::vec3 boundsMax);
+};
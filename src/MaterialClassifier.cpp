@@ -0,0 +1,32 @@
+#include "MaterialClassifier.h"
+
+// Jede Variante muss alle Features ihrer Materialien abdecken: Alpha ist der volle Shader mit Any Hit,
+// Brechung und Reflexion enthalten zusätzlich Texturen, nur Diffuse kommt ganz ohne Texturen aus
+MaterialVariant MaterialClassifier::classify(const Material& material){
+    if (material.alphaTexId >= 0) {
+        return MaterialVariantAlpha;
+    }
+    if (material.illum == 7) {
+        return MaterialVariantRefractive;
+    }
+    if (material.illum == 3) {
+        return MaterialVariantReflective;
+    }
+    if (material.ambientTexId >= 0 || material.diffuseTexId >= 0 || material.specularTexId >= 0) {
+        return MaterialVariantTextured;
+    }
+    return MaterialVariantDiffuse;
+}
+
+const char* MaterialClassifier::getName(MaterialVariant variant){
+    switch (variant)
+    {
+        case MaterialVariantDiffuse:    return "diffuse";
+        case MaterialVariantTextured:   return "textured";
+        case MaterialVariantReflective: return "reflective";
+        case MaterialVariantRefractive: return "refractive";
+        case MaterialVariantAlpha:      return "alpha";
+        default:                        break;
+    }
+    throw std::runtime_error("unknown material variant!");
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "GlobalDefs.h"
+
+// Die Reihenfolge entspricht den Dreieck Hit Groups in der SBT und MATERIAL_VARIANT in closesthit.rchit,
+// die Kugel Hit Group folgt direkt danach
+enum MaterialVariant{
+    MaterialVariantDiffuse = 0,
+    MaterialVariantTextured,
+    MaterialVariantReflective,
+    MaterialVariantRefractive,
+    MaterialVariantAlpha,
+    MaterialVariantCount
+};
+
+// Ordnet Materialien einer Variante zu, deren Hit Shader nur die benötigten Features enthält
+class MaterialClassifier
+{
+public:
+    static MaterialVariant classify(const Material& material);
+    static const char* getName(MaterialVariant variant);
+};
@@ -0,0 +1,128 @@
+#include "PipelineCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+PipelineCache::PipelineCache()
+{
+
+}
+
+PipelineCache::PipelineCache(Device* device, std::string filepath) : m_device(device), m_filepath(filepath)
+{
+
+}
+
+PipelineCache::FileHeader PipelineCache::getExpectedHeader(){
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(m_device->getPhysicalDevice(), &properties);
+    FileHeader header{};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    std::memcpy(header.uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    return header;
+}
+
+// Liefert leere Daten, wenn die Datei fehlt, von einem anderen Gerät bzw. Treiber stammt oder abgeschnitten ist
+std::vector<char> PipelineCache::readFile(const std::string& filepath, const FileHeader& expected){
+    std::ifstream file(filepath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return {};
+    }
+    uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0);
+    FileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader))) {
+        return {};
+    }
+    if (header.magic != expected.magic || header.version != expected.version ||
+        header.vendorID != expected.vendorID || header.deviceID != expected.deviceID ||
+        header.driverVersion != expected.driverVersion || std::memcmp(header.uuid, expected.uuid, VK_UUID_SIZE) != 0) {
+        std::cout << "pipeline cache " << filepath << " belongs to another device or driver, starting cold" << std::endl;
+        return {};
+    }
+    // dataSize kommt aus der Datei, vor dem Anlegen des Puffers gegen die echte Größe prüfen
+    if (header.dataSize > fileSize - sizeof(FileHeader)) {
+        std::cout << "pipeline cache " << filepath << " is truncated, starting cold" << std::endl;
+        return {};
+    }
+    std::vector<char> data(static_cast<size_t>(header.dataSize));
+    if (!file.read(data.data(), data.size())) {
+        return {};
+    }
+    return data;
+}
+
+void PipelineCache::create(){
+    std::vector<char> data = readFile(m_filepath, getExpectedHeader());
+    m_warm = !data.empty();
+
+    VkPipelineCacheCreateInfo cacheInfo{};
+    cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cacheInfo.initialDataSize = data.size();
+    cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+    if (vkCreatePipelineCache(m_device->getHandle(), &cacheInfo, nullptr, &m_handle) != VK_SUCCESS) {
+        // Der Treiber darf ungültige Daten ablehnen, dann leer neu anlegen
+        cacheInfo.initialDataSize = 0;
+        cacheInfo.pInitialData = nullptr;
+        m_warm = false;
+        if (vkCreatePipelineCache(m_device->getHandle(), &cacheInfo, nullptr, &m_handle) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+    }
+}
+
+void PipelineCache::save(){
+    if (m_handle == VK_NULL_HANDLE) {
+        return;
+    }
+    size_t dataSize = 0;
+    if (vkGetPipelineCacheData(m_device->getHandle(), m_handle, &dataSize, nullptr) != VK_SUCCESS || dataSize == 0) {
+        return;
+    }
+    std::vector<char> data(dataSize);
+    if (vkGetPipelineCacheData(m_device->getHandle(), m_handle, &dataSize, data.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to read pipeline cache data!");
+    }
+
+    data.resize(dataSize);
+    writeFile(m_filepath, getExpectedHeader(), data);
+}
+
+// In eine temporäre Datei schreiben und umbenennen, damit ein Absturz keinen halben Cache hinterlässt
+void PipelineCache::writeFile(const std::string& filepath, FileHeader header, const std::vector<char>& data){
+    header.dataSize = data.size();
+    std::filesystem::path path(filepath);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path());
+    }
+    std::string tempPath = filepath + ".tmp";
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to write pipeline cache " + filepath + "!");
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+        file.write(data.data(), data.size());
+    }
+    std::filesystem::rename(tempPath, filepath);
+}
+
+void PipelineCache::destroy(){
+    if (m_handle != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(m_device->getHandle(), m_handle, nullptr);
+        m_handle = VK_NULL_HANDLE;
+    }
+}
+
+VkPipelineCache PipelineCache::getHandle(){
+    return m_handle;
+}
+
+bool PipelineCache::isWarm() const{
+    return m_warm;
+}
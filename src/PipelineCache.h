@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Device.h"
+#include "GlobalDefs.h"
+
+// VkPipelineCache, der zwischen Programmstarts auf der Platte liegt. Die Datei trägt einen eigenen
+// Kopf mit Geräte UUID und Treiberversion, passt beides nicht wird mit leerem Cache gestartet
+class PipelineCache
+{
+public:
+    struct FileHeader{
+        uint32_t magic;
+        uint32_t version;
+        uint32_t vendorID;
+        uint32_t deviceID;
+        uint32_t driverVersion;
+        uint8_t uuid[VK_UUID_SIZE];
+        uint64_t dataSize;
+    };
+    PipelineCache();
+    PipelineCache(Device* device, std::string filepath);
+    void create();
+    void save();
+    void destroy();
+    VkPipelineCache getHandle();
+    bool isWarm() const;
+    // Ohne Gerät nutzbar: liefert leere Daten, wenn der Kopf nicht zu expected passt oder die Datei zu kurz ist
+    static std::vector<char> readFile(const std::string& filepath, const FileHeader& expected);
+    static void writeFile(const std::string& filepath, FileHeader header, const std::vector<char>& data);
+private:
+    static const uint32_t FILE_MAGIC = 0x4B525450; // "PTRK"
+    static const uint32_t FILE_VERSION = 1;
+    Device* m_device;
+    std::string m_filepath;
+    VkPipelineCache m_handle = VK_NULL_HANDLE;
+    bool m_warm = false;
+    FileHeader getExpectedHeader();
+};
@@ -0,0 +1,200 @@
+#include "Profiler.h"
+
+Profiler::Profiler()
+{
+
+}
+
+void Profiler::create(Device* device, uint32_t frameSlots, uint32_t maxMarkers){
+    if (m_queryPool != VK_NULL_HANDLE) {
+        destroy();
+    }
+    m_device = device;
+    // Zusätzliche Slots für einmalige Arbeit: synchron auf der Graphics Queue (TLAS) und asynchron auf der Compute Queue (BLAS)
+    m_slotCount = frameSlots + 2;
+    m_maxMarkers = maxMarkers;
+    m_markers = std::vector<std::vector<Marker>>(m_slotCount);
+    m_open = std::vector<std::vector<uint32_t>>(m_slotCount);
+    m_submitted = std::vector<bool>(m_slotCount, false);
+    m_slotFrames = std::vector<uint64_t>(m_slotCount, 0);
+
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(m_device->getPhysicalDevice(), &properties);
+    m_timestampPeriod = properties.limits.timestampPeriod;
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device->getPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_device->getPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+    // timestampValidBits kann sich je Familie unterscheiden, z.B. zwischen Graphics und Async Compute
+    m_validBits = std::vector<uint32_t>(queueFamilyCount);
+    m_timestampMasks = std::vector<uint64_t>(queueFamilyCount);
+    for (uint32_t i = 0; i < queueFamilyCount; i++) {
+        m_validBits[i] = queueFamilies[i].timestampValidBits;
+        m_timestampMasks[i] = getTimestampMask(m_validBits[i]);
+    }
+    m_slotFamilies = std::vector<uint32_t>(m_slotCount, m_device->getGraphicsQueueFamily());
+
+    VkQueryPoolCreateInfo queryPoolInfo{};
+    queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    queryPoolInfo.queryCount = m_slotCount * m_maxMarkers * 2;
+
+    if (vkCreateQueryPool(m_device->getHandle(), &queryPoolInfo, nullptr, &m_queryPool) != VK_SUCCESS) {
+        throw std::runtime_error("failed to create timestamp query pool!");
+    }
+    resetPool();
+}
+
+// Alle Queries einmal zurücksetzen, damit nie ein uninitialisierter Slot gelesen wird
+void Profiler::resetPool(){
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_device->getCommandPool();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer;
+    if (vkAllocateCommandBuffers(m_device->getHandle(), &allocInfo, &command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffer!");
+    }
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &beginInfo);
+    vkCmdResetQueryPool(command_buffer, m_queryPool, 0, m_slotCount * m_maxMarkers * 2);
+    vkEndCommandBuffer(command_buffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &command_buffer;
+    if (vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit query pool reset!");
+    }
+    vkQueueWaitIdle(m_device->getGraphicsQueue());
+    vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), 1, &command_buffer);
+}
+
+bool Profiler::supports(uint32_t queueFamily) const{
+    return m_queryPool != VK_NULL_HANDLE && queueFamily < m_validBits.size() && m_validBits[queueFamily] > 0;
+}
+
+uint32_t Profiler::getImmediateSlot() const{
+    return m_slotCount - 1;
+}
+
+uint32_t Profiler::getAsyncSlot() const{
+    return m_slotCount - 2;
+}
+
+// Submittet aber noch nicht ausgelesen
+bool Profiler::isPending(uint32_t slot) const{
+    return m_submitted[slot];
+}
+
+void Profiler::reset(VkCommandBuffer command_buffer, uint32_t slot, uint32_t queueFamily){
+    m_slotFamilies[slot] = queueFamily;
+    vkCmdResetQueryPool(command_buffer, m_queryPool, slot * m_maxMarkers * 2, m_maxMarkers * 2);
+    m_markers[slot].clear();
+    m_open[slot].clear();
+    m_submitted[slot] = false;
+}
+
+void Profiler::begin(VkCommandBuffer command_buffer, uint32_t slot, std::string name){
+    if (m_markers[slot].size() >= m_maxMarkers) {
+        m_open[slot].push_back(UINT32_MAX);
+        return;
+    }
+    uint32_t query = (slot * m_maxMarkers + static_cast<uint32_t>(m_markers[slot].size())) * 2;
+    m_open[slot].push_back(static_cast<uint32_t>(m_markers[slot].size()));
+    m_markers[slot].push_back({name, query, m_timestampMasks[m_slotFamilies[slot]]});
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_queryPool, query);
+}
+
+void Profiler::end(VkCommandBuffer command_buffer, uint32_t slot){
+    if (m_open[slot].empty()) {
+        throw std::runtime_error("profiler marker ended without begin!");
+    }
+    uint32_t marker = m_open[slot].back();
+    m_open[slot].pop_back();
+    if (marker == UINT32_MAX) {
+        return;
+    }
+    vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_queryPool, m_markers[slot][marker].query + 1);
+}
+
+void Profiler::markSubmitted(uint32_t slot, uint64_t frame){
+    m_submitted[slot] = true;
+    m_slotFrames[slot] = frame;
+}
+
+// Ergebnisse von Frames vor diesem Index werden verworfen (z.B. Warm-up)
+void Profiler::setMinFrame(uint64_t frame){
+    m_minFrame = frame;
+}
+
+// Liest die Ergebnisse ohne zu warten, nicht verfügbare Marker werden übersprungen
+void Profiler::collect(uint32_t slot){
+    if (!m_submitted[slot] || m_markers[slot].empty()) {
+        return;
+    }
+    m_submitted[slot] = false;
+    if (m_slotFrames[slot] < m_minFrame) {
+        return;
+    }
+
+    uint32_t queryCount = static_cast<uint32_t>(m_markers[slot].size()) * 2;
+    // Pro Query Wert und Verfügbarkeit
+    std::vector<uint64_t> results(queryCount * 2);
+    vkGetQueryPoolResults(m_device->getHandle(), m_queryPool, slot * m_maxMarkers * 2, queryCount, results.size() * sizeof(uint64_t), results.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    for (size_t i = 0; i < m_markers[slot].size(); i++) {
+        uint64_t beginValue = results[i * 4];
+        uint64_t beginAvailable = results[i * 4 + 1];
+        uint64_t endValue = results[i * 4 + 2];
+        uint64_t endAvailable = results[i * 4 + 3];
+        if (beginAvailable == 0 || endAvailable == 0) {
+            continue;
+        }
+        uint64_t ticks = (endValue - beginValue) & m_markers[slot][i].timestampMask;
+        m_stats.add(m_markers[slot][i].name, ticks * static_cast<double>(m_timestampPeriod) / 1000000.0);
+    }
+}
+
+// Nach vkDeviceWaitIdle aufrufen, um die letzten Frames noch einzusammeln
+void Profiler::collectAll(){
+    for (uint32_t slot = 0; slot < m_slotCount; slot++) {
+        collect(slot);
+    }
+}
+
+TimingStats& Profiler::getStats(){
+    return m_stats;
+}
+
+// Nur die unteren validBits eines Timestamps sind gültig, die Differenz wird darauf maskiert
+uint64_t Profiler::getTimestampMask(uint32_t validBits){
+    return validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+}
+
+void Profiler::destroy(){
+    if (m_queryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(m_device->getHandle(), m_queryPool, nullptr);
+        m_queryPool = VK_NULL_HANDLE;
+    }
+}
+
+ProfilerScope::ProfilerScope(Profiler* profiler, VkCommandBuffer command_buffer, uint32_t slot, std::string name) : m_profiler(profiler), m_commandBuffer(command_buffer), m_slot(slot)
+{
+    if (m_profiler) {
+        m_profiler->begin(m_commandBuffer, m_slot, name);
+    }
+}
+
+ProfilerScope::~ProfilerScope()
+{
+    if (m_profiler) {
+        m_profiler->end(m_commandBuffer, m_slot);
+    }
+}
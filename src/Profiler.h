@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Device.h"
+#include "GlobalDefs.h"
+#include "TimingStats.h"
+
+// GPU Zeitmessung über Timestamp Queries. Jeder Slot gehört zu einem Command Buffer,
+// ausgelesen wird erst wenn der Slot wieder verwendet wird (N Frames Latenz)
+class Profiler
+{
+private:
+    struct Marker{
+        std::string name;
+        uint32_t query;
+        uint64_t timestampMask;
+    };
+    Device* m_device = nullptr;
+    VkQueryPool m_queryPool = VK_NULL_HANDLE;
+    uint32_t m_slotCount = 0;
+    uint32_t m_maxMarkers = 0;
+    float m_timestampPeriod = 1.0f;
+    std::vector<uint32_t> m_validBits;
+    std::vector<uint64_t> m_timestampMasks;
+    std::vector<uint32_t> m_slotFamilies;
+    std::vector<std::vector<Marker>> m_markers;
+    std::vector<std::vector<uint32_t>> m_open;
+    std::vector<bool> m_submitted;
+    std::vector<uint64_t> m_slotFrames;
+    uint64_t m_minFrame = 0;
+    TimingStats m_stats;
+    void resetPool();
+public:
+    Profiler();
+    void create(Device* device, uint32_t frameSlots, uint32_t maxMarkers);
+    bool supports(uint32_t queueFamily) const;
+    uint32_t getImmediateSlot() const;
+    uint32_t getAsyncSlot() const;
+    bool isPending(uint32_t slot) const;
+    // queueFamily ist die Familie, auf der der Command Buffer des Slots submittet wird
+    void reset(VkCommandBuffer command_buffer, uint32_t slot, uint32_t queueFamily);
+    void begin(VkCommandBuffer command_buffer, uint32_t slot, std::string name);
+    void end(VkCommandBuffer command_buffer, uint32_t slot);
+    void markSubmitted(uint32_t slot, uint64_t frame = 0);
+    void setMinFrame(uint64_t frame);
+    void collect(uint32_t slot);
+    void collectAll();
+    TimingStats& getStats();
+    static uint64_t getTimestampMask(uint32_t validBits);
+    void destroy();
+};
+
+// Misst den umschlossenen Bereich, profiler darf nullptr sein
+class ProfilerScope
+{
+private:
+    Profiler* m_profiler;
+    VkCommandBuffer m_commandBuffer;
+    uint32_t m_slot;
+public:
+    ProfilerScope(Profiler* profiler, VkCommandBuffer command_buffer, uint32_t slot, std::string name);
+    ~ProfilerScope();
+};
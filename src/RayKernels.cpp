@@ -0,0 +1,392 @@
+#include "RayKernels.h"
+#include <algorithm>
+#include <cmath>
+
+// Die AVX2 Funktionen werden einzeln für AVX2 übersetzt, der Rest der Datei läuft auf jeder x86-64 CPU
+#if defined(VKR_AVX2) && (defined(__x86_64__) || defined(_M_X64))
+#define VKR_KERNEL_AVX2
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define VKR_TARGET_AVX2
+#else
+#define VKR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VKR_KERNEL_SSE
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const float DETERMINANT_EPSILON = 1e-12f;
+
+uint32_t laneMask(uint32_t count){
+    return count >= 8 ? 0xFFu : (1u << count) - 1u;
+}
+
+// Je Achse die nähere und fernere Ebene abhängig vom Vorzeichen der Richtung, dadurch ohne min/max pro Achse
+uint32_t intersectBoxesScalar(const float bounds[6][8], glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax, float* distances){
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < 8; i++) {
+        float tNear = tmin;
+        float tFar = tmax;
+        for (int axis = 0; axis < 3; axis++) {
+            bool positive = inverseDirection[axis] >= 0.0f;
+            float nearPlane = bounds[positive ? axis : axis + 3][i];
+            float farPlane = bounds[positive ? axis + 3 : axis][i];
+            tNear = std::max(tNear, (nearPlane - origin[axis]) * inverseDirection[axis]);
+            tFar = std::min(tFar, (farPlane - origin[axis]) * inverseDirection[axis]);
+        }
+        distances[i] = tNear;
+        if (tNear <= tFar) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+uint32_t intersectTrianglesScalar(const TrianglePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, float* u, float* v){
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 v0 = glm::vec3(packet.v0[0][i], packet.v0[1][i], packet.v0[2][i]);
+        glm::vec3 e1 = glm::vec3(packet.e1[0][i], packet.e1[1][i], packet.e1[2][i]);
+        glm::vec3 e2 = glm::vec3(packet.e2[0][i], packet.e2[1][i], packet.e2[2][i]);
+        glm::vec3 p = glm::cross(direction, e2);
+        float determinant = glm::dot(e1, p);
+        if (std::abs(determinant) < DETERMINANT_EPSILON) {
+            continue;
+        }
+        float inverseDeterminant = 1.0f / determinant;
+        glm::vec3 s = origin - v0;
+        u[i] = glm::dot(s, p) * inverseDeterminant;
+        glm::vec3 q = glm::cross(s, e1);
+        v[i] = glm::dot(direction, q) * inverseDeterminant;
+        t[i] = glm::dot(e2, q) * inverseDeterminant;
+        if (u[i] >= 0.0f && v[i] >= 0.0f && u[i] + v[i] <= 1.0f && t[i] >= tmin && t[i] <= tmax) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+// Diskriminante über den Abstand des Mittelpunkts zum Strahl, zweite Nullstelle aus c / q, siehe hitSphereStable
+uint32_t intersectSpheresScalar(const SpherePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t){
+    uint32_t mask = 0;
+    float a = glm::dot(direction, direction);
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 oc = origin - glm::vec3(packet.center[0][i], packet.center[1][i], packet.center[2][i]);
+        float halfB = glm::dot(oc, direction);
+        float radiusSquared = packet.radius[i] * packet.radius[i];
+        float c = glm::dot(oc, oc) - radiusSquared;
+        glm::vec3 l = oc - (halfB / a) * direction;
+        float discriminant = a * (radiusSquared - glm::dot(l, l));
+        if (discriminant < 0) {
+            continue;
+        }
+        float root = std::sqrt(discriminant);
+        float q = halfB >= 0.0f ? -halfB - root : -halfB + root;
+        if (q == 0.0f) {
+            continue;
+        }
+        float tNear = std::min(q / a, c / q);
+        float tFar = std::max(q / a, c / q);
+        t[i] = tNear >= tmin ? tNear : tFar;
+        if (t[i] >= tmin && t[i] <= tmax) {
+            mask |= 1u << i;
+        }
+    }
+    return mask;
+}
+
+#ifdef VKR_KERNEL_SSE
+// SSE2 hat kein blendv, Auswahl über and/andnot/or
+inline __m128 select4(__m128 mask, __m128 a, __m128 b){
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+uint32_t intersectBoxesSse(const float bounds[6][8], glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax, float* distances){
+    uint32_t mask = 0;
+    for (uint32_t half = 0; half < 8; half += 4) {
+        __m128 tNear = _mm_set1_ps(tmin);
+        __m128 tFar = _mm_set1_ps(tmax);
+        for (int axis = 0; axis < 3; axis++) {
+            bool positive = inverseDirection[axis] >= 0.0f;
+            __m128 o = _mm_set1_ps(origin[axis]);
+            __m128 inverse = _mm_set1_ps(inverseDirection[axis]);
+            __m128 nearPlane = _mm_load_ps(bounds[positive ? axis : axis + 3] + half);
+            __m128 farPlane = _mm_load_ps(bounds[positive ? axis + 3 : axis] + half);
+            tNear = _mm_max_ps(tNear, _mm_mul_ps(_mm_sub_ps(nearPlane, o), inverse));
+            tFar = _mm_min_ps(tFar, _mm_mul_ps(_mm_sub_ps(farPlane, o), inverse));
+        }
+        _mm_storeu_ps(distances + half, tNear);
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar))) << half;
+    }
+    return mask;
+}
+
+uint32_t intersectTrianglesSse(const TrianglePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, float* u, float* v){
+    uint32_t mask = 0;
+    const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+    const __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    for (uint32_t half = 0; half < count; half += 4) {
+        __m128 e1x = _mm_load_ps(packet.e1[0] + half), e1y = _mm_load_ps(packet.e1[1] + half), e1z = _mm_load_ps(packet.e1[2] + half);
+        __m128 e2x = _mm_load_ps(packet.e2[0] + half), e2y = _mm_load_ps(packet.e2[1] + half), e2z = _mm_load_ps(packet.e2[2] + half);
+        // p = cross(d, e2)
+        __m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+        __m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+        __m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+        __m128 determinant = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+        __m128 valid = _mm_cmpge_ps(_mm_andnot_ps(signMask, determinant), _mm_set1_ps(DETERMINANT_EPSILON));
+        __m128 inverseDeterminant = _mm_div_ps(one, determinant);
+        __m128 sx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(packet.v0[0] + half));
+        __m128 sy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(packet.v0[1] + half));
+        __m128 sz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(packet.v0[2] + half));
+        __m128 uu = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inverseDeterminant);
+        // q = cross(s, e1)
+        __m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+        __m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+        __m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+        __m128 vv = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inverseDeterminant);
+        __m128 tt = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inverseDeterminant);
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(uu, zero));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(vv, zero));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(_mm_add_ps(uu, vv), one));
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(tt, _mm_set1_ps(tmin)));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(tt, _mm_set1_ps(tmax)));
+        _mm_storeu_ps(t + half, tt);
+        _mm_storeu_ps(u + half, uu);
+        _mm_storeu_ps(v + half, vv);
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(valid)) << half;
+    }
+    return mask & laneMask(count);
+}
+
+uint32_t intersectSpheresSse(const SpherePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t){
+    uint32_t mask = 0;
+    const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+    const __m128 a = _mm_set1_ps(glm::dot(direction, direction));
+    const __m128 inverseA = _mm_set1_ps(1.0f / glm::dot(direction, direction));
+    const __m128 zero = _mm_setzero_ps();
+    for (uint32_t half = 0; half < count; half += 4) {
+        __m128 ocx = _mm_sub_ps(_mm_set1_ps(origin.x), _mm_load_ps(packet.center[0] + half));
+        __m128 ocy = _mm_sub_ps(_mm_set1_ps(origin.y), _mm_load_ps(packet.center[1] + half));
+        __m128 ocz = _mm_sub_ps(_mm_set1_ps(origin.z), _mm_load_ps(packet.center[2] + half));
+        __m128 radius = _mm_load_ps(packet.radius + half);
+        __m128 radiusSquared = _mm_mul_ps(radius, radius);
+        __m128 halfB = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, dx), _mm_mul_ps(ocy, dy)), _mm_mul_ps(ocz, dz));
+        __m128 c = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ocx, ocx), _mm_mul_ps(ocy, ocy)), _mm_mul_ps(ocz, ocz)), radiusSquared);
+        __m128 k = _mm_mul_ps(halfB, inverseA);
+        __m128 lx = _mm_sub_ps(ocx, _mm_mul_ps(k, dx));
+        __m128 ly = _mm_sub_ps(ocy, _mm_mul_ps(k, dy));
+        __m128 lz = _mm_sub_ps(ocz, _mm_mul_ps(k, dz));
+        __m128 distanceSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(lx, lx), _mm_mul_ps(ly, ly)), _mm_mul_ps(lz, lz));
+        __m128 discriminant = _mm_mul_ps(a, _mm_sub_ps(radiusSquared, distanceSquared));
+        __m128 valid = _mm_cmpge_ps(discriminant, zero);
+        __m128 root = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+        __m128 negativeHalfB = _mm_sub_ps(zero, halfB);
+        __m128 q = select4(_mm_cmpge_ps(halfB, zero), _mm_sub_ps(negativeHalfB, root), _mm_add_ps(negativeHalfB, root));
+        valid = _mm_and_ps(valid, _mm_cmpneq_ps(q, zero));
+        __m128 t0 = _mm_div_ps(q, a);
+        __m128 t1 = _mm_div_ps(c, q);
+        __m128 tNear = _mm_min_ps(t0, t1);
+        __m128 tFar = _mm_max_ps(t0, t1);
+        __m128 tt = select4(_mm_cmpge_ps(tNear, _mm_set1_ps(tmin)), tNear, tFar);
+        valid = _mm_and_ps(valid, _mm_cmpge_ps(tt, _mm_set1_ps(tmin)));
+        valid = _mm_and_ps(valid, _mm_cmple_ps(tt, _mm_set1_ps(tmax)));
+        _mm_storeu_ps(t + half, tt);
+        mask |= static_cast<uint32_t>(_mm_movemask_ps(valid)) << half;
+    }
+    return mask & laneMask(count);
+}
+#endif
+
+#ifdef VKR_KERNEL_AVX2
+// AVX2 Befehle und vom Betriebssystem gesicherte YMM Register
+bool hasAvx2(){
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+VKR_TARGET_AVX2 uint32_t intersectBoxesAvx2(const float bounds[6][8], glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax, float* distances){
+    __m256 tNear = _mm256_set1_ps(tmin);
+    __m256 tFar = _mm256_set1_ps(tmax);
+    for (int axis = 0; axis < 3; axis++) {
+        bool positive = inverseDirection[axis] >= 0.0f;
+        __m256 o = _mm256_set1_ps(origin[axis]);
+        __m256 inverse = _mm256_set1_ps(inverseDirection[axis]);
+        __m256 nearPlane = _mm256_load_ps(bounds[positive ? axis : axis + 3]);
+        __m256 farPlane = _mm256_load_ps(bounds[positive ? axis + 3 : axis]);
+        tNear = _mm256_max_ps(tNear, _mm256_mul_ps(_mm256_sub_ps(nearPlane, o), inverse));
+        tFar = _mm256_min_ps(tFar, _mm256_mul_ps(_mm256_sub_ps(farPlane, o), inverse));
+    }
+    _mm256_storeu_ps(distances, tNear);
+    return static_cast<uint32_t>(_mm256_movemask_ps(_mm256_cmp_ps(tNear, tFar, _CMP_LE_OQ)));
+}
+
+VKR_TARGET_AVX2 uint32_t intersectTrianglesAvx2(const TrianglePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, float* u, float* v){
+    const __m256 dx = _mm256_set1_ps(direction.x), dy = _mm256_set1_ps(direction.y), dz = _mm256_set1_ps(direction.z);
+    const __m256 zero = _mm256_setzero_ps(), one = _mm256_set1_ps(1.0f);
+    __m256 e1x = _mm256_load_ps(packet.e1[0]), e1y = _mm256_load_ps(packet.e1[1]), e1z = _mm256_load_ps(packet.e1[2]);
+    __m256 e2x = _mm256_load_ps(packet.e2[0]), e2y = _mm256_load_ps(packet.e2[1]), e2z = _mm256_load_ps(packet.e2[2]);
+    __m256 px = _mm256_sub_ps(_mm256_mul_ps(dy, e2z), _mm256_mul_ps(dz, e2y));
+    __m256 py = _mm256_sub_ps(_mm256_mul_ps(dz, e2x), _mm256_mul_ps(dx, e2z));
+    __m256 pz = _mm256_sub_ps(_mm256_mul_ps(dx, e2y), _mm256_mul_ps(dy, e2x));
+    __m256 determinant = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e1x, px), _mm256_mul_ps(e1y, py)), _mm256_mul_ps(e1z, pz));
+    __m256 valid = _mm256_cmp_ps(_mm256_andnot_ps(_mm256_set1_ps(-0.0f), determinant), _mm256_set1_ps(DETERMINANT_EPSILON), _CMP_GE_OQ);
+    __m256 inverseDeterminant = _mm256_div_ps(one, determinant);
+    __m256 sx = _mm256_sub_ps(_mm256_set1_ps(origin.x), _mm256_load_ps(packet.v0[0]));
+    __m256 sy = _mm256_sub_ps(_mm256_set1_ps(origin.y), _mm256_load_ps(packet.v0[1]));
+    __m256 sz = _mm256_sub_ps(_mm256_set1_ps(origin.z), _mm256_load_ps(packet.v0[2]));
+    __m256 uu = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, px), _mm256_mul_ps(sy, py)), _mm256_mul_ps(sz, pz)), inverseDeterminant);
+    __m256 qx = _mm256_sub_ps(_mm256_mul_ps(sy, e1z), _mm256_mul_ps(sz, e1y));
+    __m256 qy = _mm256_sub_ps(_mm256_mul_ps(sz, e1x), _mm256_mul_ps(sx, e1z));
+    __m256 qz = _mm256_sub_ps(_mm256_mul_ps(sx, e1y), _mm256_mul_ps(sy, e1x));
+    __m256 vv = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, qx), _mm256_mul_ps(dy, qy)), _mm256_mul_ps(dz, qz)), inverseDeterminant);
+    __m256 tt = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(e2x, qx), _mm256_mul_ps(e2y, qy)), _mm256_mul_ps(e2z, qz)), inverseDeterminant);
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(uu, zero, _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(vv, zero, _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(_mm256_add_ps(uu, vv), one, _CMP_LE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(tt, _mm256_set1_ps(tmin), _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(tt, _mm256_set1_ps(tmax), _CMP_LE_OQ));
+    _mm256_storeu_ps(t, tt);
+    _mm256_storeu_ps(u, uu);
+    _mm256_storeu_ps(v, vv);
+    return static_cast<uint32_t>(_mm256_movemask_ps(valid)) & laneMask(count);
+}
+
+VKR_TARGET_AVX2 uint32_t intersectSpheresAvx2(const SpherePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t){
+    const __m256 dx = _mm256_set1_ps(direction.x), dy = _mm256_set1_ps(direction.y), dz = _mm256_set1_ps(direction.z);
+    const __m256 a = _mm256_set1_ps(glm::dot(direction, direction));
+    const __m256 inverseA = _mm256_set1_ps(1.0f / glm::dot(direction, direction));
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 ocx = _mm256_sub_ps(_mm256_set1_ps(origin.x), _mm256_load_ps(packet.center[0]));
+    __m256 ocy = _mm256_sub_ps(_mm256_set1_ps(origin.y), _mm256_load_ps(packet.center[1]));
+    __m256 ocz = _mm256_sub_ps(_mm256_set1_ps(origin.z), _mm256_load_ps(packet.center[2]));
+    __m256 radius = _mm256_load_ps(packet.radius);
+    __m256 radiusSquared = _mm256_mul_ps(radius, radius);
+    __m256 halfB = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, dx), _mm256_mul_ps(ocy, dy)), _mm256_mul_ps(ocz, dz));
+    __m256 c = _mm256_sub_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ocx, ocx), _mm256_mul_ps(ocy, ocy)), _mm256_mul_ps(ocz, ocz)), radiusSquared);
+    __m256 k = _mm256_mul_ps(halfB, inverseA);
+    __m256 lx = _mm256_sub_ps(ocx, _mm256_mul_ps(k, dx));
+    __m256 ly = _mm256_sub_ps(ocy, _mm256_mul_ps(k, dy));
+    __m256 lz = _mm256_sub_ps(ocz, _mm256_mul_ps(k, dz));
+    __m256 distanceSquared = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(lx, lx), _mm256_mul_ps(ly, ly)), _mm256_mul_ps(lz, lz));
+    __m256 discriminant = _mm256_mul_ps(a, _mm256_sub_ps(radiusSquared, distanceSquared));
+    __m256 valid = _mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ);
+    __m256 root = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+    __m256 negativeHalfB = _mm256_sub_ps(zero, halfB);
+    __m256 q = _mm256_blendv_ps(_mm256_add_ps(negativeHalfB, root), _mm256_sub_ps(negativeHalfB, root), _mm256_cmp_ps(halfB, zero, _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(q, zero, _CMP_NEQ_OQ));
+    __m256 t0 = _mm256_div_ps(q, a);
+    __m256 t1 = _mm256_div_ps(c, q);
+    __m256 tNear = _mm256_min_ps(t0, t1);
+    __m256 tFar = _mm256_max_ps(t0, t1);
+    __m256 tt = _mm256_blendv_ps(tFar, tNear, _mm256_cmp_ps(tNear, _mm256_set1_ps(tmin), _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(tt, _mm256_set1_ps(tmin), _CMP_GE_OQ));
+    valid = _mm256_and_ps(valid, _mm256_cmp_ps(tt, _mm256_set1_ps(tmax), _CMP_LE_OQ));
+    _mm256_storeu_ps(t, tt);
+    return static_cast<uint32_t>(_mm256_movemask_ps(valid)) & laneMask(count);
+}
+#endif
+
+}
+
+bool RayKernels::isSupported(SimdKernel kernel){
+    switch (kernel)
+    {
+        case SimdKernelScalar:
+            return true;
+        case SimdKernelSse:
+#ifdef VKR_KERNEL_SSE
+            return true;
+#else
+            return false;
+#endif
+        case SimdKernelAvx2:
+#ifdef VKR_KERNEL_AVX2
+            return hasAvx2();
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+SimdKernel RayKernels::getBestKernel(){
+    if (isSupported(SimdKernelAvx2))
+        return SimdKernelAvx2;
+    if (isSupported(SimdKernelSse))
+        return SimdKernelSse;
+    return SimdKernelScalar;
+}
+
+const char* RayKernels::getName(SimdKernel kernel){
+    switch (kernel)
+    {
+        case SimdKernelScalar:  return "scalar";
+        case SimdKernelSse:     return "sse";
+        case SimdKernelAvx2:    return "avx2";
+        default:                return "unknown";
+    }
+}
+
+// Achsenparallele Richtungen bekommen statt 1/0 einen großen endlichen Wert, so entstehen im Box Test keine NaNs
+glm::vec3 RayKernels::getInverseDirection(glm::vec3 direction){
+    glm::vec3 inverseDirection;
+    for (int axis = 0; axis < 3; axis++) {
+        float d = std::abs(direction[axis]) < 1e-20f ? std::copysign(1e-20f, direction[axis]) : direction[axis];
+        inverseDirection[axis] = 1.0f / d;
+    }
+    return inverseDirection;
+}
+
+uint32_t RayKernels::intersectBoxes(const float bounds[6][8], glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax, float* distances, SimdKernel kernel){
+#ifdef VKR_KERNEL_AVX2
+    if (kernel == SimdKernelAvx2)
+        return intersectBoxesAvx2(bounds, origin, inverseDirection, tmin, tmax, distances);
+#endif
+#ifdef VKR_KERNEL_SSE
+    if (kernel != SimdKernelScalar)
+        return intersectBoxesSse(bounds, origin, inverseDirection, tmin, tmax, distances);
+#endif
+    return intersectBoxesScalar(bounds, origin, inverseDirection, tmin, tmax, distances);
+}
+
+uint32_t RayKernels::intersectTriangles(const TrianglePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, float* u, float* v, SimdKernel kernel){
+#ifdef VKR_KERNEL_AVX2
+    if (kernel == SimdKernelAvx2)
+        return intersectTrianglesAvx2(packet, count, origin, direction, tmin, tmax, t, u, v);
+#endif
+#ifdef VKR_KERNEL_SSE
+    if (kernel != SimdKernelScalar)
+        return intersectTrianglesSse(packet, count, origin, direction, tmin, tmax, t, u, v);
+#endif
+    return intersectTrianglesScalar(packet, count, origin, direction, tmin, tmax, t, u, v);
+}
+
+uint32_t RayKernels::intersectSpheres(const SpherePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, SimdKernel kernel){
+#ifdef VKR_KERNEL_AVX2
+    if (kernel == SimdKernelAvx2)
+        return intersectSpheresAvx2(packet, count, origin, direction, tmin, tmax, t);
+#endif
+#ifdef VKR_KERNEL_SSE
+    if (kernel != SimdKernelScalar)
+        return intersectSpheresSse(packet, count, origin, direction, tmin, tmax, t);
+#endif
+    return intersectSpheresScalar(packet, count, origin, direction, tmin, tmax, t);
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include "GlobalDefs.h"
+
+// SSE2 gibt es auf x86-64 immer, AVX2 nur mit VKR_AVX2 und wenn die CPU es unterstützt
+enum SimdKernel{
+    SimdKernelScalar = 0,
+    SimdKernelSse,
+    SimdKernelAvx2,
+    SimdKernelCount
+};
+
+// Bis zu 8 Dreiecke als Ecke und Kanten im SoA Layout, leere Einträge bleiben 0
+struct alignas(32) TrianglePacket{
+    float v0[3][8];
+    float e1[3][8];
+    float e2[3][8];
+};
+
+// Bis zu 8 Kugeln im SoA Layout
+struct alignas(32) SpherePacket{
+    float center[3][8];
+    float radius[8];
+};
+
+// Strahl Tests gegen jeweils 8 Boxen, Dreiecke oder Kugeln. Alle Varianten liefern eine Bitmaske der Treffer.
+// Dreiecke wie Möller-Trumbore im CpuRayTracer, Kugeln wie hitSphereStable in intersection.rint
+class RayKernels
+{
+public:
+    static const uint32_t Width = 8;
+    static bool isSupported(SimdKernel kernel);
+    static SimdKernel getBestKernel();
+    static const char* getName(SimdKernel kernel);
+    static glm::vec3 getInverseDirection(glm::vec3 direction);
+    // bounds: [minX, minY, minZ, maxX, maxY, maxZ][Width], leere Einträge mit min = +inf und max = -inf treffen nie
+    static uint32_t intersectBoxes(const float bounds[6][8], glm::vec3 origin, glm::vec3 inverseDirection, float tmin, float tmax, float* distances, SimdKernel kernel);
+    static uint32_t intersectTriangles(const TrianglePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, float* u, float* v, SimdKernel kernel);
+    static uint32_t intersectSpheres(const SpherePacket& packet, uint32_t count, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float* t, SimdKernel kernel);
+};
@@ -0,0 +1,461 @@
+#include "RenderGraph.h"
+#include <algorithm>
+
+RenderGraph::RenderGraph(){
+
+}
+
+RenderGraph::ResourceState RenderGraph::getState(Usage usage){
+    switch (usage)
+    {
+        case UsageRayTracingStorageRead:
+            return {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_GENERAL};
+        case UsageRayTracingStorageWrite:
+            return {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+        case UsageRayTracingSampled:
+            return {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+        case UsageRayTracingUniformRead:
+            return {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED};
+        case UsageAccelerationStructureRead:
+            return {VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED};
+        case UsageAccelerationStructureBuild:
+            return {VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR, VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR, VK_IMAGE_LAYOUT_UNDEFINED};
+        case UsageTransferSrc:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL};
+        case UsageTransferDst:
+            return {VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL};
+        case UsageHostWrite:
+            return {VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL};
+        case UsagePresent:
+            return {VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR};
+        case UsageUndefined:
+        default:
+            return {VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED};
+    }
+}
+
+uint32_t RenderGraph::importImage(std::string name, VkImage image, VkImageSubresourceRange subresourceRange, ResourceState initialState, ResourceState finalState){
+    Resource resource{};
+    resource.name = name;
+    resource.isImage = true;
+    resource.transient = false;
+    resource.image = image;
+    resource.subresourceRange = subresourceRange;
+    resource.initialState = initialState;
+    resource.finalState = finalState;
+    m_resources.push_back(resource);
+    m_compiled = false;
+    return static_cast<uint32_t>(m_resources.size() - 1);
+}
+
+uint32_t RenderGraph::importBuffer(std::string name, VkBuffer buffer, ResourceState initialState, ResourceState finalState){
+    Resource resource{};
+    resource.name = name;
+    resource.isImage = false;
+    resource.transient = false;
+    resource.buffer = buffer;
+    resource.initialState = initialState;
+    resource.finalState = finalState;
+    m_resources.push_back(resource);
+    m_compiled = false;
+    return static_cast<uint32_t>(m_resources.size() - 1);
+}
+
+uint32_t RenderGraph::createTransientImage(std::string name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage){
+    Resource resource{};
+    resource.name = name;
+    resource.isImage = true;
+    resource.transient = true;
+    resource.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    resource.createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    resource.createInfo.imageType = VK_IMAGE_TYPE_2D;
+    resource.createInfo.extent = {width, height, 1};
+    resource.createInfo.mipLevels = 1;
+    resource.createInfo.arrayLayers = 1;
+    resource.createInfo.format = format;
+    resource.createInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    resource.createInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    resource.createInfo.usage = usage;
+    resource.createInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    resource.createInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    // Der Inhalt überlebt den Graphen nicht
+    resource.initialState = getState(UsageUndefined);
+    resource.finalState = getState(UsageUndefined);
+    m_resources.push_back(resource);
+    m_compiled = false;
+    return static_cast<uint32_t>(m_resources.size() - 1);
+}
+
+uint32_t RenderGraph::addPass(std::string name, std::function<void(VkCommandBuffer)> record){
+    Pass pass{};
+    pass.name = name;
+    pass.record = record;
+    m_passes.push_back(pass);
+    m_compiled = false;
+    return static_cast<uint32_t>(m_passes.size() - 1);
+}
+
+void RenderGraph::read(uint32_t pass, uint32_t resource, Usage usage){
+    m_passes[pass].accesses.push_back({resource, usage, false});
+    m_compiled = false;
+}
+
+void RenderGraph::write(uint32_t pass, uint32_t resource, Usage usage){
+    m_passes[pass].accesses.push_back({resource, usage, true});
+    m_compiled = false;
+}
+
+void RenderGraph::transition(Tracker& tracker, uint32_t resource, ResourceState state, bool write, BarrierBatch& batch){
+    const bool isImage = m_resources[resource].isImage;
+    const bool layoutChange = isImage && tracker.layout != state.layout && state.layout != VK_IMAGE_LAYOUT_UNDEFINED;
+    const VkPipelineStageFlags pendingStages = tracker.writeStage | tracker.readStages;
+
+    Barrier barrier{};
+    barrier.resource  = resource;
+    barrier.dstStage  = state.stage;
+    barrier.dstAccess = state.access;
+    barrier.oldLayout = tracker.layout;
+    barrier.newLayout = isImage ? (state.layout != VK_IMAGE_LAYOUT_UNDEFINED ? state.layout : tracker.layout) : VK_IMAGE_LAYOUT_UNDEFINED;
+
+    bool needed = false;
+    if (layoutChange || write)
+    {
+        // RAW/WAW braucht Sichtbarkeit der Schreibzugriffe, WAR nur eine Ausführungsabhängigkeit
+        needed = layoutChange || pendingStages != 0;
+        barrier.srcStage  = pendingStages != 0 ? pendingStages : tracker.baseStage;
+        barrier.srcAccess = tracker.writeAccess;
+    }
+    else if (tracker.writeStage != 0 && ((state.stage & ~tracker.readStages) || (state.access & ~tracker.readAccess)))
+    {
+        needed = true;
+        barrier.srcStage  = tracker.writeStage;
+        barrier.srcAccess = tracker.writeAccess;
+    }
+
+    if (needed)
+    {
+        batch.srcStages |= barrier.srcStage;
+        batch.dstStages |= barrier.dstStage;
+        batch.barriers.push_back(barrier);
+    }
+
+    if (layoutChange || write)
+    {
+        tracker.layout      = barrier.newLayout;
+        tracker.writeStage  = state.stage;
+        tracker.writeAccess = write ? (state.access & (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR)) : 0;
+        tracker.readStages  = write ? 0 : state.stage;
+        tracker.readAccess  = write ? 0 : state.access;
+    }
+    else
+    {
+        tracker.readStages |= state.stage;
+        tracker.readAccess |= state.access;
+    }
+}
+
+void RenderGraph::compile(){
+    m_batches = std::vector<BarrierBatch>(m_passes.size());
+    m_finalBatch = BarrierBatch();
+
+    for (Resource& resource : m_resources)
+    {
+        resource.firstPass = UINT32_MAX;
+        resource.lastPass = 0;
+    }
+
+    // Zugriffe eines Passes auf dieselbe Ressource zusammenfassen und Lebenszeiten bestimmen
+    std::vector<std::vector<std::pair<uint32_t, std::pair<ResourceState, bool>>>> merged(m_passes.size());
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        for (const Access& access : m_passes[p].accesses)
+        {
+            ResourceState state = getState(access.usage);
+            auto it = std::find_if(merged[p].begin(), merged[p].end(), [&](const auto& entry){ return entry.first == access.resource; });
+            if (it == merged[p].end())
+            {
+                merged[p].push_back({access.resource, {state, access.write}});
+            }
+            else
+            {
+                if (m_resources[access.resource].isImage && it->second.first.layout != state.layout)
+                    throw std::runtime_error("render graph pass uses an image in two different layouts!");
+                it->second.first.stage  |= state.stage;
+                it->second.first.access |= state.access;
+                it->second.second = it->second.second || access.write;
+            }
+            Resource& resource = m_resources[access.resource];
+            resource.firstPass = std::min(resource.firstPass, p);
+            resource.lastPass = std::max(resource.lastPass, p);
+        }
+    }
+
+    std::vector<Tracker> trackers(m_resources.size());
+    for (uint32_t r = 0; r < m_resources.size(); r++)
+    {
+        trackers[r].layout      = m_resources[r].initialState.layout;
+        trackers[r].baseStage   = m_resources[r].initialState.stage;
+        trackers[r].writeStage  = 0;
+        trackers[r].writeAccess = 0;
+        trackers[r].readStages  = 0;
+        trackers[r].readAccess  = 0;
+        // Importierte Ressourcen, deren Ausgangszustand ein Schreibzugriff ist (z.B. aus dem vorherigen Frame),
+        // müssen vor dem ersten Zugriff sichtbar gemacht werden
+        const VkAccessFlags writeAccess = m_resources[r].initialState.access & (VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR);
+        if (!m_resources[r].transient && writeAccess != 0)
+        {
+            trackers[r].writeStage  = m_resources[r].initialState.stage;
+            trackers[r].writeAccess = writeAccess;
+        }
+    }
+
+    // Transiente Bilder, die sich Speicher teilen, müssen auf den letzten Zugriff des Vorgängers warten
+    for (uint32_t r = 0; r < m_resources.size() && r < m_aliasSlots.size(); r++)
+    {
+        if (!m_resources[r].transient || m_resources[r].firstPass == UINT32_MAX)
+            continue;
+        int previous = -1;
+        for (uint32_t o = 0; o < m_resources.size() && o < m_aliasSlots.size(); o++)
+        {
+            if (o == r || !m_resources[o].transient || m_aliasSlots[o].slot != m_aliasSlots[r].slot || m_resources[o].firstPass == UINT32_MAX)
+                continue;
+            if (m_resources[o].lastPass < m_resources[r].firstPass && (previous < 0 || m_resources[o].lastPass > m_resources[previous].lastPass))
+                previous = static_cast<int>(o);
+        }
+        if (previous >= 0)
+        {
+            for (const auto& entry : merged[m_resources[previous].lastPass])
+            {
+                if (entry.first != static_cast<uint32_t>(previous))
+                    continue;
+                trackers[r].writeStage  = entry.second.first.stage;
+                trackers[r].writeAccess = entry.second.second ? entry.second.first.access : 0;
+            }
+        }
+    }
+
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        for (const auto& entry : merged[p])
+        {
+            transition(trackers[entry.first], entry.first, entry.second.first, entry.second.second, m_batches[p]);
+        }
+    }
+
+    // Übergang in den Endzustand, z.B. PRESENT_SRC für das Swapchain Bild
+    for (uint32_t r = 0; r < m_resources.size(); r++)
+    {
+        if (m_resources[r].transient)
+            continue;
+        const ResourceState& finalState = m_resources[r].finalState;
+        if (m_resources[r].isImage && trackers[r].layout != finalState.layout && finalState.layout != VK_IMAGE_LAYOUT_UNDEFINED)
+        {
+            transition(trackers[r], r, finalState, false, m_finalBatch);
+        }
+    }
+    m_compiled = true;
+}
+
+std::vector<RenderGraph::AliasSlot> RenderGraph::computeAliasing(const std::vector<AliasRequest>& requests, std::vector<VkDeviceSize>& slotSizes){
+    std::vector<AliasSlot> result(requests.size(), {UINT32_MAX, 0});
+    std::vector<uint32_t> slotTypeBits;
+    std::vector<std::vector<uint32_t>> slotMembers;
+    slotSizes.clear();
+
+    // Größte Bilder zuerst, damit kleinere in deren Speicher passen
+    std::vector<uint32_t> order(requests.size());
+    for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b){ return requests[a].size > requests[b].size; });
+
+    for (uint32_t i : order)
+    {
+        const AliasRequest& request = requests[i];
+        uint32_t chosen = UINT32_MAX;
+        for (uint32_t s = 0; s < slotMembers.size() && chosen == UINT32_MAX; s++)
+        {
+            if ((slotTypeBits[s] & request.memoryTypeBits) == 0)
+                continue;
+            bool overlaps = false;
+            for (uint32_t member : slotMembers[s])
+            {
+                if (request.firstPass <= requests[member].lastPass && requests[member].firstPass <= request.lastPass)
+                {
+                    overlaps = true;
+                    break;
+                }
+            }
+            if (!overlaps)
+                chosen = s;
+        }
+        if (chosen == UINT32_MAX)
+        {
+            chosen = static_cast<uint32_t>(slotMembers.size());
+            slotMembers.push_back({});
+            slotTypeBits.push_back(request.memoryTypeBits);
+            slotSizes.push_back(0);
+        }
+        VkDeviceSize alignedRequestSize = (request.size + request.alignment - 1) & ~(request.alignment - 1);
+        slotMembers[chosen].push_back(i);
+        slotTypeBits[chosen] &= request.memoryTypeBits;
+        slotSizes[chosen] = std::max(slotSizes[chosen], alignedRequestSize);
+        result[i] = {chosen, 0};
+    }
+    return result;
+}
+
+void RenderGraph::allocate(Device* device){
+    m_device = device;
+    if (!m_compiled)
+        compile();
+
+    std::vector<uint32_t> transientIds;
+    std::vector<AliasRequest> transientRequests;
+    for (uint32_t r = 0; r < m_resources.size(); r++)
+    {
+        Resource& resource = m_resources[r];
+        if (!resource.transient)
+            continue;
+        if (vkCreateImage(m_device->getHandle(), &resource.createInfo, nullptr, &resource.image) != VK_SUCCESS)
+            throw std::runtime_error("failed to create transient image!");
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(m_device->getHandle(), resource.image, &memRequirements);
+        // Nie benutzte Bilder bekommen eine leere Lebenszeit am Ende
+        uint32_t firstPass = resource.firstPass != UINT32_MAX ? resource.firstPass : static_cast<uint32_t>(m_passes.size());
+        uint32_t lastPass = resource.firstPass != UINT32_MAX ? resource.lastPass : static_cast<uint32_t>(m_passes.size());
+        transientIds.push_back(r);
+        transientRequests.push_back({firstPass, lastPass, memRequirements.size, memRequirements.alignment, memRequirements.memoryTypeBits});
+    }
+
+    std::vector<VkDeviceSize> slotSizes;
+    std::vector<AliasSlot> transientSlots = computeAliasing(transientRequests, slotSizes);
+
+    m_aliasSlots = std::vector<AliasSlot>(m_resources.size(), {UINT32_MAX, 0});
+    std::vector<uint32_t> slotTypeBits(slotSizes.size(), UINT32_MAX);
+    for (uint32_t i = 0; i < transientIds.size(); i++)
+    {
+        m_aliasSlots[transientIds[i]] = transientSlots[i];
+        slotTypeBits[transientSlots[i].slot] &= transientRequests[i].memoryTypeBits;
+    }
+
+    m_memory.resize(slotSizes.size());
+    for (uint32_t s = 0; s < slotSizes.size(); s++)
+    {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = slotSizes[s];
+        allocInfo.memoryTypeIndex = findMemoryType(slotTypeBits[s], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (vkAllocateMemory(m_device->getHandle(), &allocInfo, nullptr, &m_memory[s]) != VK_SUCCESS)
+            throw std::runtime_error("failed to allocate transient image memory!");
+        m_device->trackAllocation(m_memory[s], allocInfo.allocationSize);
+    }
+    for (uint32_t id : transientIds)
+    {
+        if (vkBindImageMemory(m_device->getHandle(), m_resources[id].image, m_memory[m_aliasSlots[id].slot], m_aliasSlots[id].offset) != VK_SUCCESS)
+            throw std::runtime_error("failed to bind transient image memory!");
+    }
+
+    // Mit bekannter Speicherbelegung neu kompilieren, damit Alias-Barrieren entstehen
+    compile();
+}
+
+void RenderGraph::recordBatch(VkCommandBuffer command_buffer, const BarrierBatch& batch){
+    if (batch.barriers.empty())
+        return;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    for (const Barrier& barrier : batch.barriers)
+    {
+        const Resource& resource = m_resources[barrier.resource];
+        if (resource.isImage)
+        {
+            VkImageMemoryBarrier imageBarrier{};
+            imageBarrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            imageBarrier.srcAccessMask       = barrier.srcAccess;
+            imageBarrier.dstAccessMask       = barrier.dstAccess;
+            imageBarrier.oldLayout           = barrier.oldLayout;
+            imageBarrier.newLayout           = barrier.newLayout;
+            imageBarrier.image               = resource.image;
+            imageBarrier.subresourceRange    = resource.subresourceRange;
+            imageBarriers.push_back(imageBarrier);
+        }
+        else
+        {
+            VkBufferMemoryBarrier bufferBarrier{};
+            bufferBarrier.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufferBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            bufferBarrier.srcAccessMask       = barrier.srcAccess;
+            bufferBarrier.dstAccessMask       = barrier.dstAccess;
+            bufferBarrier.buffer              = resource.buffer;
+            bufferBarrier.offset              = 0;
+            bufferBarrier.size                = VK_WHOLE_SIZE;
+            bufferBarriers.push_back(bufferBarrier);
+        }
+    }
+    vkCmdPipelineBarrier(command_buffer, batch.srcStages, batch.dstStages, 0, 0, nullptr, static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(), static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+}
+
+void RenderGraph::execute(VkCommandBuffer command_buffer){
+    if (!m_compiled)
+        compile();
+    for (uint32_t p = 0; p < m_passes.size(); p++)
+    {
+        recordBatch(command_buffer, m_batches[p]);
+        if (m_passes[p].record)
+            m_passes[p].record(command_buffer);
+    }
+    recordBatch(command_buffer, m_finalBatch);
+}
+
+VkImage RenderGraph::getImage(uint32_t resource){
+    return m_resources[resource].image;
+}
+
+uint32_t RenderGraph::getPassCount() const{
+    return static_cast<uint32_t>(m_passes.size());
+}
+
+const RenderGraph::BarrierBatch& RenderGraph::getBarriers(uint32_t pass) const{
+    return m_batches[pass];
+}
+
+const RenderGraph::BarrierBatch& RenderGraph::getFinalBarriers() const{
+    return m_finalBatch;
+}
+
+const std::vector<RenderGraph::AliasSlot>& RenderGraph::getAliasSlots() const{
+    return m_aliasSlots;
+}
+
+uint32_t RenderGraph::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(m_device->getPhysicalDevice(), &memProperties);
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return i;
+        }
+    }
+    throw std::runtime_error("failed to find suitable memory type!");
+}
+
+void RenderGraph::destroy(){
+    if (m_device == nullptr)
+        return;
+    for (Resource& resource : m_resources)
+    {
+        if (resource.transient && resource.image != VK_NULL_HANDLE)
+        {
+            vkDestroyImage(m_device->getHandle(), resource.image, nullptr);
+            resource.image = VK_NULL_HANDLE;
+        }
+    }
+    for (VkDeviceMemory memory : m_memory)
+    {
+        m_device->trackFree(memory);
+        vkFreeMemory(m_device->getHandle(), memory, nullptr);
+    }
+    m_memory.clear();
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <functional>
+#include "Device.h"
+#include "GlobalDefs.h"
+
+class RenderGraph
+{
+public:
+    enum Usage{
+        UsageUndefined = 0,
+        UsageRayTracingStorageRead,
+        UsageRayTracingStorageWrite,
+        UsageRayTracingSampled,
+        UsageRayTracingUniformRead,
+        UsageAccelerationStructureRead,
+        UsageAccelerationStructureBuild,
+        UsageTransferSrc,
+        UsageTransferDst,
+        UsageHostWrite,
+        UsagePresent
+    };
+    // Stage, Zugriff und Layout mit denen eine Ressource verwendet wird
+    struct ResourceState{
+        VkPipelineStageFlags stage;
+        VkAccessFlags access;
+        VkImageLayout layout;
+    };
+    struct Barrier{
+        uint32_t resource;
+        VkPipelineStageFlags srcStage;
+        VkPipelineStageFlags dstStage;
+        VkAccessFlags srcAccess;
+        VkAccessFlags dstAccess;
+        VkImageLayout oldLayout;
+        VkImageLayout newLayout;
+    };
+    // Alle Barrieren vor einem Pass werden in einem vkCmdPipelineBarrier zusammengefasst
+    struct BarrierBatch{
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<Barrier> barriers;
+    };
+    struct AliasRequest{
+        uint32_t firstPass;
+        uint32_t lastPass;
+        VkDeviceSize size;
+        VkDeviceSize alignment;
+        uint32_t memoryTypeBits;
+    };
+    struct AliasSlot{
+        uint32_t slot;
+        VkDeviceSize offset;
+    };
+
+    RenderGraph();
+    uint32_t importImage(std::string name, VkImage image, VkImageSubresourceRange subresourceRange, ResourceState initialState, ResourceState finalState);
+    uint32_t importBuffer(std::string name, VkBuffer buffer, ResourceState initialState, ResourceState finalState);
+    uint32_t createTransientImage(std::string name, uint32_t width, uint32_t height, VkFormat format, VkImageUsageFlags usage);
+    uint32_t addPass(std::string name, std::function<void(VkCommandBuffer)> record);
+    void read(uint32_t pass, uint32_t resource, Usage usage);
+    void write(uint32_t pass, uint32_t resource, Usage usage);
+    void compile();
+    void allocate(Device* device);
+    void execute(VkCommandBuffer command_buffer);
+    void destroy();
+    VkImage getImage(uint32_t resource);
+    uint32_t getPassCount() const;
+    const BarrierBatch& getBarriers(uint32_t pass) const;
+    const BarrierBatch& getFinalBarriers() const;
+    const std::vector<AliasSlot>& getAliasSlots() const;
+    static ResourceState getState(Usage usage);
+    static std::vector<AliasSlot> computeAliasing(const std::vector<AliasRequest>& requests, std::vector<VkDeviceSize>& slotSizes);
+
+private:
+    struct Access{
+        uint32_t resource;
+        Usage usage;
+        bool write;
+    };
+    struct Pass{
+        std::string name;
+        std::function<void(VkCommandBuffer)> record;
+        std::vector<Access> accesses;
+    };
+    struct Resource{
+        std::string name;
+        bool isImage;
+        bool transient;
+        VkImage image = VK_NULL_HANDLE;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkImageSubresourceRange subresourceRange;
+        VkImageCreateInfo createInfo{};
+        ResourceState initialState;
+        ResourceState finalState;
+        uint32_t firstPass = UINT32_MAX;
+        uint32_t lastPass = 0;
+    };
+    // Zustand einer Ressource während dem Kompilieren
+    struct Tracker{
+        VkImageLayout layout;
+        VkPipelineStageFlags baseStage;
+        VkPipelineStageFlags writeStage;
+        VkAccessFlags writeAccess;
+        VkPipelineStageFlags readStages;
+        VkAccessFlags readAccess;
+    };
+    Device* m_device = nullptr;
+    std::vector<Pass> m_passes;
+    std::vector<Resource> m_resources;
+    std::vector<BarrierBatch> m_batches;
+    BarrierBatch m_finalBatch;
+    std::vector<AliasSlot> m_aliasSlots;
+    std::vector<VkDeviceMemory> m_memory;
+    bool m_compiled = false;
+    void transition(Tracker& tracker, uint32_t resource, ResourceState state, bool write, BarrierBatch& batch);
+    void recordBatch(VkCommandBuffer command_buffer, const BarrierBatch& batch);
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+};
@@ -0,0 +1,153 @@
+#include "ShaderBindingTable.h"
+#include <algorithm>
+#include <cstring>
+
+ShaderBindingTable::ShaderBindingTable()
+{
+
+}
+
+ShaderBindingTable::ShaderBindingTable(uint32_t handleSize, uint32_t handleAlignment, uint32_t baseAlignment) : m_handleSize(handleSize), m_handleAlignment(std::max(handleAlignment, 1u)), m_baseAlignment(std::max(baseAlignment, 1u))
+{
+
+}
+
+VkDeviceSize ShaderBindingTable::alignUp(VkDeviceSize value, VkDeviceSize alignment){
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Gibt den Index des Records innerhalb seiner Region zurück, für Hit Records ist das der SBT Offset
+uint32_t ShaderBindingTable::add(Region region, uint32_t group, const void* data, uint32_t dataSize){
+    Record record{};
+    record.group = group;
+    if (dataSize > 0) {
+        record.data = std::vector<uint8_t>(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + dataSize);
+    }
+    m_records[region].push_back(record);
+    return static_cast<uint32_t>(m_records[region].size()) - 1;
+}
+
+uint32_t ShaderBindingTable::getRecordCount(Region region) const{
+    return static_cast<uint32_t>(m_records[region].size());
+}
+
+// Jede Region beginnt auf shaderGroupBaseAlignment, der Stride deckt Handle und größte Inline Daten ab.
+// Bei Raygen muss size == stride gelten, deshalb ist dort auch der Stride auf die Basis ausgerichtet
+ShaderBindingTable::Layout ShaderBindingTable::computeLayout() const{
+    Layout layout{};
+    VkDeviceSize cursor = 0;
+    for (uint32_t region = 0; region < RegionCount; region++) {
+        RegionLayout& regionLayout = layout.regions[region];
+        if (m_records[region].empty()) {
+            regionLayout = {0, 0, 0};
+            continue;
+        }
+        size_t maxDataSize = 0;
+        for (const Record& record : m_records[region]) {
+            maxDataSize = std::max(maxDataSize, record.data.size());
+        }
+        regionLayout.stride = alignUp(m_handleSize + maxDataSize, m_handleAlignment);
+        if (region == RegionRayGen) {
+            regionLayout.stride = alignUp(regionLayout.stride, m_baseAlignment);
+        }
+        regionLayout.offset = alignUp(cursor, m_baseAlignment);
+        regionLayout.size = regionLayout.stride * m_records[region].size();
+        cursor = regionLayout.offset + regionLayout.size;
+    }
+    layout.size = cursor;
+    return layout;
+}
+
+// handles liegen wie von vkGetRayTracingShaderGroupHandlesKHR geliefert dicht hintereinander
+std::vector<uint8_t> ShaderBindingTable::write(const Layout& layout, const std::vector<uint8_t>& handles) const{
+    std::vector<uint8_t> data(layout.size, 0);
+    for (uint32_t region = 0; region < RegionCount; region++) {
+        for (size_t i = 0; i < m_records[region].size(); i++) {
+            const Record& record = m_records[region][i];
+            if ((static_cast<size_t>(record.group) + 1) * m_handleSize > handles.size()) {
+                throw std::runtime_error("shader binding table references unknown shader group!");
+            }
+            uint8_t* dst = data.data() + layout.regions[region].offset + i * layout.regions[region].stride;
+            memcpy(dst, handles.data() + static_cast<size_t>(record.group) * m_handleSize, m_handleSize);
+            if (!record.data.empty()) {
+                memcpy(dst + m_handleSize, record.data.data(), record.data.size());
+            }
+        }
+    }
+    return data;
+}
+
+void ShaderBindingTable::create(Device* device, VkPipeline pipeline, uint32_t groupCount){
+    m_device = device;
+    m_layout = computeLayout();
+    for (uint32_t region = 0; region < RegionCount; region++) {
+        if (m_layout.regions[region].stride > m_device->getMaxShaderGroupStride()) {
+            throw std::runtime_error("shader binding table stride exceeds maxShaderGroupStride!");
+        }
+    }
+
+    PFN_vkGetRayTracingShaderGroupHandlesKHR vkGetRayTracingShaderGroupHandlesKHR = reinterpret_cast<PFN_vkGetRayTracingShaderGroupHandlesKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetRayTracingShaderGroupHandlesKHR"));
+    std::vector<uint8_t> handles(static_cast<size_t>(groupCount) * m_handleSize);
+    if (vkGetRayTracingShaderGroupHandlesKHR(m_device->getHandle(), pipeline, 0, groupCount, handles.size(), handles.data()) != VK_SUCCESS) {
+        throw std::runtime_error("failed to get ray tracing shader group handles!");
+    }
+    std::vector<uint8_t> data = write(m_layout, handles);
+
+    Buffer stagingBuffer = Buffer(m_device, m_layout.size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    stagingBuffer.map(m_layout.size, 0);
+    stagingBuffer.copyTo(data.data(), m_layout.size);
+    stagingBuffer.unmap();
+
+    m_buffer = Buffer(m_device, m_layout.size, VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    m_deviceAddress = m_buffer.getDeviceAddress();
+
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.commandPool = m_device->getCommandPool();
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer command_buffer;
+    if (vkAllocateCommandBuffers(m_device->getHandle(), &allocInfo, &command_buffer) != VK_SUCCESS) {
+        throw std::runtime_error("failed to allocate command buffer!");
+    }
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(command_buffer, &beginInfo);
+    VkBufferCopy region{};
+    region.size = m_layout.size;
+    vkCmdCopyBuffer(command_buffer, stagingBuffer.getHandle(), m_buffer.getHandle(), 1, &region);
+    vkEndCommandBuffer(command_buffer);
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &command_buffer;
+    if (vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+        throw std::runtime_error("failed to submit shader binding table upload!");
+    }
+    vkQueueWaitIdle(m_device->getGraphicsQueue());
+    vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), 1, &command_buffer);
+    stagingBuffer.destroy();
+}
+
+// Leere Regionen liefern eine Null Region, wie sie vkCmdTraceRaysKHR für ungenutzte Tabellen erwartet
+VkStridedDeviceAddressRegionKHR ShaderBindingTable::getRegion(Region region) const{
+    VkStridedDeviceAddressRegionKHR stridedRegion{};
+    if (m_layout.regions[region].size == 0) {
+        return stridedRegion;
+    }
+    stridedRegion.deviceAddress = m_deviceAddress + m_layout.regions[region].offset;
+    stridedRegion.stride = m_layout.regions[region].stride;
+    stridedRegion.size = m_layout.regions[region].size;
+    return stridedRegion;
+}
+
+void ShaderBindingTable::destroy(){
+    if (m_deviceAddress != 0) {
+        m_buffer.destroy();
+        m_buffer = Buffer();
+        m_deviceAddress = 0;
+    }
+}
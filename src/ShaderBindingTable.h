@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Device.h"
+#include "Buffer.h"
+#include "GlobalDefs.h"
+
+// Sammelt Raygen, Miss, Hit und Callable Records mit optionalen Inline Daten und legt sie
+// in einem Device Local Buffer ab. Das Layout wird ohne Device berechnet und lässt sich so auf der CPU prüfen
+class ShaderBindingTable
+{
+public:
+    enum Region{
+        RegionRayGen = 0,
+        RegionMiss,
+        RegionHit,
+        RegionCallable,
+        RegionCount
+    };
+    struct Record{
+        uint32_t group;
+        std::vector<uint8_t> data;
+    };
+    struct RegionLayout{
+        VkDeviceSize offset;
+        VkDeviceSize stride;
+        VkDeviceSize size;
+    };
+    struct Layout{
+        RegionLayout regions[RegionCount];
+        VkDeviceSize size;
+    };
+    ShaderBindingTable();
+    ShaderBindingTable(uint32_t handleSize, uint32_t handleAlignment, uint32_t baseAlignment);
+    uint32_t add(Region region, uint32_t group, const void* data = nullptr, uint32_t dataSize = 0);
+    uint32_t getRecordCount(Region region) const;
+    Layout computeLayout() const;
+    std::vector<uint8_t> write(const Layout& layout, const std::vector<uint8_t>& handles) const;
+    void create(Device* device, VkPipeline pipeline, uint32_t groupCount);
+    VkStridedDeviceAddressRegionKHR getRegion(Region region) const;
+    void destroy();
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment);
+private:
+    Device* m_device = nullptr;
+    uint32_t m_handleSize = 0;
+    uint32_t m_handleAlignment = 1;
+    uint32_t m_baseAlignment = 1;
+    std::vector<Record> m_records[RegionCount];
+    Layout m_layout{};
+    Buffer m_buffer;
+    VkDeviceAddress m_deviceAddress = 0;
+};
@@ -0,0 +1,312 @@
+#include "ShaderCompiler.h"
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <glslang/Public/ShaderLang.h>
+#include <SPIRV/GlslangToSpv.h>
+
+namespace {
+
+// Löst #include "datei" relativ zum Shader Verzeichnis auf
+class ShaderIncluder : public glslang::TShader::Includer
+{
+public:
+    ShaderIncluder(std::string directory) : m_directory(directory) {}
+
+    IncludeResult* includeLocal(const char* headerName, const char* includerName, size_t inclusionDepth) override {
+        std::string path = m_directory + "/" + headerName;
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            return nullptr;
+        }
+        std::string* content = new std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        return new IncludeResult(path, content->c_str(), content->size(), content);
+    }
+
+    IncludeResult* includeSystem(const char* headerName, const char* includerName, size_t inclusionDepth) override {
+        return includeLocal(headerName, includerName, inclusionDepth);
+    }
+
+    void releaseInclude(IncludeResult* result) override {
+        if (result) {
+            delete static_cast<std::string*>(result->userData);
+            delete result;
+        }
+    }
+private:
+    std::string m_directory;
+};
+
+TBuiltInResource getDefaultResources() {
+    TBuiltInResource resources{};
+    resources.maxLights = 32;
+    resources.maxClipPlanes = 6;
+    resources.maxTextureUnits = 32;
+    resources.maxTextureCoords = 32;
+    resources.maxVertexAttribs = 64;
+    resources.maxVertexUniformComponents = 4096;
+    resources.maxVaryingFloats = 64;
+    resources.maxVertexTextureImageUnits = 32;
+    resources.maxCombinedTextureImageUnits = 80;
+    resources.maxTextureImageUnits = 32;
+    resources.maxFragmentUniformComponents = 4096;
+    resources.maxDrawBuffers = 32;
+    resources.maxVertexUniformVectors = 128;
+    resources.maxVaryingVectors = 8;
+    resources.maxFragmentUniformVectors = 16;
+    resources.maxVertexOutputVectors = 16;
+    resources.maxFragmentInputVectors = 15;
+    resources.minProgramTexelOffset = -8;
+    resources.maxProgramTexelOffset = 7;
+    resources.maxClipDistances = 8;
+    resources.maxComputeWorkGroupCountX = 65535;
+    resources.maxComputeWorkGroupCountY = 65535;
+    resources.maxComputeWorkGroupCountZ = 65535;
+    resources.maxComputeWorkGroupSizeX = 1024;
+    resources.maxComputeWorkGroupSizeY = 1024;
+    resources.maxComputeWorkGroupSizeZ = 64;
+    resources.maxComputeUniformComponents = 1024;
+    resources.maxComputeTextureImageUnits = 16;
+    resources.maxComputeImageUniforms = 8;
+    resources.maxComputeAtomicCounters = 8;
+    resources.maxComputeAtomicCounterBuffers = 1;
+    resources.maxVaryingComponents = 60;
+    resources.maxVertexOutputComponents = 64;
+    resources.maxFragmentInputComponents = 128;
+    resources.maxImageUnits = 8;
+    resources.maxCombinedImageUnitsAndFragmentOutputs = 8;
+    resources.maxCombinedShaderOutputResources = 8;
+    resources.maxImageSamples = 0;
+    resources.maxFragmentImageUniforms = 8;
+    resources.maxCombinedImageUniforms = 8;
+    resources.maxCullDistances = 8;
+    resources.maxCombinedClipAndCullDistances = 8;
+    resources.maxSamples = 4;
+    resources.limits.nonInductiveForLoops = true;
+    resources.limits.whileLoops = true;
+    resources.limits.doWhileLoops = true;
+    resources.limits.generalUniformIndexing = true;
+    resources.limits.generalAttributeMatrixVectorIndexing = true;
+    resources.limits.generalVaryingIndexing = true;
+    resources.limits.generalSamplerIndexing = true;
+    resources.limits.generalVariableIndexing = true;
+    resources.limits.generalConstantMatrixVectorIndexing = true;
+    return resources;
+}
+
+EShLanguage toLanguage(ShaderCompiler::Stage stage) {
+    switch (stage)
+    {
+        case ShaderCompiler::StageRayGen:       return EShLangRayGen;
+        case ShaderCompiler::StageMiss:         return EShLangMiss;
+        case ShaderCompiler::StageClosestHit:   return EShLangClosestHit;
+        case ShaderCompiler::StageAnyHit:       return EShLangAnyHit;
+        case ShaderCompiler::StageIntersection: return EShLangIntersect;
+        case ShaderCompiler::StageCallable:     return EShLangCallable;
+    }
+    throw std::runtime_error("unknown shader stage!");
+}
+
+bool g_glslangInitialized = false;
+
+}
+
+ShaderCompiler::ShaderCompiler()
+{
+
+}
+
+ShaderCompiler::ShaderCompiler(std::string shaderDirectory, std::string cacheDirectory, std::string targetEnv) : m_shaderDirectory(shaderDirectory), m_cacheDirectory(cacheDirectory), m_targetEnv(targetEnv)
+{
+    if (m_targetEnv != "vulkan1.1" && m_targetEnv != "vulkan1.2") {
+        throw std::runtime_error("unsupported shader target environment " + m_targetEnv + "!");
+    }
+    std::filesystem::create_directories(m_cacheDirectory);
+    if (!g_glslangInitialized) {
+        glslang::InitializeProcess();
+        g_glslangInitialized = true;
+    }
+}
+
+ShaderCompiler::Stage ShaderCompiler::getStage(const std::string& filename){
+    std::string extension = std::filesystem::path(filename).extension().string();
+    if (extension == ".rgen")  return StageRayGen;
+    if (extension == ".rmiss") return StageMiss;
+    if (extension == ".rchit") return StageClosestHit;
+    if (extension == ".rahit") return StageAnyHit;
+    if (extension == ".rint")  return StageIntersection;
+    if (extension == ".rcall") return StageCallable;
+    throw std::runtime_error("unknown shader stage for " + filename + "!");
+}
+
+// FNV-1a 64 Bit
+uint64_t ShaderCompiler::hash(const std::string& data, uint64_t seed){
+    uint64_t value = seed;
+    for (unsigned char c : data) {
+        value ^= c;
+        value *= 1099511628211ull;
+    }
+    return value;
+}
+
+// Liest den Quelltext inklusive aller #include Dateien, damit Änderungen daran den Hash ändern
+std::string ShaderCompiler::readSource(const std::string& path, uint32_t depth){
+    if (depth > 16) {
+        throw std::runtime_error("shader include depth exceeded in " + path + "!");
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open shader " + path + "!");
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (depth == 0 && source.find("#include") == std::string::npos) {
+        return source;
+    }
+    std::string expanded = source;
+    std::istringstream lines(source);
+    std::string line;
+    while (std::getline(lines, line)) {
+        size_t directive = line.find("#include");
+        if (directive == std::string::npos) {
+            continue;
+        }
+        size_t first = line.find_first_of("\"<", directive);
+        size_t last = line.find_last_of("\">");
+        if (first != std::string::npos && last != std::string::npos && last > first) {
+            expanded += readSource(m_shaderDirectory + "/" + line.substr(first + 1, last - first - 1), depth + 1);
+        }
+    }
+    return expanded;
+}
+
+std::string ShaderCompiler::getPreamble(const std::vector<std::string>& defines){
+    std::string preamble = "#extension GL_GOOGLE_include_directive : enable\n";
+    for (const std::string& define : defines) {
+        size_t separator = define.find('=');
+        if (separator == std::string::npos) {
+            preamble += "#define " + define + "\n";
+        } else {
+            preamble += "#define " + define.substr(0, separator) + " " + define.substr(separator + 1) + "\n";
+        }
+    }
+    return preamble;
+}
+
+uint64_t ShaderCompiler::getCacheKey(const std::string& filename, const std::vector<std::string>& defines){
+    uint64_t key = hash(readSource(m_shaderDirectory + filename));
+    key = hash(getPreamble(defines), key);
+    key = hash(m_targetEnv, key);
+    glslang::Version version = glslang::GetVersion();
+    key = hash(std::to_string(version.major) + "." + std::to_string(version.minor) + "." + std::to_string(version.patch), key);
+    return key;
+}
+
+std::string ShaderCompiler::getCachePath(const std::string& filename, uint64_t key){
+    std::ostringstream path;
+    path << m_cacheDirectory << "/" << std::filesystem::path(filename).filename().string() << "_" << std::hex << key << ".spv";
+    return path.str();
+}
+
+std::vector<uint32_t> ShaderCompiler::compile(const std::string& filename, const std::vector<std::string>& defines){
+    uint64_t key = getCacheKey(filename, defines);
+    std::string cachePath = getCachePath(filename, key);
+
+    std::ifstream cached(cachePath, std::ios::ate | std::ios::binary);
+    if (cached.is_open()) {
+        size_t size = static_cast<size_t>(cached.tellg());
+        std::vector<uint32_t> spirv(size / sizeof(uint32_t));
+        cached.seekg(0);
+        cached.read(reinterpret_cast<char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+        // Header prüfen (Magic Number, Bound, Schema), kaputte oder abgeschnittene Dateien werden neu übersetzt
+        if (cached && isValidSpirv(spirv, size)) {
+            m_cacheHits++;
+            return spirv;
+        }
+    }
+
+    std::ifstream file(m_shaderDirectory + filename, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open shader " + filename + "!");
+    }
+    std::string source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<uint32_t> spirv = compileSource(source, getStage(filename), defines, filename);
+
+    // Erst in eine temporäre Datei schreiben, damit parallele Prozesse nie eine halbe Datei lesen
+    std::string tempPath = cachePath + ".tmp";
+    bool written = false;
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (out.is_open()) {
+            out.write(reinterpret_cast<const char*>(spirv.data()), spirv.size() * sizeof(uint32_t));
+            written = static_cast<bool>(out);
+        }
+    }
+    std::error_code error;
+    if (written) {
+        std::filesystem::rename(tempPath, cachePath, error);
+    } else {
+        std::filesystem::remove(tempPath, error);
+    }
+    return spirv;
+}
+
+std::vector<uint32_t> ShaderCompiler::compileSource(const std::string& source, Stage stage, const std::vector<std::string>& defines, const std::string& name){
+    if (!g_glslangInitialized) {
+        glslang::InitializeProcess();
+        g_glslangInitialized = true;
+    }
+    EShLanguage language = toLanguage(stage);
+    glslang::TShader shader(language);
+    const char* sources[] = {source.c_str()};
+    const char* names[] = {name.c_str()};
+    shader.setStringsWithLengthsAndNames(sources, nullptr, names, 1);
+
+    std::string preamble = getPreamble(defines);
+    shader.setPreamble(preamble.c_str());
+
+    glslang::EShTargetClientVersion clientVersion = m_targetEnv == "vulkan1.1" ? glslang::EShTargetVulkan_1_1 : glslang::EShTargetVulkan_1_2;
+    glslang::EShTargetLanguageVersion spirvVersion = m_targetEnv == "vulkan1.1" ? glslang::EShTargetSpv_1_4 : glslang::EShTargetSpv_1_5;
+    shader.setEnvInput(glslang::EShSourceGlsl, language, glslang::EShClientVulkan, 100);
+    shader.setEnvClient(glslang::EShClientVulkan, clientVersion);
+    shader.setEnvTarget(glslang::EShTargetSpv, spirvVersion);
+
+    TBuiltInResource resources = getDefaultResources();
+    EShMessages messages = static_cast<EShMessages>(EShMsgSpvRules | EShMsgVulkanRules);
+    ShaderIncluder includer(m_shaderDirectory);
+    if (!shader.parse(&resources, 460, false, messages, includer)) {
+        throw std::runtime_error("failed to compile shader " + name + "!\n" + shader.getInfoLog() + shader.getInfoDebugLog());
+    }
+
+    glslang::TProgram program;
+    program.addShader(&shader);
+    if (!program.link(messages)) {
+        throw std::runtime_error("failed to link shader " + name + "!\n" + program.getInfoLog() + program.getInfoDebugLog());
+    }
+
+    std::vector<uint32_t> spirv;
+    spv::SpvBuildLogger logger;
+    glslang::SpvOptions options{};
+    glslang::GlslangToSpv(*program.getIntermediate(language), spirv, &logger, &options);
+    if (spirv.empty()) {
+        throw std::runtime_error("failed to generate SPIR-V for shader " + name + "!\n" + logger.getAllMessages());
+    }
+    m_compileCount++;
+    return spirv;
+}
+
+// Fünf Wörter Header: Magic Number, Version, Generator, Bound und Schema (immer 0)
+bool ShaderCompiler::isValidSpirv(const std::vector<uint32_t>& spirv, size_t byteSize){
+    if (byteSize % sizeof(uint32_t) != 0 || spirv.size() <= 5) {
+        return false;
+    }
+    return spirv[0] == 0x07230203 && spirv[3] != 0 && spirv[4] == 0;
+}
+
+uint32_t ShaderCompiler::getCacheHits() const{
+    return m_cacheHits;
+}
+
+uint32_t ShaderCompiler::getCompileCount() const{
+    return m_compileCount;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Übersetzt GLSL zur Laufzeit mit glslang. SPIR-V wird auf der Platte unter einem Hash
+// aus Quelltext (inklusive #include), Defines und Zielumgebung abgelegt
+class ShaderCompiler
+{
+public:
+    enum Stage{
+        StageRayGen = 0,
+        StageMiss,
+        StageClosestHit,
+        StageAnyHit,
+        StageIntersection,
+        StageCallable
+    };
+    ShaderCompiler();
+    ShaderCompiler(std::string shaderDirectory, std::string cacheDirectory, std::string targetEnv = "vulkan1.2");
+    std::vector<uint32_t> compile(const std::string& filename, const std::vector<std::string>& defines = {});
+    std::vector<uint32_t> compileSource(const std::string& source, Stage stage, const std::vector<std::string>& defines = {}, const std::string& name = "shader");
+    uint64_t getCacheKey(const std::string& filename, const std::vector<std::string>& defines);
+    uint32_t getCacheHits() const;
+    uint32_t getCompileCount() const;
+    static Stage getStage(const std::string& filename);
+    static uint64_t hash(const std::string& data, uint64_t seed = 14695981039346656037ull);
+    static bool isValidSpirv(const std::vector<uint32_t>& spirv, size_t byteSize);
+private:
+    std::string m_shaderDirectory;
+    std::string m_cacheDirectory;
+    std::string m_targetEnv;
+    uint32_t m_cacheHits = 0;
+    uint32_t m_compileCount = 0;
+    std::string readSource(const std::string& path, uint32_t depth = 0);
+    std::string getCachePath(const std::string& filename, uint64_t key);
+    static std::string getPreamble(const std::vector<std::string>& defines);
+};
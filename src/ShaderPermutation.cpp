@@ -0,0 +1,90 @@
+#include "ShaderPermutation.h"
+#include <cstddef>
+#include "ShaderCompiler.h"
+
+// Features, die kein Material nutzt, werden abgeschaltet, damit der Compiler die Zweige entfernt
+HitShaderConstants HitShaderConstants::fromScene(const std::vector<Light>& lights, const std::vector<Material>& materials, uint32_t maxRecursion){
+    HitShaderConstants constants{};
+    for (const Light& light : lights) {
+        if (light.m_pos[3] > 0.0001f) {
+            constants.pointLightCount++;
+        } else {
+            constants.dirLightCount++;
+        }
+    }
+    constants.maxRecursion = maxRecursion;
+    constants.enableTextures = VK_FALSE;
+    constants.enableReflection = VK_FALSE;
+    constants.enableRefraction = VK_FALSE;
+    constants.enableAlphaTest = VK_FALSE;
+    for (const Material& material : materials) {
+        if (material.ambientTexId >= 0 || material.diffuseTexId >= 0 || material.specularTexId >= 0) {
+            constants.enableTextures = VK_TRUE;
+        }
+        if (material.illum == 3) {
+            constants.enableReflection = VK_TRUE;
+        }
+        if (material.illum == 7) {
+            constants.enableRefraction = VK_TRUE;
+        }
+        // Ohne Alpha Textur können Schattenstrahlen den Any Hit Shader überspringen
+        if (material.alphaTexId >= 0) {
+            constants.enableAlphaTest = VK_TRUE;
+        }
+    }
+    return constants;
+}
+
+std::vector<VkSpecializationMapEntry> HitShaderConstants::getMapEntries(){
+    return {
+        {0, offsetof(HitShaderConstants, dirLightCount),    sizeof(uint32_t)},
+        {1, offsetof(HitShaderConstants, pointLightCount),  sizeof(uint32_t)},
+        {2, offsetof(HitShaderConstants, maxRecursion),     sizeof(uint32_t)},
+        {3, offsetof(HitShaderConstants, enableTextures),   sizeof(VkBool32)},
+        {4, offsetof(HitShaderConstants, enableReflection), sizeof(VkBool32)},
+        {5, offsetof(HitShaderConstants, enableRefraction), sizeof(VkBool32)},
+        {6, offsetof(HitShaderConstants, lightSamples),     sizeof(uint32_t)},
+        {7, offsetof(HitShaderConstants, useLightTree),     sizeof(VkBool32)},
+        {8, offsetof(HitShaderConstants, iterativePath),    sizeof(VkBool32)},
+        {9, offsetof(HitShaderConstants, enableAlphaTest),  sizeof(VkBool32)},
+        {10, offsetof(HitShaderConstants, materialVariant), sizeof(uint32_t)},
+        {11, offsetof(HitShaderConstants, objectSpaceSpheres), sizeof(VkBool32)},
+        {12, offsetof(HitShaderConstants, shadowSbtOffset), sizeof(uint32_t)}
+    };
+}
+
+// Die Struktur hat keine Lücken, der Schlüssel ist der Hash über alle Werte
+uint64_t HitShaderConstants::getKey() const{
+    return ShaderCompiler::hash(std::string(reinterpret_cast<const char*>(this), sizeof(HitShaderConstants)));
+}
+
+PermutationCache::PermutationCache()
+{
+
+}
+
+VkPipeline PermutationCache::get(uint64_t key) const{
+    auto pipeline = m_pipelines.find(key);
+    if (pipeline == m_pipelines.end()) {
+        return VK_NULL_HANDLE;
+    }
+    return pipeline->second;
+}
+
+void PermutationCache::add(uint64_t key, VkPipeline pipeline){
+    if (m_pipelines.count(key) > 0) {
+        throw std::runtime_error("pipeline permutation already exists!");
+    }
+    m_pipelines[key] = pipeline;
+}
+
+size_t PermutationCache::size() const{
+    return m_pipelines.size();
+}
+
+void PermutationCache::destroy(Device* device){
+    for (auto& pipeline : m_pipelines) {
+        vkDestroyPipeline(device->getHandle(), pipeline.second, nullptr);
+    }
+    m_pipelines.clear();
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <unordered_map>
+#include "Device.h"
+#include "GlobalDefs.h"
+#include "MaterialClassifier.h"
+
+// Spezialisierungskonstanten der Hit Shader, die Reihenfolge entspricht den constant_id
+struct HitShaderConstants{
+    uint32_t dirLightCount = 0;
+    uint32_t pointLightCount = 0;
+    uint32_t maxRecursion = 4;
+    VkBool32 enableTextures = VK_TRUE;
+    VkBool32 enableReflection = VK_TRUE;
+    VkBool32 enableRefraction = VK_TRUE;
+    uint32_t lightSamples = 0;
+    VkBool32 useLightTree = VK_FALSE;
+    VkBool32 iterativePath = VK_FALSE;
+    VkBool32 enableAlphaTest = VK_TRUE;
+    uint32_t materialVariant = UINT32_MAX;  // MaterialVariant der Hit Group, UINT32_MAX für alle Materialien
+    VkBool32 objectSpaceSpheres = VK_TRUE;  // Kugeltest im Objektraum, VK_FALSE für den alten Test in Weltkoordinaten
+    uint32_t shadowSbtOffset = MaterialVariantCount + 1;  // erste Schatten Hit Group hinter den Dreieck Varianten und der Kugel
+    static HitShaderConstants fromScene(const std::vector<Light>& lights, const std::vector<Material>& materials, uint32_t maxRecursion);
+    static std::vector<VkSpecializationMapEntry> getMapEntries();
+    uint64_t getKey() const;
+};
+
+// Hält pro Kombination von Spezialisierungskonstanten eine fertige Pipeline,
+// gebaut wird nur, was eine Szene tatsächlich anfragt
+class PermutationCache
+{
+public:
+    PermutationCache();
+    VkPipeline get(uint64_t key) const;
+    void add(uint64_t key, VkPipeline pipeline);
+    size_t size() const;
+    void destroy(Device* device);
+private:
+    std::unordered_map<uint64_t, VkPipeline> m_pipelines;
+};
@@ -0,0 +1,54 @@
+#include "SlotAllocator.h"
+#include <stdexcept>
+
+SlotAllocator::SlotAllocator()
+{
+
+}
+
+SlotAllocator::SlotAllocator(uint32_t capacity) : m_capacity(capacity), m_allocated(capacity, false)
+{
+
+}
+
+uint32_t SlotAllocator::allocate(){
+    uint32_t slot;
+    if (!m_freeSlots.empty()) {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    } else {
+        if (m_highWater >= m_capacity) {
+            throw std::runtime_error("descriptor slot capacity exceeded!");
+        }
+        slot = m_highWater++;
+    }
+    m_allocated[slot] = true;
+    m_allocatedCount++;
+    return slot;
+}
+
+void SlotAllocator::free(uint32_t slot){
+    if (!isAllocated(slot)) {
+        throw std::runtime_error("descriptor slot freed twice or never allocated!");
+    }
+    m_allocated[slot] = false;
+    m_allocatedCount--;
+    m_freeSlots.push_back(slot);
+}
+
+bool SlotAllocator::isAllocated(uint32_t slot) const{
+    return slot < m_capacity && m_allocated[slot];
+}
+
+uint32_t SlotAllocator::getCapacity() const{
+    return m_capacity;
+}
+
+uint32_t SlotAllocator::getAllocatedCount() const{
+    return m_allocatedCount;
+}
+
+// Ein Slot über dem höchsten je vergebenen, alle gültigen Slots liegen darunter
+uint32_t SlotAllocator::getHighWater() const{
+    return m_highWater;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Vergibt Indizes in ein Descriptor Array fester Größe. Freigegebene Slots kommen auf eine Free List
+// und werden vor neuen Slots wiederverwendet, damit das Array dicht bleibt
+class SlotAllocator
+{
+public:
+    SlotAllocator();
+    SlotAllocator(uint32_t capacity);
+    uint32_t allocate();
+    void free(uint32_t slot);
+    bool isAllocated(uint32_t slot) const;
+    uint32_t getCapacity() const;
+    uint32_t getAllocatedCount() const;
+    uint32_t getHighWater() const;
+private:
+    uint32_t m_capacity = 0;
+    uint32_t m_highWater = 0;
+    uint32_t m_allocatedCount = 0;
+    std::vector<uint32_t> m_freeSlots;
+    std::vector<bool> m_allocated;
+};
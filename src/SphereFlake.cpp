@@ -5,13 +5,36 @@ SphereFlake::SphereFlake(){
 }
 
 void SphereFlake::generateSphereFlake(int recursionDepth, float radius){
-    generateSphereFlake(recursionDepth, glm::mat4(1.f), radius);
+    generateSphereFlake(recursionDepth, radius, JobSystem::getDefault());
+}
+
+void SphereFlake::generateSphereFlake(int recursionDepth, float radius, JobSystem& jobs){
+    m_spheres.resize(getSphereCount(recursionDepth));
+    generateSphereFlake(recursionDepth, radius, m_spheres.data(), jobs);
     std::cout<<"Sphereflake Size: "<<m_spheres.size()<<std::endl;
 }
 
-void SphereFlake::generateSphereFlake(int recursionDepth,  glm::mat4 ModelMatrix, float radius){
+void SphereFlake::generateSphereFlake(int recursionDepth, float radius, Sphere* spheres, JobSystem& jobs){
+    generateSphereFlake(recursionDepth, glm::mat4(1.f), radius, spheres, &jobs, ParallelLevels);
+}
+
+// 1 + 9 + 81 + ... + 9^recursionDepth
+size_t SphereFlake::getSphereCount(int recursionDepth){
+    size_t count = 0;
+    size_t level = 1;
+    for (int i = 0; i <= recursionDepth; i++) {
+        count += level;
+        level *= 9;
+    }
+    return count;
+}
+
+// Die Kugeln liegen in Tiefensuche Reihenfolge, Teilbaum i beginnt also bei 1 + i * getSphereCount(recursionDepth - 1).
+// Dadurch schreibt jeder Job in seinen eigenen Abschnitt des Puffers
+void SphereFlake::generateSphereFlake(int recursionDepth, const glm::mat4& ModelMatrix, float radius, Sphere* spheres, JobSystem* jobs, int parallelLevels){
     glm::vec4 tempCenter = ModelMatrix * glm::vec4(0.f, 0.f, 0.f, 1.f);
-    Sphere sphere;
+    Sphere& sphere = spheres[0];
+    sphere = Sphere{};
     sphere.matID = 0;
     sphere.center[0] = tempCenter.x; 
     sphere.center[1] = tempCenter.y; 
@@ -23,58 +46,105 @@ void SphereFlake::generateSphereFlake(int recursionDepth,  glm::mat4 ModelMatrix
     sphere.aabbmax[0] = sphere.center[0] + sphere.radius; 
     sphere.aabbmax[1] = sphere.center[1] + sphere.radius; 
     sphere.aabbmax[2] = sphere.center[2] + sphere.radius;
-
-    m_spheres.push_back(sphere);
 	
 	if (recursionDepth-- > 0)
 	{
 		float newRadius = radius / 3.f;
-		
-		glm::vec3 xVec = glm::vec3(glm::column( ModelMatrix, 0));
-		glm::vec3 yVec = glm::vec3(glm::column( ModelMatrix, 1));
-		glm::vec3 zVec = glm::vec3(glm::column( ModelMatrix, 2));
-		glm::vec3 center = glm::vec3(glm::column( ModelMatrix, 3));
+		glm::mat4 children[9];
+		getChildFrames(ModelMatrix, radius, children);
+
+		size_t childCount = getSphereCount(recursionDepth);
+		if (jobs != nullptr && parallelLevels > 0)
+		{
+			jobs->parallelFor(0, 9, 1, [&](uint32_t begin, uint32_t end){
+				for (uint32_t i = begin; i < end; i++)
+					generateSphereFlake(recursionDepth, children[i], newRadius, spheres + 1 + i * childCount, jobs, parallelLevels - 1);
+			});
+		}
+		else
+		{
+			for (int i = 0; i < 9; i++)
+				generateSphereFlake(recursionDepth, children[i], newRadius, spheres + 1 + i * childCount, jobs, parallelLevels);
+		}
+	}	
+
+}
+
+// Sechs Kinder am Äquator und drei oben, jeweils mit Radius radius / 3. Die Spalten sind orthonormal
+void SphereFlake::getChildFrames(const glm::mat4& ModelMatrix, float radius, glm::mat4 children[9]){
+	float newRadius = radius / 3.f;
+	
+	glm::vec3 xVec = glm::vec3(glm::column( ModelMatrix, 0));
+	glm::vec3 yVec = glm::vec3(glm::column( ModelMatrix, 1));
+	glm::vec3 zVec = glm::vec3(glm::column( ModelMatrix, 2));
+	glm::vec3 center = glm::vec3(glm::column( ModelMatrix, 3));
 
-		float rho = 2.f * glm::pi<float>() / 6.f;
+	float rho = 2.f * glm::pi<float>() / 6.f;
+	
+	for (int i = 0; i < 6; i++)
+	{			
+		float phi = i * rho;
 		
-		for (int i = 0; i < 6; i++)
-		{			
-			float phi = i * rho;
-			
-			glm::vec3 newy = ((float)cos(phi)) * xVec + ((float)sin(phi)) * zVec;
-			glm::vec3 newx = glm::cross( newy, yVec);
-			glm::vec3 newz = glm::cross( newx, newy);
-			glm::vec3 newcenter = center + newy * (radius + newRadius);
-
-			glm::mat4 newmat = glm::mat4( glm::vec4( newx, 0), glm::vec4( newy, 0), glm::vec4( newz, 0), glm::vec4( newcenter, 1.f));
-
-			generateSphereFlake(recursionDepth, newmat, newRadius);
-		}	
+		glm::vec3 newy = ((float)cos(phi)) * xVec + ((float)sin(phi)) * zVec;
+		glm::vec3 newx = glm::cross( newy, yVec);
+		glm::vec3 newz = glm::cross( newx, newy);
+		glm::vec3 newcenter = center + newy * (radius + newRadius);
+
+		children[i] = glm::mat4( glm::vec4( newx, 0), glm::vec4( newy, 0), glm::vec4( newz, 0), glm::vec4( newcenter, 1.f));
+	}	
+	
+	for (int i = 0; i < 3; i++)
+	{
+		float phi = (i + 0.5f) * 2.f * rho;
 		
-		for (int i = 0; i < 3; i++)
-		{
-			float phi = (i + 0.5f) * 2.f * rho;
-			
-			glm::vec3 tmpy = ((float)cos(phi)) * xVec + ((float)sin(phi)) * zVec;
-			glm::vec3 newy = ((float)cos(rho)) * tmpy + ((float)sin(rho)) * yVec;
-			glm::vec3 newx = glm::cross( newy, yVec);
-			newx = glm::normalize( newx);
-			glm::vec3 newz = glm::cross( newx, newy);
-			glm::vec3 newcenter = center + newy * (radius + newRadius);
-
-			glm::mat4 newmat = glm::mat4( glm::vec4( newx, 0), glm::vec4( newy, 0), glm::vec4( newz, 0), glm::vec4( newcenter, 1.f));
-			
-			generateSphereFlake(recursionDepth, newmat, newRadius);
-		}	
+		glm::vec3 tmpy = ((float)cos(phi)) * xVec + ((float)sin(phi)) * zVec;
+		glm::vec3 newy = ((float)cos(rho)) * tmpy + ((float)sin(rho)) * yVec;
+		glm::vec3 newx = glm::cross( newy, yVec);
+		newx = glm::normalize( newx);
+		glm::vec3 newz = glm::cross( newx, newy);
+		glm::vec3 newcenter = center + newy * (radius + newRadius);
+
+		children[6 + i] = glm::mat4( glm::vec4( newx, 0), glm::vec4( newy, 0), glm::vec4( newz, 0), glm::vec4( newcenter, 1.f));
 	}	
+}
+
+// Ein Teilflake der Tiefe k mit Radius 1 im Ursprung, skaliert und gedreht auf einen Knoten der Ebene recursionDepth - k,
+// ergibt genau den Teilbaum dieses Knotens. Die Ebenen darüber fehlen und kommen aus generateSphereFlake(recursionDepth - k - 1)
+void SphereFlake::generateInstanceTransforms(int levels, float radius, std::vector<glm::mat4>& transforms){
+    transforms.resize(getInstanceCount(levels));
+    generateInstanceTransforms(levels, glm::mat4(1.f), radius, transforms.data());
+}
 
+// 9^levels
+size_t SphereFlake::getInstanceCount(int levels){
+    size_t count = 1;
+    for (int i = 0; i < levels; i++) {
+        count *= 9;
+    }
+    return count;
 }
 
+void SphereFlake::generateInstanceTransforms(int levels, const glm::mat4& ModelMatrix, float radius, glm::mat4* transforms){
+    if (levels == 0) {
+        transforms[0] = glm::scale(ModelMatrix, glm::vec3(radius));
+        return;
+    }
+    glm::mat4 children[9];
+    getChildFrames(ModelMatrix, radius, children);
+    size_t childCount = getInstanceCount(levels - 1);
+    for (int i = 0; i < 9; i++)
+        generateInstanceTransforms(levels - 1, children[i], radius / 3.f, transforms + i * childCount);
+}
 
-std::vector<Sphere> SphereFlake::getSpheres(){
+
+const std::vector<Sphere>& SphereFlake::getSpheres() const{
     return m_spheres;
 }
 
+std::vector<Sphere> SphereFlake::takeSpheres(){
+    return std::move(m_spheres);
+}
+
 SphereFlake::~SphereFlake(){
 
 }
\ No newline at end of file
@@ -1,18 +1,33 @@
 #pragma once
 #include "GlobalDefs.h"
 #include <glm/gtc/matrix_access.hpp>
+#include "JobSystem.h"
 
 class SphereFlake
 {
 private:
     std::vector<Sphere> m_spheres;
-    void generateSphereFlake(int recursionDepth,  glm::mat4 ModelMatrix, float radius);
+    static void generateSphereFlake(int recursionDepth, const glm::mat4& ModelMatrix, float radius, Sphere* spheres, JobSystem* jobs, int parallelLevels);
+    static void generateInstanceTransforms(int levels, const glm::mat4& ModelMatrix, float radius, glm::mat4* transforms);
+    static void getChildFrames(const glm::mat4& ModelMatrix, float radius, glm::mat4 children[9]);
 public:
+    // Die obersten Ebenen verteilen ihre neun Teilbäume als Jobs, jeder schreibt direkt in seinen Abschnitt des Puffers
+    static const int ParallelLevels = 2;
+
     SphereFlake();
     
     void generateSphereFlake(int recursionDepth, float radius);
+    void generateSphereFlake(int recursionDepth, float radius, JobSystem& jobs);
+    // Schreibt in einen Puffer des Aufrufers mit genau getSphereCount(recursionDepth) Einträgen
+    static void generateSphereFlake(int recursionDepth, float radius, Sphere* spheres, JobSystem& jobs);
+    static size_t getSphereCount(int recursionDepth);
+    // Zweistufig: eine Transformation pro Knoten der Ebene levels, Skalierung radius / 3^levels
+    static void generateInstanceTransforms(int levels, float radius, std::vector<glm::mat4>& transforms);
+    static size_t getInstanceCount(int levels);
 
-    std::vector<Sphere> getSpheres();
+    const std::vector<Sphere>& getSpheres() const;
+    // Gibt den Puffer ohne Kopie ab, z.B. an BottomLevelSphereAS::createSpheres
+    std::vector<Sphere> takeSpheres();
 
     ~SphereFlake();
 };
\ No newline at end of file
@@ -2,6 +2,9 @@
 #include "Texture.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 Texture::Texture(/* args */)
 {
@@ -14,50 +17,109 @@ Texture::Texture(Device* device, std::string filepath, VkFormat format)
     m_memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
     m_format = format;
     m_device = device;
+    m_filepath = filepath;
+    // Ohne Device wird nur der Pfad gemerkt, der CPU Ray Tracer lädt die Bilder selbst
+    if (m_device == nullptr) {
+        return;
+    }
+    upload(decode(filepath));
+}
 
+// Für vorab, z.B. parallel über das JobSystem, dekodierte Bilder
+Texture::Texture(Device* device, std::string filepath, VkFormat format, const Image& image)
+{
+    m_usageFlags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    m_memoryPropertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    m_format = format;
+    m_device = device;
+    m_filepath = filepath;
+    if (m_device == nullptr) {
+        return;
+    }
+    upload(image);
+}
 
+// Lädt das Bild und erzeugt die Mip Kette, ohne Vulkan Aufrufe und damit von jedem Thread aus nutzbar.
+// Die Mip Kette entsteht auf der CPU, weil die Transfer Queue kein vkCmdBlitImage kann.
+// Die Hit Shader wählen das Level über Ray Cones aus
+Texture::Image Texture::decode(const std::string& filepath){
     std::string texture_path = TEXTURE_PATH;
     texture_path += filepath;
     const char* path = texture_path.c_str();
     int texWidth, texHeight, texChannels;
     stbi_uc* pixels = stbi_load(path, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;
-
-    m_width = static_cast<uint32_t>(texWidth);
-    m_height = static_cast<uint32_t>(texHeight);
 
     if (!pixels) {
         throw std::runtime_error("failed to load texture image!");
     }
 
+    Image image{};
+    image.width = static_cast<uint32_t>(texWidth);
+    image.height = static_cast<uint32_t>(texHeight);
+    VkDeviceSize imageSize = static_cast<VkDeviceSize>(texWidth) * texHeight * 4;
+    image.mipLevels = getMipLevelCount(image.width, image.height);
+    image.data = std::vector<stbi_uc>(pixels, pixels + imageSize);
+    image.regions.resize(image.mipLevels);
+    std::vector<stbi_uc> level = image.data;
+    uint32_t levelWidth = image.width;
+    uint32_t levelHeight = image.height;
+    VkDeviceSize levelOffset = 0;
+    for (uint32_t mip = 0; mip < image.mipLevels; mip++) {
+        image.regions[mip].bufferOffset = levelOffset;
+        image.regions[mip].imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, mip, 0, 1};
+        image.regions[mip].imageExtent = {levelWidth, levelHeight, 1};
+        if (mip + 1 < image.mipLevels) {
+            levelOffset += static_cast<VkDeviceSize>(levelWidth) * levelHeight * 4;
+            level = downsample(level.data(), levelWidth, levelHeight);
+            levelWidth = std::max(levelWidth / 2, 1u);
+            levelHeight = std::max(levelHeight / 2, 1u);
+            image.data.insert(image.data.end(), level.begin(), level.end());
+        }
+    }
+    stbi_image_free(pixels);
+    return image;
+}
+
+void Texture::upload(const Image& image){
+    m_width = image.width;
+    m_height = image.height;
+    m_mipLevels = image.mipLevels;
+    const std::vector<VkBufferImageCopy>& regions = image.regions;
+    VkDeviceSize imageSize = image.data.size();
+
     Buffer stagingBuffer = Buffer(m_device, imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
     stagingBuffer.map(imageSize, 0);
-    stagingBuffer.copyTo(pixels, static_cast<size_t>(imageSize));
+    stagingBuffer.copyTo(image.data.data(), static_cast<size_t>(imageSize));
     stagingBuffer.unmap();
 
-    stbi_image_free(pixels);
-    createImage(m_width, m_height, format, VK_IMAGE_TILING_OPTIMAL, m_usageFlags, m_memoryPropertyFlags);
-    VkCommandBuffer command_buffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+    createImage(m_width, m_height, m_format, VK_IMAGE_TILING_OPTIMAL, m_usageFlags, m_memoryPropertyFlags);
 
-        setImageLayout(command_buffer, m_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
+    // Upload über die Transfer Queue, damit das Rendering nicht blockiert wird
+    uint32_t transferFamily = m_device->getTransferQueueFamily();
+    uint32_t graphicsFamily = m_device->getGraphicsQueueFamily();
+    VkCommandBuffer command_buffer = createCommandBuffer(m_device->getTransferCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
 
-        VkBufferImageCopy region{};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
-        region.imageOffset = {0, 0, 0};
-        region.imageExtent = {m_width, m_height, 1};
-        vkCmdCopyBufferToImage(command_buffer, stagingBuffer.getHandle(), m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        setImageLayout(command_buffer, m_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_mipLevels, 0, 1}, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
-        setImageLayout(command_buffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
+        vkCmdCopyBufferToImage(command_buffer, stagingBuffer.getHandle(), m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
 
-    flushCommandBuffer(command_buffer, m_device->getGraphicsQueue());
+    // Kein Host Wait: die Graphics Queue wartet über die Transfer Timeline, Staging wird nach Abschluss freigegeben
+    uint64_t uploadValue = 0;
+    if (transferFamily == graphicsFamily) {
+        setImageLayout(command_buffer, m_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_mipLevels, 0, 1}, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+        uploadValue = m_device->submitAsync(Device::QueueTransfer, command_buffer);
+    } else {
+        // Release auf der Transfer Queue, Acquire auf der Graphics Queue
+        transferOwnership(command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, transferFamily, graphicsFamily, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, 0);
+        uploadValue = m_device->submitAsync(Device::QueueTransfer, command_buffer);
 
-    stagingBuffer.destroy();
+        command_buffer = createCommandBuffer(m_device->getCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+        transferOwnership(command_buffer, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, transferFamily, graphicsFamily, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, 0, VK_ACCESS_SHADER_READ_BIT);
+        m_device->submitAsync(Device::QueueGraphics, command_buffer, {{Device::QueueTransfer, uploadValue, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR}});
+    }
+    m_device->deferRelease(Device::QueueTransfer, uploadValue, [stagingBuffer]() mutable {
+        stagingBuffer.destroy();
+    });
 
     createTextureImageView();
     createTextureSampler();
@@ -74,9 +136,9 @@ Texture::Texture(Device* device, uint32_t width, uint32_t height, VkFormat forma
 
     createImage(m_width, m_height, format, VK_IMAGE_TILING_OPTIMAL, m_usageFlags, m_memoryPropertyFlags);
     createTextureImageView();
-    VkCommandBuffer command_buffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
-        setImageLayout(command_buffer, m_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1});
-    flushCommandBuffer(command_buffer, m_device->getGraphicsQueue());
+    VkCommandBuffer command_buffer = createCommandBuffer(m_device->getCommandPool(), VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+        setImageLayout(command_buffer, m_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL, {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1}, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR);
+    flushCommandBuffer(command_buffer, m_device->getGraphicsQueue(), m_device->getCommandPool());
 }
 
 VkDescriptorImageInfo Texture::getDescriptorInfo(){
@@ -98,6 +160,65 @@ VkImage Texture::getImage(){
     return m_image;
 }
 
+const std::string& Texture::getFilepath() const{
+    return m_filepath;
+}
+
+uint32_t Texture::getMipLevelCount(uint32_t width, uint32_t height){
+    uint32_t levels = 1;
+    while ((width | height) >> levels) {
+        levels++;
+    }
+    return levels;
+}
+
+namespace {
+
+float srgbToLinear(float value){
+    return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+float linearToSrgb(float value){
+    return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+}
+
+// 2x2 Box Filter auf RGBA8 sRGB Daten, bei ungerader Größe wird die letzte Zeile bzw. Spalte wiederholt.
+// RGB wird linear gemittelt und wieder nach sRGB kodiert, Alpha ist bereits linear
+std::vector<stbi_uc> Texture::downsample(const stbi_uc* pixels, uint32_t width, uint32_t height){
+    static const std::array<float, 256> toLinear = [](){
+        std::array<float, 256> table{};
+        for (uint32_t i = 0; i < 256; i++) {
+            table[i] = srgbToLinear(i / 255.0f);
+        }
+        return table;
+    }();
+    uint32_t dstWidth = std::max(width / 2, 1u);
+    uint32_t dstHeight = std::max(height / 2, 1u);
+    std::vector<stbi_uc> dst(static_cast<size_t>(dstWidth) * dstHeight * 4);
+    for (uint32_t y = 0; y < dstHeight; y++) {
+        uint32_t y0 = std::min(2 * y, height - 1);
+        uint32_t y1 = std::min(2 * y + 1, height - 1);
+        for (uint32_t x = 0; x < dstWidth; x++) {
+            uint32_t x0 = std::min(2 * x, width - 1);
+            uint32_t x1 = std::min(2 * x + 1, width - 1);
+            const stbi_uc* p00 = pixels + (static_cast<size_t>(y0) * width + x0) * 4;
+            const stbi_uc* p01 = pixels + (static_cast<size_t>(y0) * width + x1) * 4;
+            const stbi_uc* p10 = pixels + (static_cast<size_t>(y1) * width + x0) * 4;
+            const stbi_uc* p11 = pixels + (static_cast<size_t>(y1) * width + x1) * 4;
+            stbi_uc* out = dst.data() + (static_cast<size_t>(y) * dstWidth + x) * 4;
+            for (uint32_t c = 0; c < 3; c++) {
+                float linear = 0.25f * (toLinear[p00[c]] + toLinear[p01[c]] + toLinear[p10[c]] + toLinear[p11[c]]);
+                out[c] = static_cast<stbi_uc>(std::min(linearToSrgb(linear) * 255.0f + 0.5f, 255.0f));
+            }
+            uint32_t alpha = p00[3] + p01[3] + p10[3] + p11[3];
+            out[3] = static_cast<stbi_uc>((alpha + 2) / 4);
+        }
+    }
+    return dst;
+}
+
 void Texture::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -105,7 +226,7 @@ void Texture::createImage(uint32_t width, uint32_t height, VkFormat format, VkIm
     imageInfo.extent.width = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth = 1;
-    imageInfo.mipLevels = 1;
+    imageInfo.mipLevels = m_mipLevels;
     imageInfo.arrayLayers = 1;
     imageInfo.format = format;
     imageInfo.tiling = tiling;
@@ -129,6 +250,7 @@ void Texture::createImage(uint32_t width, uint32_t height, VkFormat format, VkIm
     if (vkAllocateMemory(m_device->getHandle(), &allocInfo, nullptr, &m_imageMemory) != VK_SUCCESS) {
         throw std::runtime_error("failed to allocate image memory!");
     }
+    m_device->trackAllocation(m_imageMemory, allocInfo.allocationSize);
 
     vkBindImageMemory(m_device->getHandle(), m_image, m_imageMemory, 0);
 }
@@ -141,7 +263,7 @@ void Texture::createTextureImageView() {
     viewInfo.format = m_format;
     viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = 1;
+    viewInfo.subresourceRange.levelCount = m_mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = 1;
     if (vkCreateImageView(m_device->getHandle(), &viewInfo, nullptr, &m_imageView) != VK_SUCCESS) {
@@ -167,6 +289,8 @@ void Texture::createTextureSampler() {
     samplerInfo.compareEnable = VK_FALSE;
     samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.minLod = 0.0f;
+    samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
     if (vkCreateSampler(m_device->getHandle(), &samplerInfo, nullptr, &m_sampler) != VK_SUCCESS) {
         throw std::runtime_error("failed to create texture sampler!");
@@ -248,11 +372,26 @@ void Texture::createTextureSampler() {
     vkCmdPipelineBarrier(command_buffer, srcMask, dstMask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
 }
 
-VkCommandBuffer Texture::createCommandBuffer(VkCommandBufferLevel level, bool begin)
+void Texture::transferOwnership(VkCommandBuffer command_buffer, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcQueueFamily, uint32_t dstQueueFamily, VkPipelineStageFlags srcMask, VkPipelineStageFlags dstMask, VkAccessFlags srcAccess, VkAccessFlags dstAccess)
+{
+    VkImageMemoryBarrier barrier{};
+    barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = srcQueueFamily;
+    barrier.dstQueueFamilyIndex = dstQueueFamily;
+    barrier.srcAccessMask       = srcAccess;
+    barrier.dstAccessMask       = dstAccess;
+    barrier.oldLayout           = oldLayout;
+    barrier.newLayout           = newLayout;
+    barrier.image               = m_image;
+    barrier.subresourceRange    = {VK_IMAGE_ASPECT_COLOR_BIT, 0, m_mipLevels, 0, 1};
+    vkCmdPipelineBarrier(command_buffer, srcMask, dstMask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VkCommandBuffer Texture::createCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level, bool begin)
 {
     VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
     cmdBufAllocateInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    cmdBufAllocateInfo.commandPool        = m_device->getCommandPool();
+    cmdBufAllocateInfo.commandPool        = commandPool;
     cmdBufAllocateInfo.level              = level;
     cmdBufAllocateInfo.commandBufferCount = 1;
 
@@ -270,7 +409,7 @@ VkCommandBuffer Texture::createCommandBuffer(VkCommandBufferLevel level, bool be
     return command_buffer;
 }
 
-void Texture::flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue, bool free, VkSemaphore signalSemaphore) 
+void Texture::flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue, VkCommandPool commandPool, bool free, VkSemaphore signalSemaphore) 
 {
     if (command_buffer == VK_NULL_HANDLE)
     {
@@ -304,7 +443,7 @@ void Texture::flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue,
 
     vkDestroyFence(m_device->getHandle(), fence, nullptr);
 
-    vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), 1, &command_buffer);
+    vkFreeCommandBuffers(m_device->getHandle(), commandPool, 1, &command_buffer);
 }
 
 uint32_t Texture::findMemoryType(uint32_t typeFilter) {
@@ -319,9 +458,13 @@ uint32_t Texture::findMemoryType(uint32_t typeFilter) {
 }
 
 void Texture::destroy(){
+    if (m_device == nullptr) {
+        return;
+    }
     vkDestroySampler(m_device->getHandle(), m_sampler, nullptr);
     vkDestroyImageView(m_device->getHandle(), m_imageView, nullptr);
     vkDestroyImage(m_device->getHandle(), m_image, nullptr);
+    m_device->trackFree(m_imageMemory);
     vkFreeMemory(m_device->getHandle(), m_imageMemory, nullptr);
 }
 
@@ -7,8 +7,17 @@
 
 class Texture
 {
+public:
+    // Dekodiertes Bild mit allen Mip Leveln hintereinander, regions beschreibt die Level für vkCmdCopyBufferToImage
+    struct Image{
+        uint32_t width;
+        uint32_t height;
+        uint32_t mipLevels;
+        std::vector<stbi_uc> data;
+        std::vector<VkBufferImageCopy> regions;
+    };
 private:
-    Device*                 m_device;
+    Device*                 m_device = nullptr;
     VkImage                 m_image;
     VkBufferUsageFlags      m_usageFlags;
     VkMemoryPropertyFlags   m_memoryPropertyFlags;
@@ -18,19 +27,28 @@ private:
     VkFormat                m_format;
     uint32_t                m_width;
     uint32_t                m_height;
+    uint32_t                m_mipLevels = 1;
+    std::string             m_filepath;
     void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties);
     void createTextureImageView();
     void createTextureSampler();
-    void setImageLayout(VkCommandBuffer command_buffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subresourceRange, VkPipelineStageFlags srcMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
-    VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin);
-    void flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue, bool free = true, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
+    void setImageLayout(VkCommandBuffer command_buffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subresourceRange, VkPipelineStageFlags srcMask, VkPipelineStageFlags dstMask);
+    void transferOwnership(VkCommandBuffer command_buffer, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t srcQueueFamily, uint32_t dstQueueFamily, VkPipelineStageFlags srcMask, VkPipelineStageFlags dstMask, VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+    VkCommandBuffer createCommandBuffer(VkCommandPool commandPool, VkCommandBufferLevel level, bool begin);
+    void flushCommandBuffer(VkCommandBuffer command_buffer, VkQueue queue, VkCommandPool commandPool, bool free = true, VkSemaphore signalSemaphore = VK_NULL_HANDLE);
     uint32_t findMemoryType(uint32_t typeFilter);
+    void upload(const Image& image);
 public:
     Texture();
     Texture(Device* device, std::string filepath, VkFormat format);
+    Texture(Device* device, std::string filepath, VkFormat format, const Image& image);
     Texture(Device* device, uint32_t width, uint32_t height, VkFormat format);
     VkDescriptorImageInfo getDescriptorInfo();
     VkImage getImage();
+    const std::string& getFilepath() const;
+    static Image decode(const std::string& filepath);
+    static uint32_t getMipLevelCount(uint32_t width, uint32_t height);
+    static std::vector<stbi_uc> downsample(const stbi_uc* pixels, uint32_t width, uint32_t height);
     void destroy();
     ~Texture();
 };
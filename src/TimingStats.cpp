@@ -0,0 +1,136 @@
+#include "TimingStats.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+TimingStats::TimingStats(size_t maxSamples) : m_maxSamples(maxSamples)
+{
+
+}
+
+void TimingStats::add(const std::string& name, double milliseconds){
+    auto it = m_samples.find(name);
+    if (it == m_samples.end()) {
+        m_names.push_back(name);
+        it = m_samples.emplace(name, std::deque<double>()).first;
+    }
+    it->second.push_back(milliseconds);
+    // Nur die letzten Werte behalten, damit lange Sitzungen nicht wachsen
+    if (m_maxSamples > 0 && it->second.size() > m_maxSamples) {
+        it->second.pop_front();
+    }
+}
+
+void TimingStats::clear(){
+    m_names.clear();
+    m_samples.clear();
+}
+
+const std::vector<std::string>& TimingStats::getNames() const{
+    return m_names;
+}
+
+std::vector<double> TimingStats::getSamples(const std::string& name) const{
+    auto it = m_samples.find(name);
+    if (it == m_samples.end()) {
+        return std::vector<double>(0);
+    }
+    return std::vector<double>(it->second.begin(), it->second.end());
+}
+
+size_t TimingStats::getCount(const std::string& name) const{
+    auto it = m_samples.find(name);
+    return it == m_samples.end() ? 0 : it->second.size();
+}
+
+double TimingStats::getMean(const std::string& name) const{
+    std::vector<double> samples = getSamples(name);
+    if (samples.empty()) {
+        return 0.0;
+    }
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    return sum / samples.size();
+}
+
+double TimingStats::getPercentile(const std::string& name, double percent) const{
+    return percentile(getSamples(name), percent);
+}
+
+// Lineare Interpolation zwischen den benachbarten Rängen
+double TimingStats::percentile(std::vector<double> samples, double percent){
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    double rank = std::min(std::max(percent, 0.0), 100.0) / 100.0 * (samples.size() - 1);
+    size_t lower = static_cast<size_t>(rank);
+    size_t upper = std::min(lower + 1, samples.size() - 1);
+    double fraction = rank - lower;
+    return samples[lower] + (samples[upper] - samples[lower]) * fraction;
+}
+
+std::string TimingStats::escape(const std::string& name){
+    std::string escaped;
+    for (char c : name) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+        }
+        escaped += c;
+    }
+    return escaped;
+}
+
+std::string TimingStats::toCSV() const{
+    std::ostringstream out;
+    out << "pass,count,mean_ms,min_ms,p50_ms,p95_ms,p99_ms,max_ms\n";
+    for (const std::string& name : m_names) {
+        out << name << ","
+            << getCount(name) << ","
+            << getMean(name) << ","
+            << getPercentile(name, 0.0) << ","
+            << getPercentile(name, 50.0) << ","
+            << getPercentile(name, 95.0) << ","
+            << getPercentile(name, 99.0) << ","
+            << getPercentile(name, 100.0) << "\n";
+    }
+    return out.str();
+}
+
+std::string TimingStats::toJSON() const{
+    std::ostringstream out;
+    out << "{\"passes\":[";
+    for (size_t i = 0; i < m_names.size(); i++) {
+        const std::string& name = m_names[i];
+        out << (i > 0 ? "," : "")
+            << "{\"name\":\"" << escape(name) << "\""
+            << ",\"count\":" << getCount(name)
+            << ",\"mean_ms\":" << getMean(name)
+            << ",\"min_ms\":" << getPercentile(name, 0.0)
+            << ",\"p50_ms\":" << getPercentile(name, 50.0)
+            << ",\"p95_ms\":" << getPercentile(name, 95.0)
+            << ",\"p99_ms\":" << getPercentile(name, 99.0)
+            << ",\"max_ms\":" << getPercentile(name, 100.0) << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+void TimingStats::writeCSV(const std::string& path) const{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + path + "!");
+    }
+    file << toCSV();
+}
+
+void TimingStats::writeJSON(const std::string& path) const{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("failed to open " + path + "!");
+    }
+    file << toJSON();
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+// Sammelt Zeiten pro Pass, unabhängig von Vulkan damit es auf der CPU testbar bleibt
+class TimingStats
+{
+private:
+    size_t m_maxSamples;
+    std::vector<std::string> m_names;
+    std::map<std::string, std::deque<double>> m_samples;
+    static std::string escape(const std::string& name);
+public:
+    TimingStats(size_t maxSamples = 10000);
+    void add(const std::string& name, double milliseconds);
+    void clear();
+    const std::vector<std::string>& getNames() const;
+    std::vector<double> getSamples(const std::string& name) const;
+    size_t getCount(const std::string& name) const;
+    double getMean(const std::string& name) const;
+    double getPercentile(const std::string& name, double percent) const;
+    std::string toCSV() const;
+    std::string toJSON() const;
+    void writeCSV(const std::string& path) const;
+    void writeJSON(const std::string& path) const;
+    static double percentile(std::vector<double> samples, double percent);
+};
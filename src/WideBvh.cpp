@@ -0,0 +1,108 @@
+#include "WideBvh.h"
+#include <limits>
+
+WideBvh::WideBvh()
+{
+
+}
+
+// Pro Knoten wird das innere Kind mit der größten Oberfläche durch seine beiden Kinder ersetzt, bis Width Kinder
+// erreicht sind oder nur noch Blätter übrig bleiben. Ist die Wurzel selbst ein Blatt, hat der einzige Knoten ein Kind
+void WideBvh::collapse(const Bvh& bvh){
+    m_nodes.clear();
+    m_leaves.clear();
+    m_indices = bvh.getIndices();
+    const std::vector<Bvh::Node>& nodes = bvh.getNodes();
+    if (nodes.empty()) {
+        return;
+    }
+    auto surfaceArea = [&](uint32_t index){
+        Aabb bounds;
+        bounds.min = nodes[index].boundsMin;
+        bounds.max = nodes[index].boundsMax;
+        return bounds.getSurfaceArea();
+    };
+
+    std::vector<std::pair<uint32_t, uint32_t>> queue = {{0, 0}};
+    m_nodes.push_back({});
+    while (!queue.empty()) {
+        auto [binaryIndex, wideIndex] = queue.back();
+        queue.pop_back();
+
+        uint32_t children[Width];
+        uint32_t childCount = 0;
+        if (nodes[binaryIndex].count > 0) {
+            children[childCount++] = binaryIndex;
+        } else {
+            children[childCount++] = binaryIndex + 1;
+            children[childCount++] = nodes[binaryIndex].rightOrFirst;
+        }
+        while (childCount < Width) {
+            int largest = -1;
+            float largestArea = -1.0f;
+            for (uint32_t i = 0; i < childCount; i++) {
+                if (nodes[children[i]].count == 0 && surfaceArea(children[i]) > largestArea) {
+                    largest = static_cast<int>(i);
+                    largestArea = surfaceArea(children[i]);
+                }
+            }
+            if (largest < 0) {
+                break;
+            }
+            uint32_t expanded = children[largest];
+            children[largest] = expanded + 1;
+            children[childCount++] = nodes[expanded].rightOrFirst;
+        }
+
+        Node node;
+        for (uint32_t i = 0; i < Width; i++) {
+            for (int axis = 0; axis < 3; axis++) {
+                node.bounds[axis][i] = std::numeric_limits<float>::infinity();
+                node.bounds[axis + 3][i] = -std::numeric_limits<float>::infinity();
+            }
+            node.child[i] = Invalid;
+            node.count[i] = 0;
+        }
+        for (uint32_t i = 0; i < childCount; i++) {
+            const Bvh::Node& child = nodes[children[i]];
+            for (int axis = 0; axis < 3; axis++) {
+                node.bounds[axis][i] = child.boundsMin[axis];
+                node.bounds[axis + 3][i] = child.boundsMax[axis];
+            }
+            if (child.count > 0) {
+                node.child[i] = static_cast<uint32_t>(m_leaves.size());
+                node.count[i] = child.count;
+                m_leaves.push_back({child.rightOrFirst, child.count});
+            } else {
+                node.child[i] = static_cast<uint32_t>(m_nodes.size());
+                m_nodes.push_back({});
+                queue.push_back({children[i], node.child[i]});
+            }
+        }
+        m_nodes[wideIndex] = node;
+    }
+}
+
+const std::vector<WideBvh::Node>& WideBvh::getNodes() const{
+    return m_nodes;
+}
+
+const std::vector<WideBvh::Leaf>& WideBvh::getLeaves() const{
+    return m_leaves;
+}
+
+const std::vector<uint32_t>& WideBvh::getIndices() const{
+    return m_indices;
+}
+
+bool WideBvh::empty() const{
+    return m_nodes.empty();
+}
+
+void WideBvh::setKernel(SimdKernel kernel){
+    m_kernel = RayKernels::isSupported(kernel) ? kernel : RayKernels::getBestKernel();
+}
+
+SimdKernel WideBvh::getKernel() const{
+    return m_kernel;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "Bvh.h"
+#include "RayKernels.h"
+
+// 8-fach verzweigte BVH, aus einer binären Bvh zusammengefasst. Die Boxen der Kinder liegen pro Knoten im SoA Layout,
+// so testet RayKernels::intersectBoxes alle Kinder eines Knotens in einem Schritt
+class WideBvh
+{
+public:
+    static const uint32_t Width = RayKernels::Width;
+    static const uint32_t Invalid = 0xFFFFFFFF;
+    struct alignas(32) Node{
+        float bounds[6][Width];         // minX, minY, minZ, maxX, maxY, maxZ
+        uint32_t child[Width];          // innerer Knoten: Index in getNodes(), Blatt: Index in getLeaves(), leer: Invalid
+        uint32_t count[Width];          // Anzahl Primitive im Blatt, 0 bei inneren Knoten und leeren Einträgen
+    };
+    struct Leaf{
+        uint32_t first;                 // erster Eintrag in getIndices()
+        uint32_t count;
+    };
+
+    WideBvh();
+    void collapse(const Bvh& bvh);
+    const std::vector<Node>& getNodes() const;
+    const std::vector<Leaf>& getLeaves() const;
+    const std::vector<uint32_t>& getIndices() const;
+    bool empty() const;
+    void setKernel(SimdKernel kernel);
+    SimdKernel getKernel() const;
+
+    // Wie Bvh::traverse, aber pro Blatt: intersectLeaf(leaf, tmax) gibt true zurück, wenn es tmax verkürzt hat.
+    // Getroffene Kinder werden nach Eintrittsdistanz sortiert gestapelt, das nächste liegt oben
+    template<typename IntersectLeaf>
+    bool traverse(glm::vec3 origin, glm::vec3 direction, float tmin, float& tmax, bool anyHit, IntersectLeaf intersectLeaf) const{
+        if (m_nodes.empty()) {
+            return false;
+        }
+        struct Entry{
+            uint32_t index;             // mit LeafBit ein Blatt
+            float distance;
+        };
+        glm::vec3 inverseDirection = RayKernels::getInverseDirection(direction);
+        Entry stack[StackSize];
+        uint32_t stackSize = 0;
+        stack[stackSize++] = {0, tmin};
+        alignas(32) float distances[Width];
+        bool hit = false;
+        while (stackSize > 0) {
+            Entry entry = stack[--stackSize];
+            if (entry.distance > tmax) {
+                continue;
+            }
+            if (entry.index & LeafBit) {
+                if (intersectLeaf(entry.index & ~LeafBit, tmax)) {
+                    hit = true;
+                    if (anyHit) {
+                        return true;
+                    }
+                }
+                continue;
+            }
+            const Node& node = m_nodes[entry.index];
+            uint32_t mask = RayKernels::intersectBoxes(node.bounds, origin, inverseDirection, tmin, tmax, distances, m_kernel);
+            uint32_t first = stackSize;
+            for (uint32_t i = 0; mask != 0; i++, mask >>= 1) {
+                if ((mask & 1) == 0) {
+                    continue;
+                }
+                Entry child{node.count[i] > 0 ? node.child[i] | LeafBit : node.child[i], distances[i]};
+                uint32_t j = stackSize++;
+                while (j > first && stack[j - 1].distance < child.distance) {
+                    stack[j] = stack[j - 1];
+                    j--;
+                }
+                stack[j] = child;
+            }
+        }
+        return hit;
+    }
+private:
+    static const uint32_t LeafBit = 0x80000000;
+    // Jede Ebene legt höchstens Width - 1 Einträge mehr ab, als sie entnimmt
+    static const uint32_t StackSize = Width * Bvh::MaxDepth;
+    std::vector<Node> m_nodes;
+    std::vector<Leaf> m_leaves;
+    std::vector<uint32_t> m_indices;
+    SimdKernel m_kernel = RayKernels::getBestKernel();
+};
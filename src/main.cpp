@@ -1,5 +1,10 @@
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #include <chrono>
+#include <thread>
+#include <random>
+#include <cstring>
 #include <vulkan/vulkan.hpp>
 
 #include "GlobalDefs.h"
@@ -11,6 +16,21 @@
 #include "BottomLevelTriangleAS.h"
 #include "BottomLevelSphereAS.h"
 #include "SphereFlake.h"
+#include "RenderGraph.h"
+#include "Profiler.h"
+#include "CameraPath.h"
+#include "ShaderCompiler.h"
+#include "ShaderPermutation.h"
+#include "ShaderBindingTable.h"
+#include "MaterialClassifier.h"
+#include "BindlessDescriptors.h"
+#include "PipelineCache.h"
+#include "LightSampler.h"
+#include "LightTree.h"
+#include "CpuRayTracer.h"
+#include "ImageWriter.h"
+#include "HostAccelerationStructure.h"
+#include "JobSystem.h"
 
 struct AccelerationStructure
 {
@@ -19,27 +39,344 @@ struct AccelerationStructure
 	VkAccelerationStructureKHR  accelerationStructure;
 };
 
+// Kommandozeilen Einstellungen, im Benchmark Modus läuft alles mit festem Zeitschritt
+struct Settings
+{
+    std::string scene = "sphereflake";
+    bool benchmark = false;
+    std::string cameraPath = "";
+    std::string recordPath = "";
+    uint32_t warmupFrames = 60;
+    uint32_t measuredFrames = 600;
+    float timestep = 1.0f / 60.0f;
+    std::string report = "benchmark.json";
+    uint32_t maxRecursion = 4;
+    uint32_t lightSamples = 0;
+    bool lightTree = false;
+    uint32_t extraLights = 0;
+    bool animateLights = false;     // bewegtes Licht setzt die Akkumulation jeden Frame zurück, L schaltet um
+    bool iterativePath = false;
+    // CPU Referenz: rendert ein Bild ohne GPU zum Zeitpunkt cpuTime der Kamerafahrt
+    std::string cpuOutput = "";
+    uint32_t cpuWidth = 1000;
+    uint32_t cpuHeight = 1000;
+    uint32_t cpuThreads = 0;
+    float cpuTime = 0.0f;
+    std::string compare = "";
+    float compareTolerance = 2.0f;  // mittlere Abweichung in 8 Bit Stufen
+    bool bvhBenchmark = false;
+    uint32_t leafSize = 4;
+    bool rayBenchmark = false;
+    bool picking = false;           // rechte Maustaste fragt die Host BVH nach dem Objekt unter dem Cursor
+    bool jobBenchmark = false;
+    uint32_t flakeDepth = 4;
+    uint32_t flakeInstanceDepth = 0;    // > 0: ein Teilflake dieser Tiefe als BLAS, instanziert auf Ebene flakeDepth - flakeInstanceDepth
+    bool flakeBenchmark = false;
+    bool worldSpaceSpheres = false;     // alter Kugeltest in Weltkoordinaten statt im Objektraum
+    bool sphereBenchmark = false;
+};
+
 class VulkanRaytracer {
 public:
+    VulkanRaytracer(Settings settings) : m_settings(settings) {}
+
     void run() {
         initVulkan();
         mainLoop();
         cleanup();
     }
 
+    // Mit --threads teilen sich alle CPU Modi ein eigenes JobSystem, sonst das gemeinsame
+    JobSystem& getCpuJobs() {
+        if (m_settings.cpuThreads == 0) {
+            return JobSystem::getDefault();
+        }
+        if (!m_cpuJobs) {
+            m_cpuJobs = std::make_unique<JobSystem>(m_settings.cpuThreads);
+        }
+        return *m_cpuJobs;
+    }
+
+    // Gleiche Szene, Lichter, Kamera und Transformation wie auf der GPU, ausgewertet vom CpuRayTracer.
+    // Vergleicht das Ergebnis optional mit einem gespeicherten Referenzbild
+    void runCpu() {
+        createLights();
+        if (m_settings.animateLights) {
+            glm::mat3 lightRotation = glm::mat3(glm::rotate(glm::mat4(1.0f), (m_settings.cpuTime/5) * glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
+            glm::vec3 lightpos = lightRotation * glm::vec3(lights[0].m_pos[0], lights[0].m_pos[1], lights[0].m_pos[2]);
+            lights[0].m_pos[0] = lightpos.x; lights[0].m_pos[1] = lightpos.y; lights[0].m_pos[2] = lightpos.z;
+        }
+        loadScene(m_settings.scene);
+        if (!m_settings.cameraPath.empty()) {
+            cameraPath.load(m_settings.cameraPath);
+        }
+
+        auto start = std::chrono::high_resolution_clock::now();
+        CpuRayTracer tracer;
+        addSceneGeometry(tracer);
+        tracer.setMaterials(BottomLevelAS::getMaterials());
+        tracer.setLights(lights);
+        tracer.loadTextures(BottomLevelAS::getTexturePaths());
+        tracer.setMaxRecursion(m_settings.maxRecursion);
+        tracer.build();
+        auto built = std::chrono::high_resolution_clock::now();
+
+        glm::mat4 proj = glm::perspective(glm::radians(45.0f), m_settings.cpuWidth / (float) m_settings.cpuHeight, 0.1f, 1000.0f);
+        proj[1][1] *= -1;
+        std::vector<float> image = tracer.render(cameraPath.getView(m_settings.cpuTime), glm::inverse(proj), m_settings.cpuWidth, m_settings.cpuHeight, getCpuJobs());
+        auto rendered = std::chrono::high_resolution_clock::now();
+        std::cout << "cpu bvh " << tracer.getBvh().getNodes().size() << " nodes in " << std::chrono::duration<double, std::milli>(built - start).count() << " ms, render "
+                  << std::chrono::duration<double, std::milli>(rendered - built).count() << " ms" << std::endl;
+
+        ImageWriter::write(m_settings.cpuOutput, m_settings.cpuWidth, m_settings.cpuHeight, image);
+        if (!m_settings.compare.empty()) {
+            compareImage(image);
+        }
+        for (BottomLevelAS* blas : BLAS) {
+            delete blas;
+        }
+    }
+
+    // Baut die Host BVH für feste Modelle und SphereFlake Tiefen, jeweils die schnellste von fünf Wiederholungen
+    void runBvhBenchmark() {
+        std::vector<std::pair<std::string, std::vector<Aabb>>> cases;
+        tinyobj::material_t material{};
+        for (std::string model : {"teapot", "viking_room"}) {
+            BottomLevelTriangleAS mesh(nullptr, model);
+            mesh.uploadData("/" + model + "/" + model + ".obj", material);
+            cases.emplace_back(model, Bvh::getTriangleBounds(mesh.getVertices(), mesh.getIndices()));
+        }
+        for (int depth = 4; depth <= 6; depth++) {
+            SphereFlake sf = SphereFlake();
+            sf.generateSphereFlake(depth, 0.5f);
+            cases.emplace_back("sphereflake" + std::to_string(depth), Bvh::getSphereBounds(sf.getSpheres()));
+        }
+
+        Bvh::BuildSettings buildSettings;
+        buildSettings.maxLeafSize = m_settings.leafSize;
+        buildSettings.jobs = &getCpuJobs();
+        for (auto& [name, bounds] : cases) {
+            Bvh bvh;
+            double best = std::numeric_limits<double>::max();
+            for (int run = 0; run < 5; run++) {
+                auto start = std::chrono::high_resolution_clock::now();
+                bvh.build(bounds, buildSettings);
+                best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+            }
+            std::cout << name << ": " << bounds.size() << " primitives, " << bvh.getNodes().size() << " nodes, depth " << bvh.getDepth()
+                      << ", sah " << bvh.getSahCost(buildSettings.traversalCost) << ", build " << best << " ms" << std::endl;
+        }
+    }
+
+    // Closest Hit Anfragen auf einem Thread gegen die Szene, für jede verfügbare Kernel Variante. Kohärent sind die
+    // Primärstrahlen der Kamera, inkohärent zufällige Strahlen aus der Bounding Box der Szene
+    void runRayBenchmark() {
+        loadScene(m_settings.scene);
+        if (!m_settings.cameraPath.empty()) {
+            cameraPath.load(m_settings.cameraPath);
+        }
+        HostAccelerationStructure accelerationStructure;
+        addSceneGeometry(accelerationStructure);
+        Bvh::BuildSettings buildSettings;
+        buildSettings.maxLeafSize = RayKernels::Width;
+        buildSettings.jobs = &getCpuJobs();
+        accelerationStructure.build(buildSettings);
+
+        uint32_t width = m_settings.cpuWidth;
+        uint32_t height = m_settings.cpuHeight;
+        glm::mat4 inverseView = cameraPath.getView(m_settings.cpuTime);
+        glm::mat4 proj = glm::perspective(glm::radians(45.0f), width / (float) height, 0.1f, 1000.0f);
+        proj[1][1] *= -1;
+        glm::mat4 inverseProj = glm::inverse(proj);
+        std::vector<glm::vec3> coherentOrigins;
+        std::vector<glm::vec3> coherentDirections;
+        glm::vec3 cameraOrigin = glm::vec3(inverseView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+        for (uint32_t y = 0; y < height; y++) {
+            for (uint32_t x = 0; x < width; x++) {
+                glm::vec2 d = glm::vec2((x + 0.5f) / width, (y + 0.5f) / height) * 2.0f - 1.0f;
+                glm::vec4 target = inverseProj * glm::vec4(d.x, d.y, 1.0f, 1.0f);
+                coherentOrigins.push_back(cameraOrigin);
+                coherentDirections.push_back(glm::vec3(inverseView * glm::vec4(glm::normalize(glm::vec3(target)), 0.0f)));
+            }
+        }
+        Aabb bounds = accelerationStructure.getBounds();
+        std::mt19937 random(11);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::vector<glm::vec3> incoherentOrigins;
+        std::vector<glm::vec3> incoherentDirections;
+        for (size_t i = 0; i < coherentOrigins.size(); i++) {
+            incoherentOrigins.push_back(bounds.min + glm::vec3(unit(random), unit(random), unit(random)) * (bounds.max - bounds.min));
+            float z = 2.0f * unit(random) - 1.0f;
+            float phi = glm::radians(360.0f) * unit(random);
+            float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+            incoherentDirections.push_back(glm::vec3(r * std::cos(phi), r * std::sin(phi), z));
+        }
+
+        std::cout << m_settings.scene << ": " << accelerationStructure.getPrimitiveCount() << " primitives, " << coherentOrigins.size() << " rays per set" << std::endl;
+        for (uint32_t kernel = 0; kernel < SimdKernelCount; kernel++) {
+            if (!RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+                continue;
+            }
+            accelerationStructure.setKernel(static_cast<SimdKernel>(kernel));
+            auto measure = [&](const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, uint32_t& hits){
+                hits = 0;
+                auto start = std::chrono::high_resolution_clock::now();
+                for (size_t i = 0; i < origins.size(); i++) {
+                    HostAccelerationStructure::Hit hit;
+                    hits += accelerationStructure.intersect(origins[i], directions[i], 0.001f, 10000.0f, hit) ? 1 : 0;
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+                return origins.size() / seconds / 1e6;
+            };
+            uint32_t coherentHits, incoherentHits;
+            double coherent = measure(coherentOrigins, coherentDirections, coherentHits);
+            double incoherent = measure(incoherentOrigins, incoherentDirections, incoherentHits);
+            std::cout << RayKernels::getName(static_cast<SimdKernel>(kernel)) << ": coherent " << coherent << " Mrays/s (" << coherentHits << " hits), incoherent "
+                      << incoherent << " Mrays/s (" << incoherentHits << " hits)" << std::endl;
+        }
+        for (BottomLevelAS* blas : BLAS) {
+            delete blas;
+        }
+    }
+
+    // Flacher gegen zweistufigen SphereFlake für Tiefe 4 bis 10: Größe der Build Eingaben (Kugeln und Instanzen) und Zeit für
+    // Erzeugung und Host BVH Build. Der flache Fall wird nur bis FlatLimit gebaut, darüber nur die Größe berechnet
+    void runFlakeBenchmark() {
+        const int flatLimit = 7;
+        int instanceDepth = m_settings.flakeInstanceDepth > 0 ? static_cast<int>(m_settings.flakeInstanceDepth) : 5;
+        Bvh::BuildSettings buildSettings;
+        buildSettings.jobs = &getCpuJobs();
+        auto megabytes = [](size_t bytes){ return bytes / (1024.0 * 1024.0); };
+        auto elapsed = [](std::chrono::high_resolution_clock::time_point start){
+            return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        };
+        for (int depth = 4; depth <= 10; depth++) {
+            size_t flatCount = SphereFlake::getSphereCount(depth);
+            std::stringstream flatReport;
+            flatReport << "depth " << depth << ": flat " << flatCount << " spheres, " << megabytes(flatCount * sizeof(Sphere)) << " MB";
+            if (depth <= flatLimit) {
+                auto start = std::chrono::high_resolution_clock::now();
+                SphereFlake flat = SphereFlake();
+                flat.generateSphereFlake(depth, 0.5f);
+                double generated = elapsed(start);
+                start = std::chrono::high_resolution_clock::now();
+                Bvh bvh;
+                bvh.build(Bvh::getSphereBounds(flat.getSpheres()), buildSettings);
+                flatReport << ", generate " << generated << " ms, bvh " << elapsed(start) << " ms";
+            }
+            std::cout << flatReport.str() << std::endl;
+
+            int subDepth = std::min(instanceDepth, depth);
+            int levels = depth - subDepth;
+            auto start = std::chrono::high_resolution_clock::now();
+            SphereFlake subFlake = SphereFlake();
+            subFlake.generateSphereFlake(subDepth, 1.0f);
+            SphereFlake topFlake = SphereFlake();
+            if (levels > 0) {
+                topFlake.generateSphereFlake(levels - 1, 0.5f);
+            }
+            std::vector<glm::mat4> transforms;
+            SphereFlake::generateInstanceTransforms(levels, 0.5f, transforms);
+            double generated = elapsed(start);
+
+            // Die TLAS sieht jede Instanz als Box um die Bounding Kugel des Teilflakes
+            start = std::chrono::high_resolution_clock::now();
+            float subRadius = 0.0f;
+            for (const Sphere& sphere : subFlake.getSpheres()) {
+                subRadius = std::max(subRadius, glm::length(glm::vec3(sphere.center[0], sphere.center[1], sphere.center[2])) + sphere.radius);
+            }
+            std::vector<Aabb> instanceBounds(transforms.size());
+            for (size_t i = 0; i < transforms.size(); i++) {
+                glm::vec3 extent = glm::vec3(subRadius * glm::length(glm::vec3(transforms[i][0])));
+                instanceBounds[i].grow(glm::vec3(transforms[i][3]) - extent);
+                instanceBounds[i].grow(glm::vec3(transforms[i][3]) + extent);
+            }
+            Bvh subBvh, topBvh, instanceBvh;
+            subBvh.build(Bvh::getSphereBounds(subFlake.getSpheres()), buildSettings);
+            if (levels > 0) {
+                topBvh.build(Bvh::getSphereBounds(topFlake.getSpheres()), buildSettings);
+            }
+            instanceBvh.build(instanceBounds, buildSettings);
+            double built = elapsed(start);
+
+            size_t sphereCount = subFlake.getSpheres().size() + topFlake.getSpheres().size();
+            size_t bytes = sphereCount * sizeof(Sphere) + transforms.size() * sizeof(VkAccelerationStructureInstanceKHR);
+            std::cout << "depth " << depth << ": instanced (sub depth " << subDepth << ") " << sphereCount << " spheres, " << transforms.size() << " instances, "
+                      << megabytes(bytes) << " MB, generate " << generated << " ms, bvh " << built << " ms" << std::endl;
+        }
+    }
+
+    // Zeit der Ladephase und CPU Abfragen je Thread Anzahl, jeweils die schnellste von drei Wiederholungen
+    void runJobBenchmark() {
+        Bvh::BuildSettings buildSettings;
+        buildSettings.maxLeafSize = RayKernels::Width;
+        SphereFlake reference = SphereFlake();
+        reference.generateSphereFlake(6, 0.5f);
+        std::vector<Aabb> bounds = Bvh::getSphereBounds(reference.getSpheres());
+        HostAccelerationStructure accelerationStructure;
+        accelerationStructure.addSpheres(reference.getSpheres(), glm::mat4(1.0f));
+        accelerationStructure.build(buildSettings);
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+        std::vector<glm::vec3> origins(1 << 18);
+        std::vector<glm::vec3> directions(origins.size());
+        std::vector<float> tmax(origins.size(), 10000.0f);
+        for (size_t i = 0; i < origins.size(); i++) {
+            origins[i] = glm::vec3(unit(random), unit(random), 4.0f);
+            directions[i] = glm::normalize(glm::vec3(unit(random) * 0.2f, unit(random) * 0.2f, -1.0f));
+        }
+
+        std::cout << "sphereflake 6: " << reference.getSpheres().size() << " spheres, " << origins.size() << " rays" << std::endl;
+        double baseline[3] = {0.0, 0.0, 0.0};
+        for (uint32_t threadCount : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+            JobSystem jobs(threadCount);
+            auto measure = [](const std::function<void()>& work){
+                double best = std::numeric_limits<double>::max();
+                for (int run = 0; run < 3; run++) {
+                    auto start = std::chrono::high_resolution_clock::now();
+                    work();
+                    best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+                }
+                return best;
+            };
+            double times[3];
+            times[0] = measure([&](){
+                SphereFlake sf = SphereFlake();
+                sf.generateSphereFlake(6, 0.5f, jobs);
+            });
+            buildSettings.jobs = &jobs;
+            times[1] = measure([&](){
+                Bvh bvh;
+                bvh.build(bounds, buildSettings);
+            });
+            times[2] = measure([&](){
+                accelerationStructure.intersect(origins, directions, tmax, 0.0f, jobs);
+            });
+            if (threadCount == 1) {
+                std::copy(times, times + 3, baseline);
+            }
+            std::cout << threadCount << " threads: sphereflake " << times[0] << " ms (" << baseline[0] / times[0] << "x), bvh " << times[1] << " ms ("
+                      << baseline[1] / times[1] << "x), rays " << times[2] << " ms (" << baseline[2] / times[2] << "x)" << std::endl;
+        }
+    }
+
 private:
-    Instance* m_instance;
-    Device* m_device;
+    Instance* m_instance = nullptr;
+    Device* m_device = nullptr;
 
     PFN_vkCmdBuildAccelerationStructuresKHR vkCmdBuildAccelerationStructuresKHR;
-    PFN_vkBuildAccelerationStructuresKHR vkBuildAccelerationStructuresKHR;
     PFN_vkCreateAccelerationStructureKHR vkCreateAccelerationStructureKHR;
     PFN_vkDestroyAccelerationStructureKHR vkDestroyAccelerationStructureKHR;
     PFN_vkGetAccelerationStructureBuildSizesKHR vkGetAccelerationStructureBuildSizesKHR;
     PFN_vkGetAccelerationStructureDeviceAddressKHR vkGetAccelerationStructureDeviceAddressKHR;
     PFN_vkCmdTraceRaysKHR vkCmdTraceRaysKHR;
-    PFN_vkGetRayTracingShaderGroupHandlesKHR vkGetRayTracingShaderGroupHandlesKHR;
     PFN_vkCreateRayTracingPipelinesKHR vkCreateRayTracingPipelinesKHR;
+    PFN_vkCreateDeferredOperationKHR vkCreateDeferredOperationKHR;
+    PFN_vkDestroyDeferredOperationKHR vkDestroyDeferredOperationKHR;
+    PFN_vkGetDeferredOperationMaxConcurrencyKHR vkGetDeferredOperationMaxConcurrencyKHR;
+    PFN_vkGetDeferredOperationResultKHR vkGetDeferredOperationResultKHR;
+    PFN_vkDeferredOperationJoinKHR vkDeferredOperationJoinKHR;
 
     VkSwapchainKHR swapChain;
     std::vector<VkImage> swapChainImages;
@@ -57,19 +394,26 @@ private:
     VkDescriptorSet descriptorSet;
 
     std::vector<VkCommandBuffer> commandBuffers;
+    std::vector<RenderGraph> frameGraphs;
+    Profiler profiler;
 
     Texture* storageImage;
+    Texture* accumulationImage;
 	AccelerationStructure topLevelAccelerationStructure;
 
     Buffer* uniformBuffer;
     Buffer m_lightBuffer;
+    LightSampler lightSampler;
+    LightTree lightTree;
     
     std::vector<Light> lights;
 
     std::vector<VkRayTracingShaderGroupCreateInfoKHR> shaderGroups{};
-    Buffer* raygenShaderBindingTable;
-    Buffer* missShaderBindingTable;
-    Buffer* hitShaderBindingTable;
+    ShaderCompiler shaderCompiler;
+    PermutationCache pipelinePermutations;
+    PipelineCache pipelineCache;
+    ShaderBindingTable shaderBindingTable;
+    BindlessDescriptors bindlessDescriptors;
 
     VkSemaphore imageAvailableSemaphore;
     VkSemaphore renderFinishedSemaphore;
@@ -77,8 +421,37 @@ private:
     std::vector<BottomLevelAS*> BLAS;
 
     Camera cam;
+    HostAccelerationStructure hostScene;
+    std::vector<BottomLevelAS*> hostSceneOwners;
+    bool m_pickPressed = false;
+    bool m_lightKeyPressed = false;
+
+    Settings m_settings;
+    std::unique_ptr<JobSystem> m_cpuJobs;
+    float m_time = 0.0f;
+    uint64_t m_frameIndex = 0;
+    CameraPath cameraPath;
+    CameraPath recordedPath;
+    float m_lastRecordTime = -1.0f;
+    // Progressive Akkumulation, solange sich Kamera, Lichter und TLAS nicht ändern
+    uint32_t m_sampleIndex = 0;
+    glm::mat4 m_lastView = glm::mat4(0.0f);
+    Light m_lastLight = Light(glm::vec3(0.0f), glm::vec3(0.0f), 0.0f);
+    std::vector<std::pair<std::string, double>> startupStages;
+    std::chrono::high_resolution_clock::time_point stageStart;
+
+    void beginStartupStage() {
+        stageStart = std::chrono::high_resolution_clock::now();
+    }
+
+    void endStartupStage(std::string name) {
+        auto stageEnd = std::chrono::high_resolution_clock::now();
+        startupStages.emplace_back(name, std::chrono::duration<double, std::milli>(stageEnd - stageStart).count());
+        stageStart = stageEnd;
+    }
 
     void initVulkan() {
+        beginStartupStage();
 
         //Instanz mit den Parameter Name, Auflösung, API  Version und Validation flag
         m_instance = new Instance("Vulkan Raytracing", 1000, 1000, VK_API_VERSION_1_2, true);
@@ -102,15 +475,75 @@ private:
         m_device->pickPhysicalDevice();
         m_device->createLogicalDevice();
         m_device->createCommandPool();
+        endStartupStage("instance and device");
 
         createSwapChain();
         createImageViews();
         createRenderPass();
         createFramebuffers();
+
+        profiler.create(m_device, static_cast<uint32_t>(swapChainImages.size()), 32);
+        BottomLevelAS::setProfiler(&profiler);
         
         cam = Camera(Camera::TypeFirstPerson ,m_instance->getWindow(), swapChainExtent.width, swapChainExtent.height, glm::vec3(-7.5f, 1.f, 0.f), glm::vec3(0.0f));
 
 
+        createLights();
+        createLightBuffer();
+        getExtensionFunctionPointers();
+        createStorageImage();
+        endStartupStage("swapchain and resources");
+
+        loadScene(m_settings.scene);
+        if (m_settings.picking) {
+            hostSceneOwners = addSceneGeometry(hostScene);
+            hostScene.build();
+        }
+        endStartupStage("scene and blas");
+
+        createTopLevelAccelerationStructure();
+        endStartupStage("tlas");
+        createUniformBuffer();
+        shaderCompiler = ShaderCompiler(SHADER_PATH, std::string(SHADER_PATH) + "/cache");
+        pipelineCache = PipelineCache(m_device, std::string(SHADER_PATH) + "/cache/pipeline.bin");
+        pipelineCache.create();
+        createRayTracingPipeline();
+        createShaderBindingTables();
+        endStartupStage("pipeline and sbt");
+        createDescriptorSets();
+        createCommandBuffers();
+        createSemaphores();
+        endStartupStage("descriptors and command buffers");
+    }
+
+    // Geometrie aller BLAS mit den Transformationen der TLAS Instanzen, für CpuRayTracer und HostAccelerationStructure.
+    // Instanzen werden dabei ausgerollt. Liefert zu jeder Instanz des Ziels die BLAS
+    template<typename Target>
+    std::vector<BottomLevelAS*> addSceneGeometry(Target& target) {
+        glm::mat4 sceneTransform = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -1.55f, 0.0f));
+        std::vector<BottomLevelAS*> owners;
+        for (BottomLevelAS* blas : BLAS) {
+            BottomLevelTriangleAS* triangles = dynamic_cast<BottomLevelTriangleAS*>(blas);
+            BottomLevelSphereAS* sphereAS = dynamic_cast<BottomLevelSphereAS*>(blas);
+            if (triangles == nullptr && sphereAS == nullptr) {
+                continue;
+            }
+            // Die Kugeln einmal pro BLAS aus den GPU Strömen zusammensetzen, nicht pro Instanz
+            std::vector<Sphere> spheres = sphereAS != nullptr ? sphereAS->getSpheres() : std::vector<Sphere>();
+            for (const glm::mat4& instanceTransform : blas->getInstanceTransforms()) {
+                glm::mat4 transform = sceneTransform * instanceTransform;
+                if (triangles != nullptr) {
+                    target.addTriangles(triangles->getVertices(), triangles->getIndices(), transform);
+                } else {
+                    target.addSpheres(spheres, transform);
+                }
+                owners.push_back(blas);
+            }
+        }
+        return owners;
+    }
+
+    void createLights() {
         lights.emplace_back(glm::vec3(4.0f, 10.0f, 3.0f),    glm::vec3(1.0f, 1.0f, 1.0f),    0.1f);
         lights.emplace_back(glm::vec3(0.0f, 4.0f, 4.0f),     glm::vec3(1.0f, 0.09f, 0.032f), glm::vec3(0.6f, 0.6f, 1.0f), 0.1f);
         lights.emplace_back(glm::vec3(0.0f, 4.0f, -4.0f),    glm::vec3(1.0f, 0.09f, 0.032f), glm::vec3(1.0f, 0.6f, 0.6f), 0.1f);
@@ -118,15 +551,34 @@ private:
         lights.emplace_back(glm::vec3(4.1f, 0.55f, 1.38f),   glm::vec3(1.0f, 0.22f, 0.20f),  glm::vec3(1.0f, 0.5372f, 0.f), 0.1f);
         lights.emplace_back(glm::vec3(-4.1f, 0.55f, -1.27f), glm::vec3(1.0f, 0.22f, 0.20f),  glm::vec3(1.0f, 0.5372f, 0.f), 0.1f);
         lights.emplace_back(glm::vec3(-4.1f, 0.55f, 1.38f),  glm::vec3(1.0f, 0.22f, 0.20f),  glm::vec3(1.0f, 0.5372f, 0.f), 0.1f);
+        // Zusätzliche schwache Punktlichter mit festem Seed, um viele Lichter zu testen
+        std::mt19937 lightRandom(7);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        for (uint32_t i = 0; i < m_settings.extraLights; i++) {
+            glm::vec3 pos = glm::vec3(unit(lightRandom) * 10.0f - 5.0f, 0.2f + unit(lightRandom) * 5.0f, unit(lightRandom) * 10.0f - 5.0f);
+            glm::vec3 color = glm::vec3(unit(lightRandom), unit(lightRandom), unit(lightRandom)) * 0.3f;
+            lights.emplace_back(pos, glm::vec3(1.0f, 0.7f, 1.8f), color, 0.01f);
+        }
+    }
 
-        createLightBuffer();
-        getExtensionFunctionPointers();
-        createStorageImage();
-
-        // BottomLevelTriangleAS* sponza = new BottomLevelTriangleAS(m_device, "sponza");
-        // sponza->uploadData("/sponza/sponza.obj");
-        // sponza->create();
-        // BLAS.push_back(sponza);
+    // Szenen nach Namen, jede Szene liefert auch eine Standard Kamerafahrt für den Benchmark.
+    // Ohne Device (CPU Referenz) werden die BLAS nur geladen und nicht gebaut
+    void loadScene(std::string name) {
+        if (name == "sponza") {
+            BottomLevelTriangleAS* sponza = new BottomLevelTriangleAS(m_device, "sponza");
+            sponza->uploadData("/sponza/sponza.obj");
+            for (BottomLevelTriangleAS* part : sponza->splitByVariant()) {
+                if (m_device != nullptr)
+                    part->create();
+                BLAS.push_back(part);
+            }
+            cameraPath = CameraPath::orbit(glm::vec3(0.0f, 3.5f, 0.0f), 7.5f, -1.5f, 20.0f, 16);
+            return;
+        }
+        if (name != "sphereflake") {
+            throw std::runtime_error("unknown scene " + name + "!");
+        }
+        cameraPath = CameraPath::orbit(glm::vec3(0.0f), 3.0f, 1.0f, 10.0f, 16);
 
         // tinyobj::material_t material00{};
         // material00.ambient[0] = 1.0f;         material00.ambient[1] = 1.0f;         material00.ambient[2] = 1.0f;
@@ -226,36 +678,199 @@ private:
         material02.alpha_texname = "";
         material02.reflection_texname = "";
 
-        SphereFlake sf = SphereFlake();
-        sf.generateSphereFlake(4, 0.5);
-        singleSphere1->createSpheres(sf.getSpheres(), material02);
-        singleSphere1->create();
+        int depth = static_cast<int>(m_settings.flakeDepth);
+        int instanceDepth = static_cast<int>(m_settings.flakeInstanceDepth);
+        if (instanceDepth == 0 || instanceDepth > depth) {
+            SphereFlake sf = SphereFlake();
+            sf.generateSphereFlake(depth, 0.5);
+            singleSphere1->createSpheres(sf.takeSpheres(), material02);
+            if (m_device != nullptr)
+                singleSphere1->create();
+            BLAS.push_back(singleSphere1);
+            return;
+        }
+
+        // Zweistufig: der Teilflake mit Radius 1 wird einmal gebaut und pro Knoten der Ebene depth - instanceDepth instanziert,
+        // die Ebenen darüber liegen flach in einer zweiten BLAS
+        int levels = depth - instanceDepth;
+        SphereFlake subFlake = SphereFlake();
+        subFlake.generateSphereFlake(instanceDepth, 1.0f);
+        singleSphere1->createSpheres(subFlake.takeSpheres(), material02);
+        std::vector<glm::mat4> transforms;
+        SphereFlake::generateInstanceTransforms(levels, 0.5f, transforms);
+        std::cout << "Sphereflake Instances: " << transforms.size() << std::endl;
+        singleSphere1->setInstanceTransforms(std::move(transforms));
+        if (m_device != nullptr)
+            singleSphere1->create();
         BLAS.push_back(singleSphere1);
+        if (levels > 0) {
+            BottomLevelSphereAS* top = new BottomLevelSphereAS(m_device, "sphere1_top");
+            SphereFlake topFlake = SphereFlake();
+            topFlake.generateSphereFlake(levels - 1, 0.5f);
+            top->createSpheres(topFlake.takeSpheres(), material02);
+            if (m_device != nullptr)
+                top->create();
+            BLAS.push_back(top);
+        }
+    }
 
-        createTopLevelAccelerationStructure();
-        createUniformBuffer();
-        createRayTracingPipeline();
-        createShaderBindingTables();
-        createDescriptorSets();
-        createCommandBuffers();
-        createSemaphores();
+    // Mittlere absolute Abweichung in 8 Bit Stufen gegenüber dem Referenzbild, wirft bei Überschreitung
+    void compareImage(const std::vector<float>& image) {
+        int width, height, channels;
+        stbi_uc* golden = stbi_load(m_settings.compare.c_str(), &width, &height, &channels, STBI_rgb);
+        if (!golden) {
+            throw std::runtime_error("failed to load reference image " + m_settings.compare + "!");
+        }
+        if (static_cast<uint32_t>(width) != m_settings.cpuWidth || static_cast<uint32_t>(height) != m_settings.cpuHeight) {
+            stbi_image_free(golden);
+            throw std::runtime_error("reference image size does not match!");
+        }
+        std::vector<uint8_t> rendered = ImageWriter::toRGB8(image);
+        double difference = 0.0;
+        uint8_t maxDifference = 0;
+        for (size_t i = 0; i < rendered.size(); i++) {
+            uint8_t d = static_cast<uint8_t>(std::abs(static_cast<int>(rendered[i]) - static_cast<int>(golden[i])));
+            difference += d;
+            maxDifference = std::max(maxDifference, d);
+        }
+        stbi_image_free(golden);
+        difference /= static_cast<double>(rendered.size());
+        std::cout << "compare " << m_settings.compare << ": mean " << difference << ", max " << static_cast<int>(maxDifference) << std::endl;
+        if (difference > m_settings.compareTolerance) {
+            throw std::runtime_error("image differs from reference " + m_settings.compare + "!");
+        }
     }
 
     void mainLoop() {
+        if (m_settings.sphereBenchmark) {
+            runSphereBenchmark();
+            return;
+        }
+        if (m_settings.benchmark) {
+            runBenchmark();
+            return;
+        }
         double time;
-        std::vector<double> frameTimes(0);
+        double startTime = glfwGetTime();
         while (!glfwWindowShouldClose(m_instance->getWindow())) {
             glfwPollEvents();
             time = glfwGetTime();
+            m_time = static_cast<float>(time - startTime);
             drawFrame();
-            frameTimes.emplace_back(glfwGetTime() - time);
-        }
-        for (size_t i = std::max((int)frameTimes.size() - 101, (int)0); i < frameTimes.size(); i++)
-        {
-            std::cout<<frameTimes[i] * 1000.f<<std::endl;
+            profiler.getStats().add("cpu frame", (glfwGetTime() - time) * 1000.0);
+            m_frameIndex++;
         }
         
         vkDeviceWaitIdle(m_device->getHandle());
+        profiler.collectAll();
+
+        // GPU Zeiten pro Pass und CPU Frame Zeit als Perzentile
+        std::cout<<profiler.getStats().toCSV()<<std::endl;
+        profiler.getStats().writeCSV("profile.csv");
+        profiler.getStats().writeJSON("profile.json");
+
+        if (!m_settings.recordPath.empty() && !recordedPath.empty()) {
+            recordedPath.save(m_settings.recordPath);
+        }
+    }
+
+    // Fester Zeitschritt, Kamera aus der Kamerafahrt, Warm-up Frames fließen nicht in die Statistik ein
+    void runBenchmark() {
+        if (!m_settings.cameraPath.empty()) {
+            cameraPath.load(m_settings.cameraPath);
+        }
+        uint64_t totalFrames = static_cast<uint64_t>(m_settings.warmupFrames) + m_settings.measuredFrames;
+        profiler.setMinFrame(m_settings.warmupFrames);
+        for (m_frameIndex = 0; m_frameIndex < totalFrames && !glfwWindowShouldClose(m_instance->getWindow()); m_frameIndex++) {
+            glfwPollEvents();
+            m_time = m_frameIndex * m_settings.timestep;
+            double time = glfwGetTime();
+            drawFrame();
+            if (m_frameIndex >= m_settings.warmupFrames) {
+                profiler.getStats().add("cpu frame", (glfwGetTime() - time) * 1000.0);
+            }
+        }
+
+        vkDeviceWaitIdle(m_device->getHandle());
+        profiler.collectAll();
+
+        std::cout<<profiler.getStats().toCSV()<<std::endl;
+        writeBenchmarkReport(m_frameIndex > m_settings.warmupFrames ? m_frameIndex - m_settings.warmupFrames : 0);
+    }
+
+    // Dieselbe Kamerafahrt erst mit dem Kugeltest in Weltkoordinaten, dann im Objektraum. Zwischen den Läufen
+    // werden Pipeline Permutation, SBT und Command Buffer getauscht, verglichen wird die GPU Zeit des Trace Pass
+    void runSphereBenchmark() {
+        if (!m_settings.cameraPath.empty()) {
+            cameraPath.load(m_settings.cameraPath);
+        }
+        uint64_t totalFrames = static_cast<uint64_t>(m_settings.warmupFrames) + m_settings.measuredFrames;
+        double traceMs[2] = {0.0, 0.0};
+        m_frameIndex = 0;
+        for (uint32_t pass = 0; pass < 2; pass++) {
+            setSphereIntersection(pass == 0);
+            profiler.getStats().clear();
+            profiler.setMinFrame(m_frameIndex + m_settings.warmupFrames);
+            for (uint64_t frame = 0; frame < totalFrames && !glfwWindowShouldClose(m_instance->getWindow()); frame++, m_frameIndex++) {
+                glfwPollEvents();
+                m_time = frame * m_settings.timestep;
+                drawFrame();
+            }
+            vkDeviceWaitIdle(m_device->getHandle());
+            profiler.collectAll();
+            traceMs[pass] = profiler.getStats().getMean("trace");
+            std::cout << (pass == 0 ? "world space spheres" : "object space spheres") << std::endl << profiler.getStats().toCSV() << std::endl;
+        }
+        std::cout << m_settings.scene << " (flake depth " << m_settings.flakeDepth << ", instance depth " << m_settings.flakeInstanceDepth << "): trace world " << traceMs[0] << " ms, object " << traceMs[1] << " ms, speedup "
+                  << (traceMs[1] > 0.0 ? traceMs[0] / traceMs[1] : 0.0) << std::endl;
+    }
+
+    void setSphereIntersection(bool worldSpace) {
+        vkDeviceWaitIdle(m_device->getHandle());
+        m_settings.worldSpaceSpheres = worldSpace;
+        rayTracingPipeline = getPipelinePermutation(getHitShaderConstants());
+        shaderBindingTable.destroy();
+        createShaderBindingTables();
+        vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+        for (RenderGraph& graph : frameGraphs) {
+            graph.destroy();
+        }
+        createCommandBuffers();
+    }
+
+    void writeBenchmarkReport(uint64_t measuredFrames) {
+        TimingStats& stats = profiler.getStats();
+        // Primärstrahlen pro Sekunde aus der GPU Zeit des Trace Pass
+        double traceMs = stats.getCount("trace") > 0 ? stats.getMean("trace") : stats.getMean("cpu frame");
+        double raysPerSecond = traceMs > 0.0 ? (swapChainExtent.width * static_cast<double>(swapChainExtent.height)) / (traceMs / 1000.0) : 0.0;
+
+        std::ostringstream out;
+        out << "{\n";
+        out << "  \"scene\": \"" << m_settings.scene << "\",\n";
+        out << "  \"device\": \"" << m_device->getName() << "\",\n";
+        out << "  \"driver_version\": " << m_device->getDriverVersion() << ",\n";
+        out << "  \"resolution\": [" << swapChainExtent.width << ", " << swapChainExtent.height << "],\n";
+        out << "  \"camera_path\": \"" << (m_settings.cameraPath.empty() ? "default" : m_settings.cameraPath) << "\",\n";
+        out << "  \"timestep\": " << m_settings.timestep << ",\n";
+        out << "  \"warmup_frames\": " << m_settings.warmupFrames << ",\n";
+        out << "  \"measured_frames\": " << measuredFrames << ",\n";
+        out << "  \"sphere_intersection\": \"" << (m_settings.worldSpaceSpheres ? "world" : "object") << "\",\n";
+        out << "  \"pipeline_cache_warm\": " << (pipelineCache.isWarm() ? "true" : "false") << ",\n";
+        out << "  \"startup_ms\": {";
+        for (size_t i = 0; i < startupStages.size(); i++) {
+            out << (i > 0 ? ", " : "") << "\"" << startupStages[i].first << "\": " << startupStages[i].second;
+        }
+        out << "},\n";
+        out << "  \"frame_times\": " << stats.toJSON() << ",\n";
+        out << "  \"primary_rays_per_second\": " << raysPerSecond << ",\n";
+        out << "  \"memory\": {\"allocated_bytes\": " << m_device->getAllocatedBytes() << ", \"peak_allocated_bytes\": " << m_device->getPeakAllocatedBytes() << "}\n";
+        out << "}\n";
+
+        std::ofstream file(m_settings.report);
+        if (!file.is_open()) {
+            throw std::runtime_error("failed to write benchmark report " + m_settings.report + "!");
+        }
+        file << out.str();
     }
 
     void handleResize(){
@@ -270,6 +885,9 @@ private:
             vkDestroyFramebuffer(m_device->getHandle(), framebuffer, nullptr);
         }
         vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+        for (RenderGraph& graph : frameGraphs) {
+            graph.destroy();
+        }
         vkDestroyRenderPass(m_device->getHandle(), renderPass, nullptr);
         for (auto imageView : swapChainImageViews) {
             vkDestroyImageView(m_device->getHandle(), imageView, nullptr);
@@ -280,9 +898,12 @@ private:
         delete uniformBuffer;
 
         storageImage->destroy();
+        accumulationImage->destroy();
+        delete accumulationImage;
         vkDestroyDescriptorPool(m_device->getHandle(), descriptorPool, nullptr);
 
         createSwapChain();
+        profiler.create(m_device, static_cast<uint32_t>(swapChainImages.size()), 32);
         createImageViews();
         createRenderPass();
         createFramebuffers();
@@ -293,13 +914,20 @@ private:
     }
 
     void cleanup() {
+        // Ausstehende Uploads und BLAS Builds freigeben, solange Profiler und Command Pools noch existieren
+        m_device->retire(true);
         for (auto framebuffer : swapChainFramebuffers) {
             vkDestroyFramebuffer(m_device->getHandle(), framebuffer, nullptr);
         }
 
         vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+        for (RenderGraph& graph : frameGraphs) {
+            graph.destroy();
+        }
         
-        vkDestroyPipeline(m_device->getHandle(), rayTracingPipeline, nullptr);
+        pipelinePermutations.destroy(m_device);
+        pipelineCache.save();
+        pipelineCache.destroy();
         vkDestroyPipelineLayout(m_device->getHandle(), pipelineLayout, nullptr);
         vkDestroyRenderPass(m_device->getHandle(), renderPass, nullptr);
 
@@ -313,9 +941,13 @@ private:
         delete uniformBuffer;
 
         m_lightBuffer.destroy();
+        lightSampler.destroy();
+        lightTree.destroy();
 
 
         storageImage->destroy();
+        accumulationImage->destroy();
+        delete accumulationImage;
         
         vkDestroyDescriptorPool(m_device->getHandle(), descriptorPool, nullptr);
         vkDestroyDescriptorSetLayout(m_device->getHandle(), descriptorSetLayout, nullptr);
@@ -336,16 +968,13 @@ private:
         vkDestroyAccelerationStructureKHR(m_device->getHandle(), topLevelAccelerationStructure.accelerationStructure, nullptr);
 
 
-        raygenShaderBindingTable->destroy();
-        delete raygenShaderBindingTable;
-        missShaderBindingTable->destroy();
-        delete missShaderBindingTable;
-        hitShaderBindingTable->destroy();
-        delete hitShaderBindingTable;
+        shaderBindingTable.destroy();
 
         vkDestroySemaphore(m_device->getHandle(), renderFinishedSemaphore, nullptr);
         vkDestroySemaphore(m_device->getHandle(), imageAvailableSemaphore, nullptr);
 
+        profiler.destroy();
+
         m_device->destroy(); //destroys device and its command pool
         delete m_device;
         m_instance->destroy();
@@ -432,14 +1061,17 @@ private:
 
     void getExtensionFunctionPointers(){
         vkCmdBuildAccelerationStructuresKHR = reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCmdBuildAccelerationStructuresKHR"));
-		vkBuildAccelerationStructuresKHR = reinterpret_cast<PFN_vkBuildAccelerationStructuresKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkBuildAccelerationStructuresKHR"));
 		vkCreateAccelerationStructureKHR = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCreateAccelerationStructureKHR"));
 		vkDestroyAccelerationStructureKHR = reinterpret_cast<PFN_vkDestroyAccelerationStructureKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkDestroyAccelerationStructureKHR"));
 		vkGetAccelerationStructureBuildSizesKHR = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetAccelerationStructureBuildSizesKHR"));
 		vkGetAccelerationStructureDeviceAddressKHR = reinterpret_cast<PFN_vkGetAccelerationStructureDeviceAddressKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetAccelerationStructureDeviceAddressKHR"));
 		vkCmdTraceRaysKHR = reinterpret_cast<PFN_vkCmdTraceRaysKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCmdTraceRaysKHR"));
-		vkGetRayTracingShaderGroupHandlesKHR = reinterpret_cast<PFN_vkGetRayTracingShaderGroupHandlesKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetRayTracingShaderGroupHandlesKHR"));
 		vkCreateRayTracingPipelinesKHR = reinterpret_cast<PFN_vkCreateRayTracingPipelinesKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCreateRayTracingPipelinesKHR"));
+		vkCreateDeferredOperationKHR = reinterpret_cast<PFN_vkCreateDeferredOperationKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkCreateDeferredOperationKHR"));
+		vkDestroyDeferredOperationKHR = reinterpret_cast<PFN_vkDestroyDeferredOperationKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkDestroyDeferredOperationKHR"));
+		vkGetDeferredOperationMaxConcurrencyKHR = reinterpret_cast<PFN_vkGetDeferredOperationMaxConcurrencyKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetDeferredOperationMaxConcurrencyKHR"));
+		vkGetDeferredOperationResultKHR = reinterpret_cast<PFN_vkGetDeferredOperationResultKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkGetDeferredOperationResultKHR"));
+		vkDeferredOperationJoinKHR = reinterpret_cast<PFN_vkDeferredOperationJoinKHR>(vkGetDeviceProcAddr(m_device->getHandle(), "vkDeferredOperationJoinKHR"));
     }
 
     Buffer createScratchBuffer(VkDeviceSize size){
@@ -448,6 +1080,8 @@ private:
     }
 
     void createLightBuffer(){
+        // Richtungslichter zuerst, die Hit Shader iterieren über die Typen getrennt
+        std::stable_partition(lights.begin(), lights.end(), [](const Light& light){ return light.m_pos[3] <= 0.0001f; });
         auto lightBufferSize = lights.size() * sizeof(Light);
         const VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
         const VkMemoryPropertyFlags memoryPropertyFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
@@ -455,10 +1089,44 @@ private:
         m_lightBuffer.map(lightBufferSize, 0);
         m_lightBuffer.copyTo(lights.data(), lightBufferSize);
         m_lightBuffer.unmap();
+
+        lightSampler = LightSampler(m_device);
+        lightSampler.update(lights);
+
+        lightTree = LightTree(m_device);
+        lightTree.build(lights);
+        lightTree.upload();
     }
 
     void createStorageImage(){
         storageImage = new Texture(m_device, swapChainExtent.width, swapChainExtent.height, VK_FORMAT_B8G8R8A8_UNORM);
+        accumulationImage = new Texture(m_device, swapChainExtent.width, swapChainExtent.height, VK_FORMAT_R32G32B32A32_SFLOAT);
+        resetAccumulation();
+    }
+
+    void resetAccumulation(){
+        m_sampleIndex = 0;
+    }
+
+    // VkTransformMatrixKHR ist zeilenweise 3x4, glm spaltenweise
+    static VkTransformMatrixKHR toTransformMatrix(const glm::mat4& matrix){
+        VkTransformMatrixKHR transform;
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++) {
+                transform.matrix[row][column] = matrix[column][row];
+            }
+        }
+        return transform;
+    }
+
+    static glm::mat4 toMat4(const VkTransformMatrixKHR& transform){
+        glm::mat4 matrix(1.0f);
+        for (int row = 0; row < 3; row++) {
+            for (int column = 0; column < 4; column++) {
+                matrix[column][row] = transform.matrix[row][column];
+            }
+        }
+        return matrix;
     }
 
     void createTopLevelAccelerationStructure(){
@@ -485,13 +1153,22 @@ private:
         //     0.0f, 0.0f, 1.0f, 0.6f
         // };
 
-        VkAccelerationStructureInstanceKHR accelerationStructureInstance0{};
-        accelerationStructureInstance0.transform                              = transformMatrix0;
-        accelerationStructureInstance0.instanceCustomIndex                    = BLAS[0]->getId();
-        accelerationStructureInstance0.mask                                   = 0xFF;
-        accelerationStructureInstance0.instanceShaderBindingTableRecordOffset = 1;
-        accelerationStructureInstance0.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
-        accelerationStructureInstance0.accelerationStructureReference         = BLAS[0]->getDeviceAdress();
+        // Eine Instanz pro Eintrag in getInstanceTransforms, die Teile eines nach Materialvariante geteilten Modells teilen sich
+        // die Transformation. Instanzen derselben BLAS teilen sich auch den Custom Index und damit die Geometrie Puffer.
+        // Der SBT Offset wählt die Hit Group der Variante, Schattenstrahlen addieren SHADOW_SBT_OFFSET
+        std::vector<VkAccelerationStructureInstanceKHR> geometryInstances;
+        for (BottomLevelAS* blas : BLAS) {
+            for (const glm::mat4& instanceTransform : blas->getInstanceTransforms()) {
+                VkAccelerationStructureInstanceKHR accelerationStructureInstance{};
+                accelerationStructureInstance.transform                              = toTransformMatrix(toMat4(transformMatrix0) * instanceTransform);
+                accelerationStructureInstance.instanceCustomIndex                    = blas->getId();
+                accelerationStructureInstance.mask                                   = 0xFF;
+                accelerationStructureInstance.instanceShaderBindingTableRecordOffset = blas->getHitGroup();
+                accelerationStructureInstance.flags                                  = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+                accelerationStructureInstance.accelerationStructureReference         = blas->getDeviceAdress();
+                geometryInstances.push_back(accelerationStructureInstance);
+            }
+        }
 
         // VkAccelerationStructureInstanceKHR accelerationStructureInstance1{};
         // accelerationStructureInstance1.transform                              = transformMatrix1;
@@ -518,7 +1195,6 @@ private:
         // accelerationStructureInstance4.accelerationStructureReference         = BLAS[3]->getDeviceAdress();
 
 
-        std::vector<VkAccelerationStructureInstanceKHR> geometryInstances {accelerationStructureInstance0/*, accelerationStructureInstance1, accelerationStructureInstance3, accelerationStructureInstance4*/};
         VkDeviceSize geometryInstancesSize = geometryInstances.size() * sizeof(VkAccelerationStructureInstanceKHR);
 
         Buffer instancesBuffer = Buffer(m_device, geometryInstancesSize, VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);        
@@ -577,15 +1253,17 @@ private:
         accelerationStructureBuildRangeInfo.transformOffset                                          = 0;
         std::vector<VkAccelerationStructureBuildRangeInfoKHR *> accelerationBuildStructureRangeInfos = {&accelerationStructureBuildRangeInfo};
 
-        if (m_device->supportsAccelerationStructureHostCommands())
-		{
-			vkBuildAccelerationStructuresKHR(m_device->getHandle(), VK_NULL_HANDLE, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
-		}else{
-            VkCommandBuffer command_buffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+        uint32_t profilerSlot = profiler.getImmediateSlot();
+        VkCommandBuffer command_buffer = createCommandBuffer(VK_COMMAND_BUFFER_LEVEL_PRIMARY, true);
+        profiler.reset(command_buffer, profilerSlot, m_device->getGraphicsQueueFamily());
+        {
+            ProfilerScope scope(&profiler, command_buffer, profilerSlot, "tlas build");
             vkCmdBuildAccelerationStructuresKHR(command_buffer, 1, &accelerationBuildGeometryInfo, accelerationBuildStructureRangeInfos.data());
-            flushCommandBuffer(command_buffer, m_device->getGraphicsQueue());
-            scratchBuffer.destroy();
         }
+        flushCommandBuffer(command_buffer, m_device->getGraphicsQueue());
+        profiler.markSubmitted(profilerSlot);
+        profiler.collect(profilerSlot);
+        scratchBuffer.destroy();
 
         VkAccelerationStructureDeviceAddressInfoKHR accelerationDeviceAddressInfo{};
         accelerationDeviceAddressInfo.sType                 = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
@@ -593,12 +1271,11 @@ private:
         topLevelAccelerationStructure.device_address        = vkGetAccelerationStructureDeviceAddressKHR(m_device->getHandle(), &accelerationDeviceAddressInfo);
 
         instancesBuffer.destroy();
+        resetAccumulation();
     }
 
     void updateUniformBuffer(){
-        static auto startTime = std::chrono::high_resolution_clock::now();
-        auto currentTime = std::chrono::high_resolution_clock::now();
-        float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+        float time = m_time;
 
         UniformBufferObject ubo{};
         glm::mat3 camRotation = glm::mat3(glm::rotate(glm::mat4(1.0f), (time/5) * glm::radians(45.0f), glm::vec3(0.0f, 1.0f, 0.0f)));
@@ -611,50 +1288,100 @@ private:
         ubo.proj = glm::perspective(glm::radians(45.0f), swapChainExtent.width / (float) swapChainExtent.height, 0.1f, 1000.0f);
         ubo.proj[1][1] *= -1;
 
-        cam.update();
-        ubo.view = cam.getView();
+        if (m_settings.benchmark) {
+            ubo.view = cameraPath.getView(m_time);
+        } else {
+            cam.update();
+            ubo.view = cam.getView();
+            if (!m_settings.recordPath.empty() && m_time - m_lastRecordTime >= 0.1f) {
+                recordedPath.addKeyframe(m_time, cam.getPosition(), cam.getTarget());
+                m_lastRecordTime = m_time;
+            }
+        }
         ubo.proj = glm::inverse(ubo.proj);
+        if (m_settings.picking && !m_settings.benchmark) {
+            pickCursor(ubo.proj);
+        }
+        if (!m_settings.benchmark) {
+            toggleLightAnimation();
+        }
+
+        Light l = lights[0];
+        if (m_settings.animateLights) {
+            glm::vec3 lightpos = glm::vec3(l.m_pos[0], l.m_pos[1], l.m_pos[2]);
+            lightpos = camRotation * lightpos;
+            l.m_pos[0] = lightpos.x; l.m_pos[1] = lightpos.y; l.m_pos[2] = lightpos.z;
+        }
+
+        if (ubo.view != m_lastView || std::memcmp(&l, &m_lastLight, sizeof(Light)) != 0) {
+            resetAccumulation();
+            // Bewegtes Punktlicht: Boxen und Leistung im Baum nachziehen, die Topologie bleibt
+            if (l.m_pos[3] > 0.0001f && std::memcmp(&l, &m_lastLight, sizeof(Light)) != 0) {
+                std::vector<Light> currentLights = lights;
+                currentLights[0] = l;
+                lightTree.refit(currentLights);
+                lightTree.upload();
+            }
+            m_lastView = ubo.view;
+            m_lastLight = l;
+        }
+        ubo.frameIndex = static_cast<uint32_t>(m_frameIndex);
+        ubo.sampleIndex = m_sampleIndex++;
 
         uniformBuffer->map(sizeof(ubo), 0);
         uniformBuffer->copyTo(&ubo, sizeof(ubo));
         uniformBuffer->unmap();
 
-        Light l = lights[0];
-        glm::vec3 lightpos = glm::vec3(l.m_pos[0], l.m_pos[1], l.m_pos[2]);
-        lightpos = camRotation * lightpos;
-        l.m_pos[0] = lightpos.x; l.m_pos[1] = lightpos.y; l.m_pos[2] = lightpos.z;
-
         m_lightBuffer.map(sizeof(Light), 0);
         m_lightBuffer.copyTo(&l, sizeof(Light));
         m_lightBuffer.unmap();
     }
 
+    // Schaltet beim Drücken von L die Lichtanimation um, stehendes Licht lässt die Akkumulation konvergieren
+    void toggleLightAnimation(){
+        bool pressed = glfwGetKey(m_instance->getWindow(), GLFW_KEY_L) == GLFW_PRESS;
+        if (pressed && !m_lightKeyPressed) {
+            m_settings.animateLights = !m_settings.animateLights;
+        }
+        m_lightKeyPressed = pressed;
+    }
+
+    // Nur beim Drücken der rechten Maustaste, nicht solange sie gehalten wird
+    void pickCursor(const glm::mat4& inverseProj){
+        bool pressed = glfwGetMouseButton(m_instance->getWindow(), GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+        bool clicked = pressed && !m_pickPressed;
+        m_pickPressed = pressed;
+        if (!clicked) {
+            return;
+        }
+        glm::vec3 origin, direction;
+        cam.getCursorRay(inverseProj, origin, direction);
+        HostAccelerationStructure::Hit hit = hostScene.intersect({origin}, {direction}, {10000.0f}, 0.001f)[0];
+        if (hit.instance == HostAccelerationStructure::Miss) {
+            std::cout << "picked nothing" << std::endl;
+            return;
+        }
+        std::cout << "picked " << hostSceneOwners[hit.instance]->m_name << " primitive " << hit.primitive << " at distance " << hit.t
+                  << " (barycentrics " << hit.u << ", " << hit.v << ")" << std::endl;
+    }
+
     void createUniformBuffer(){
         uniformBuffer = new Buffer(m_device, sizeof(UniformBufferObject), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
         updateUniformBuffer();
     }
 
     void createDescriptorSets(){
-        uint32_t storageBufferCount = 2;
-        if(BottomLevelTriangleAS::getCount() > 0){
-            storageBufferCount += 2;
-        }
-        if(BottomLevelSphereAS::getCount() > 0){
-            storageBufferCount += 1;
-        }
         std::vector<VkDescriptorPoolSize> poolSizes = {
             {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1},
-            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1},
+            {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2},
             {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
-            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount}
+            {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 4}
         };
-
-        if(BottomLevelAS::getTextureCount() > 0){
-            poolSizes.push_back({VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, BottomLevelAS::getTextureCount()});
-        }
+        BindlessDescriptors::appendPoolSizes(poolSizes);
 
         VkDescriptorPoolCreateInfo descriptorPoolInfo{};
         descriptorPoolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
         descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
         descriptorPoolInfo.pPoolSizes    = poolSizes.data();
         descriptorPoolInfo.maxSets       = 1;
@@ -693,6 +1420,16 @@ private:
         resultImageWrite.pImageInfo      = &storageImageDescriptor;
         resultImageWrite.descriptorCount = 1;
 
+        VkDescriptorImageInfo accumulationImageDescriptor = accumulationImage->getDescriptorInfo();
+
+        VkWriteDescriptorSet accumulationImageWrite{};
+        accumulationImageWrite.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        accumulationImageWrite.dstSet          = descriptorSet;
+        accumulationImageWrite.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        accumulationImageWrite.dstBinding      = 11;
+        accumulationImageWrite.pImageInfo      = &accumulationImageDescriptor;
+        accumulationImageWrite.descriptorCount = 1;
+
         VkDescriptorBufferInfo uniformBufferDescriptor = uniformBuffer->getDescriptorInfo(sizeof(UniformBufferObject), 0);
 
         VkWriteDescriptorSet uniformBufferWrite{};
@@ -704,47 +1441,6 @@ private:
         uniformBufferWrite.descriptorCount = 1;
         uniformBufferWrite.pBufferInfo = &uniformBufferDescriptor;
 
-        VkWriteDescriptorSet vertexBufferWrite{};
-        VkWriteDescriptorSet indexBufferWrite{};
-        if(BottomLevelTriangleAS::getCount() > 0){
-            vertexBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            vertexBufferWrite.dstSet = descriptorSet;
-            vertexBufferWrite.dstBinding = 3;
-            vertexBufferWrite.dstArrayElement = 0;
-            vertexBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            vertexBufferWrite.descriptorCount = BottomLevelTriangleAS::getCount();
-            vertexBufferWrite.pBufferInfo = BottomLevelTriangleAS::getVertexBufferDescriptors();
-            indexBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            indexBufferWrite.dstSet = descriptorSet;
-            indexBufferWrite.dstBinding = 4;
-            indexBufferWrite.dstArrayElement = 0;
-            indexBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            indexBufferWrite.descriptorCount = BottomLevelTriangleAS::getCount();
-            indexBufferWrite.pBufferInfo = BottomLevelTriangleAS::getIndexBufferDescriptors();
-        }
-        
-        VkWriteDescriptorSet textureImageWrite{};
-        if(BottomLevelAS::getTextureCount() > 0){
-            textureImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            textureImageWrite.dstSet = descriptorSet;
-            textureImageWrite.dstBinding = 5;
-            textureImageWrite.dstArrayElement = 0;
-            textureImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            textureImageWrite.descriptorCount = BottomLevelAS::getTextureCount();
-            textureImageWrite.pImageInfo = BottomLevelAS::getTextureDescriptors();
-        }
-
-        VkWriteDescriptorSet sphereBufferWrite{};
-        if(BottomLevelSphereAS::getCount() > 0){
-            sphereBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            sphereBufferWrite.dstSet = descriptorSet;
-            sphereBufferWrite.dstBinding = 6;
-            sphereBufferWrite.dstArrayElement = 0;
-            sphereBufferWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-            sphereBufferWrite.descriptorCount = BottomLevelSphereAS::getCount();
-            sphereBufferWrite.pBufferInfo = BottomLevelSphereAS::getSphereBufferDescriptors();
-        }
-
         VkWriteDescriptorSet materialBufferWrite{};
         materialBufferWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
         materialBufferWrite.dstSet = descriptorSet;
@@ -764,25 +1460,45 @@ private:
         lightBufferWrite.descriptorCount = 1;
         lightBufferWrite.pBufferInfo = &lightBufferDescriptor;
 
+        VkDescriptorBufferInfo lightAliasDescriptor = lightSampler.getDescriptorInfo();
+        VkWriteDescriptorSet lightAliasWrite{};
+        lightAliasWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        lightAliasWrite.dstSet = descriptorSet;
+        lightAliasWrite.dstBinding = 9;
+        lightAliasWrite.dstArrayElement = 0;
+        lightAliasWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        lightAliasWrite.descriptorCount = 1;
+        lightAliasWrite.pBufferInfo = &lightAliasDescriptor;
+
+        VkDescriptorBufferInfo lightTreeDescriptor = lightTree.getDescriptorInfo();
+        VkWriteDescriptorSet lightTreeWrite{};
+        lightTreeWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        lightTreeWrite.dstSet = descriptorSet;
+        lightTreeWrite.dstBinding = 10;
+        lightTreeWrite.dstArrayElement = 0;
+        lightTreeWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        lightTreeWrite.descriptorCount = 1;
+        lightTreeWrite.pBufferInfo = &lightTreeDescriptor;
+
         std::vector<VkWriteDescriptorSet> writeDescriptorSets = {
             accelerationStructureWrite,
 	        resultImageWrite,
+            accumulationImageWrite,
             uniformBufferWrite,
             materialBufferWrite,
-            lightBufferWrite
+            lightBufferWrite,
+            lightAliasWrite,
+            lightTreeWrite
         };
-        if(BottomLevelTriangleAS::getCount() > 0){
-            writeDescriptorSets.push_back(vertexBufferWrite);
-            writeDescriptorSets.push_back(indexBufferWrite);
-        }
-        if(BottomLevelSphereAS::getCount() > 0){
-            writeDescriptorSets.push_back(sphereBufferWrite);
-        }
-        if(BottomLevelAS::getTextureCount() > 0){
-            writeDescriptorSets.push_back(textureImageWrite);
-        }
 
         vkUpdateDescriptorSets(m_device->getHandle(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, VK_NULL_HANDLE);
+
+        // Geometrie und Texturen schreiben nur ihre eigenen Slots, später geladene BLAS machen dasselbe
+        bindlessDescriptors.setDescriptorSet(m_device, descriptorSet);
+        for(BottomLevelAS* blas : BLAS){
+            blas->writeDescriptors(bindlessDescriptors);
+        }
+        BottomLevelAS::writeTextureDescriptors(bindlessDescriptors);
     }
 
     void createRenderPass() {
@@ -839,36 +1555,17 @@ private:
         result_image_layout_binding.descriptorCount = 1;
         result_image_layout_binding.stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
 
+        VkDescriptorSetLayoutBinding accumulation_image_layout_binding{};
+        accumulation_image_layout_binding.binding         = 11;
+        accumulation_image_layout_binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+        accumulation_image_layout_binding.descriptorCount = 1;
+        accumulation_image_layout_binding.stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
+
         VkDescriptorSetLayoutBinding uniform_buffer_binding{};
         uniform_buffer_binding.binding         = 2;
         uniform_buffer_binding.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         uniform_buffer_binding.descriptorCount = 1;
-        uniform_buffer_binding.stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
-
-        VkDescriptorSetLayoutBinding vertex_buffer_binding{};
-        vertex_buffer_binding.binding         = 3;
-        vertex_buffer_binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        vertex_buffer_binding.descriptorCount = BottomLevelTriangleAS::getCount();
-        vertex_buffer_binding.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
-
-        VkDescriptorSetLayoutBinding index_buffer_binding{};
-        index_buffer_binding.binding         = 4;
-        index_buffer_binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        index_buffer_binding.descriptorCount = BottomLevelTriangleAS::getCount();
-        index_buffer_binding.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
-
-        VkDescriptorSetLayoutBinding samplerLayoutBinding{};
-        samplerLayoutBinding.binding = 5;
-        samplerLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        samplerLayoutBinding.descriptorCount = BottomLevelAS::getTextureCount();
-        samplerLayoutBinding.pImmutableSamplers = nullptr;
-        samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
-
-        VkDescriptorSetLayoutBinding sphere_buffer_binding{};
-        sphere_buffer_binding.binding         = 6;
-        sphere_buffer_binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-        sphere_buffer_binding.descriptorCount = BottomLevelSphereAS::getCount();
-        sphere_buffer_binding.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR | VK_SHADER_STAGE_INTERSECTION_BIT_KHR | VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
+        uniform_buffer_binding.stageFlags      = VK_SHADER_STAGE_RAYGEN_BIT_KHR | VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
 
         VkDescriptorSetLayoutBinding material_buffer_binding{};
         material_buffer_binding.binding         = 7;
@@ -882,20 +1579,43 @@ private:
         light_buffer_binding.descriptorCount = 1;
         light_buffer_binding.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
 
+        VkDescriptorSetLayoutBinding light_alias_binding{};
+        light_alias_binding.binding         = 9;
+        light_alias_binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        light_alias_binding.descriptorCount = 1;
+        light_alias_binding.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
+        VkDescriptorSetLayoutBinding light_tree_binding{};
+        light_tree_binding.binding         = 10;
+        light_tree_binding.descriptorType  = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        light_tree_binding.descriptorCount = 1;
+        light_tree_binding.stageFlags      = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+
         std::vector<VkDescriptorSetLayoutBinding> bindings = {
             acceleration_structure_layout_binding,
             result_image_layout_binding,
             uniform_buffer_binding,
-            vertex_buffer_binding,
-            index_buffer_binding,
-            samplerLayoutBinding,
-            sphere_buffer_binding,
             material_buffer_binding,
-            light_buffer_binding
+            light_buffer_binding,
+            light_alias_binding,
+            light_tree_binding,
+            accumulation_image_layout_binding
         };
 
+        // Vertices, Indices, Texturen und Kugeln als Bindless Arrays, die Größe hängt nicht von der Szene ab
+        std::vector<VkDescriptorBindingFlags> bindingFlags(bindings.size(), 0);
+        BindlessDescriptors::checkSupport(m_device, 4);
+        BindlessDescriptors::appendLayoutBindings(bindings, bindingFlags);
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount  = static_cast<uint32_t>(bindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
         VkDescriptorSetLayoutCreateInfo layoutInfo{};
         layoutInfo.sType        = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext        = &bindingFlagsInfo;
+        layoutInfo.flags        = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
         layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
         layoutInfo.pBindings    = bindings.data();
         if(vkCreateDescriptorSetLayout(m_device->getHandle(), &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
@@ -909,15 +1629,48 @@ private:
         if(vkCreatePipelineLayout(m_device->getHandle(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
             throw std::runtime_error("failed to create pipeline layout!");
 
-        std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+        rayTracingPipeline = getPipelinePermutation(getHitShaderConstants());
+    }
+
+    HitShaderConstants getHitShaderConstants(){
+        // Der tiefste Closest Hit schießt noch einen Schattenstrahl, im iterativen Modus begrenzt nur raygen
+        uint32_t maxRecursion = m_settings.iterativePath ? m_settings.maxRecursion : std::min(m_settings.maxRecursion, m_device->getMaxRayRecursionDepth() - 1);
+        HitShaderConstants constants = HitShaderConstants::fromScene(lights, BottomLevelAS::getMaterials(), maxRecursion);
+        constants.lightSamples = m_settings.lightSamples;
+        constants.useLightTree = m_settings.lightTree ? VK_TRUE : VK_FALSE;
+        constants.iterativePath = m_settings.iterativePath ? VK_TRUE : VK_FALSE;
+        constants.objectSpaceSpheres = m_settings.worldSpaceSpheres ? VK_FALSE : VK_TRUE;
+        return constants;
+    }
+
+    VkPipeline getPipelinePermutation(const HitShaderConstants& constants){
+        VkPipeline pipeline = pipelinePermutations.get(constants.getKey());
+        if (pipeline != VK_NULL_HANDLE) {
+            return pipeline;
+        }
+        pipeline = createPipelinePermutation(constants);
+        pipelinePermutations.add(constants.getKey(), pipeline);
+        return pipeline;
+    }
 
-        auto raygenShaderCode = readFile("/raygen.spv");
-        auto missShaderCode = readFile("/miss.spv");
-        auto missShadowShaderCode = readFile("/shadow.spv");
-        auto rchitShaderCode = readFile("/closesthit.spv");
-        auto rchitSphereShaderCode = readFile("/closesthitsphere.spv");
-        auto rintShaderCode = readFile("/intersection.spv");
-        auto rahitShaderCode = readFile("/anyhit.spv");
+    VkPipeline createPipelinePermutation(const HitShaderConstants& constants){
+        std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
+        shaderGroups.clear();
+
+        std::vector<VkSpecializationMapEntry> specializationMapEntries = HitShaderConstants::getMapEntries();
+        VkSpecializationInfo specializationInfo{};
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationMapEntries.size());
+        specializationInfo.pMapEntries   = specializationMapEntries.data();
+        specializationInfo.dataSize      = sizeof(HitShaderConstants);
+        specializationInfo.pData         = &constants;
+
+        auto raygenShaderCode = shaderCompiler.compile("/raygen.rgen");
+        auto missShaderCode = shaderCompiler.compile("/miss.rmiss");
+        auto missShadowShaderCode = shaderCompiler.compile("/shadow.rmiss");
+        auto rchitShaderCode = shaderCompiler.compile("/closesthit.rchit");
+        auto rchitSphereShaderCode = shaderCompiler.compile("/closesthitsphere.rchit");
+        auto rintShaderCode = shaderCompiler.compile("/intersection.rint");
+        auto rahitShaderCode = shaderCompiler.compile("/anyhit.rahit");
         VkShaderModule raygenShaderModule = createShaderModule(raygenShaderCode);
         VkShaderModule missShaderModule = createShaderModule(missShaderCode);
         VkShaderModule missShadowShaderModule = createShaderModule(missShadowShaderCode);
@@ -931,6 +1684,7 @@ private:
         raygenShaderStageInfo.stage = VK_SHADER_STAGE_RAYGEN_BIT_KHR;
         raygenShaderStageInfo.module = raygenShaderModule;
         raygenShaderStageInfo.pName = "main";
+        raygenShaderStageInfo.pSpecializationInfo = &specializationInfo;
         shaderStages.push_back(raygenShaderStageInfo);
 
         VkRayTracingShaderGroupCreateInfoKHR raygenGroupCreateInfo{};
@@ -968,34 +1722,47 @@ private:
         missGroupCreateInfo.generalShader = static_cast<uint32_t>(shaderStages.size()) - 1;
         shaderGroups.push_back(missGroupCreateInfo);
 
-        VkPipelineShaderStageCreateInfo rchitShaderStageInfo{};
-        rchitShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        rchitShaderStageInfo.stage = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
-        rchitShaderStageInfo.module = rchitShaderModule;
-        rchitShaderStageInfo.pName = "main";
-        shaderStages.push_back(rchitShaderStageInfo);
-
-        VkRayTracingShaderGroupCreateInfoKHR closesHitGroupCreateInfo{};
-		closesHitGroupCreateInfo.sType              = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
-		closesHitGroupCreateInfo.type               = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR;
-		closesHitGroupCreateInfo.generalShader      = VK_SHADER_UNUSED_KHR;
-		closesHitGroupCreateInfo.closestHitShader   = static_cast<uint32_t>(shaderStages.size()) - 1;
-		closesHitGroupCreateInfo.anyHitShader       = static_cast<uint32_t>(shaderStages.size());
-		closesHitGroupCreateInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
-		shaderGroups.push_back(closesHitGroupCreateInfo);
-
         VkPipelineShaderStageCreateInfo rahitShaderStageInfo{};
         rahitShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         rahitShaderStageInfo.stage = VK_SHADER_STAGE_ANY_HIT_BIT_KHR;
         rahitShaderStageInfo.module = rahitShaderModule;
         rahitShaderStageInfo.pName = "main";
         shaderStages.push_back(rahitShaderStageInfo);
+        const uint32_t rahitStage = static_cast<uint32_t>(shaderStages.size()) - 1;
+
+        // Eine Closest Hit Stage pro Materialvariante, MATERIAL_VARIANT entfernt die Zweige der anderen Materialien.
+        // Nur die Alpha Variante bekommt den Any Hit Shader
+        std::vector<HitShaderConstants> variantConstants(MaterialVariantCount, constants);
+        std::vector<VkSpecializationInfo> variantSpecializationInfos(MaterialVariantCount, specializationInfo);
+        const uint32_t firstHitGroup = static_cast<uint32_t>(shaderGroups.size());
+        for(uint32_t variant = 0; variant < MaterialVariantCount; variant++){
+            variantConstants[variant].materialVariant = variant;
+            variantSpecializationInfos[variant].pData = &variantConstants[variant];
+
+            VkPipelineShaderStageCreateInfo rchitShaderStageInfo{};
+            rchitShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+            rchitShaderStageInfo.stage = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
+            rchitShaderStageInfo.module = rchitShaderModule;
+            rchitShaderStageInfo.pName = "main";
+            rchitShaderStageInfo.pSpecializationInfo = &variantSpecializationInfos[variant];
+            shaderStages.push_back(rchitShaderStageInfo);
+
+            VkRayTracingShaderGroupCreateInfoKHR closesHitGroupCreateInfo{};
+            closesHitGroupCreateInfo.sType              = VK_STRUCTURE_TYPE_RAY_TRACING_SHADER_GROUP_CREATE_INFO_KHR;
+            closesHitGroupCreateInfo.type               = VK_RAY_TRACING_SHADER_GROUP_TYPE_TRIANGLES_HIT_GROUP_KHR;
+            closesHitGroupCreateInfo.generalShader      = VK_SHADER_UNUSED_KHR;
+            closesHitGroupCreateInfo.closestHitShader   = static_cast<uint32_t>(shaderStages.size()) - 1;
+            closesHitGroupCreateInfo.anyHitShader       = variant == MaterialVariantAlpha ? rahitStage : VK_SHADER_UNUSED_KHR;
+            closesHitGroupCreateInfo.intersectionShader = VK_SHADER_UNUSED_KHR;
+            shaderGroups.push_back(closesHitGroupCreateInfo);
+        }
 
         VkPipelineShaderStageCreateInfo rchitSphereShaderStageInfo{};
         rchitSphereShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
         rchitSphereShaderStageInfo.stage = VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR;
         rchitSphereShaderStageInfo.module = rchitSphereShaderModule;
         rchitSphereShaderStageInfo.pName = "main";
+        rchitSphereShaderStageInfo.pSpecializationInfo = &specializationInfo;
         shaderStages.push_back(rchitSphereShaderStageInfo);
 
         VkRayTracingShaderGroupCreateInfoKHR rchitSphereGroupCreateInfo{};
@@ -1012,19 +1779,35 @@ private:
         rintShaderStageInfo.stage = VK_SHADER_STAGE_INTERSECTION_BIT_KHR;
         rintShaderStageInfo.module = rintShaderModule;
         rintShaderStageInfo.pName = "main";
+        rintShaderStageInfo.pSpecializationInfo = &specializationInfo;
         shaderStages.push_back(rintShaderStageInfo);
 
+        // Schatten Hit Groups ohne Closest Hit in derselben Reihenfolge: Dreiecke nur mit Alpha Test, Kugeln nur mit Intersection.
+        // SHADOW_SBT_OFFSET in den Hit Shadern zeigt auf die erste davon
+        if (static_cast<uint32_t>(shaderGroups.size()) - firstHitGroup != constants.shadowSbtOffset) {
+            throw std::runtime_error("shadow hit groups do not match SHADOW_SBT_OFFSET!");
+        }
+        for(uint32_t variant = 0; variant < MaterialVariantCount; variant++){
+            VkRayTracingShaderGroupCreateInfoKHR shadowHitGroupCreateInfo = shaderGroups[firstHitGroup + variant];
+            shadowHitGroupCreateInfo.closestHitShader = VK_SHADER_UNUSED_KHR;
+            shaderGroups.push_back(shadowHitGroupCreateInfo);
+        }
+
+        VkRayTracingShaderGroupCreateInfoKHR shadowSphereGroupCreateInfo = rchitSphereGroupCreateInfo;
+        shadowSphereGroupCreateInfo.closestHitShader = VK_SHADER_UNUSED_KHR;
+        shaderGroups.push_back(shadowSphereGroupCreateInfo);
+
         VkRayTracingPipelineCreateInfoKHR raytracingPipelineCreateInfo{};
         raytracingPipelineCreateInfo.sType                        = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
         raytracingPipelineCreateInfo.stageCount                   = static_cast<uint32_t>(shaderStages.size());
         raytracingPipelineCreateInfo.pStages                      = shaderStages.data();
         raytracingPipelineCreateInfo.groupCount                   = static_cast<uint32_t>(shaderGroups.size());
         raytracingPipelineCreateInfo.pGroups                      = shaderGroups.data();
-        raytracingPipelineCreateInfo.maxPipelineRayRecursionDepth = 31;
+        // Iterativ: raygen -> Closest Hit -> Schattenstrahl, unabhängig von der Anzahl der Abpraller
+        raytracingPipelineCreateInfo.maxPipelineRayRecursionDepth = constants.iterativePath ? std::min(2u, m_device->getMaxRayRecursionDepth()) : constants.maxRecursion + 1;
         raytracingPipelineCreateInfo.layout                       = pipelineLayout;
 
-        if(vkCreateRayTracingPipelinesKHR(m_device->getHandle(), VK_NULL_HANDLE, VK_NULL_HANDLE, 1, &raytracingPipelineCreateInfo, nullptr, &rayTracingPipeline) != VK_SUCCESS)
-            throw std::runtime_error("failed to create ray tracing pipeline!");
+        VkPipeline pipeline = createPipelineDeferred(raytracingPipelineCreateInfo);
         vkDestroyShaderModule(m_device->getHandle(), raygenShaderModule, nullptr);
         vkDestroyShaderModule(m_device->getHandle(), missShaderModule, nullptr);
         vkDestroyShaderModule(m_device->getHandle(), missShadowShaderModule, nullptr);
@@ -1032,35 +1815,54 @@ private:
         vkDestroyShaderModule(m_device->getHandle(), rchitSphereShaderModule, nullptr);
         vkDestroyShaderModule(m_device->getHandle(), rintShaderModule, nullptr);
         vkDestroyShaderModule(m_device->getHandle(), rahitShaderModule, nullptr);
+        return pipeline;
+    }
+
+    // Der Treiber übersetzt die Pipeline als Deferred Host Operation, an der Jobs des JobSystems mitarbeiten
+    VkPipeline createPipelineDeferred(const VkRayTracingPipelineCreateInfoKHR& createInfo){
+        VkDeferredOperationKHR deferredOperation;
+        if(vkCreateDeferredOperationKHR(m_device->getHandle(), nullptr, &deferredOperation) != VK_SUCCESS)
+            throw std::runtime_error("failed to create deferred operation!");
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult result = vkCreateRayTracingPipelinesKHR(m_device->getHandle(), deferredOperation, pipelineCache.getHandle(), 1, &createInfo, nullptr, &pipeline);
+        if(result == VK_OPERATION_DEFERRED_KHR){
+            uint32_t maxConcurrency = vkGetDeferredOperationMaxConcurrencyKHR(m_device->getHandle(), deferredOperation);
+            JobSystem& jobs = JobSystem::getDefault();
+            uint32_t threadCount = std::max(1u, std::min(maxConcurrency, jobs.getThreadCount()));
+            jobs.parallelFor(0, threadCount, 1, [this, deferredOperation](uint32_t, uint32_t){
+                // VK_THREAD_IDLE_KHR heißt, dass gerade keine Arbeit frei ist, aber noch nicht alles fertig ist
+                VkResult joinResult = vkDeferredOperationJoinKHR(m_device->getHandle(), deferredOperation);
+                while(joinResult == VK_THREAD_IDLE_KHR){
+                    std::this_thread::yield();
+                    joinResult = vkDeferredOperationJoinKHR(m_device->getHandle(), deferredOperation);
+                }
+            });
+            result = vkGetDeferredOperationResultKHR(m_device->getHandle(), deferredOperation);
+        }else if(result == VK_OPERATION_NOT_DEFERRED_KHR){
+            result = VK_SUCCESS;
+        }
+        vkDestroyDeferredOperationKHR(m_device->getHandle(), deferredOperation, nullptr);
+
+        if(result != VK_SUCCESS)
+            throw std::runtime_error("failed to create ray tracing pipeline!");
+        return pipeline;
     }
 
+    // Gruppen liegen wie in createPipelinePermutation: raygen, Miss Shader, dann die Hit Groups
+    // (Dreieck pro Materialvariante, Kugel, dasselbe noch einmal für Schatten), der Index in der Hit Region ist der SBT Offset
     void createShaderBindingTables(){
-        const uint32_t handleSize = m_device->getShaderGroupHandleSize();
-		const uint32_t handleSizeAligned = alignedSize(handleSize, m_device->getShaderGroupHandleAlignment());
-		const uint32_t groupCount = static_cast<uint32_t>(shaderGroups.size());
-		const uint32_t sbtSize = groupCount * handleSizeAligned;
-
-		std::vector<uint8_t> shaderHandleStorage(sbtSize);
-		if(vkGetRayTracingShaderGroupHandlesKHR(m_device->getHandle(), rayTracingPipeline, 0, groupCount, sbtSize, shaderHandleStorage.data()) != VK_SUCCESS)
-            throw std::runtime_error("failed to get ray tracing shader group handles!");
-
-		const VkBufferUsageFlags bufferUsageFlags = VK_BUFFER_USAGE_SHADER_BINDING_TABLE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
-		const VkMemoryPropertyFlags memoryUsageFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-
-        raygenShaderBindingTable = new Buffer(m_device, handleSize, bufferUsageFlags, memoryUsageFlags);
-        raygenShaderBindingTable->map(handleSize, 0);
-        raygenShaderBindingTable->copyTo(shaderHandleStorage.data(), handleSize);
-        raygenShaderBindingTable->unmap();
-
-        missShaderBindingTable = new Buffer(m_device, handleSize * 2, bufferUsageFlags, memoryUsageFlags);
-        missShaderBindingTable->map(handleSize * 2, 0);
-        missShaderBindingTable->copyTo(shaderHandleStorage.data() + handleSizeAligned, handleSize * 2);
-        missShaderBindingTable->unmap();
-
-        hitShaderBindingTable = new Buffer(m_device, handleSize * 2, bufferUsageFlags, memoryUsageFlags);
-        hitShaderBindingTable->map(handleSize * 2, 0);
-        hitShaderBindingTable->copyTo(shaderHandleStorage.data() + handleSizeAligned * 3, handleSize * 2);
-        hitShaderBindingTable->unmap();
+        shaderBindingTable = ShaderBindingTable(m_device->getShaderGroupHandleSize(), m_device->getShaderGroupHandleAlignment(), m_device->getShaderGroupBaseAlignment());
+        for(uint32_t group = 0; group < shaderGroups.size(); group++){
+            if(group == 0){
+                shaderBindingTable.add(ShaderBindingTable::RegionRayGen, group);
+            }else if(shaderGroups[group].type == VK_RAY_TRACING_SHADER_GROUP_TYPE_GENERAL_KHR){
+                shaderBindingTable.add(ShaderBindingTable::RegionMiss, group);
+            }else{
+                shaderBindingTable.add(ShaderBindingTable::RegionHit, group);
+            }
+        }
+        shaderBindingTable.create(m_device, rayTracingPipeline, static_cast<uint32_t>(shaderGroups.size()));
     }
 
     void createFramebuffers() {
@@ -1088,6 +1890,7 @@ private:
 
     void createCommandBuffers() {
         commandBuffers.resize(swapChainFramebuffers.size());
+        frameGraphs = std::vector<RenderGraph>(commandBuffers.size());
 
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -1109,61 +1912,52 @@ private:
             if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS) {
                 throw std::runtime_error("failed to begin recording command buffer!");
             }
+            const uint32_t profilerSlot = static_cast<uint32_t>(i);
+            profiler.reset(commandBuffers[i], profilerSlot, m_device->getGraphicsQueueFamily());
 
-            /*
-                Setup the strided device address regions pointing at the shader identifiers in the shader binding table
-            */
-
-            const uint32_t handle_size_aligned = alignedSize(m_device->getShaderGroupHandleSize(), m_device-> getShaderGroupHandleAlignment());
-
-            VkStridedDeviceAddressRegionKHR raygen_shader_sbt_entry{};
-            raygen_shader_sbt_entry.deviceAddress = raygenShaderBindingTable->getDeviceAddress();
-            raygen_shader_sbt_entry.stride        = handle_size_aligned;
-            raygen_shader_sbt_entry.size          = handle_size_aligned;
-
-            VkStridedDeviceAddressRegionKHR miss_shader_sbt_entry{};
-            miss_shader_sbt_entry.deviceAddress = missShaderBindingTable->getDeviceAddress();
-            miss_shader_sbt_entry.stride        = handle_size_aligned;
-            miss_shader_sbt_entry.size          = handle_size_aligned * 2;
-
-            VkStridedDeviceAddressRegionKHR hit_shader_sbt_entry{};
-            hit_shader_sbt_entry.deviceAddress = hitShaderBindingTable->getDeviceAddress();
-            hit_shader_sbt_entry.stride        = handle_size_aligned;
-            hit_shader_sbt_entry.size          = handle_size_aligned * 2;
-
-            VkStridedDeviceAddressRegionKHR callable_shader_sbt_entry{};
+            VkStridedDeviceAddressRegionKHR raygen_shader_sbt_entry = shaderBindingTable.getRegion(ShaderBindingTable::RegionRayGen);
+            VkStridedDeviceAddressRegionKHR miss_shader_sbt_entry = shaderBindingTable.getRegion(ShaderBindingTable::RegionMiss);
+            VkStridedDeviceAddressRegionKHR hit_shader_sbt_entry = shaderBindingTable.getRegion(ShaderBindingTable::RegionHit);
+            VkStridedDeviceAddressRegionKHR callable_shader_sbt_entry = shaderBindingTable.getRegion(ShaderBindingTable::RegionCallable);
 
             /*
-                Dispatch the ray tracing commands
+                Trace -> Copy -> Present als Render Graph, Barrieren werden aus den Zugriffen abgeleitet
             */
-            vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline);
-            vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, pipelineLayout, 0, 1, &descriptorSet, 0, 0);
-
-            vkCmdTraceRaysKHR(commandBuffers[i], &raygen_shader_sbt_entry, &miss_shader_sbt_entry, &hit_shader_sbt_entry, &callable_shader_sbt_entry, swapChainExtent.width, swapChainExtent.height, 1);
-
-            /*
-                Copy ray tracing output to swap chain image
-            */
-
-            // Prepare current swap chain image as transfer destination
-            setImageLayout(commandBuffers[i], swapChainImages[i], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, subresource_range);
-
-            // Prepare ray tracing output image as transfer source
-            setImageLayout( commandBuffers[i], storageImage->getImage(), VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, subresource_range);
-
-            VkImageCopy copy_region{};
-            copy_region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
-            copy_region.srcOffset      = {0, 0, 0};
-            copy_region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
-            copy_region.dstOffset      = {0, 0, 0};
-            copy_region.extent         = {swapChainExtent.width, swapChainExtent.height, 1};
-            vkCmdCopyImage(commandBuffers[i], storageImage->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapChainImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
-
-            // Transition swap chain image back for presentation
-            setImageLayout(commandBuffers[i], swapChainImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, subresource_range);
-
-            // Transition ray tracing output image back to general layout
-            setImageLayout(commandBuffers[i], storageImage->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL, subresource_range);
+            RenderGraph& graph = frameGraphs[i];
+            uint32_t storage = graph.importImage("storageImage", storageImage->getImage(), subresource_range, RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite), RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite));
+            // Bleibt über Frames bestehen, die Barriere vor dem Trace ordnet es nach dem vorherigen Frame ein
+            uint32_t accumulation = graph.importImage("accumulationImage", accumulationImage->getImage(), subresource_range, RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite), RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite));
+            // Der imageAvailableSemaphore wartet in der Transfer Stage
+            uint32_t swapChainImage = graph.importImage("swapChainImage", swapChainImages[i], subresource_range, {VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED}, RenderGraph::getState(RenderGraph::UsagePresent));
+
+            uint32_t tracePass = graph.addPass("trace", [=](VkCommandBuffer command_buffer){
+                ProfilerScope scope(&profiler, command_buffer, profilerSlot, "trace");
+                vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, rayTracingPipeline);
+                vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR, pipelineLayout, 0, 1, &descriptorSet, 0, 0);
+                vkCmdTraceRaysKHR(command_buffer, &raygen_shader_sbt_entry, &miss_shader_sbt_entry, &hit_shader_sbt_entry, &callable_shader_sbt_entry, swapChainExtent.width, swapChainExtent.height, 1);
+            });
+            graph.write(tracePass, storage, RenderGraph::UsageRayTracingStorageWrite);
+            graph.read(tracePass, accumulation, RenderGraph::UsageRayTracingStorageRead);
+            graph.write(tracePass, accumulation, RenderGraph::UsageRayTracingStorageWrite);
+
+            uint32_t copyPass = graph.addPass("copy", [=](VkCommandBuffer command_buffer){
+                ProfilerScope scope(&profiler, command_buffer, profilerSlot, "copy");
+                VkImageCopy copy_region{};
+                copy_region.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                copy_region.srcOffset      = {0, 0, 0};
+                copy_region.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+                copy_region.dstOffset      = {0, 0, 0};
+                copy_region.extent         = {swapChainExtent.width, swapChainExtent.height, 1};
+                vkCmdCopyImage(command_buffer, storageImage->getImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapChainImages[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy_region);
+            });
+            graph.read(copyPass, storage, RenderGraph::UsageTransferSrc);
+            graph.write(copyPass, swapChainImage, RenderGraph::UsageTransferDst);
+
+            graph.compile();
+            {
+                ProfilerScope scope(&profiler, commandBuffers[i], profilerSlot, "frame");
+                graph.execute(commandBuffers[i]);
+            }
 
             if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS) {
                 throw std::runtime_error("failed to record command buffer!");
@@ -1181,12 +1975,15 @@ private:
             throw std::runtime_error("failed to acquire swap chain image!");
         }
 
+        // Der Slot dieses Bildes wurde zuletzt vor swapChainImages.size() Frames verwendet
+        profiler.collect(imageIndex);
+        m_device->retire();
         updateUniformBuffer();
 
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         VkSemaphore waitSemaphores[] = {imageAvailableSemaphore};
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_TRANSFER_BIT};
         submitInfo.waitSemaphoreCount = 1;
         submitInfo.pWaitSemaphores = waitSemaphores;
         submitInfo.pWaitDstStageMask = waitStages;
@@ -1199,6 +1996,7 @@ private:
         if (vkQueueSubmit(m_device->getGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
             throw std::runtime_error("failed to submit draw command buffer!");
         }
+        profiler.markSubmitted(imageIndex, m_frameIndex);
         
         VkPresentInfoKHR presentInfo{};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -1228,11 +2026,11 @@ private:
         }
     }
 
-    VkShaderModule createShaderModule(const std::vector<char>& code) {
+    VkShaderModule createShaderModule(const std::vector<uint32_t>& code) {
         VkShaderModuleCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        createInfo.codeSize = code.size();
-        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+        createInfo.codeSize = code.size() * sizeof(uint32_t);
+        createInfo.pCode = code.data();
 
         VkShaderModule shaderModule;
         if (vkCreateShaderModule(m_device->getHandle(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
@@ -1253,6 +2051,14 @@ private:
     }
 
     VkPresentModeKHR chooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes) {
+        // Im Benchmark soll VSync die Messung nicht begrenzen
+        if (m_settings.benchmark) {
+            for (const auto& availablePresentMode : availablePresentModes) {
+                if (availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR) {
+                    return availablePresentMode;
+                }
+            }
+        }
         for (const auto& availablePresentMode : availablePresentModes) {
             if (availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR) {
                 return availablePresentMode;
@@ -1281,24 +2087,6 @@ private:
         }
     }
 
-    static std::vector<char> readFile(const std::string& filename) {
-        std::ifstream file(SHADER_PATH+filename, std::ios::ate | std::ios::binary);
-
-        if (!file.is_open()) {
-            throw std::runtime_error("failed to open file!");
-        }
-
-        size_t fileSize = (size_t) file.tellg();
-        std::vector<char> buffer(fileSize);
-
-        file.seekg(0);
-        file.read(buffer.data(), fileSize);
-
-        file.close();
-
-        return buffer;
-    }
-
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
         VkPhysicalDeviceMemoryProperties memProperties;
         vkGetPhysicalDeviceMemoryProperties(m_device->getPhysicalDevice(), &memProperties);
@@ -1312,81 +2100,6 @@ private:
         throw std::runtime_error("failed to find suitable memory type!");
     }
 
-    void setImageLayout(VkCommandBuffer command_buffer, VkImage image, VkImageLayout oldLayout, VkImageLayout newLayout, VkImageSubresourceRange subresourceRange, VkPipelineStageFlags srcMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VkPipelineStageFlags dstMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
-    {
-        VkImageMemoryBarrier barrier{};
-        barrier.sType               = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-        barrier.oldLayout           = oldLayout;
-        barrier.newLayout           = newLayout;
-        barrier.image               = image;
-        barrier.subresourceRange    = subresourceRange;
-
-        switch (oldLayout)
-        {
-            case VK_IMAGE_LAYOUT_UNDEFINED:
-                barrier.srcAccessMask = 0;
-                break;
-
-            case VK_IMAGE_LAYOUT_PREINITIALIZED:
-                barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-                barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-                barrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-                barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
-                break;
-            default:
-                break;
-        }
-
-        switch (newLayout)
-        {
-            case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
-                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
-                barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
-                barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
-                barrier.dstAccessMask = barrier.dstAccessMask | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-                break;
-
-            case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
-                if (barrier.srcAccessMask == 0)
-                {
-                    barrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
-                }
-                barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-                break;
-            default:
-                break;
-        }
-        vkCmdPipelineBarrier(command_buffer, srcMask, dstMask, 0, 0, nullptr, 0, nullptr, 1, &barrier);
-    }
-
     VkCommandBuffer createCommandBuffer(VkCommandBufferLevel level, bool begin)
     {
         VkCommandBufferAllocateInfo cmdBufAllocateInfo{};
@@ -1446,18 +2159,106 @@ private:
         vkFreeCommandBuffers(m_device->getHandle(), m_device->getCommandPool(), 1, &command_buffer);
     }
 
-    inline uint32_t alignedSize(uint32_t value, uint32_t alignment)
-    {
-        return (value + alignment - 1) & ~(alignment - 1);
-    }
-
 }; 
 
-int main() {
-    VulkanRaytracer app;
+int main(int argc, char** argv) {
+    Settings settings;
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--benchmark") {
+                settings.benchmark = true;
+            } else if (arg == "--scene" && hasValue) {
+                settings.scene = argv[++i];
+            } else if (arg == "--camera-path" && hasValue) {
+                settings.cameraPath = argv[++i];
+            } else if (arg == "--record-path" && hasValue) {
+                settings.recordPath = argv[++i];
+            } else if (arg == "--warmup" && hasValue) {
+                settings.warmupFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--frames" && hasValue) {
+                settings.measuredFrames = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--timestep" && hasValue) {
+                settings.timestep = std::stof(argv[++i]);
+            } else if (arg == "--report" && hasValue) {
+                settings.report = argv[++i];
+            } else if (arg == "--max-recursion" && hasValue) {
+                settings.maxRecursion = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--light-samples" && hasValue) {
+                settings.lightSamples = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--light-tree") {
+                settings.lightTree = true;
+            } else if (arg == "--extra-lights" && hasValue) {
+                settings.extraLights = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--animate-lights") {
+                settings.animateLights = true;
+            } else if (arg == "--static-lights") {
+                settings.animateLights = false;
+            } else if (arg == "--iterative") {
+                settings.iterativePath = true;
+            } else if (arg == "--cpu" && hasValue) {
+                settings.cpuOutput = argv[++i];
+            } else if (arg == "--width" && hasValue) {
+                settings.cpuWidth = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--height" && hasValue) {
+                settings.cpuHeight = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--threads" && hasValue) {
+                settings.cpuThreads = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--time" && hasValue) {
+                settings.cpuTime = std::stof(argv[++i]);
+            } else if (arg == "--compare" && hasValue) {
+                settings.compare = argv[++i];
+            } else if (arg == "--tolerance" && hasValue) {
+                settings.compareTolerance = std::stof(argv[++i]);
+            } else if (arg == "--bvh-benchmark") {
+                settings.bvhBenchmark = true;
+            } else if (arg == "--picking") {
+                settings.picking = true;
+            } else if (arg == "--ray-benchmark") {
+                settings.rayBenchmark = true;
+            } else if (arg == "--flake-depth" && hasValue) {
+                settings.flakeDepth = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--flake-instance-depth" && hasValue) {
+                settings.flakeInstanceDepth = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else if (arg == "--flake-benchmark") {
+                settings.flakeBenchmark = true;
+            } else if (arg == "--world-space-spheres") {
+                settings.worldSpaceSpheres = true;
+            } else if (arg == "--sphere-benchmark") {
+                // Kamera aus der Kamerafahrt, ohne VSync und Eingaben wie im normalen Benchmark
+                settings.benchmark = true;
+                settings.sphereBenchmark = true;
+            } else if (arg == "--job-benchmark") {
+                settings.jobBenchmark = true;
+            } else if (arg == "--leaf-size" && hasValue) {
+                settings.leafSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+            } else {
+                throw std::runtime_error("unknown argument " + arg + "!");
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        std::cerr << "usage: VulkanRaytracer [--scene sphereflake|sponza] [--benchmark] [--camera-path file] [--record-path file] [--warmup N] [--frames N] [--timestep seconds] [--report file] [--max-recursion N] [--light-samples N] [--light-tree] [--extra-lights N] [--animate-lights] [--static-lights] [--iterative] [--cpu out.png|out.exr] [--width N] [--height N] [--threads N] [--time seconds] [--compare golden.png] [--tolerance levels] [--bvh-benchmark] [--leaf-size N] [--ray-benchmark] [--picking] [--job-benchmark] [--flake-depth N] [--flake-instance-depth N] [--flake-benchmark] [--world-space-spheres] [--sphere-benchmark]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    VulkanRaytracer app(settings);
 
     try {
-        app.run();
+        if (settings.bvhBenchmark) {
+            app.runBvhBenchmark();
+        } else if (settings.rayBenchmark) {
+            app.runRayBenchmark();
+        } else if (settings.flakeBenchmark) {
+            app.runFlakeBenchmark();
+        } else if (settings.jobBenchmark) {
+            app.runJobBenchmark();
+        } else if (!settings.cpuOutput.empty()) {
+            app.runCpu();
+        } else {
+            app.run();
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
         return EXIT_FAILURE;
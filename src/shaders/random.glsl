@@ -0,0 +1,16 @@
+// PCG Hash (Jarzynski und Olano), pro Pixel und Frame ein eigener Zustand
+uint pcgHash(uint v){
+  uint state = v * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+uint initRandom(uvec2 pixel, uint frame){
+  return pcgHash(pixel.x + pcgHash(pixel.y + pcgHash(frame)));
+}
+
+// Gleichverteilt in [0, 1)
+float nextRandom(inout uint state){
+  state = pcgHash(state);
+  return float(state >> 8) / 16777216.0;
+}
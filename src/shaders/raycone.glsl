@@ -0,0 +1,17 @@
+// Ray Cones (Akenine-Möller et al.): jeder Strahl trägt Breite und Öffnungswinkel eines Kegels,
+// daraus ergibt sich an der Oberfläche ein explizites Mip Level statt immer Level 0
+
+// Öffnungswinkel eines Pixels aus dem vertikalen Sichtfeld
+float pixelSpreadAngle(float tanHalfFovY, float height){
+  return atan(2.0 * tanHalfFovY / height);
+}
+
+// Texturunabhängiger Teil: 0.5 * log2(UV Fläche / Weltfläche) des Dreiecks, Kegelbreite und Neigung der Fläche
+float coneLod(float triangleLod, float coneWidth, vec3 direction, vec3 normal){
+  return triangleLod + log2(max(coneWidth, 1e-8)) - log2(max(abs(dot(direction, normal)), 1e-4));
+}
+
+// Die Texturgröße macht aus UV Fläche Texelfläche
+float coneTextureLod(float lod, ivec2 size){
+  return lod + 0.5 * log2(float(size.x) * float(size.y));
+}
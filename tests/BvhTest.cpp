@@ -0,0 +1,236 @@
+#include "Test.h"
+#include "Bvh.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace {
+
+// Zufällige kleine Boxen in einem Würfel, dazu ein paar große, die viele Knoten überlappen
+std::vector<Aabb> makeBounds(uint32_t count, uint32_t seed){
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Aabb> bounds(count);
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * 20.0f - glm::vec3(10.0f);
+        float size = i % 64 == 0 ? 3.0f : 0.2f * unit(random) + 0.01f;
+        bounds[i].grow(center - glm::vec3(size));
+        bounds[i].grow(center + glm::vec3(size, 0.5f * size, size));
+    }
+    return bounds;
+}
+
+bool contains(const Bvh::Node& parent, glm::vec3 boundsMin, glm::vec3 boundsMax){
+    for (int axis = 0; axis < 3; axis++) {
+        if (boundsMin[axis] < parent.boundsMin[axis] || boundsMax[axis] > parent.boundsMax[axis]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Jedes Primitiv genau einmal in einem Blatt, Kindboxen in der Elternbox, Blattboxen umschließen ihre Primitive
+void checkTree(const Bvh& bvh, const std::vector<Aabb>& bounds, const Bvh::BuildSettings& settings){
+    const std::vector<Bvh::Node>& nodes = bvh.getNodes();
+    const std::vector<uint32_t>& indices = bvh.getIndices();
+    CHECK(!nodes.empty());
+    CHECK_EQUAL(bounds.size(), indices.size());
+    std::vector<uint32_t> seen(bounds.size(), 0);
+    uint32_t maxDepth = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> stack = {{0, 1}};
+    while (!stack.empty()) {
+        auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+        maxDepth = std::max(maxDepth, depth);
+        const Bvh::Node& node = nodes[nodeIndex];
+        if (node.count > 0) {
+            CHECK(node.count <= std::max(settings.maxLeafSize, 1u));
+            CHECK(node.rightOrFirst + node.count <= indices.size());
+            for (uint32_t i = node.rightOrFirst; i < node.rightOrFirst + node.count; i++) {
+                seen[indices[i]]++;
+                CHECK(contains(node, bounds[indices[i]].min, bounds[indices[i]].max));
+            }
+            continue;
+        }
+        uint32_t left = nodeIndex + 1;
+        uint32_t right = node.rightOrFirst;
+        CHECK(right > left && right < nodes.size());
+        CHECK(contains(node, nodes[left].boundsMin, nodes[left].boundsMax));
+        CHECK(contains(node, nodes[right].boundsMin, nodes[right].boundsMax));
+        stack.push_back({left, depth + 1});
+        stack.push_back({right, depth + 1});
+    }
+    for (uint32_t count : seen) {
+        CHECK_EQUAL(1u, count);
+    }
+    CHECK_EQUAL(maxDepth, bvh.getDepth());
+    CHECK(bvh.getDepth() <= Bvh::MaxDepth);
+}
+
+// Anzahl der Primitive unter jedem Knoten, Kinder liegen immer hinter dem Elternknoten
+std::vector<uint32_t> countPrimitives(const Bvh& bvh){
+    const std::vector<Bvh::Node>& nodes = bvh.getNodes();
+    std::vector<uint32_t> counts(nodes.size(), 0);
+    for (size_t i = nodes.size(); i-- > 0;) {
+        counts[i] = nodes[i].count > 0 ? nodes[i].count : counts[i + 1] + counts[nodes[i].rightOrFirst];
+    }
+    return counts;
+}
+
+// Eintrittsdistanz in die Box als Ersatz für einen Primitiv Test, negativ ohne Treffer
+float intersectBox(const Aabb& box, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax){
+    glm::vec3 t0 = (box.min - origin) / direction;
+    glm::vec3 t1 = (box.max - origin) / direction;
+    glm::vec3 tNear = glm::min(t0, t1);
+    glm::vec3 tFar = glm::max(t0, t1);
+    float enter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tmin));
+    float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tmax));
+    return enter <= exit ? enter : -1.0f;
+}
+
+}
+
+TEST(Bvh, SerialBuildInvariants){
+    std::vector<Aabb> bounds = makeBounds(3000, 1);
+    JobSystem serial(1);
+    Bvh::BuildSettings settings;
+    settings.jobs = &serial;
+    Bvh bvh;
+    bvh.build(bounds, settings);
+    checkTree(bvh, bounds, settings);
+}
+
+TEST(Bvh, ParallelBuildInvariants){
+    std::vector<Aabb> bounds = makeBounds(20000, 2);
+    JobSystem jobs(4);
+    Bvh::BuildSettings settings;
+    settings.jobs = &jobs;
+    settings.parallelThreshold = 256;
+    settings.maxLeafSize = 8;
+    Bvh bvh;
+    bvh.build(bounds, settings);
+    checkTree(bvh, bounds, settings);
+}
+
+// Gleiche Boxen lassen sich nicht nach SAH trennen, exponentiell verteilte würden ohne Median Teilung eine Kette bilden
+TEST(Bvh, DegenerateInputStaysBelowMaxDepth){
+    std::vector<Aabb> bounds;
+    for (uint32_t i = 0; i < 500; i++) {
+        Aabb box;
+        box.grow(glm::vec3(1.0f));
+        box.grow(glm::vec3(2.0f));
+        bounds.push_back(box);
+    }
+    for (uint32_t i = 0; i < 2000; i++) {
+        Aabb box;
+        float x = std::ldexp(1.0f, -static_cast<int>(i % 120));
+        box.grow(glm::vec3(x, 0.0f, 0.0f));
+        bounds.push_back(box);
+    }
+    JobSystem serial(1);
+    Bvh::BuildSettings settings;
+    settings.jobs = &serial;
+    Bvh bvh;
+    bvh.build(bounds, settings);
+    checkTree(bvh, bounds, settings);
+}
+
+// Nächster Treffer und Any Hit müssen mit dem Test aller Primitive übereinstimmen
+TEST(Bvh, TraversalMatchesBruteForce){
+    std::vector<Aabb> bounds = makeBounds(2000, 3);
+    Bvh bvh;
+    bvh.build(bounds);
+    std::mt19937 random(4);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    for (uint32_t ray = 0; ray < 500; ray++) {
+        glm::vec3 origin = glm::vec3(unit(random), unit(random), unit(random)) * 15.0f;
+        glm::vec3 direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)));
+        // Einige Strahlen entlang der Achsen, dort ist die inverse Richtung unendlich
+        if (ray % 10 == 0) {
+            direction = glm::vec3(0.0f);
+            direction[ray % 3] = 1.0f;
+        }
+        float expected = 1e30f;
+        int32_t expectedPrimitive = -1;
+        for (uint32_t i = 0; i < bounds.size(); i++) {
+            float t = intersectBox(bounds[i], origin, direction, 0.0f, expected);
+            if (t >= 0.0f && t < expected) {
+                expected = t;
+                expectedPrimitive = static_cast<int32_t>(i);
+            }
+        }
+        float tmax = 1e30f;
+        int32_t primitive = -1;
+        bool hit = bvh.traverse(origin, direction, 0.0f, tmax, false, [&](uint32_t index, float& t){
+            float hitT = intersectBox(bounds[index], origin, direction, 0.0f, t);
+            if (hitT >= 0.0f && hitT < t) {
+                t = hitT;
+                primitive = static_cast<int32_t>(index);
+                return true;
+            }
+            return false;
+        });
+        CHECK_EQUAL(expectedPrimitive >= 0, hit);
+        CHECK_NEAR(expected, tmax, 1e-4f);
+        if (primitive != expectedPrimitive) {
+            // Gleichstand zweier Boxen, beide liefern dieselbe Distanz
+            CHECK_NEAR(expected, intersectBox(bounds[primitive], origin, direction, 0.0f, 1e30f), 1e-4f);
+        }
+
+        float anyTmax = 1e30f;
+        bool anyHit = bvh.traverse(origin, direction, 0.0f, anyTmax, true, [&](uint32_t index, float& t){
+            float hitT = intersectBox(bounds[index], origin, direction, 0.0f, t);
+            if (hitT >= 0.0f && hitT < t) {
+                t = hitT;
+                return true;
+            }
+            return false;
+        });
+        CHECK_EQUAL(hit, anyHit);
+    }
+}
+
+// Teure Traversierung teilt nur Knoten über maxLeafSize, billige teilt auch kleine Knoten weiter
+TEST(Bvh, TraversalCostControlsLeafTermination){
+    std::vector<Aabb> bounds = makeBounds(4000, 5);
+    JobSystem serial(1);
+    Bvh::BuildSettings settings;
+    settings.jobs = &serial;
+    settings.maxLeafSize = 8;
+    settings.traversalCost = 1000.0f;
+    Bvh coarse;
+    coarse.build(bounds, settings);
+    checkTree(coarse, bounds, settings);
+    settings.traversalCost = 0.01f;
+    Bvh fine;
+    fine.build(bounds, settings);
+    checkTree(fine, bounds, settings);
+
+    uint32_t smallInnerCoarse = 0;
+    std::vector<uint32_t> primitives = countPrimitives(coarse);
+    for (size_t i = 0; i < primitives.size(); i++) {
+        smallInnerCoarse += coarse.getNodes()[i].count == 0 && primitives[i] <= settings.maxLeafSize ? 1 : 0;
+    }
+    uint32_t smallInnerFine = 0;
+    primitives = countPrimitives(fine);
+    for (size_t i = 0; i < primitives.size(); i++) {
+        smallInnerFine += fine.getNodes()[i].count == 0 && primitives[i] <= settings.maxLeafSize ? 1 : 0;
+    }
+    CHECK_EQUAL(0u, smallInnerCoarse);
+    CHECK(smallInnerFine > 0);
+    CHECK(coarse.getNodes().size() < fine.getNodes().size());
+}
+
+TEST(Bvh, EmptyAndSinglePrimitive){
+    Bvh bvh;
+    bvh.build({});
+    CHECK(bvh.empty());
+    float tmax = 1.0f;
+    CHECK(!bvh.traverse(glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, tmax, false, [](uint32_t, float&){ return true; }));
+
+    std::vector<Aabb> bounds = makeBounds(1, 6);
+    bvh.build(bounds);
+    CHECK_EQUAL(1u, static_cast<uint32_t>(bvh.getNodes().size()));
+    CHECK_EQUAL(1u, bvh.getNodes()[0].count);
+    CHECK_EQUAL(1u, bvh.getDepth());
+}
@@ -0,0 +1,137 @@
+#include "Test.h"
+#include "CpuRayTracer.h"
+#include "JobSystem.h"
+#include <cmath>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+const glm::vec3 SkyColor = glm::vec3(0.5255f, 0.8745f, 1.0f);
+const glm::vec3 Diffuse = glm::vec3(0.6f, 0.4f, 0.2f);
+const float AmbientIntensity = 0.1f;
+
+Vertex makeVertex(float x, float y, float z){
+    Vertex vertex{};
+    vertex.position[0] = x;
+    vertex.position[1] = y;
+    vertex.position[2] = z;
+    vertex.normal[1] = 1.0f;
+    vertex.matID = 0;
+    return vertex;
+}
+
+// Bodendreieck bei y = 0, groß genug für jeden Kamerastrahl nach unten (Primitive 0), Kugel mit Radius 1 bei (0, 1, 0) darauf (Primitive 1),
+// ein diffuses Material ohne Spiegelung und ein Richtungslicht von oben
+CpuRayTracer makeScene(){
+    CpuRayTracer tracer;
+    tracer.addTriangles({makeVertex(-100.0f, 0.0f, -100.0f), makeVertex(100.0f, 0.0f, -100.0f), makeVertex(0.0f, 0.0f, 200.0f)}, {0, 1, 2}, glm::mat4(1.0f));
+    Sphere sphere{};
+    sphere.radius = 0.5f;
+    sphere.matID = 0;
+    // Radius und Mittelpunkt kommen wie bei der TLAS aus der Instanz Transformation
+    tracer.addSpheres({sphere}, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::vec3(2.0f)));
+
+    Material material{};
+    material.diffuse[0] = Diffuse.x;
+    material.diffuse[1] = Diffuse.y;
+    material.diffuse[2] = Diffuse.z;
+    material.shininess = 1.0f;
+    material.dissolve = 1.0f;
+    material.illum = 2;
+    material.ambientTexId = material.diffuseTexId = material.specularTexId = material.alphaTexId = -1;
+    tracer.setMaterials({material});
+    tracer.setLights({Light(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f), AmbientIntensity)});
+    tracer.build();
+    return tracer;
+}
+
+// Analytische Referenz: Boden im Schatten der Kugel liegt innerhalb von x² + z² < 1,
+// auf der Kugel ist nur der Lambert Anteil winkelabhängig
+glm::vec3 shadeReference(glm::vec3 origin, glm::vec3 direction){
+    glm::vec3 oc = origin - glm::vec3(0.0f, 1.0f, 0.0f);
+    float b = glm::dot(oc, direction);
+    float c = glm::dot(oc, oc) - 1.0f;
+    float discriminant = b * b - c;
+    if (discriminant >= 0.0f) {
+        glm::vec3 position = origin + direction * (-b - std::sqrt(discriminant));
+        float cosPhi = std::max(position.y - 1.0f, 0.0f);
+        return Diffuse * AmbientIntensity + Diffuse * cosPhi;
+    }
+    if (direction.y < 0.0f) {
+        glm::vec3 position = origin - direction * (origin.y / direction.y);
+        bool shadowed = position.x * position.x + position.z * position.z < 1.0f;
+        return Diffuse * AmbientIntensity + (shadowed ? glm::vec3(0.0f) : Diffuse);
+    }
+    return SkyColor;
+}
+
+}
+
+TEST(CpuRayTracer, IntersectKnownHits){
+    CpuRayTracer tracer = makeScene();
+    CpuRayTracer::Hit hit{};
+    // Senkrecht auf die Kugel
+    CHECK(tracer.intersect(glm::vec3(0.0f, 5.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), 0.0f, 100.0f, hit));
+    CHECK_NEAR(3.0f, hit.t, 1e-5f);
+    CHECK(tracer.getPrimitive(hit.primitive).sphere);
+    CHECK_EQUAL(1u, tracer.getPrimitive(hit.primitive).instance);
+    // Neben der Kugel auf den Boden, u und v für (5, 0, 50) im Bodendreieck
+    CHECK(tracer.intersect(glm::vec3(5.0f, 5.0f, 50.0f), glm::vec3(0.0f, -1.0f, 0.0f), 0.0f, 100.0f, hit));
+    CHECK_NEAR(5.0f, hit.t, 1e-5f);
+    CHECK(!tracer.getPrimitive(hit.primitive).sphere);
+    CHECK_EQUAL(0u, tracer.getPrimitive(hit.primitive).instance);
+    CHECK_NEAR(0.275f, hit.u, 1e-5f);
+    CHECK_NEAR(0.5f, hit.v, 1e-5f);
+    // Von unten durch den Boden, tmax davor und nach oben ins Leere
+    CHECK(tracer.intersect(glm::vec3(5.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, 100.0f, hit));
+    CHECK_NEAR(1.0f, hit.t, 1e-5f);
+    CHECK(!tracer.intersect(glm::vec3(5.0f, 5.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f), 0.0f, 4.9f, hit));
+    CHECK(!tracer.intersect(glm::vec3(5.0f, 5.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, 100.0f, hit));
+}
+
+TEST(CpuRayTracer, OccludedKnownResults){
+    CpuRayTracer tracer = makeScene();
+    // Schattenstrahlen vom Boden zum Licht
+    CHECK(tracer.occluded(glm::vec3(0.5f, 0.0f, 0.5f), glm::vec3(0.0f, 1.0f, 0.0f), 0.001f, 10000.0f));
+    CHECK(!tracer.occluded(glm::vec3(1.5f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.001f, 10000.0f));
+    // Oberseite der Kugel verdeckt sich nicht selbst, tmax vor der Kugel
+    CHECK(!tracer.occluded(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.001f, 10000.0f));
+    CHECK(!tracer.occluded(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 1.5f, 1.9f));
+    CHECK(tracer.occluded(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), 0.0f, 1.5f));
+}
+
+// Jedes Pixel gegen die analytische Referenz, Kamera bei (0, 1, -5) mit Blick in +z
+TEST(CpuRayTracer, RenderMatchesReference){
+    CpuRayTracer tracer = makeScene();
+    const uint32_t width = 24;
+    const uint32_t height = 16;
+    glm::mat4 inverseView = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 1.0f, -5.0f));
+    glm::mat4 inverseProj = glm::mat4(1.0f);
+    JobSystem jobs(4);
+    std::vector<float> image = tracer.render(inverseView, inverseProj, width, height, jobs, 5);
+    CHECK_EQUAL(static_cast<size_t>(width) * height * 3, image.size());
+
+    uint32_t sky = 0, sphere = 0, shadow = 0;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            glm::vec2 d = (glm::vec2(x, y) + glm::vec2(0.5f)) / glm::vec2(width, height) * 2.0f - 1.0f;
+            glm::vec3 direction = glm::normalize(glm::vec3(d.x, d.y, 1.0f));
+            glm::vec3 expected = shadeReference(glm::vec3(0.0f, 1.0f, -5.0f), direction);
+            size_t pixel = (static_cast<size_t>(y) * width + x) * 3;
+            for (uint32_t c = 0; c < 3; c++) {
+                CHECK_NEAR(expected[c], image[pixel + c], 1e-3f);
+            }
+            sky += expected == SkyColor ? 1 : 0;
+            shadow += expected == Diffuse * AmbientIntensity ? 1 : 0;
+            sphere += expected != SkyColor && expected != Diffuse * AmbientIntensity && expected != Diffuse * (1.0f + AmbientIntensity) ? 1 : 0;
+        }
+    }
+    // Das Bild enthält Himmel, Kugel und Schatten
+    CHECK(sky > 0);
+    CHECK(sphere > 0);
+    CHECK(shadow > 0);
+
+    // Unabhängig von Kachelgröße und Anzahl der Threads
+    JobSystem serial(1);
+    CHECK(tracer.render(inverseView, inverseProj, width, height, serial, 16) == image);
+}
@@ -0,0 +1,137 @@
+#include "Test.h"
+#include "HostAccelerationStructure.h"
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace {
+
+Vertex makeVertex(float x, float y, float z){
+    Vertex vertex{};
+    vertex.position[0] = x;
+    vertex.position[1] = y;
+    vertex.position[2] = z;
+    return vertex;
+}
+
+// Instanz 0: Quadrat [-1, 1]² bei z = 0, Instanz 1: Kugel mit Radius 1 bei (3, 0, 0) über eine skalierte Instanz,
+// Instanz 2: dasselbe Quadrat bei z = -2
+struct Scene{
+    HostAccelerationStructure accelerationStructure;
+
+    Scene(){
+        std::vector<Vertex> vertices = {makeVertex(-1.0f, -1.0f, 0.0f), makeVertex(1.0f, -1.0f, 0.0f), makeVertex(1.0f, 1.0f, 0.0f), makeVertex(-1.0f, 1.0f, 0.0f)};
+        std::vector<uint32_t> indices = {0, 1, 2, 0, 2, 3};
+        Sphere sphere{};
+        sphere.radius = 0.5f;
+        accelerationStructure.addTriangles(vertices, indices, glm::mat4(1.0f));
+        accelerationStructure.addSpheres({sphere}, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(3.0f, 0.0f, 0.0f)), glm::vec3(2.0f)));
+        accelerationStructure.addTriangles(vertices, indices, glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -2.0f)));
+        accelerationStructure.build();
+    }
+};
+
+struct Query{
+    glm::vec3 origin;
+    float tmax;
+    HostAccelerationStructure::Hit expected;
+};
+
+// Alle Strahlen laufen in -z Richtung
+const glm::vec3 Down = glm::vec3(0.0f, 0.0f, -1.0f);
+const uint32_t Miss = HostAccelerationStructure::Miss;
+const Query Queries[] = {
+    {glm::vec3(0.5f, 0.25f, 5.0f), 100.0f, {5.0f, 0, 0, 0.125f, 0.625f}},     // vorderes Quadrat, erstes Dreieck
+    {glm::vec3(-0.5f, 0.5f, 5.0f), 100.0f, {5.0f, 0, 1, 0.25f, 0.5f}},      // vorderes Quadrat, zweites Dreieck
+    {glm::vec3(3.0f, 0.0f, 5.0f), 100.0f, {4.0f, 1, 0, 0.0f, 0.0f}},        // Kugel
+    {glm::vec3(0.5f, 0.25f, -1.0f), 100.0f, {1.0f, 2, 0, 0.125f, 0.625f}},  // hinter dem vorderen Quadrat
+    {glm::vec3(10.0f, 10.0f, 5.0f), 100.0f, {100.0f, Miss, Miss, 0.0f, 0.0f}},
+    {glm::vec3(0.5f, 0.25f, 5.0f), 4.9f, {4.9f, Miss, Miss, 0.0f, 0.0f}},    // tmax vor dem Quadrat
+};
+const uint32_t QueryCount = sizeof(Queries) / sizeof(Queries[0]);
+
+void checkHit(const HostAccelerationStructure::Hit& expected, const HostAccelerationStructure::Hit& hit){
+    CHECK_NEAR(expected.t, hit.t, 1e-5f);
+    CHECK_EQUAL(expected.instance, hit.instance);
+    CHECK_EQUAL(expected.primitive, hit.primitive);
+    CHECK_NEAR(expected.u, hit.u, 1e-5f);
+    CHECK_NEAR(expected.v, hit.v, 1e-5f);
+}
+
+// Mehr als BatchSize Strahlen, damit die Batches als Jobs laufen
+void makeBatch(uint32_t repeat, std::vector<glm::vec3>& origins, std::vector<glm::vec3>& directions, std::vector<float>& tmax){
+    for (uint32_t i = 0; i < repeat * QueryCount; i++) {
+        origins.push_back(Queries[i % QueryCount].origin);
+        directions.push_back(Down);
+        tmax.push_back(Queries[i % QueryCount].tmax);
+    }
+}
+
+}
+
+TEST(HostAccelerationStructure, BatchIntersectReportsHitFields){
+    Scene scene;
+    JobSystem jobs(4);
+    std::vector<glm::vec3> origins, directions;
+    std::vector<float> tmax;
+    makeBatch(50, origins, directions, tmax);
+    for (uint32_t kernel = 0; kernel < SimdKernelCount; kernel++) {
+        if (!RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+            continue;
+        }
+        scene.accelerationStructure.setKernel(static_cast<SimdKernel>(kernel));
+        std::vector<HostAccelerationStructure::Hit> hits = scene.accelerationStructure.intersect(origins, directions, tmax, 0.0f, jobs);
+        CHECK_EQUAL(origins.size(), hits.size());
+        for (size_t i = 0; i < hits.size(); i++) {
+            checkHit(Queries[i % QueryCount].expected, hits[i]);
+        }
+    }
+}
+
+// Einzelne Anfragen verhalten sich wie der Batch, tmin hinter dem vorderen Quadrat findet das hintere
+TEST(HostAccelerationStructure, SingleIntersectMatchesBatch){
+    Scene scene;
+    for (const Query& query : Queries) {
+        HostAccelerationStructure::Hit hit{};
+        bool found = scene.accelerationStructure.intersect(query.origin, Down, 0.0f, query.tmax, hit);
+        CHECK_EQUAL(query.expected.instance != Miss, found);
+        if (found) {
+            checkHit(query.expected, hit);
+        }
+    }
+    HostAccelerationStructure::Hit hit{};
+    CHECK(scene.accelerationStructure.intersect(glm::vec3(0.5f, 0.25f, 5.0f), Down, 5.5f, 100.0f, hit));
+    checkHit({7.0f, 2, 0, 0.125f, 0.625f}, hit);
+}
+
+// Verdeckt ist jeder Strahl mit einem Treffer vor tmax, auch wenn mehrere Verdecker hintereinander liegen
+TEST(HostAccelerationStructure, BatchOccludedMatchesIntersect){
+    Scene scene;
+    JobSystem jobs(4);
+    std::vector<glm::vec3> origins, directions;
+    std::vector<float> tmax;
+    makeBatch(50, origins, directions, tmax);
+    std::vector<uint8_t> occluded = scene.accelerationStructure.occluded(origins, directions, tmax, 0.0f, jobs);
+    CHECK_EQUAL(origins.size(), occluded.size());
+    for (size_t i = 0; i < occluded.size(); i++) {
+        CHECK_EQUAL(Queries[i % QueryCount].expected.instance != Miss ? 1 : 0, static_cast<int>(occluded[i]));
+    }
+    // Kurz vor und hinter dem Quadrat bzw. der Kugel
+    CHECK(!scene.accelerationStructure.occluded(glm::vec3(0.5f, 0.25f, 5.0f), Down, 0.0f, 4.99f));
+    CHECK(scene.accelerationStructure.occluded(glm::vec3(0.5f, 0.25f, 5.0f), Down, 0.0f, 5.01f));
+    CHECK(!scene.accelerationStructure.occluded(glm::vec3(3.0f, 0.0f, 5.0f), Down, 0.0f, 3.99f));
+    CHECK(scene.accelerationStructure.occluded(glm::vec3(3.0f, 0.0f, 5.0f), Down, 0.0f, 4.01f));
+}
+
+TEST(HostAccelerationStructure, BatchSizeMismatchThrows){
+    Scene scene;
+    std::vector<glm::vec3> origins(3, glm::vec3(0.0f, 0.0f, 5.0f));
+    std::vector<glm::vec3> directions(3, Down);
+    std::vector<float> tmax(3, 100.0f);
+    std::vector<glm::vec3> shortDirections(2, Down);
+    std::vector<float> shortTmax(2, 100.0f);
+    CHECK_THROWS(scene.accelerationStructure.intersect(origins, shortDirections, tmax));
+    CHECK_THROWS(scene.accelerationStructure.intersect(origins, directions, shortTmax));
+    CHECK_THROWS(scene.accelerationStructure.occluded(origins, shortDirections, tmax));
+    CHECK_THROWS(scene.accelerationStructure.occluded(origins, directions, shortTmax));
+    CHECK_EQUAL(static_cast<size_t>(3), scene.accelerationStructure.intersect(origins, directions, tmax).size());
+    CHECK(scene.accelerationStructure.intersect({}, {}, {}).empty());
+}
@@ -0,0 +1,167 @@
+#include "Test.h"
+#include "JobSystem.h"
+#include <chrono>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Mehr Threads als Kerne eingeschlossen, 1 läuft ganz ohne Worker auf dem wartenden Thread
+const uint32_t ThreadCounts[] = {1, 2, 4, 16, 64};
+
+}
+
+TEST(JobSystem, ChildrenFinishBeforeParent){
+    for (uint32_t threadCount : ThreadCounts) {
+        JobSystem jobs(threadCount);
+        std::atomic<uint32_t> counter{0};
+        JobSystem::JobHandle root = jobs.create(nullptr);
+        for (uint32_t i = 0; i < 20000; i++) {
+            jobs.run(jobs.create([&counter](){ counter++; }, root));
+        }
+        jobs.run(root);
+        jobs.wait(root);
+        CHECK(jobs.isFinished(root));
+        CHECK_EQUAL(20000u, counter.load());
+    }
+}
+
+// Jeder Job erzeugt Kinder und wartet auf sie, ohne wait-while-helping würde das mit wenigen Threads blockieren
+TEST(JobSystem, NestedWaitsDoNotDeadlock){
+    for (uint32_t threadCount : ThreadCounts) {
+        JobSystem jobs(threadCount);
+        std::function<uint64_t(uint32_t)> fib = [&](uint32_t n) -> uint64_t {
+            if (n < 2) {
+                return n;
+            }
+            uint64_t a = 0;
+            JobSystem::JobHandle first = jobs.run([&, n](){ a = fib(n - 1); });
+            uint64_t b = fib(n - 2);
+            jobs.wait(first);
+            return a + b;
+        };
+        uint64_t result = 0;
+        jobs.wait(jobs.run([&](){ result = fib(18); }));
+        CHECK_EQUAL(static_cast<uint64_t>(2584), result);
+    }
+}
+
+// Rückwärts gestartet muss die Kette trotzdem in Reihenfolge laufen
+TEST(JobSystem, DependencyChainRunsInOrder){
+    for (uint32_t threadCount : ThreadCounts) {
+        JobSystem jobs(threadCount);
+        std::vector<uint32_t> order;
+        std::mutex orderMutex;
+        std::vector<JobSystem::JobHandle> chain;
+        for (uint32_t i = 0; i < 500; i++) {
+            chain.push_back(jobs.create([&, i](){ std::lock_guard<std::mutex> lock(orderMutex); order.push_back(i); }));
+            if (i > 0) {
+                jobs.addDependency(chain[i], chain[i - 1]);
+            }
+        }
+        for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+            jobs.run(*it);
+        }
+        jobs.wait(chain.back());
+        CHECK_EQUAL(chain.size(), order.size());
+        for (uint32_t i = 0; i < order.size(); i++) {
+            CHECK_EQUAL(i, order[i]);
+        }
+    }
+}
+
+// Rauten: d wartet auf b und c, beide warten auf a. Eine Abhängigkeit auf einen fertigen Job blockiert nicht
+TEST(JobSystem, DiamondDependencies){
+    for (uint32_t threadCount : ThreadCounts) {
+        JobSystem jobs(threadCount);
+        for (uint32_t i = 0; i < 200; i++) {
+            std::atomic<uint32_t> step{0};
+            std::atomic<bool> valid{true};
+            JobSystem::JobHandle a = jobs.create([&](){ step = 1; });
+            JobSystem::JobHandle b = jobs.create([&](){ valid = valid && step >= 1; step++; });
+            JobSystem::JobHandle c = jobs.create([&](){ valid = valid && step >= 1; step++; });
+            JobSystem::JobHandle d = jobs.create([&](){ valid = valid && step == 3; });
+            jobs.addDependency(b, a);
+            jobs.addDependency(c, a);
+            jobs.addDependency(d, b);
+            jobs.addDependency(d, c);
+            jobs.run(d);
+            jobs.run(c);
+            jobs.run(b);
+            jobs.run(a);
+            jobs.wait(d);
+            CHECK(valid.load());
+            CHECK_EQUAL(3u, step.load());
+
+            JobSystem::JobHandle late = jobs.create([&](){ step++; });
+            jobs.addDependency(late, d);
+            jobs.run(late);
+            jobs.wait(late);
+            CHECK_EQUAL(4u, step.load());
+        }
+    }
+}
+
+TEST(JobSystem, ParallelForCoversRange){
+    for (uint32_t threadCount : ThreadCounts) {
+        JobSystem jobs(threadCount);
+        std::vector<uint32_t> visits(100000, 0);
+        jobs.parallelFor(0, static_cast<uint32_t>(visits.size()), 777, [&visits](uint32_t begin, uint32_t end){
+            for (uint32_t i = begin; i < end; i++) {
+                visits[i]++;
+            }
+        });
+        for (uint32_t count : visits) {
+            CHECK_EQUAL(1u, count);
+        }
+        bool called = false;
+        jobs.parallelFor(5, 5, 1, [&called](uint32_t, uint32_t){ called = true; });
+        CHECK(!called);
+    }
+}
+
+// Die Exception eines Kindes landet beim Elternjob, die übrigen Kinder laufen trotzdem zu Ende
+TEST(JobSystem, ExceptionsPropagateToWaiter){
+    for (uint32_t threadCount : ThreadCounts) {
+        JobSystem jobs(threadCount);
+        std::string message;
+        try {
+            jobs.parallelFor(0, 100, 1, [](uint32_t begin, uint32_t end){
+                if (begin <= 42 && 42 < end) {
+                    throw std::runtime_error("expected");
+                }
+            });
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        CHECK_EQUAL(std::string("expected"), message);
+
+        std::atomic<uint32_t> completed{0};
+        JobSystem::JobHandle root = jobs.create(nullptr);
+        jobs.run(jobs.create([](){ throw std::runtime_error("child"); }, root));
+        for (uint32_t i = 0; i < 50; i++) {
+            jobs.run(jobs.create([&completed](){ completed++; }, root));
+        }
+        jobs.run(root);
+        CHECK_THROWS(jobs.wait(root));
+        CHECK_EQUAL(50u, completed.load());
+
+        // Das System bleibt nach einer Exception benutzbar
+        uint32_t value = 0;
+        jobs.wait(jobs.run([&value](){ value = 7; }));
+        CHECK_EQUAL(7u, value);
+    }
+}
+
+// Ein fremder Thread wartet auf einen langen Job, ohne selbst etwas abarbeiten zu können
+TEST(JobSystem, WaitBlocksUntilLongJobFinishes){
+    JobSystem jobs(2);
+    std::atomic<bool> done{false};
+    JobSystem::JobHandle slow = jobs.run([&done](){
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        done = true;
+    });
+    jobs.wait(slow);
+    CHECK(done.load());
+    CHECK(jobs.isFinished(slow));
+}
@@ -0,0 +1,83 @@
+#include "Test.h"
+#include "LightSampler.h"
+#include <random>
+
+namespace {
+
+// Auswahlwahrscheinlichkeit jedes Index aus Schwelle und Alias zurückrechnen: Eintrag i behält sich selbst mit
+// threshold und gibt den Rest an alias ab, jeder Eintrag wird mit 1 / count gezogen
+std::vector<double> getSelectionProbabilities(const std::vector<LightSampler::AliasEntry>& table){
+    std::vector<double> probabilities(table.size(), 0.0);
+    for (size_t i = 0; i < table.size(); i++) {
+        probabilities[i] += table[i].threshold / static_cast<double>(table.size());
+        probabilities[table[i].alias] += (1.0 - table[i].threshold) / static_cast<double>(table.size());
+    }
+    return probabilities;
+}
+
+void checkTable(const std::vector<float>& weights){
+    std::vector<LightSampler::AliasEntry> table = LightSampler::buildAliasTable(weights);
+    CHECK_EQUAL(weights.size(), table.size());
+    double total = 0.0;
+    for (float weight : weights) {
+        total += weight;
+    }
+    std::vector<double> probabilities = getSelectionProbabilities(table);
+    for (size_t i = 0; i < weights.size(); i++) {
+        CHECK(table[i].threshold >= 0.0f && table[i].threshold <= 1.0f);
+        CHECK(table[i].alias < weights.size());
+        CHECK_NEAR(weights[i] / total, probabilities[i], 1e-5);
+        CHECK_NEAR(weights[i] / total, table[i].pdf, 1e-5);
+    }
+}
+
+}
+
+TEST(LightSampler, EqualWeightsKeepOwnIndex){
+    std::vector<float> weights(7, 2.5f);
+    checkTable(weights);
+    for (const LightSampler::AliasEntry& entry : LightSampler::buildAliasTable(weights)) {
+        CHECK_NEAR(1.0f, entry.threshold, 1e-6f);
+    }
+}
+
+TEST(LightSampler, SingleLight){
+    checkTable({3.0f});
+    std::vector<LightSampler::AliasEntry> table = LightSampler::buildAliasTable({3.0f});
+    CHECK_EQUAL(1.0f, table[0].threshold);
+    CHECK_EQUAL(0u, table[0].alias);
+    CHECK_EQUAL(1.0f, table[0].pdf);
+    CHECK(LightSampler::buildAliasTable({}).empty());
+}
+
+// Lichter ohne Leistung werden nie gezogen: Schwelle 0 und kein anderer Eintrag verweist auf sie
+TEST(LightSampler, ZeroPowerLightsNeverSelected){
+    std::vector<float> weights = {0.0f, 4.0f, 0.0f, 1.0f, 0.0f, 0.5f, 0.0f};
+    checkTable(weights);
+    std::vector<LightSampler::AliasEntry> table = LightSampler::buildAliasTable(weights);
+    for (size_t i = 0; i < weights.size(); i++) {
+        if (weights[i] == 0.0f) {
+            CHECK_EQUAL(0.0f, table[i].threshold);
+            CHECK_EQUAL(0.0f, table[i].pdf);
+        }
+        CHECK(weights[table[i].alias] > 0.0f);
+    }
+    // Ganz ohne Leistung wird gleichverteilt gezogen
+    std::vector<double> probabilities = getSelectionProbabilities(LightSampler::buildAliasTable({0.0f, 0.0f, 0.0f, 0.0f}));
+    for (double probability : probabilities) {
+        CHECK_NEAR(0.25, probability, 1e-6);
+    }
+}
+
+TEST(LightSampler, RandomWeightsMatchPower){
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (uint32_t count : {2u, 3u, 16u, 100u, 1000u}) {
+        std::vector<float> weights(count);
+        for (float& weight : weights) {
+            // Stark unterschiedliche Leistungen wie bei Sonne und Punktlichtern
+            weight = unit(random) < 0.1f ? unit(random) * 1000.0f : unit(random);
+        }
+        checkTable(weights);
+    }
+}
@@ -0,0 +1,138 @@
+#include "Test.h"
+#include "LightTree.h"
+#include <algorithm>
+#include <cstddef>
+#include <random>
+
+namespace {
+
+bool isPointLight(const Light& light){
+    return light.m_pos[3] > 0.0001f;
+}
+
+// Richtungslichter zuerst wie in createLightBuffer, danach zufällige Punktlichter
+std::vector<Light> makeLights(uint32_t directional, uint32_t points, uint32_t seed){
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Light> lights;
+    for (uint32_t i = 0; i < directional; i++) {
+        lights.emplace_back(glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f), 0.1f);
+    }
+    for (uint32_t i = 0; i < points; i++) {
+        glm::vec3 position = glm::vec3(unit(random) * 10.0f - 5.0f, unit(random) * 5.0f, unit(random) * 10.0f - 5.0f);
+        glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random));
+        lights.emplace_back(position, glm::vec3(1.0f, 0.7f, 1.8f), color, 0.01f);
+    }
+    return lights;
+}
+
+// Jedes Punktlicht in genau einem Blatt, Kinder nach dem Elternknoten und in dessen Box, Leistung als Summe der Kinder
+void checkTree(const LightTree& tree, const std::vector<Light>& lights){
+    const std::vector<LightTree::Node>& nodes = tree.getNodes();
+    uint32_t pointLights = 0;
+    for (const Light& light : lights) {
+        pointLights += isPointLight(light) ? 1 : 0;
+    }
+    if (pointLights == 0) {
+        CHECK(nodes.empty());
+        return;
+    }
+    CHECK_EQUAL(static_cast<size_t>(pointLights * 2 - 1), nodes.size());
+
+    std::vector<uint32_t> seen(lights.size(), 0);
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+        const LightTree::Node& node = nodes[i];
+        if (node.leaf) {
+            CHECK(node.lightIndex < lights.size());
+            const Light& light = lights[node.lightIndex];
+            CHECK(isPointLight(light));
+            seen[node.lightIndex]++;
+            for (int axis = 0; axis < 3; axis++) {
+                CHECK_EQUAL(light.m_pos[axis], node.boundsMin[axis]);
+                CHECK_EQUAL(light.m_pos[axis], node.boundsMax[axis]);
+            }
+            CHECK(node.power > 0.0f);
+            continue;
+        }
+        CHECK(node.left > i && node.left < nodes.size());
+        CHECK(node.right > i && node.right < nodes.size());
+        for (uint32_t child : {node.left, node.right}) {
+            for (int axis = 0; axis < 3; axis++) {
+                CHECK(nodes[child].boundsMin[axis] >= node.boundsMin[axis]);
+                CHECK(nodes[child].boundsMax[axis] <= node.boundsMax[axis]);
+            }
+        }
+        CHECK_NEAR(node.power, nodes[node.left].power + nodes[node.right].power, 1e-4f * std::max(1.0f, node.power));
+    }
+    for (uint32_t i = 0; i < lights.size(); i++) {
+        CHECK_EQUAL(isPointLight(lights[i]) ? 1u : 0u, seen[i]);
+    }
+}
+
+}
+
+// Muss zum LightNode in den Hit Shadern passen (std430)
+TEST(LightTree, NodeLayoutMatchesStd430){
+    CHECK_EQUAL(static_cast<size_t>(64), sizeof(LightTree::Node));
+    CHECK_EQUAL(static_cast<size_t>(0), offsetof(LightTree::Node, boundsMin));
+    CHECK_EQUAL(static_cast<size_t>(12), offsetof(LightTree::Node, power));
+    CHECK_EQUAL(static_cast<size_t>(16), offsetof(LightTree::Node, boundsMax));
+    CHECK_EQUAL(static_cast<size_t>(28), offsetof(LightTree::Node, cosThetaO));
+    CHECK_EQUAL(static_cast<size_t>(32), offsetof(LightTree::Node, axis));
+    CHECK_EQUAL(static_cast<size_t>(44), offsetof(LightTree::Node, cosThetaE));
+    CHECK_EQUAL(static_cast<size_t>(48), offsetof(LightTree::Node, left));
+    CHECK_EQUAL(static_cast<size_t>(52), offsetof(LightTree::Node, right));
+    CHECK_EQUAL(static_cast<size_t>(56), offsetof(LightTree::Node, lightIndex));
+    CHECK_EQUAL(static_cast<size_t>(60), offsetof(LightTree::Node, leaf));
+}
+
+TEST(LightTree, BuildCoversEveryPointLightOnce){
+    for (uint32_t points : {1u, 2u, 3u, 17u, 200u}) {
+        std::vector<Light> lights = makeLights(2, points, points);
+        LightTree tree;
+        tree.build(lights);
+        checkTree(tree, lights);
+    }
+}
+
+TEST(LightTree, OnlyDirectionalLightsGiveEmptyTree){
+    std::vector<Light> lights = makeLights(3, 0, 1);
+    LightTree tree;
+    tree.build(lights);
+    checkTree(tree, lights);
+}
+
+// Lichter am selben Ort haben keine Ausdehnung zum Binnen und werden halbiert
+TEST(LightTree, CoincidentLightsAreHalved){
+    std::vector<Light> lights;
+    for (int i = 0; i < 9; i++) {
+        lights.emplace_back(glm::vec3(1.0f, 2.0f, 3.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.5f), 0.0f);
+    }
+    LightTree tree;
+    tree.build(lights);
+    checkTree(tree, lights);
+}
+
+// Refit nach bewegtem Licht erhält die Invarianten, ohne die Topologie zu ändern
+TEST(LightTree, RefitFollowsMovedLights){
+    std::vector<Light> lights = makeLights(1, 32, 7);
+    LightTree tree;
+    tree.build(lights);
+    std::vector<LightTree::Node> before = tree.getNodes();
+
+    lights[1].m_pos[0] += 20.0f;
+    lights[5].m_pos[1] -= 3.0f;
+    lights[9].m_color[0] *= 4.0f;
+    tree.refit(lights);
+    checkTree(tree, lights);
+
+    const std::vector<LightTree::Node>& after = tree.getNodes();
+    for (size_t i = 0; i < after.size(); i++) {
+        CHECK_EQUAL(before[i].leaf, after[i].leaf);
+        CHECK_EQUAL(before[i].left, after[i].left);
+        CHECK_EQUAL(before[i].right, after[i].right);
+        CHECK_EQUAL(before[i].lightIndex, after[i].lightIndex);
+    }
+    CHECK(after[0].boundsMax[0] >= lights[1].m_pos[0]);
+    CHECK(after[0].power > before[0].power);
+}
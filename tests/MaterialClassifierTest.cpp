@@ -0,0 +1,74 @@
+#include "Test.h"
+#include "MaterialClassifier.h"
+#include "ShaderPermutation.h"
+#include <string>
+
+namespace {
+
+// Diffuses Material ohne Texturen
+Material makeMaterial(){
+    Material material{};
+    material.illum = 2;
+    material.ambientTexId = -1;
+    material.diffuseTexId = -1;
+    material.specularTexId = -1;
+    material.specularHighlightTexId = -1;
+    material.bumpTexId = -1;
+    material.displacementTexId = -1;
+    material.alphaTexId = -1;
+    material.reflectionTexId = -1;
+    return material;
+}
+
+}
+
+TEST(MaterialClassifier, TextureSlotsSelectTextured){
+    CHECK_EQUAL(MaterialVariantDiffuse, MaterialClassifier::classify(makeMaterial()));
+    for (int slot = 0; slot < 3; slot++) {
+        Material material = makeMaterial();
+        int32_t* textures[] = {&material.ambientTexId, &material.diffuseTexId, &material.specularTexId};
+        *textures[slot] = 0;
+        CHECK_EQUAL(MaterialVariantTextured, MaterialClassifier::classify(material));
+    }
+    // Texturen, die kein Hit Shader ausliest, ändern die Variante nicht
+    Material material = makeMaterial();
+    material.bumpTexId = 0;
+    material.specularHighlightTexId = 0;
+    material.displacementTexId = 0;
+    material.reflectionTexId = 0;
+    CHECK_EQUAL(MaterialVariantDiffuse, MaterialClassifier::classify(material));
+}
+
+// Nur illum 3 und 7 sind Sonderfälle, die Nachbarwerte bleiben diffus
+TEST(MaterialClassifier, IllumSelectsReflectiveAndRefractive){
+    for (int illum = 0; illum <= 10; illum++) {
+        Material material = makeMaterial();
+        material.illum = illum;
+        MaterialVariant expected = illum == 3 ? MaterialVariantReflective : illum == 7 ? MaterialVariantRefractive : MaterialVariantDiffuse;
+        CHECK_EQUAL(expected, MaterialClassifier::classify(material));
+        // Reflexion und Brechung enthalten die Texturen, die Textur ändert die Variante also nicht
+        material.diffuseTexId = 0;
+        CHECK_EQUAL(expected == MaterialVariantDiffuse ? MaterialVariantTextured : expected, MaterialClassifier::classify(material));
+    }
+}
+
+// Alpha hat Vorrang vor allen anderen Features
+TEST(MaterialClassifier, AlphaTextureWins){
+    for (int illum : {2, 3, 7}) {
+        Material material = makeMaterial();
+        material.illum = illum;
+        material.alphaTexId = 0;
+        CHECK_EQUAL(MaterialVariantAlpha, MaterialClassifier::classify(material));
+        material.diffuseTexId = 1;
+        CHECK_EQUAL(MaterialVariantAlpha, MaterialClassifier::classify(material));
+    }
+}
+
+TEST(MaterialClassifier, NamesAndShadowOffset){
+    for (uint32_t variant = 0; variant < MaterialVariantCount; variant++) {
+        CHECK(std::string(MaterialClassifier::getName(static_cast<MaterialVariant>(variant))).size() > 0);
+    }
+    CHECK_THROWS(MaterialClassifier::getName(MaterialVariantCount));
+    // Die Schatten Hit Groups folgen auf die Dreieck Varianten und die Kugel
+    CHECK_EQUAL(static_cast<uint32_t>(MaterialVariantCount) + 1, HitShaderConstants{}.shadowSbtOffset);
+}
@@ -0,0 +1,90 @@
+#include "Test.h"
+#include "PipelineCache.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+PipelineCache::FileHeader makeHeader(){
+    PipelineCache::FileHeader header{};
+    header.magic = 0x4B525450;
+    header.version = 1;
+    header.vendorID = 0x10DE;
+    header.deviceID = 0x2204;
+    header.driverVersion = 42;
+    for (uint32_t i = 0; i < VK_UUID_SIZE; i++) {
+        header.uuid[i] = static_cast<uint8_t>(i);
+    }
+    return header;
+}
+
+std::vector<char> makeData(size_t size){
+    std::vector<char> data(size);
+    for (size_t i = 0; i < size; i++) {
+        data[i] = static_cast<char>(i * 7);
+    }
+    return data;
+}
+
+std::string makePath(const std::string& name){
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "vkr_pipeline_cache";
+    std::filesystem::create_directories(directory);
+    std::filesystem::path path = directory / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+}
+
+TEST(PipelineCache, RoundTrip){
+    std::string path = makePath("roundtrip.bin");
+    CHECK(PipelineCache::readFile(path, makeHeader()).empty());
+    std::vector<char> data = makeData(1000);
+    PipelineCache::writeFile(path, makeHeader(), data);
+    CHECK(PipelineCache::readFile(path, makeHeader()) == data);
+    CHECK(!std::filesystem::exists(path + ".tmp"));
+    // Überschreiben ersetzt den alten Inhalt vollständig
+    data = makeData(10);
+    PipelineCache::writeFile(path, makeHeader(), data);
+    CHECK(PipelineCache::readFile(path, makeHeader()) == data);
+}
+
+// Jedes Feld des Kopfes einzeln verändert führt zu einem kalten Start
+TEST(PipelineCache, MismatchedHeaderStartsCold){
+    std::string path = makePath("mismatch.bin");
+    PipelineCache::writeFile(path, makeHeader(), makeData(100));
+    for (uint32_t field = 0; field < 6; field++) {
+        PipelineCache::FileHeader expected = makeHeader();
+        switch (field)
+        {
+            case 0: expected.magic++; break;
+            case 1: expected.version++; break;
+            case 2: expected.vendorID = 0x1002; break;
+            case 3: expected.deviceID++; break;
+            case 4: expected.driverVersion++; break;
+            default: expected.uuid[VK_UUID_SIZE - 1] ^= 0xFF; break;
+        }
+        CHECK(PipelineCache::readFile(path, expected).empty());
+    }
+    CHECK_EQUAL(static_cast<size_t>(100), PipelineCache::readFile(path, makeHeader()).size());
+}
+
+// Abgeschnittene Dateien und ein dataSize über die Dateigröße hinaus starten kalt, ohne den Puffer anzulegen
+TEST(PipelineCache, TruncatedFileStartsCold){
+    std::string path = makePath("truncated.bin");
+    PipelineCache::writeFile(path, makeHeader(), makeData(100));
+    std::filesystem::resize_file(path, sizeof(PipelineCache::FileHeader) + 50);
+    CHECK(PipelineCache::readFile(path, makeHeader()).empty());
+    std::filesystem::resize_file(path, sizeof(PipelineCache::FileHeader) / 2);
+    CHECK(PipelineCache::readFile(path, makeHeader()).empty());
+
+    PipelineCache::FileHeader header = makeHeader();
+    header.dataSize = UINT64_MAX;
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write("data", 4);
+    }
+    CHECK(PipelineCache::readFile(path, makeHeader()).empty());
+}
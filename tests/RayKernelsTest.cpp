@@ -0,0 +1,347 @@
+#include "Test.h"
+#include "RayKernels.h"
+#include "WideBvh.h"
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace {
+
+const float Infinity = std::numeric_limits<float>::infinity();
+
+// Werte der SIMD Varianten dürfen nur in der Rundung vom skalaren Kernel abweichen
+void checkClose(float expected, float actual){
+    CHECK_NEAR(expected, actual, 1e-5f * std::max(1.0f, std::abs(expected)));
+}
+
+std::vector<SimdKernel> getSimdKernels(){
+    std::vector<SimdKernel> kernels;
+    for (uint32_t kernel = SimdKernelScalar + 1; kernel < SimdKernelCount; kernel++) {
+        if (RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+            kernels.push_back(static_cast<SimdKernel>(kernel));
+        }
+    }
+    return kernels;
+}
+
+struct Ray{
+    glm::vec3 origin;
+    glm::vec3 direction;
+    float tmin;
+    float tmax;
+};
+
+// Zufällige Strahlen auf einen Punkt nahe der Szene, jeder fünfte parallel zu einer Achse, wechselnde tmin/tmax
+std::vector<Ray> makeRays(uint32_t count, uint32_t seed){
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays(count);
+    for (uint32_t i = 0; i < count; i++) {
+        glm::vec3 origin = glm::vec3(unit(random), unit(random), unit(random)) * 4.0f;
+        glm::vec3 target = glm::vec3(unit(random), unit(random), unit(random));
+        glm::vec3 direction = target - origin;
+        if (i % 5 == 0) {
+            direction = glm::vec3(0.0f);
+            direction[i % 3] = unit(random) < 0.0f ? -1.0f : 1.0f;
+        }
+        float tmin = i % 3 == 0 ? 0.0f : 0.5f;
+        float tmax = i % 4 == 0 ? 1.5f : 1e30f;
+        rays[i] = {origin, direction, tmin, tmax};
+    }
+    return rays;
+}
+
+void setBox(float bounds[6][8], uint32_t lane, glm::vec3 boundsMin, glm::vec3 boundsMax){
+    for (int axis = 0; axis < 3; axis++) {
+        bounds[axis][lane] = boundsMin[axis];
+        bounds[axis + 3][lane] = boundsMax[axis];
+    }
+}
+
+// Leere Einträge wie in WideBvh::collapse
+void setEmptyBox(float bounds[6][8], uint32_t lane){
+    setBox(bounds, lane, glm::vec3(Infinity), glm::vec3(-Infinity));
+}
+
+void setTriangle(TrianglePacket& packet, uint32_t lane, glm::vec3 p0, glm::vec3 p1, glm::vec3 p2){
+    for (int axis = 0; axis < 3; axis++) {
+        packet.v0[axis][lane] = p0[axis];
+        packet.e1[axis][lane] = p1[axis] - p0[axis];
+        packet.e2[axis][lane] = p2[axis] - p0[axis];
+    }
+}
+
+void setSphere(SpherePacket& packet, uint32_t lane, glm::vec3 center, float radius){
+    for (int axis = 0; axis < 3; axis++) {
+        packet.center[axis][lane] = center[axis];
+    }
+    packet.radius[lane] = radius;
+}
+
+// Möller-Trumbore wie in CpuRayTracer::intersectPrimitive, Referenz für die Traversierung
+bool intersectTriangle(const glm::vec3* corners, glm::vec3 origin, glm::vec3 direction, float tmin, float tmax, float& t){
+    glm::vec3 e1 = corners[1] - corners[0];
+    glm::vec3 e2 = corners[2] - corners[0];
+    glm::vec3 p = glm::cross(direction, e2);
+    float determinant = glm::dot(e1, p);
+    if (std::abs(determinant) < 1e-12f) {
+        return false;
+    }
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 s = origin - corners[0];
+    float u = glm::dot(s, p) * inverseDeterminant;
+    glm::vec3 q = glm::cross(s, e1);
+    float v = glm::dot(direction, q) * inverseDeterminant;
+    float hitT = glm::dot(e2, q) * inverseDeterminant;
+    if (u < 0.0f || v < 0.0f || u + v > 1.0f || hitT < tmin || hitT > tmax) {
+        return false;
+    }
+    t = hitT;
+    return true;
+}
+
+}
+
+// Einheitswürfel: Eintritt, Clipping über tmin/tmax, achsenparallele Strahlen innerhalb und außerhalb der Schicht
+TEST(RayKernels, BoxesKnownResults){
+    for (uint32_t kernel = 0; kernel < SimdKernelCount; kernel++) {
+        if (!RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+            continue;
+        }
+        SimdKernel simd = static_cast<SimdKernel>(kernel);
+        alignas(32) float bounds[6][8];
+        for (uint32_t lane = 0; lane < 8; lane++) {
+            setEmptyBox(bounds, lane);
+        }
+        setBox(bounds, 0, glm::vec3(0.0f), glm::vec3(1.0f));
+        setBox(bounds, 3, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(1.0f, 3.0f, 1.0f));
+        alignas(32) float distances[8];
+        glm::vec3 origin = glm::vec3(-4.0f, 0.5f, 0.5f);
+        glm::vec3 inverseDirection = RayKernels::getInverseDirection(glm::vec3(1.0f, 0.0f, 0.0f));
+
+        CHECK_EQUAL(1u, RayKernels::intersectBoxes(bounds, origin, inverseDirection, 0.0f, 100.0f, distances, simd));
+        CHECK_NEAR(4.0f, distances[0], 1e-6f);
+        CHECK_EQUAL(0u, RayKernels::intersectBoxes(bounds, origin, inverseDirection, 0.0f, 3.0f, distances, simd));
+        CHECK_EQUAL(1u, RayKernels::intersectBoxes(bounds, origin, inverseDirection, 4.5f, 100.0f, distances, simd));
+        CHECK_NEAR(4.5f, distances[0], 1e-6f);
+        CHECK_EQUAL(0u, RayKernels::intersectBoxes(bounds, origin, inverseDirection, 5.5f, 100.0f, distances, simd));
+
+        // Parallel zur x Achse auf Höhe der zweiten Box, außerhalb der y Schicht der ersten
+        origin = glm::vec3(-4.0f, 2.5f, 0.5f);
+        CHECK_EQUAL(1u << 3, RayKernels::intersectBoxes(bounds, origin, inverseDirection, 0.0f, 100.0f, distances, simd));
+        // Entgegen der Richtung liegt nichts
+        inverseDirection = RayKernels::getInverseDirection(glm::vec3(-1.0f, 0.0f, 0.0f));
+        CHECK_EQUAL(0u, RayKernels::intersectBoxes(bounds, origin, inverseDirection, 0.0f, 100.0f, distances, simd));
+    }
+}
+
+TEST(RayKernels, BoxesMatchScalar){
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays = makeRays(2000, 2);
+    for (SimdKernel kernel : getSimdKernels()) {
+        for (uint32_t i = 0; i < rays.size(); i++) {
+            alignas(32) float bounds[6][8];
+            uint32_t used = 1 + i % 8;
+            for (uint32_t lane = 0; lane < 8; lane++) {
+                if (lane >= used) {
+                    setEmptyBox(bounds, lane);
+                    continue;
+                }
+                glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random));
+                glm::vec3 extent = glm::abs(glm::vec3(unit(random), unit(random), unit(random))) * 0.5f;
+                setBox(bounds, lane, center - extent, center + extent);
+            }
+            const Ray& ray = rays[i];
+            glm::vec3 inverseDirection = RayKernels::getInverseDirection(ray.direction);
+            alignas(32) float expected[8];
+            alignas(32) float actual[8];
+            uint32_t expectedMask = RayKernels::intersectBoxes(bounds, ray.origin, inverseDirection, ray.tmin, ray.tmax, expected, SimdKernelScalar);
+            uint32_t mask = RayKernels::intersectBoxes(bounds, ray.origin, inverseDirection, ray.tmin, ray.tmax, actual, kernel);
+            CHECK_EQUAL(expectedMask, mask);
+            CHECK_EQUAL(0u, mask >> used);
+            for (uint32_t lane = 0; lane < 8; lane++) {
+                if (expectedMask & (1u << lane)) {
+                    checkClose(expected[lane], actual[lane]);
+                }
+            }
+        }
+    }
+}
+
+TEST(RayKernels, TrianglesKnownResults){
+    for (uint32_t kernel = 0; kernel < SimdKernelCount; kernel++) {
+        if (!RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+            continue;
+        }
+        SimdKernel simd = static_cast<SimdKernel>(kernel);
+        TrianglePacket packet{};
+        setTriangle(packet, 0, glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+        setTriangle(packet, 1, glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(1.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, -1.0f));
+        alignas(32) float t[8], u[8], v[8];
+        glm::vec3 origin = glm::vec3(0.25f, 0.25f, 1.0f);
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+
+        CHECK_EQUAL(3u, RayKernels::intersectTriangles(packet, 2, origin, direction, 0.0f, 100.0f, t, u, v, simd));
+        CHECK_NEAR(1.0f, t[0], 1e-6f);
+        CHECK_NEAR(0.25f, u[0], 1e-6f);
+        CHECK_NEAR(0.25f, v[0], 1e-6f);
+        CHECK_NEAR(2.0f, t[1], 1e-6f);
+        // Nur die erste Spur zählt, tmax schneidet das zweite Dreieck ab, tmin das erste
+        CHECK_EQUAL(1u, RayKernels::intersectTriangles(packet, 1, origin, direction, 0.0f, 100.0f, t, u, v, simd));
+        CHECK_EQUAL(1u, RayKernels::intersectTriangles(packet, 2, origin, direction, 0.0f, 1.5f, t, u, v, simd));
+        CHECK_EQUAL(2u, RayKernels::intersectTriangles(packet, 2, origin, direction, 1.5f, 100.0f, t, u, v, simd));
+        // Parallel zur Ebene der Dreiecke
+        CHECK_EQUAL(0u, RayKernels::intersectTriangles(packet, 2, glm::vec3(-1.0f, 0.25f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), 0.0f, 100.0f, t, u, v, simd));
+        // Neben dem Dreieck
+        CHECK_EQUAL(0u, RayKernels::intersectTriangles(packet, 2, glm::vec3(0.75f, 0.75f, 1.0f), direction, 0.0f, 100.0f, t, u, v, simd));
+    }
+}
+
+TEST(RayKernels, TrianglesMatchScalar){
+    std::mt19937 random(3);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays = makeRays(2000, 4);
+    for (SimdKernel kernel : getSimdKernels()) {
+        for (uint32_t i = 0; i < rays.size(); i++) {
+            TrianglePacket packet{};
+            uint32_t count = 1 + i % 8;
+            for (uint32_t lane = 0; lane < count; lane++) {
+                glm::vec3 p0 = glm::vec3(unit(random), unit(random), unit(random));
+                glm::vec3 p1 = p0 + glm::vec3(unit(random), unit(random), unit(random));
+                glm::vec3 p2 = p0 + glm::vec3(unit(random), unit(random), unit(random));
+                setTriangle(packet, lane, p0, p1, p2);
+            }
+            const Ray& ray = rays[i];
+            alignas(32) float expectedT[8], expectedU[8], expectedV[8];
+            alignas(32) float t[8], u[8], v[8];
+            uint32_t expectedMask = RayKernels::intersectTriangles(packet, count, ray.origin, ray.direction, ray.tmin, ray.tmax, expectedT, expectedU, expectedV, SimdKernelScalar);
+            uint32_t mask = RayKernels::intersectTriangles(packet, count, ray.origin, ray.direction, ray.tmin, ray.tmax, t, u, v, kernel);
+            CHECK_EQUAL(expectedMask, mask);
+            CHECK_EQUAL(0u, mask >> count);
+            for (uint32_t lane = 0; lane < count; lane++) {
+                if (expectedMask & (1u << lane)) {
+                    checkClose(expectedT[lane], t[lane]);
+                    checkClose(expectedU[lane], u[lane]);
+                    checkClose(expectedV[lane], v[lane]);
+                }
+            }
+        }
+    }
+}
+
+TEST(RayKernels, SpheresKnownResults){
+    for (uint32_t kernel = 0; kernel < SimdKernelCount; kernel++) {
+        if (!RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+            continue;
+        }
+        SimdKernel simd = static_cast<SimdKernel>(kernel);
+        SpherePacket packet{};
+        setSphere(packet, 0, glm::vec3(0.0f), 1.0f);
+        setSphere(packet, 1, glm::vec3(0.0f, 0.0f, -4.0f), 0.5f);
+        alignas(32) float t[8];
+        glm::vec3 direction = glm::vec3(0.0f, 0.0f, -1.0f);
+
+        CHECK_EQUAL(3u, RayKernels::intersectSpheres(packet, 2, glm::vec3(0.0f, 0.0f, 5.0f), direction, 0.0f, 100.0f, t, simd));
+        CHECK_NEAR(4.0f, t[0], 1e-5f);
+        CHECK_NEAR(8.5f, t[1], 1e-5f);
+        // Im Inneren zählt die hintere Nullstelle, tmin hinter dem Eintritt ebenso
+        CHECK_EQUAL(1u, RayKernels::intersectSpheres(packet, 1, glm::vec3(0.0f), direction, 0.0f, 100.0f, t, simd));
+        CHECK_NEAR(1.0f, t[0], 1e-5f);
+        CHECK_EQUAL(3u, RayKernels::intersectSpheres(packet, 2, glm::vec3(0.0f, 0.0f, 5.0f), direction, 5.0f, 100.0f, t, simd));
+        CHECK_NEAR(6.0f, t[0], 1e-5f);
+        CHECK_EQUAL(1u, RayKernels::intersectSpheres(packet, 2, glm::vec3(0.0f, 0.0f, 5.0f), direction, 0.0f, 5.0f, t, simd));
+        // Vorbei und hinter dem Ursprung
+        CHECK_EQUAL(0u, RayKernels::intersectSpheres(packet, 2, glm::vec3(2.0f, 0.0f, 5.0f), direction, 0.0f, 100.0f, t, simd));
+        CHECK_EQUAL(0u, RayKernels::intersectSpheres(packet, 2, glm::vec3(0.0f, 0.0f, 5.0f), -direction, 0.0f, 100.0f, t, simd));
+    }
+}
+
+TEST(RayKernels, SpheresMatchScalar){
+    std::mt19937 random(5);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<Ray> rays = makeRays(2000, 6);
+    for (SimdKernel kernel : getSimdKernels()) {
+        for (uint32_t i = 0; i < rays.size(); i++) {
+            SpherePacket packet{};
+            uint32_t count = 1 + i % 8;
+            for (uint32_t lane = 0; lane < count; lane++) {
+                setSphere(packet, lane, glm::vec3(unit(random), unit(random), unit(random)), 0.05f + 0.5f * std::abs(unit(random)));
+            }
+            const Ray& ray = rays[i];
+            alignas(32) float expected[8];
+            alignas(32) float t[8];
+            uint32_t expectedMask = RayKernels::intersectSpheres(packet, count, ray.origin, ray.direction, ray.tmin, ray.tmax, expected, SimdKernelScalar);
+            uint32_t mask = RayKernels::intersectSpheres(packet, count, ray.origin, ray.direction, ray.tmin, ray.tmax, t, kernel);
+            CHECK_EQUAL(expectedMask, mask);
+            CHECK_EQUAL(0u, mask >> count);
+            for (uint32_t lane = 0; lane < count; lane++) {
+                if (expectedMask & (1u << lane)) {
+                    checkClose(expected[lane], t[lane]);
+                }
+            }
+        }
+    }
+}
+
+// Nächster Treffer und Any Hit der 8-fach BVH gegen alle Dreiecke, mit jedem verfügbaren Kernel für die Box Tests
+TEST(RayKernels, WideBvhMatchesBruteForce){
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::vector<glm::vec3> corners;
+    std::vector<Aabb> bounds;
+    for (uint32_t i = 0; i < 3000; i++) {
+        glm::vec3 p0 = glm::vec3(unit(random), unit(random), unit(random)) * 2.0f;
+        Aabb box;
+        for (int k = 0; k < 3; k++) {
+            glm::vec3 corner = k == 0 ? p0 : p0 + glm::vec3(unit(random), unit(random), unit(random)) * 0.2f;
+            corners.push_back(corner);
+            box.grow(corner);
+        }
+        bounds.push_back(box);
+    }
+    Bvh::BuildSettings settings;
+    settings.maxLeafSize = WideBvh::Width;
+    Bvh bvh;
+    bvh.build(bounds, settings);
+    WideBvh wide;
+    wide.collapse(bvh);
+    CHECK(!wide.empty());
+
+    std::vector<Ray> rays = makeRays(1000, 8);
+    for (uint32_t kernel = 0; kernel < SimdKernelCount; kernel++) {
+        if (!RayKernels::isSupported(static_cast<SimdKernel>(kernel))) {
+            continue;
+        }
+        wide.setKernel(static_cast<SimdKernel>(kernel));
+        for (const Ray& ray : rays) {
+            float expected = ray.tmax;
+            bool expectedHit = false;
+            for (uint32_t i = 0; i < bounds.size(); i++) {
+                float t;
+                if (intersectTriangle(&corners[3 * i], ray.origin, ray.direction, ray.tmin, expected, t)) {
+                    expected = t;
+                    expectedHit = true;
+                }
+            }
+            auto intersectLeaf = [&](uint32_t leaf, float& tmax){
+                const WideBvh::Leaf& entry = wide.getLeaves()[leaf];
+                bool hit = false;
+                for (uint32_t i = entry.first; i < entry.first + entry.count; i++) {
+                    float t;
+                    if (intersectTriangle(&corners[3 * wide.getIndices()[i]], ray.origin, ray.direction, ray.tmin, tmax, t)) {
+                        tmax = t;
+                        hit = true;
+                    }
+                }
+                return hit;
+            };
+            float tmax = ray.tmax;
+            CHECK_EQUAL(expectedHit, wide.traverse(ray.origin, ray.direction, ray.tmin, tmax, false, intersectLeaf));
+            CHECK_EQUAL(expected, tmax);
+            float anyTmax = ray.tmax;
+            CHECK_EQUAL(expectedHit, wide.traverse(ray.origin, ray.direction, ray.tmin, anyTmax, true, intersectLeaf));
+            CHECK(anyTmax >= expected);
+        }
+    }
+}
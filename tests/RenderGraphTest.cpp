@@ -0,0 +1,143 @@
+#include "Test.h"
+#include "RenderGraph.h"
+
+namespace {
+
+VkImage fakeImage(uintptr_t id){
+    return reinterpret_cast<VkImage>(id);
+}
+
+// Derselbe Graph wie in createCommandBuffers: Trace schreibt Storage und Akkumulation, Copy kopiert ins Swapchain Bild
+struct TraceCopyPresent{
+    RenderGraph graph;
+    uint32_t storage;
+    uint32_t accumulation;
+    uint32_t swapChainImage;
+    uint32_t tracePass;
+    uint32_t copyPass;
+
+    TraceCopyPresent(){
+        VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        RenderGraph::ResourceState storageState = RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite);
+        storage = graph.importImage("storageImage", fakeImage(1), range, storageState, storageState);
+        accumulation = graph.importImage("accumulationImage", fakeImage(2), range, storageState, storageState);
+        swapChainImage = graph.importImage("swapChainImage", fakeImage(3), range, {VK_PIPELINE_STAGE_TRANSFER_BIT, 0, VK_IMAGE_LAYOUT_UNDEFINED}, RenderGraph::getState(RenderGraph::UsagePresent));
+
+        tracePass = graph.addPass("trace", nullptr);
+        graph.write(tracePass, storage, RenderGraph::UsageRayTracingStorageWrite);
+        graph.read(tracePass, accumulation, RenderGraph::UsageRayTracingStorageRead);
+        graph.write(tracePass, accumulation, RenderGraph::UsageRayTracingStorageWrite);
+
+        copyPass = graph.addPass("copy", nullptr);
+        graph.read(copyPass, storage, RenderGraph::UsageTransferSrc);
+        graph.write(copyPass, swapChainImage, RenderGraph::UsageTransferDst);
+        graph.compile();
+    }
+};
+
+void checkBarrier(const RenderGraph::Barrier& barrier, uint32_t resource, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess, VkImageLayout oldLayout, VkImageLayout newLayout){
+    CHECK_EQUAL(resource, barrier.resource);
+    CHECK_EQUAL(srcStage, barrier.srcStage);
+    CHECK_EQUAL(srcAccess, barrier.srcAccess);
+    CHECK_EQUAL(dstStage, barrier.dstStage);
+    CHECK_EQUAL(dstAccess, barrier.dstAccess);
+    CHECK_EQUAL(oldLayout, barrier.oldLayout);
+    CHECK_EQUAL(newLayout, barrier.newLayout);
+}
+
+}
+
+// Vor dem Trace nur Sichtbarkeit der Schreibzugriffe des vorherigen Frames, keine Layoutwechsel
+TEST(RenderGraph, TraceWaitsForPreviousFrame){
+    TraceCopyPresent frame;
+    const RenderGraph::BarrierBatch& batch = frame.graph.getBarriers(frame.tracePass);
+    CHECK_EQUAL(2u, batch.barriers.size());
+    CHECK_EQUAL(static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR), batch.srcStages);
+    CHECK_EQUAL(static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR), batch.dstStages);
+    checkBarrier(batch.barriers[0], frame.storage,
+                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+    checkBarrier(batch.barriers[1], frame.accumulation,
+                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+}
+
+// Storage wird Kopierquelle nach dem Trace, das Swapchain Bild kommt ohne Inhalt von der Präsentation
+TEST(RenderGraph, CopyTransitionsStorageAndSwapChain){
+    TraceCopyPresent frame;
+    const RenderGraph::BarrierBatch& batch = frame.graph.getBarriers(frame.copyPass);
+    CHECK_EQUAL(2u, batch.barriers.size());
+    CHECK_EQUAL(static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_TRANSFER_BIT), batch.srcStages);
+    CHECK_EQUAL(static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TRANSFER_BIT), batch.dstStages);
+    checkBarrier(batch.barriers[0], frame.storage,
+                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                 VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    checkBarrier(batch.barriers[1], frame.swapChainImage,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+}
+
+// Endzustand: Storage zurück nach GENERAL für den nächsten Frame, Swapchain nach PRESENT_SRC, die Akkumulation bleibt
+TEST(RenderGraph, FinalBarriersPresentAndRestoreStorage){
+    TraceCopyPresent frame;
+    const RenderGraph::BarrierBatch& batch = frame.graph.getFinalBarriers();
+    CHECK_EQUAL(2u, batch.barriers.size());
+    CHECK_EQUAL(static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TRANSFER_BIT), batch.srcStages);
+    CHECK_EQUAL(static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT), batch.dstStages);
+    checkBarrier(batch.barriers[0], frame.storage,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+                 VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR, VK_ACCESS_SHADER_WRITE_BIT,
+                 VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+    checkBarrier(batch.barriers[1], frame.swapChainImage,
+                 VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+}
+
+// Zwei lesende Passes hintereinander brauchen nach der ersten Sichtbarmachung keine weitere Barriere
+TEST(RenderGraph, ReadAfterReadNeedsNoBarrier){
+    RenderGraph graph;
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    RenderGraph::ResourceState state = RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite);
+    uint32_t image = graph.importImage("image", fakeImage(1), range, state, state);
+    uint32_t first = graph.addPass("first", nullptr);
+    graph.read(first, image, RenderGraph::UsageRayTracingStorageRead);
+    uint32_t second = graph.addPass("second", nullptr);
+    graph.read(second, image, RenderGraph::UsageRayTracingStorageRead);
+    graph.compile();
+    CHECK_EQUAL(1u, graph.getBarriers(first).barriers.size());
+    CHECK(graph.getBarriers(second).barriers.empty());
+    CHECK(graph.getFinalBarriers().barriers.empty());
+}
+
+// Ein Bild darf innerhalb eines Passes nur ein Layout haben
+TEST(RenderGraph, ConflictingLayoutsInOnePassThrow){
+    RenderGraph graph;
+    VkImageSubresourceRange range = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+    RenderGraph::ResourceState state = RenderGraph::getState(RenderGraph::UsageRayTracingStorageWrite);
+    uint32_t image = graph.importImage("image", fakeImage(1), range, state, state);
+    uint32_t pass = graph.addPass("pass", nullptr);
+    graph.read(pass, image, RenderGraph::UsageTransferSrc);
+    graph.write(pass, image, RenderGraph::UsageRayTracingStorageWrite);
+    CHECK_THROWS(graph.compile());
+}
+
+// Überlappende Lebenszeiten bekommen getrennte Slots, disjunkte teilen sich den größten
+TEST(RenderGraph, AliasingSharesDisjointLifetimes){
+    std::vector<RenderGraph::AliasRequest> requests = {
+        {0, 1, 1000, 256, 0x3},
+        {1, 2, 4000, 256, 0x1},
+        {2, 3, 3000, 256, 0x1},
+    };
+    std::vector<VkDeviceSize> slotSizes;
+    std::vector<RenderGraph::AliasSlot> slots = RenderGraph::computeAliasing(requests, slotSizes);
+    CHECK_EQUAL(2u, slotSizes.size());
+    CHECK_EQUAL(slots[0].slot, slots[2].slot);
+    CHECK(slots[0].slot != slots[1].slot);
+    CHECK_EQUAL(static_cast<VkDeviceSize>(4096), slotSizes[slots[1].slot]);
+    CHECK_EQUAL(static_cast<VkDeviceSize>(3072), slotSizes[slots[0].slot]);
+}
@@ -0,0 +1,150 @@
+#include "Test.h"
+#include "ShaderBindingTable.h"
+
+namespace {
+
+// Typische Werte: 32 Byte Handles, 64 Byte Basisausrichtung
+const uint32_t HandleSize = 32;
+const uint32_t HandleAlignment = 32;
+const uint32_t BaseAlignment = 64;
+
+// Handle von Gruppe g besteht aus dem Byte g + 1, so ist jede Kopie eindeutig zuzuordnen
+std::vector<uint8_t> makeHandles(uint32_t groupCount){
+    std::vector<uint8_t> handles(static_cast<size_t>(groupCount) * HandleSize);
+    for (uint32_t group = 0; group < groupCount; group++) {
+        std::fill(handles.begin() + group * HandleSize, handles.begin() + (group + 1) * HandleSize, static_cast<uint8_t>(group + 1));
+    }
+    return handles;
+}
+
+void checkRegion(const ShaderBindingTable::RegionLayout& region, VkDeviceSize offset, VkDeviceSize stride, VkDeviceSize size){
+    CHECK_EQUAL(offset, region.offset);
+    CHECK_EQUAL(stride, region.stride);
+    CHECK_EQUAL(size, region.size);
+}
+
+}
+
+// vkCmdTraceRaysKHR verlangt für Raygen size == stride, auch mit Inline Daten
+TEST(ShaderBindingTable, RayGenSizeEqualsStride){
+    ShaderBindingTable table(HandleSize, HandleAlignment, BaseAlignment);
+    table.add(ShaderBindingTable::RegionRayGen, 0);
+    ShaderBindingTable::Layout layout = table.computeLayout();
+    checkRegion(layout.regions[ShaderBindingTable::RegionRayGen], 0, 64, 64);
+
+    ShaderBindingTable withData(HandleSize, HandleAlignment, BaseAlignment);
+    uint8_t data[40] = {};
+    withData.add(ShaderBindingTable::RegionRayGen, 0, data, sizeof(data));
+    layout = withData.computeLayout();
+    checkRegion(layout.regions[ShaderBindingTable::RegionRayGen], 0, 128, 128);
+}
+
+TEST(ShaderBindingTable, RegionOffsetsAlignedToBase){
+    ShaderBindingTable table(HandleSize, HandleAlignment, BaseAlignment);
+    uint32_t hitData = 12;
+    table.add(ShaderBindingTable::RegionRayGen, 0);
+    table.add(ShaderBindingTable::RegionMiss, 1);
+    table.add(ShaderBindingTable::RegionMiss, 2);
+    table.add(ShaderBindingTable::RegionHit, 3);
+    table.add(ShaderBindingTable::RegionHit, 4, &hitData, sizeof(hitData));
+    table.add(ShaderBindingTable::RegionHit, 3);
+    table.add(ShaderBindingTable::RegionCallable, 5);
+    ShaderBindingTable::Layout layout = table.computeLayout();
+
+    checkRegion(layout.regions[ShaderBindingTable::RegionRayGen], 0, 64, 64);
+    checkRegion(layout.regions[ShaderBindingTable::RegionMiss], 64, 32, 64);
+    checkRegion(layout.regions[ShaderBindingTable::RegionHit], 128, 64, 192);
+    checkRegion(layout.regions[ShaderBindingTable::RegionCallable], 320, 32, 32);
+    CHECK_EQUAL(static_cast<VkDeviceSize>(352), layout.size);
+    for (uint32_t region = 0; region < ShaderBindingTable::RegionCount; region++) {
+        CHECK_EQUAL(static_cast<VkDeviceSize>(0), layout.regions[region].offset % BaseAlignment);
+        CHECK_EQUAL(static_cast<VkDeviceSize>(0), layout.regions[region].stride % HandleAlignment);
+    }
+}
+
+// Leere Regionen bekommen keinen Platz und werden als {0, 0, 0} übergeben
+TEST(ShaderBindingTable, EmptyRegionsAreZero){
+    ShaderBindingTable table(HandleSize, HandleAlignment, BaseAlignment);
+    table.add(ShaderBindingTable::RegionRayGen, 0);
+    table.add(ShaderBindingTable::RegionHit, 1);
+    ShaderBindingTable::Layout layout = table.computeLayout();
+    checkRegion(layout.regions[ShaderBindingTable::RegionMiss], 0, 0, 0);
+    checkRegion(layout.regions[ShaderBindingTable::RegionCallable], 0, 0, 0);
+    checkRegion(layout.regions[ShaderBindingTable::RegionHit], 64, 32, 32);
+    CHECK_EQUAL(static_cast<VkDeviceSize>(96), layout.size);
+}
+
+// Der Stride richtet sich nach den größten Inline Daten der Region, auf die Handle Ausrichtung gerundet
+TEST(ShaderBindingTable, StridesCoverLargestInlineData){
+    ShaderBindingTable table(HandleSize, HandleAlignment, BaseAlignment);
+    uint8_t small[4] = {};
+    uint8_t large[33] = {};
+    table.add(ShaderBindingTable::RegionMiss, 0, small, sizeof(small));
+    table.add(ShaderBindingTable::RegionHit, 1, small, sizeof(small));
+    table.add(ShaderBindingTable::RegionHit, 2, large, sizeof(large));
+    table.add(ShaderBindingTable::RegionHit, 3);
+    ShaderBindingTable::Layout layout = table.computeLayout();
+    checkRegion(layout.regions[ShaderBindingTable::RegionMiss], 0, 64, 64);
+    checkRegion(layout.regions[ShaderBindingTable::RegionHit], 64, 96, 288);
+
+    // Handle Ausrichtung kleiner als die Handle Größe
+    ShaderBindingTable packed(16, 8, 64);
+    packed.add(ShaderBindingTable::RegionMiss, 0, small, sizeof(small));
+    packed.add(ShaderBindingTable::RegionMiss, 1);
+    layout = packed.computeLayout();
+    checkRegion(layout.regions[ShaderBindingTable::RegionMiss], 0, 24, 48);
+}
+
+// Jeder Record liegt bei offset + index * stride, Inline Daten direkt hinter dem Handle, der Rest bleibt 0
+TEST(ShaderBindingTable, WriteCopiesHandlesToRecordOffsets){
+    ShaderBindingTable table(HandleSize, HandleAlignment, BaseAlignment);
+    uint8_t hitData[8] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5, 0xA6, 0xA7};
+    table.add(ShaderBindingTable::RegionRayGen, 0);
+    table.add(ShaderBindingTable::RegionMiss, 2);
+    table.add(ShaderBindingTable::RegionMiss, 1);
+    table.add(ShaderBindingTable::RegionHit, 3);
+    table.add(ShaderBindingTable::RegionHit, 3, hitData, sizeof(hitData));
+    ShaderBindingTable::Layout layout = table.computeLayout();
+    std::vector<uint8_t> data = table.write(layout, makeHandles(4));
+    CHECK_EQUAL(static_cast<size_t>(layout.size), data.size());
+
+    struct Expected{
+        ShaderBindingTable::Region region;
+        uint32_t index;
+        uint8_t groupByte;
+        bool hasData;
+    };
+    std::vector<Expected> records = {
+        {ShaderBindingTable::RegionRayGen, 0, 1, false},
+        {ShaderBindingTable::RegionMiss, 0, 3, false},
+        {ShaderBindingTable::RegionMiss, 1, 2, false},
+        {ShaderBindingTable::RegionHit, 0, 4, false},
+        {ShaderBindingTable::RegionHit, 1, 4, true},
+    };
+    std::vector<bool> covered(data.size(), false);
+    for (const Expected& record : records) {
+        size_t begin = layout.regions[record.region].offset + record.index * layout.regions[record.region].stride;
+        for (size_t i = 0; i < HandleSize; i++) {
+            CHECK_EQUAL(static_cast<int>(record.groupByte), static_cast<int>(data[begin + i]));
+            covered[begin + i] = true;
+        }
+        if (record.hasData) {
+            for (size_t i = 0; i < sizeof(hitData); i++) {
+                CHECK_EQUAL(static_cast<int>(hitData[i]), static_cast<int>(data[begin + HandleSize + i]));
+                covered[begin + HandleSize + i] = true;
+            }
+        }
+    }
+    for (size_t i = 0; i < data.size(); i++) {
+        if (!covered[i]) {
+            CHECK_EQUAL(0, static_cast<int>(data[i]));
+        }
+    }
+}
+
+TEST(ShaderBindingTable, WriteRejectsUnknownGroup){
+    ShaderBindingTable table(HandleSize, HandleAlignment, BaseAlignment);
+    table.add(ShaderBindingTable::RegionRayGen, 0);
+    table.add(ShaderBindingTable::RegionHit, 2);
+    CHECK_THROWS(table.write(table.computeLayout(), makeHandles(2)));
+}
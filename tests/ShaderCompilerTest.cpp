@@ -0,0 +1,121 @@
+#include "Test.h"
+#include "ShaderCompiler.h"
+#include <filesystem>
+#include <fstream>
+#include <set>
+
+namespace {
+
+// Eigene Kopie der Shader pro Test, damit Änderungen an Includes das Repo und andere Tests nicht berühren
+std::filesystem::path copyShaders(const std::string& name){
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / ("vkr_shaders_" + name);
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+    for (const auto& entry : std::filesystem::directory_iterator(SHADER_PATH)) {
+        if (entry.is_regular_file()) {
+            std::filesystem::copy_file(entry.path(), directory / entry.path().filename());
+        }
+    }
+    return directory;
+}
+
+ShaderCompiler makeCompiler(const std::filesystem::path& directory){
+    return ShaderCompiler(directory.string(), (directory / "cache").string());
+}
+
+void appendLine(const std::filesystem::path& path, const std::string& line){
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    file << "\n" << line << "\n";
+}
+
+void checkSpirv(const std::vector<uint32_t>& spirv){
+    CHECK(spirv.size() > 5);
+    CHECK_EQUAL(0x07230203u, spirv[0]);
+}
+
+}
+
+// Alle Shader im Verzeichnis übersetzen, Callable hat keine Datei und kommt als Quelltext
+TEST(ShaderCompiler, CompilesEveryStage){
+    std::filesystem::path directory = copyShaders("stages");
+    ShaderCompiler compiler = makeCompiler(directory);
+    std::set<ShaderCompiler::Stage> stages;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        std::string extension = entry.path().extension().string();
+        if (!entry.is_regular_file() || extension == ".glsl") {
+            continue;
+        }
+        std::string filename = "/" + entry.path().filename().string();
+        stages.insert(ShaderCompiler::getStage(filename));
+        checkSpirv(compiler.compile(filename));
+    }
+    checkSpirv(compiler.compileSource("#version 460\n#extension GL_EXT_ray_tracing : require\nlayout(location = 0) callableDataInEXT vec4 data;\nvoid main(){ data = vec4(1.0); }\n", ShaderCompiler::StageCallable, {}, "test.rcall"));
+    stages.insert(ShaderCompiler::StageCallable);
+    CHECK_EQUAL(6u, stages.size());
+}
+
+TEST(ShaderCompiler, SecondCompileHitsCache){
+    std::filesystem::path directory = copyShaders("cache");
+    ShaderCompiler compiler = makeCompiler(directory);
+    std::vector<uint32_t> first = compiler.compile("/raygen.rgen");
+    std::vector<uint32_t> second = compiler.compile("/raygen.rgen");
+    CHECK(first == second);
+    CHECK_EQUAL(1u, compiler.getCompileCount());
+    CHECK_EQUAL(1u, compiler.getCacheHits());
+
+    // Ein neuer Compiler auf demselben Cache übersetzt nicht erneut
+    ShaderCompiler reopened = makeCompiler(directory);
+    CHECK(reopened.compile("/raygen.rgen") == first);
+    CHECK_EQUAL(0u, reopened.getCompileCount());
+}
+
+TEST(ShaderCompiler, DefinesChangeCacheKey){
+    std::filesystem::path directory = copyShaders("defines");
+    ShaderCompiler compiler = makeCompiler(directory);
+    uint64_t plain = compiler.getCacheKey("/raygen.rgen", {});
+    CHECK(plain != compiler.getCacheKey("/raygen.rgen", {"MAX_BOUNCES=4"}));
+    CHECK(compiler.getCacheKey("/raygen.rgen", {"MAX_BOUNCES=4"}) != compiler.getCacheKey("/raygen.rgen", {"MAX_BOUNCES=8"}));
+    CHECK_EQUAL(plain, compiler.getCacheKey("/raygen.rgen", {}));
+}
+
+// Eine Änderung in einer eingebundenen Datei muss jeden Shader neu übersetzen, der sie einbindet
+TEST(ShaderCompiler, IncludeChangeInvalidatesCache){
+    for (std::string include : {"raycone.glsl", "random.glsl"}) {
+        std::filesystem::path directory = copyShaders("include_" + include);
+        ShaderCompiler compiler = makeCompiler(directory);
+        uint64_t raygen = compiler.getCacheKey("/raygen.rgen", {});
+        uint64_t closestHit = compiler.getCacheKey("/closesthit.rchit", {});
+        uint64_t sphereHit = compiler.getCacheKey("/closesthitsphere.rchit", {});
+        uint64_t miss = compiler.getCacheKey("/miss.rmiss", {});
+        compiler.compile("/raygen.rgen");
+
+        appendLine(directory / include, "// changed");
+        CHECK(raygen != compiler.getCacheKey("/raygen.rgen", {}));
+        CHECK(closestHit != compiler.getCacheKey("/closesthit.rchit", {}));
+        CHECK(sphereHit != compiler.getCacheKey("/closesthitsphere.rchit", {}));
+        CHECK_EQUAL(miss, compiler.getCacheKey("/miss.rmiss", {}));
+
+        compiler.compile("/raygen.rgen");
+        CHECK_EQUAL(2u, compiler.getCompileCount());
+        CHECK_EQUAL(0u, compiler.getCacheHits());
+    }
+}
+
+// Abgeschnittene Cache Dateien mit gültiger Magic Number werden verworfen und neu übersetzt
+TEST(ShaderCompiler, TruncatedCacheEntryRecompiles){
+    std::filesystem::path directory = copyShaders("truncated");
+    std::vector<uint32_t> first = makeCompiler(directory).compile("/raygen.rgen");
+    CHECK(ShaderCompiler::isValidSpirv(first, first.size() * sizeof(uint32_t)));
+    CHECK(!ShaderCompiler::isValidSpirv(std::vector<uint32_t>(first.begin(), first.begin() + 3), 3 * sizeof(uint32_t)));
+    CHECK(!ShaderCompiler::isValidSpirv(first, first.size() * sizeof(uint32_t) - 2));
+
+    for (const auto& entry : std::filesystem::directory_iterator(directory / "cache")) {
+        std::filesystem::resize_file(entry.path(), 3 * sizeof(uint32_t));
+    }
+    ShaderCompiler reopened = makeCompiler(directory);
+    CHECK(reopened.compile("/raygen.rgen") == first);
+    CHECK_EQUAL(1u, reopened.getCompileCount());
+    CHECK_EQUAL(0u, reopened.getCacheHits());
+    CHECK(reopened.compile("/raygen.rgen") == first);
+    CHECK_EQUAL(1u, reopened.getCacheHits());
+}
@@ -0,0 +1,103 @@
+#include "Test.h"
+#include "ShaderPermutation.h"
+#include <set>
+
+namespace {
+
+VkPipeline fakePipeline(uintptr_t id){
+    return reinterpret_cast<VkPipeline>(id);
+}
+
+// Jede Konstante einzeln verändert, der erste Eintrag sind die Standardwerte
+std::vector<HitShaderConstants> makeVariations(){
+    std::vector<HitShaderConstants> variations(1);
+    auto add = [&](auto change){
+        HitShaderConstants constants{};
+        change(constants);
+        variations.push_back(constants);
+    };
+    add([](HitShaderConstants& c){ c.dirLightCount = 1; });
+    add([](HitShaderConstants& c){ c.pointLightCount = 1; });
+    add([](HitShaderConstants& c){ c.maxRecursion = 5; });
+    add([](HitShaderConstants& c){ c.enableTextures = VK_FALSE; });
+    add([](HitShaderConstants& c){ c.enableReflection = VK_FALSE; });
+    add([](HitShaderConstants& c){ c.enableRefraction = VK_FALSE; });
+    add([](HitShaderConstants& c){ c.lightSamples = 4; });
+    add([](HitShaderConstants& c){ c.useLightTree = VK_TRUE; });
+    add([](HitShaderConstants& c){ c.iterativePath = VK_TRUE; });
+    add([](HitShaderConstants& c){ c.enableAlphaTest = VK_FALSE; });
+    add([](HitShaderConstants& c){ c.materialVariant = MaterialVariantAlpha; });
+    add([](HitShaderConstants& c){ c.objectSpaceSpheres = VK_FALSE; });
+    add([](HitShaderConstants& c){ c.shadowSbtOffset = 7; });
+    return variations;
+}
+
+}
+
+TEST(ShaderPermutation, DifferentConstantsGiveDifferentKeys){
+    std::vector<HitShaderConstants> variations = makeVariations();
+    // Jede Konstante hat einen Eintrag, sonst würde ihre Änderung nur den Schlüssel und nicht die Pipeline betreffen
+    CHECK_EQUAL(variations.size() - 1, HitShaderConstants::getMapEntries().size());
+    // Vertauschte Werte zweier Felder ergeben ebenfalls einen anderen Schlüssel
+    variations.push_back(HitShaderConstants{});
+    variations.back().dirLightCount = 2;
+    variations.back().pointLightCount = 3;
+    variations.push_back(HitShaderConstants{});
+    variations.back().dirLightCount = 3;
+    variations.back().pointLightCount = 2;
+    std::set<uint64_t> keys;
+    for (const HitShaderConstants& constants : variations) {
+        keys.insert(constants.getKey());
+    }
+    CHECK_EQUAL(variations.size(), keys.size());
+}
+
+TEST(ShaderPermutation, SameConstantsGiveSameKey){
+    for (const HitShaderConstants& constants : makeVariations()) {
+        HitShaderConstants copy = constants;
+        CHECK_EQUAL(constants.getKey(), copy.getKey());
+    }
+    std::vector<Light> lights = {Light(glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f), 0.1f), Light(glm::vec3(1.0f), glm::vec3(1.0f, 0.7f, 1.8f), glm::vec3(1.0f), 0.1f)};
+    std::vector<Material> materials(2);
+    for (Material& material : materials) {
+        material.illum = 2;
+        material.ambientTexId = material.diffuseTexId = material.specularTexId = material.alphaTexId = -1;
+    }
+    materials[1].illum = 3;
+    HitShaderConstants first = HitShaderConstants::fromScene(lights, materials, 4);
+    CHECK_EQUAL(1u, first.dirLightCount);
+    CHECK_EQUAL(1u, first.pointLightCount);
+    CHECK_EQUAL(VK_TRUE, first.enableReflection);
+    CHECK_EQUAL(VK_FALSE, first.enableRefraction);
+    CHECK_EQUAL(first.getKey(), HitShaderConstants::fromScene(lights, materials, 4).getKey());
+    CHECK(first.getKey() != HitShaderConstants::fromScene(lights, materials, 3).getKey());
+}
+
+// Die Einträge decken die Struktur lückenlos ab und passen zu den constant_id der Shader
+TEST(ShaderPermutation, MapEntriesCoverConstants){
+    std::vector<VkSpecializationMapEntry> entries = HitShaderConstants::getMapEntries();
+    size_t size = 0;
+    for (uint32_t i = 0; i < entries.size(); i++) {
+        CHECK_EQUAL(i, entries[i].constantID);
+        CHECK_EQUAL(static_cast<uint32_t>(size), entries[i].offset);
+        size += entries[i].size;
+    }
+    CHECK_EQUAL(sizeof(HitShaderConstants), size);
+}
+
+// Gleiche Konstanten finden die gecachte Pipeline wieder, andere nicht
+TEST(ShaderPermutation, CacheReturnsSamePermutation){
+    PermutationCache cache;
+    std::vector<HitShaderConstants> variations = makeVariations();
+    CHECK(cache.get(variations[0].getKey()) == VK_NULL_HANDLE);
+    for (size_t i = 0; i < variations.size(); i++) {
+        cache.add(variations[i].getKey(), fakePipeline(i + 1));
+    }
+    CHECK_EQUAL(variations.size(), cache.size());
+    for (size_t i = 0; i < variations.size(); i++) {
+        HitShaderConstants copy = variations[i];
+        CHECK(cache.get(copy.getKey()) == fakePipeline(i + 1));
+    }
+    CHECK_THROWS(cache.add(variations[0].getKey(), fakePipeline(100)));
+    CHECK(cache.get(variations[0].getKey()) == fakePipeline(1));
+}
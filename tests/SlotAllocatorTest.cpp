@@ -0,0 +1,76 @@
+#include "Test.h"
+#include "SlotAllocator.h"
+
+TEST(SlotAllocator, AllocatesAscendingSlots){
+    SlotAllocator slots(4);
+    CHECK_EQUAL(0u, slots.allocate());
+    CHECK_EQUAL(1u, slots.allocate());
+    CHECK_EQUAL(2u, slots.allocate());
+    CHECK(slots.isAllocated(2));
+    CHECK(!slots.isAllocated(3));
+    CHECK_EQUAL(4u, slots.getCapacity());
+}
+
+// Zuletzt freigegebene Slots kommen zuerst zurück, neue Slots erst wenn die Free List leer ist
+TEST(SlotAllocator, FreeListReusedBeforeNewSlots){
+    SlotAllocator slots(8);
+    for (uint32_t i = 0; i < 5; i++) {
+        slots.allocate();
+    }
+    slots.free(1);
+    slots.free(3);
+    CHECK(!slots.isAllocated(1));
+    CHECK_EQUAL(3u, slots.allocate());
+    CHECK_EQUAL(1u, slots.allocate());
+    CHECK_EQUAL(5u, slots.allocate());
+    CHECK(slots.isAllocated(1));
+    CHECK(slots.isAllocated(3));
+}
+
+// Die Kapazität zählt nur belegte Slots, nach einer Freigabe geht es weiter
+TEST(SlotAllocator, CapacityExceededThrows){
+    SlotAllocator slots(2);
+    slots.allocate();
+    slots.allocate();
+    CHECK_THROWS(slots.allocate());
+    slots.free(0);
+    CHECK_EQUAL(0u, slots.allocate());
+    CHECK_THROWS(slots.allocate());
+
+    SlotAllocator empty;
+    CHECK_THROWS(empty.allocate());
+}
+
+TEST(SlotAllocator, DoubleFreeThrows){
+    SlotAllocator slots(4);
+    uint32_t slot = slots.allocate();
+    slots.free(slot);
+    CHECK_THROWS(slots.free(slot));
+    // Nie vergebene und außerhalb der Kapazität liegende Slots
+    CHECK_THROWS(slots.free(2));
+    CHECK_THROWS(slots.free(4));
+    CHECK_EQUAL(0u, slots.getAllocatedCount());
+}
+
+// High Water bleibt nach Freigaben stehen, der Zähler folgt den belegten Slots
+TEST(SlotAllocator, HighWaterAndAllocatedCount){
+    SlotAllocator slots(16);
+    CHECK_EQUAL(0u, slots.getHighWater());
+    CHECK_EQUAL(0u, slots.getAllocatedCount());
+    for (uint32_t i = 0; i < 6; i++) {
+        slots.allocate();
+    }
+    CHECK_EQUAL(6u, slots.getHighWater());
+    CHECK_EQUAL(6u, slots.getAllocatedCount());
+    slots.free(5);
+    slots.free(2);
+    CHECK_EQUAL(6u, slots.getHighWater());
+    CHECK_EQUAL(4u, slots.getAllocatedCount());
+    slots.allocate();
+    CHECK_EQUAL(6u, slots.getHighWater());
+    CHECK_EQUAL(5u, slots.getAllocatedCount());
+    slots.allocate();
+    slots.allocate();
+    CHECK_EQUAL(7u, slots.getHighWater());
+    CHECK_EQUAL(7u, slots.getAllocatedCount());
+}
@@ -0,0 +1,121 @@
+#include "Test.h"
+#include "SphereFlake.h"
+#include <cstring>
+
+namespace {
+
+std::vector<Sphere> generate(int recursionDepth, float radius, JobSystem& jobs){
+    std::vector<Sphere> spheres(SphereFlake::getSphereCount(recursionDepth));
+    SphereFlake::generateSphereFlake(recursionDepth, radius, spheres.data(), jobs);
+    return spheres;
+}
+
+// Startindex der Knoten der Ebene level in der Tiefensuche Reihenfolge eines Flakes der Tiefe recursionDepth
+void getNodeOffsets(int level, int recursionDepth, size_t base, std::vector<size_t>& offsets){
+    if (level == 0) {
+        offsets.push_back(base);
+        return;
+    }
+    size_t childCount = SphereFlake::getSphereCount(recursionDepth - 1);
+    for (size_t i = 0; i < 9; i++) {
+        getNodeOffsets(level - 1, recursionDepth - 1, base + 1 + i * childCount, offsets);
+    }
+}
+
+void checkSphere(const Sphere& expected, glm::vec3 center, float radius){
+    for (int axis = 0; axis < 3; axis++) {
+        CHECK_NEAR(expected.center[axis], center[axis], 1e-5f);
+    }
+    CHECK_NEAR(expected.radius, radius, 1e-6f);
+}
+
+}
+
+// Geometrische Reihe 1 + 9 + ... + 9^d = (9^(d + 1) - 1) / 8
+TEST(SphereFlake, SphereCountMatchesClosedForm){
+    size_t power = 9;
+    for (int depth = 0; depth <= 8; depth++) {
+        CHECK_EQUAL((power - 1) / 8, SphereFlake::getSphereCount(depth));
+        CHECK_EQUAL(power / 9, SphereFlake::getInstanceCount(depth));
+        power *= 9;
+    }
+    CHECK_EQUAL(static_cast<size_t>(1), SphereFlake::getSphereCount(0));
+    CHECK_EQUAL(static_cast<size_t>(820), SphereFlake::getSphereCount(3));
+}
+
+// Die Jobs schreiben in getrennte Abschnitte, das Ergebnis muss Byte für Byte dem seriellen entsprechen
+TEST(SphereFlake, ParallelMatchesSerial){
+    JobSystem serial(1);
+    JobSystem jobs(4);
+    for (int depth = 0; depth <= 4; depth++) {
+        std::vector<Sphere> expected = generate(depth, 0.5f, serial);
+        std::vector<Sphere> spheres = generate(depth, 0.5f, jobs);
+        CHECK_EQUAL(expected.size(), spheres.size());
+        for (size_t i = 0; i < spheres.size(); i++) {
+            CHECK(std::memcmp(&expected[i], &spheres[i], sizeof(Sphere)) == 0);
+        }
+    }
+    // Wurzel und Radien der ersten Ebene
+    std::vector<Sphere> spheres = generate(2, 0.5f, jobs);
+    CHECK_EQUAL(0.5f, spheres[0].radius);
+    CHECK_NEAR(0.5f / 3.0f, spheres[1].radius, 1e-7f);
+    CHECK_NEAR(0.5f / 9.0f, spheres[2].radius, 1e-7f);
+    CHECK_NEAR(0.5f + 0.5f / 3.0f, glm::length(glm::vec3(spheres[1].center[0], spheres[1].center[1], spheres[1].center[2])), 1e-6f);
+}
+
+// Die Member Variante erzeugt dieselben Kugeln und gibt den Puffer ohne Kopie ab
+TEST(SphereFlake, MemberMatchesBuffer){
+    JobSystem jobs(4);
+    std::vector<Sphere> expected = generate(3, 0.5f, jobs);
+    SphereFlake flake;
+    flake.generateSphereFlake(3, 0.5f, jobs);
+    CHECK_EQUAL(expected.size(), flake.getSpheres().size());
+    CHECK(std::memcmp(expected.data(), flake.getSpheres().data(), expected.size() * sizeof(Sphere)) == 0);
+    const Sphere* data = flake.getSpheres().data();
+    std::vector<Sphere> taken = flake.takeSpheres();
+    CHECK(taken.data() == data);
+}
+
+// Wie in main.cpp: Teilflake der Tiefe instanceDepth mit Radius 1 pro Instanz, die Ebenen darüber als eigener Flake.
+// Zusammen müssen sie genau die Kugeln des flachen Flakes ergeben
+TEST(SphereFlake, InstancesMatchFlatFlake){
+    JobSystem jobs(4);
+    const float radius = 0.5f;
+    for (int recursionDepth = 1; recursionDepth <= 4; recursionDepth++) {
+        std::vector<Sphere> flat = generate(recursionDepth, radius, jobs);
+        for (int levels = 1; levels <= recursionDepth; levels++) {
+            int instanceDepth = recursionDepth - levels;
+            std::vector<Sphere> subFlake = generate(instanceDepth, 1.0f, jobs);
+            std::vector<glm::mat4> transforms;
+            SphereFlake::generateInstanceTransforms(levels, radius, transforms);
+            CHECK_EQUAL(SphereFlake::getInstanceCount(levels), transforms.size());
+
+            std::vector<size_t> offsets;
+            getNodeOffsets(levels, recursionDepth, 0, offsets);
+            CHECK_EQUAL(transforms.size(), offsets.size());
+            std::vector<bool> covered(flat.size(), false);
+            for (size_t instance = 0; instance < transforms.size(); instance++) {
+                // Gleichmäßige Skalierung, der Radius skaliert mit der Länge der ersten Spalte wie in intersection.rint
+                float scale = glm::length(glm::vec3(transforms[instance][0]));
+                for (size_t i = 0; i < subFlake.size(); i++) {
+                    glm::vec3 center = glm::vec3(transforms[instance] * glm::vec4(subFlake[i].center[0], subFlake[i].center[1], subFlake[i].center[2], 1.0f));
+                    checkSphere(flat[offsets[instance] + i], center, subFlake[i].radius * scale);
+                    covered[offsets[instance] + i] = true;
+                }
+            }
+
+            // Die übrigen Kugeln sind in derselben Reihenfolge der obere Flake
+            std::vector<Sphere> top = generate(levels - 1, radius, jobs);
+            size_t next = 0;
+            for (size_t i = 0; i < flat.size(); i++) {
+                if (covered[i]) {
+                    continue;
+                }
+                CHECK(next < top.size());
+                checkSphere(flat[i], glm::vec3(top[next].center[0], top[next].center[1], top[next].center[2]), top[next].radius);
+                next++;
+            }
+            CHECK_EQUAL(top.size(), next);
+        }
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimaler Testrahmen ohne externe Abhängigkeiten. TEST registriert eine Funktion unter Suite und Name,
+// die CHECK Makros werfen beim ersten Fehlschlag. ctest startet VKRTests einmal pro Suite
+struct TestCase{
+    std::string suite;
+    std::string name;
+    std::function<void()> run;
+};
+
+std::vector<TestCase>& getTestCases();
+
+struct TestRegistration{
+    TestRegistration(const char* suite, const char* name, void (*run)()){
+        getTestCases().push_back({suite, name, run});
+    }
+};
+
+#define TEST(suite, name) \
+    static void suite##_##name(); \
+    static TestRegistration suite##_##name##_registration(#suite, #name, suite##_##name); \
+    static void suite##_##name()
+
+#define TEST_FAIL(message) \
+    do { \
+        std::ostringstream testMessage; \
+        testMessage << __FILE__ << ":" << __LINE__ << ": " << message; \
+        throw std::runtime_error(testMessage.str()); \
+    } while (0)
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) \
+            TEST_FAIL("CHECK(" #condition ") failed"); \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        auto testExpected = (expected); \
+        auto testActual = (actual); \
+        if (!(testExpected == testActual)) \
+            TEST_FAIL("CHECK_EQUAL(" #expected ", " #actual ") failed: " << testExpected << " != " << testActual); \
+    } while (0)
+
+#define CHECK_NEAR(expected, actual, tolerance) \
+    do { \
+        double testExpected = (expected); \
+        double testActual = (actual); \
+        if (!(std::abs(testExpected - testActual) <= (tolerance))) \
+            TEST_FAIL("CHECK_NEAR(" #expected ", " #actual ") failed: " << testExpected << " != " << testActual); \
+    } while (0)
+
+#define CHECK_THROWS(statement) \
+    do { \
+        bool testThrown = false; \
+        try { \
+            statement; \
+        } catch (const std::exception&) { \
+            testThrown = true; \
+        } \
+        if (!testThrown) \
+            TEST_FAIL("CHECK_THROWS(" #statement ") did not throw"); \
+    } while (0)
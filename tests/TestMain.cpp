@@ -0,0 +1,36 @@
+#include "Test.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+std::vector<TestCase>& getTestCases(){
+    static std::vector<TestCase> testCases;
+    return testCases;
+}
+
+// Ohne Argument laufen alle Tests, sonst nur die Suiten aus der Kommandozeile
+int main(int argc, char** argv) {
+    std::vector<std::string> suites(argv + 1, argv + argc);
+    uint32_t passed = 0;
+    uint32_t failed = 0;
+    for (const TestCase& testCase : getTestCases()) {
+        if (!suites.empty() && std::find(suites.begin(), suites.end(), testCase.suite) == suites.end()) {
+            continue;
+        }
+        try {
+            testCase.run();
+            passed++;
+            std::cout << "[ pass ] " << testCase.suite << "." << testCase.name << std::endl;
+        } catch (const std::exception& e) {
+            failed++;
+            std::cout << "[ FAIL ] " << testCase.suite << "." << testCase.name << ": " << e.what() << std::endl;
+        }
+    }
+    std::cout << passed << " passed, " << failed << " failed" << std::endl;
+    if (passed + failed == 0) {
+        std::cerr << "no tests matched!" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,73 @@
+#include "Test.h"
+#include "TimingStats.h"
+#include "Profiler.h"
+
+namespace {
+
+TimingStats makeStats(const std::string& name, int count){
+    TimingStats stats;
+    for (int i = 1; i <= count; i++) {
+        stats.add(name, static_cast<double>(i));
+    }
+    return stats;
+}
+
+}
+
+// Rang = p / 100 * (n - 1), dazwischen wird linear interpoliert
+TEST(TimingStats, PercentilesInterpolateBetweenRanks){
+    TimingStats stats = makeStats("trace", 10);
+    CHECK_NEAR(1.0, stats.getPercentile("trace", 0.0), 1e-12);
+    CHECK_NEAR(5.5, stats.getPercentile("trace", 50.0), 1e-12);
+    CHECK_NEAR(9.55, stats.getPercentile("trace", 95.0), 1e-12);
+    CHECK_NEAR(9.91, stats.getPercentile("trace", 99.0), 1e-12);
+    CHECK_NEAR(10.0, stats.getPercentile("trace", 100.0), 1e-12);
+    CHECK_NEAR(5.5, stats.getMean("trace"), 1e-12);
+}
+
+TEST(TimingStats, PercentileSortsAndClamps){
+    std::vector<double> samples = {4.0, 1.0, 3.0, 2.0};
+    CHECK_NEAR(2.5, TimingStats::percentile(samples, 50.0), 1e-12);
+    CHECK_NEAR(1.0, TimingStats::percentile(samples, -10.0), 1e-12);
+    CHECK_NEAR(4.0, TimingStats::percentile(samples, 150.0), 1e-12);
+    CHECK_NEAR(7.0, TimingStats::percentile({7.0}, 99.0), 1e-12);
+    CHECK_NEAR(0.0, TimingStats::percentile({}, 50.0), 1e-12);
+}
+
+// Nur die letzten maxSamples Werte zählen
+TEST(TimingStats, KeepsOnlyNewestSamples){
+    TimingStats stats(3);
+    for (int i = 1; i <= 5; i++) {
+        stats.add("copy", static_cast<double>(i));
+    }
+    CHECK_EQUAL(3u, stats.getCount("copy"));
+    CHECK_NEAR(3.0, stats.getPercentile("copy", 0.0), 1e-12);
+    CHECK_NEAR(4.0, stats.getMean("copy"), 1e-12);
+    CHECK_EQUAL(0u, stats.getCount("missing"));
+}
+
+TEST(TimingStats, CsvHasHeaderAndOneRowPerPassInInsertionOrder){
+    TimingStats stats = makeStats("trace", 4);
+    stats.add("copy", 0.5);
+    CHECK_EQUAL(std::string("pass,count,mean_ms,min_ms,p50_ms,p95_ms,p99_ms,max_ms\n"
+                            "trace,4,2.5,1,2.5,3.85,3.97,4\n"
+                            "copy,1,0.5,0.5,0.5,0.5,0.5,0.5\n"), stats.toCSV());
+}
+
+TEST(TimingStats, JsonEscapesNames){
+    TimingStats stats;
+    stats.add("blas \"sponza\"", 2.0);
+    CHECK_EQUAL(std::string("{\"passes\":[{\"name\":\"blas \\\"sponza\\\"\",\"count\":1,\"mean_ms\":2,\"min_ms\":2,\"p50_ms\":2,\"p95_ms\":2,\"p99_ms\":2,\"max_ms\":2}]}"), stats.toJSON());
+    CHECK_EQUAL(std::string("{\"passes\":[]}"), TimingStats().toJSON());
+}
+
+// Die Maske kommt aus timestampValidBits der Queue Familie, auf der der Marker geschrieben wurde
+TEST(TimingStats, TimestampMaskPerValidBits){
+    CHECK_EQUAL(~0ull, Profiler::getTimestampMask(64));
+    CHECK_EQUAL(0xFFFFFFFFFull, Profiler::getTimestampMask(36));
+    CHECK_EQUAL(0ull, Profiler::getTimestampMask(0));
+    // Überlauf eines 36 Bit Zählers zwischen Begin und End
+    uint64_t begin = 0xFFFFFFFF0ull;
+    uint64_t end = 0x10ull;
+    CHECK_EQUAL(0x20ull, (end - begin) & Profiler::getTimestampMask(36));
+}